@@ -0,0 +1,119 @@
+/**************************************************************************/ /**
+* @brief Solution quality event extraction example.
+* @file
+******************************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <point_one/fusion_engine/analysis/event_detector.h>
+#include <point_one/fusion_engine/parsers/fusion_engine_framer.h>
+
+using namespace point_one::fusion_engine::analysis;
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::parsers;
+
+/******************************************************************************/
+void PrintEvent(const EventRecord& event) {
+  double p1_time_sec =
+      event.p1_time.seconds + (event.p1_time.fraction_ns * 1e-9);
+  printf("P1 time %.3f: %s [offset=%llu B, source=%u", p1_time_sec,
+         to_string(event.type).c_str(),
+         static_cast<unsigned long long>(event.offset_bytes),
+         event.source_identifier);
+  if (event.type == EventType::SOLUTION_TYPE_CHANGED) {
+    printf(", %s -> %s]\n",
+           to_string(static_cast<SolutionType>(event.previous_value)).c_str(),
+           to_string(static_cast<SolutionType>(event.current_value)).c_str());
+  } else {
+    printf(", previous=%.3f, current=%.3f]\n", event.previous_value,
+           event.current_value);
+  }
+}
+
+/******************************************************************************/
+int main(int argc, const char* argv[]) {
+  bool rebuild = false;
+  const char* path = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--rebuild") == 0) {
+      rebuild = true;
+    } else {
+      path = argv[i];
+    }
+  }
+
+  if (path == nullptr) {
+    printf("Usage: %s [--rebuild] FILE\n", argv[0]);
+    printf(R"EOF(
+Extract solution quality events (solution type changes, protection level
+threshold violations, stale differential corrections) from a binary file
+containing FusionEngine data.
+
+Events are stored in an index file next to the log (FILE.p1e), and read from
+the index on subsequent runs unless --rebuild is specified.
+)EOF");
+    return 0;
+  }
+
+  // Open the file.
+  std::ifstream stream(path, std::ifstream::binary);
+  if (!stream) {
+    printf("Error opening file '%s'.\n", path);
+    return 1;
+  }
+
+  // Determine the file size.
+  stream.seekg(0, stream.end);
+  uint64_t file_size_bytes = static_cast<uint64_t>(stream.tellg());
+  stream.seekg(0, stream.beg);
+
+  // Use the existing event index if it is up to date.
+  std::string index_path = GetEventIndexPath(path);
+  std::vector<EventRecord> events;
+  if (!rebuild && LoadEventIndex(index_path, events, file_size_bytes)) {
+    printf("Loaded %zu events from '%s'.\n", events.size(),
+           index_path.c_str());
+    for (const auto& event : events) {
+      PrintEvent(event);
+    }
+    return 0;
+  }
+
+  // Otherwise, decode the log and detect events.
+  EventDetector detector;
+  detector.AddDefaultRules();
+  detector.SetEventCallback(PrintEvent);
+
+  // Note: A corrupted header may claim a payload up to the framer capacity, so
+  // keep it reasonably small to limit the data lost while resynchronizing.
+  FusionEngineFramer framer(65536);
+  framer.SetMessageCallback([&](const MessageHeader& header,
+                                const void* payload, uint64_t offset_bytes) {
+    detector.OnMessage(header, payload, offset_bytes);
+  });
+
+  char buffer[65536];
+  while (stream) {
+    stream.read(buffer, sizeof(buffer));
+    framer.OnData(buffer, static_cast<size_t>(stream.gcount()));
+  }
+
+  const auto& stats = framer.GetStatistics();
+  printf("Decoded %llu messages (%llu CRC failures). Found %zu events.\n",
+         static_cast<unsigned long long>(stats.messages_decoded),
+         static_cast<unsigned long long>(stats.crc_failures),
+         detector.GetEvents().size());
+
+  if (!SaveEventIndex(index_path, detector.GetEvents(), file_size_bytes)) {
+    printf("Error writing event index '%s'.\n", index_path.c_str());
+    return 1;
+  }
+
+  return 0;
+}
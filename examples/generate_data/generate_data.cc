@@ -6,8 +6,10 @@
 #include <cstdio>
 #include <fstream>
 
+#include <point_one/fusion_engine/messages/compact_pose.h>
 #include <point_one/fusion_engine/messages/core.h>
 #include <point_one/fusion_engine/messages/crc.h>
+#include <point_one/fusion_engine/messages/imu_batch.h>
 
 using namespace point_one::fusion_engine::messages;
 
@@ -220,6 +222,63 @@ Generate a binary file containing a fixed set of messages.
   pose_message->horizontal_protection_level_m = 0.08f;
   pose_message->vertical_protection_level_m = 0.2f;
 
+  header->crc = CalculateCRC(storage);
+  stream.write(reinterpret_cast<char*>(storage),
+               sizeof(MessageHeader) + header->payload_size_bytes);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Write a compact version of the same pose for low-bandwidth links.
+  //////////////////////////////////////////////////////////////////////////////
+
+  // Note: Copying the pose before overwriting the buffer.
+  PoseMessage full_pose = *pose_message;
+
+  buffer = storage;
+  header = reinterpret_cast<MessageHeader*>(buffer);
+  buffer += sizeof(MessageHeader);
+
+  // Note: Updating contents of existing header to maintain sequence number.
+  ++header->sequence_number;
+  header->message_type = MessageType::COMPACT_POSE;
+  header->payload_size_bytes = sizeof(CompactPoseMessage);
+
+  auto compact_pose_message = reinterpret_cast<CompactPoseMessage*>(buffer);
+  ToCompactPose(full_pose, *compact_pose_message);
+
+  header->crc = CalculateCRC(storage);
+  stream.write(reinterpret_cast<char*>(storage),
+               sizeof(MessageHeader) + header->payload_size_bytes);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Write a batch of 100 Hz IMU measurements.
+  //////////////////////////////////////////////////////////////////////////////
+
+  buffer = storage;
+  header = reinterpret_cast<MessageHeader*>(buffer);
+  buffer += sizeof(MessageHeader);
+
+  // Note: Updating contents of existing header to maintain sequence number.
+  ++header->sequence_number;
+  header->message_type = MessageType::IMU_MEASUREMENT_BATCH;
+
+  IMUMeasurement imu_samples[3];
+  for (size_t i = 0; i < 3; ++i) {
+    imu_samples[i].p1_time.seconds = 123;
+    imu_samples[i].p1_time.fraction_ns =
+        static_cast<uint32_t>(670000000 + i * 10000000);
+
+    imu_samples[i].accel_mps2[0] = 0.1 * i;
+    imu_samples[i].accel_mps2[1] = -0.02;
+    imu_samples[i].accel_mps2[2] = 9.81;
+
+    imu_samples[i].gyro_rps[0] = 0.001;
+    imu_samples[i].gyro_rps[1] = -0.002;
+    imu_samples[i].gyro_rps[2] = 0.01 * i;
+  }
+
+  header->payload_size_bytes = static_cast<uint32_t>(EncodeIMUBatch(
+      imu_samples, 3, buffer, sizeof(storage) - sizeof(MessageHeader)));
+
   header->crc = CalculateCRC(storage);
   stream.write(reinterpret_cast<char*>(storage),
                sizeof(MessageHeader) + header->payload_size_bytes);
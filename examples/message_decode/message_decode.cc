@@ -7,8 +7,10 @@
 #include <cstdio>
 #include <fstream>
 
+#include <point_one/fusion_engine/messages/compact_pose.h>
 #include <point_one/fusion_engine/messages/core.h>
 #include <point_one/fusion_engine/messages/crc.h>
+#include <point_one/fusion_engine/messages/imu_batch.h>
 
 using namespace point_one::fusion_engine::messages;
 
@@ -39,7 +41,11 @@ bool DecodeMessage(std::ifstream& stream, size_t available_bytes) {
   buffer += sizeof(MessageHeader);
 
   // Read the message payload.
-  if (available_bytes < header.payload_size_bytes) {
+  if (sizeof(MessageHeader) + header.payload_size_bytes > sizeof(storage)) {
+    printf("Message too large. [%zu bytes > %zu bytes]\n",
+           sizeof(MessageHeader) + header.payload_size_bytes, sizeof(storage));
+    return false;
+  } else if (available_bytes < header.payload_size_bytes) {
     printf("Not enough data: cannot read payload. [%zu bytes < %u bytes]\n",
            available_bytes, header.payload_size_bytes);
     return false;
@@ -109,6 +115,27 @@ bool DecodeMessage(std::ifstream& stream, size_t available_bytes) {
     printf("    Aggregate: %.2f m\n", contents.aggregate_protection_level_m);
     printf("    Horizontal: %.2f m\n", contents.horizontal_protection_level_m);
     printf("    Vertical: %.2f m\n", contents.vertical_protection_level_m);
+  } else if (header.message_type == MessageType::COMPACT_POSE) {
+    auto& compact = *reinterpret_cast<CompactPoseMessage*>(buffer);
+    buffer += sizeof(compact);
+
+    PoseMessage contents;
+    FromCompactPose(compact, contents);
+
+    double p1_time_sec =
+        contents.p1_time.seconds + (contents.p1_time.fraction_ns * 1e-9);
+
+    printf("Received compact pose message @ P1 time %.3f seconds. "
+           "[sequence=%u, size=%zu B, presence=0x%02x]\n",
+           p1_time_sec, header.sequence_number, message_size,
+           compact.presence_mask);
+    printf("  Position (LLA): %.9f, %.9f, %.5f (deg, deg, m)\n",
+           contents.lla_deg[0], contents.lla_deg[1], contents.lla_deg[2]);
+    printf("  Attitude (YPR): %.2f, %.2f, %.2f (deg, deg, deg)\n",
+           contents.ypr_deg[0], contents.ypr_deg[1], contents.ypr_deg[2]);
+    printf("  Velocity (Body): %.2f, %.2f, %.2f (m/s, m/s, m/s)\n",
+           contents.velocity_body_mps[0], contents.velocity_body_mps[1],
+           contents.velocity_body_mps[2]);
   } else if (header.message_type == MessageType::GNSS_INFO) {
     auto& contents = *reinterpret_cast<GNSSInfoMessage*>(buffer);
     buffer += sizeof(contents);
@@ -157,6 +184,30 @@ bool DecodeMessage(std::ifstream& stream, size_t available_bytes) {
              sv.azimuth_deg);
       printf("    In solution: %s\n", sv.usage > 0 ? "yes" : "no");
     }
+  } else if (header.message_type == MessageType::IMU_MEASUREMENT_BATCH) {
+    IMUBatchView view(buffer, header.payload_size_bytes);
+    if (!view.IsValid()) {
+      printf("Invalid IMU batch message. [payload size=%u bytes]\n",
+             header.payload_size_bytes);
+      return false;
+    }
+
+    double p1_time_sec = view.GetBaseTime().seconds +
+                         (view.GetBaseTime().fraction_ns * 1e-9);
+
+    printf(
+        "Received IMU batch message @ P1 time %.3f seconds. [sequence=%u, "
+        "size=%zu B, %zu samples]\n",
+        p1_time_sec, header.sequence_number, message_size, view.size());
+
+    for (const IMUMeasurement& imu : view) {
+      p1_time_sec = imu.p1_time.seconds + (imu.p1_time.fraction_ns * 1e-9);
+      printf("  Sample @ P1 time %.3f seconds:\n", p1_time_sec);
+      printf("    Accel: %.2f, %.2f, %.2f (m/s^2, m/s^2, m/s^2)\n",
+             imu.accel_mps2[0], imu.accel_mps2[1], imu.accel_mps2[2]);
+      printf("    Gyro: %.3f, %.3f, %.3f (rad/s, rad/s, rad/s)\n",
+             imu.gyro_rps[0], imu.gyro_rps[1], imu.gyro_rps[2]);
+    }
   } else {
     printf("Ignoring message type %s. [%u bytes]\n",
            to_string(header.message_type).c_str(), header.payload_size_bytes);
@@ -0,0 +1,185 @@
+/**************************************************************************/ /**
+* @brief Message query example.
+* @file
+******************************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <point_one/fusion_engine/analysis/message_query.h>
+#include <point_one/fusion_engine/parsers/fusion_engine_framer.h>
+
+using namespace point_one::fusion_engine::analysis;
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::parsers;
+
+/**
+ * @brief Accumulate framed messages and evaluate the query in batches.
+ */
+class BatchEvaluator {
+ public:
+  static constexpr size_t BATCH_SIZE = 4096;
+
+  BatchEvaluator(const MessageQuery& query, bool print, std::ofstream* output)
+      : query_(query), print_(print), output_(output) {}
+
+  void Add(const MessageHeader& header, const void* payload,
+           uint64_t offset_bytes) {
+    // Reject message types that can never match before copying the message.
+    if (!query_.MayMatch(header.message_type)) {
+      return;
+    }
+
+    size_t size_bytes = sizeof(MessageHeader) + header.payload_size_bytes;
+    size_t arena_offset = arena_.size();
+    arena_.resize(arena_offset + size_bytes);
+    std::memcpy(&arena_[arena_offset], &header, sizeof(MessageHeader));
+    std::memcpy(&arena_[arena_offset + sizeof(MessageHeader)], payload,
+                header.payload_size_bytes);
+    arena_offsets_.push_back(arena_offset);
+    stream_offsets_.push_back(offset_bytes);
+
+    if (arena_offsets_.size() == BATCH_SIZE) {
+      Flush();
+    }
+  }
+
+  void Flush() {
+    size_t count = arena_offsets_.size();
+    pointers_.resize(count);
+    results_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      pointers_[i] = &arena_[arena_offsets_[i]];
+    }
+
+    num_matches_ += query_.Evaluate(pointers_.data(), count, results_.data());
+
+    for (size_t i = 0; i < count; ++i) {
+      if (!results_[i]) {
+        continue;
+      }
+
+      MessageHeader header;
+      std::memcpy(&header, pointers_[i], sizeof(header));
+      size_t size_bytes = sizeof(MessageHeader) + header.payload_size_bytes;
+      if (print_) {
+        printf("%s (%u): offset=%llu B, sequence=%u, size=%zu B\n",
+               to_string(header.message_type).c_str(),
+               static_cast<unsigned>(header.message_type),
+               static_cast<unsigned long long>(stream_offsets_[i]),
+               header.sequence_number, size_bytes);
+      }
+
+      if (output_ != nullptr) {
+        output_->write(reinterpret_cast<const char*>(pointers_[i]),
+                       size_bytes);
+      }
+    }
+
+    arena_.clear();
+    arena_offsets_.clear();
+    stream_offsets_.clear();
+  }
+
+  size_t GetNumMatches() const { return num_matches_; }
+
+ private:
+  const MessageQuery& query_;
+  bool print_;
+  std::ofstream* output_;
+
+  std::vector<uint8_t> arena_;
+  std::vector<size_t> arena_offsets_;
+  std::vector<uint64_t> stream_offsets_;
+  std::vector<const void*> pointers_;
+  std::vector<uint8_t> results_;
+  size_t num_matches_ = 0;
+};
+
+/******************************************************************************/
+int main(int argc, const char* argv[]) {
+  bool count_only = false;
+  const char* output_path = nullptr;
+  std::vector<const char*> positional;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--count") == 0) {
+      count_only = true;
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output_path = argv[++i];
+    } else {
+      positional.push_back(argv[i]);
+    }
+  }
+
+  if (positional.size() != 2) {
+    printf("Usage: %s [--count] [--output OUTPUT_FILE] FILE EXPRESSION\n",
+           argv[0]);
+    printf(R"EOF(
+Print the FusionEngine messages in a binary file that match a query expression.
+
+Options:
+  --count   Print only the number of matching messages.
+  --output  Write all matching messages to OUTPUT_FILE.
+
+Example:
+  %s data.p1log \
+    "type == POSE && solution_type == RTKFixed && horizontal_protection_level_m > 0.5"
+)EOF",
+           argv[0]);
+    return 0;
+  }
+
+  const char* path = positional[0];
+  const char* expression = positional[1];
+
+  // Compile the query.
+  MessageQuery query;
+  std::string error;
+  if (!query.Compile(expression, &error)) {
+    printf("Invalid query: %s\n", error.c_str());
+    return 1;
+  }
+
+  // Open the files.
+  std::ifstream stream(path, std::ifstream::binary);
+  if (!stream) {
+    printf("Error opening file '%s'.\n", path);
+    return 1;
+  }
+
+  std::ofstream output;
+  if (output_path != nullptr) {
+    output.open(output_path, std::ofstream::binary);
+    if (!output) {
+      printf("Error opening output file '%s'.\n", output_path);
+      return 1;
+    }
+  }
+
+  // Evaluate all messages in the file.
+  BatchEvaluator evaluator(query, !count_only,
+                           output_path != nullptr ? &output : nullptr);
+
+  FusionEngineFramer framer(65536);
+  framer.SetMessageCallback([&](const MessageHeader& header,
+                                const void* payload, uint64_t offset_bytes) {
+    evaluator.Add(header, payload, offset_bytes);
+  });
+
+  std::vector<char> buffer(1 << 20);
+  while (stream) {
+    stream.read(buffer.data(), buffer.size());
+    framer.OnData(buffer.data(), static_cast<size_t>(stream.gcount()));
+  }
+  evaluator.Flush();
+
+  printf("%zu matching messages (%llu total).\n", evaluator.GetNumMatches(),
+         static_cast<unsigned long long>(
+             framer.GetStatistics().messages_decoded));
+
+  return 0;
+}
@@ -0,0 +1,36 @@
+#!/usr/bin/env python3
+
+from argparse import ArgumentParser
+import os
+import sys
+
+root_dir = os.path.normpath(os.path.join(os.path.dirname(__file__), '..'))
+sys.path.append(root_dir)
+
+from fusion_engine_client.analysis.file_follower import FileFollower
+from fusion_engine_client.messages.core import *
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description="""\
+Print the contents of messages as they are written to a *.p1log file (e.g., by a recorder that is still running).
+""")
+    parser.add_argument('-s', '--from-start', action='store_true',
+                        help="Print the existing file contents before waiting for new messages.")
+    parser.add_argument('file', type=str, help="The path to a binary file to be followed.")
+    options = parser.parse_args()
+
+    with FileFollower(options.file, from_start=options.from_start) as follower:
+        try:
+            for header, contents in follower.follow():
+                if contents is None:
+                    print('Decoded %s message [sequence=%d, size=%d B]' %
+                          (header.get_type_string(), header.sequence_number,
+                           header.calcsize() + header.payload_size_bytes))
+                else:
+                    parts = str(contents).split('\n')
+                    parts[0] += ' [sequence=%d, size=%d B]' % (header.sequence_number,
+                                                               header.calcsize() + header.payload_size_bytes)
+                    print('\n'.join(parts))
+        except KeyboardInterrupt:
+            pass
@@ -32,12 +32,18 @@ def decode_message(header, data, offset):
     if header.message_type == PoseMessage.MESSAGE_TYPE:
         contents = PoseMessage()
         contents.unpack(buffer=data, offset=offset)
+    elif header.message_type == CompactPoseMessage.MESSAGE_TYPE:
+        contents = CompactPoseMessage()
+        contents.unpack(buffer=data, offset=offset)
     elif header.message_type == GNSSInfoMessage.MESSAGE_TYPE:
         contents = GNSSInfoMessage()
         contents.unpack(buffer=data, offset=offset)
     elif header.message_type == GNSSSatelliteMessage.MESSAGE_TYPE:
         contents = GNSSSatelliteMessage()
         contents.unpack(buffer=data, offset=offset)
+    elif header.message_type == IMUMeasurementBatch.MESSAGE_TYPE:
+        contents = IMUMeasurementBatch()
+        contents.unpack(buffer=data, offset=offset)
     elif header.message_type == ros.PoseMessage.MESSAGE_TYPE:
         contents = ros.PoseMessage()
         contents.unpack(buffer=data, offset=offset)
@@ -459,6 +459,9 @@ Load and display information stored in a FusionEngine binary file.
     parser.add_argument('--absolute-time', '--abs', action='store_true',
                         help="Interpret the timestamps in --time as absolute P1 times. Otherwise, treat them as "
                              "relative to the first message in the file.")
+    parser.add_argument('--cache', action='store_true',
+                        help="Store decoded data in a persistent cache (~/.cache/fusion_engine by default, or "
+                             "P1_CACHE_DIR if set) to speed up subsequent runs on the same file.")
     parser.add_argument('--imu', action='store_true',
                         help="Plot IMU data (slow).")
     parser.add_argument('--mapbox-token', metavar='TOKEN',
@@ -541,7 +544,8 @@ Load and display information stored in a FusionEngine binary file.
         sys.exit(1)
 
     # Read pose data from the file.
-    analyzer = Analyzer(file=input_path, output_dir=output_dir,
+    reader = FileReader(input_path, cache=options.cache)
+    analyzer = Analyzer(file=reader, output_dir=output_dir,
                         prefix=options.prefix + '.' if options.prefix is not None else '',
                         time_range=time_range, absolute_time=options.absolute_time)
 
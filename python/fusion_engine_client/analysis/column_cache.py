@@ -0,0 +1,353 @@
+from typing import Dict, Optional
+
+import hashlib
+import json
+import logging
+import os
+import re
+import shutil
+import tempfile
+
+import numpy as np
+
+
+class ColumnCache(object):
+    """!
+    @brief Persistent cache of decoded message data, stored outside the log directory.
+
+    When a log is decoded, the numpy arrays generated for each message type (see
+    @ref fusion_engine_client.analysis.file_reader.MessageData.to_numpy() "MessageData.to_numpy()") are stored as
+    individual `.npy` files in a cache directory, along with the file index. When the same log is opened again, the
+    arrays are memory-mapped directly from the cache instead of re-parsing the log.
+
+    Cache entries are keyed by a fingerprint computed from the log's size, modification time, and a hash of blocks
+    sampled throughout the file, so a modified log will never use stale data. When the total cache size exceeds
+    `max_size_bytes`, the least recently used entries are deleted.
+
+    The cache is structured as follows:
+    ```
+    <cache_dir>/
+      <fingerprint>/
+        meta.json        # Source path, t0, and the columns available for each message type
+        index.npy        # File index (see FileIndex)
+        segments.npy     # P1 time segment table (see FileIndex.detect_segments())
+        <message_type>/
+          <column>.npy
+    ```
+    """
+    logger = logging.getLogger('point_one.fusion_engine.analysis.column_cache')
+
+    VERSION = 1
+
+    DEFAULT_MAX_SIZE_BYTES = 2 * 1024 ** 3
+
+    # Number and size of the blocks sampled from the file when computing a fingerprint. The first and last blocks are
+    # always included.
+    _FINGERPRINT_NUM_BLOCKS = 16
+    _FINGERPRINT_BLOCK_SIZE = 64 * 1024
+
+    # Entry directory names: the hexadecimal digest generated by fingerprint(). Other directories are never
+    # considered part of the cache, since the cache directory may be shared.
+    _FINGERPRINT_PATTERN = re.compile(r'^[0-9a-f]{32}$')
+
+    _META_FILE = 'meta.json'
+    _INDEX_FILE = 'index.npy'
+    _SEGMENTS_FILE = 'segments.npy'
+
+    def __init__(self, cache_dir: str = None, max_size_bytes: int = DEFAULT_MAX_SIZE_BYTES):
+        """!
+        @brief Create a cache instance.
+
+        @param cache_dir The directory in which cached data will be stored. If `None`, use the directory specified by
+               the `P1_CACHE_DIR` environment variable, or `~/.cache/fusion_engine` by default.
+        @param max_size_bytes The maximum total size of all cache entries.
+        """
+        if cache_dir is None:
+            cache_dir = self.get_default_dir()
+
+        self.cache_dir = cache_dir
+        self.max_size_bytes = max_size_bytes
+
+    @classmethod
+    def get_default_dir(cls):
+        cache_dir = os.environ.get('P1_CACHE_DIR', None)
+        if cache_dir is None:
+            cache_dir = os.path.join(os.environ.get('XDG_CACHE_HOME', os.path.expanduser('~/.cache')), 'fusion_engine')
+        return cache_dir
+
+    @classmethod
+    def fingerprint(cls, path: str) -> str:
+        """!
+        @brief Compute the cache key for a file.
+
+        @param path The path to the file.
+
+        @return A hexadecimal fingerprint string.
+        """
+        stat = os.stat(path)
+        file_size = stat.st_size
+
+        hash = hashlib.blake2b(digest_size=16)
+        hash.update(('%d:%d:%d:' % (cls.VERSION, file_size, stat.st_mtime_ns)).encode('utf-8'))
+
+        with open(path, 'rb') as f:
+            if file_size <= cls._FINGERPRINT_NUM_BLOCKS * cls._FINGERPRINT_BLOCK_SIZE:
+                hash.update(f.read())
+            else:
+                last_offset = file_size - cls._FINGERPRINT_BLOCK_SIZE
+                for i in range(cls._FINGERPRINT_NUM_BLOCKS):
+                    f.seek(last_offset * i // (cls._FINGERPRINT_NUM_BLOCKS - 1))
+                    hash.update(f.read(cls._FINGERPRINT_BLOCK_SIZE))
+
+        return hash.hexdigest()
+
+    def get_entry_dir(self, fingerprint: str) -> str:
+        return os.path.join(self.cache_dir, fingerprint)
+
+    def load_metadata(self, fingerprint: str) -> Optional[dict]:
+        """!
+        @brief Load the metadata for a cache entry, and mark the entry as recently used.
+
+        @param fingerprint The cache key returned by @ref fingerprint().
+
+        @return The metadata `dict`, or `None` if the entry does not exist.
+        """
+        meta_path = os.path.join(self.get_entry_dir(fingerprint), self._META_FILE)
+        try:
+            with open(meta_path, 'r') as f:
+                meta = json.load(f)
+        except (OSError, ValueError):
+            return None
+
+        if meta.get('version', None) != self.VERSION:
+            return None
+
+        # The metadata file's modification time is used to track LRU order.
+        try:
+            os.utime(meta_path)
+        except OSError:
+            pass
+
+        return meta
+
+    def update_metadata(self, fingerprint: str, source_path: str = None, **kwargs):
+        """!
+        @brief Update (or create) the metadata for a cache entry.
+
+        @param fingerprint The cache key returned by @ref fingerprint().
+        @param source_path The path to the source file.
+        @param kwargs Additional metadata values to be stored.
+        """
+        entry_dir = self.get_entry_dir(fingerprint)
+        os.makedirs(entry_dir, exist_ok=True)
+
+        meta = self.load_metadata(fingerprint)
+        if meta is None:
+            meta = {'version': self.VERSION, 'types': {}}
+
+        if source_path is not None:
+            meta['path'] = os.path.abspath(source_path)
+        meta.update(kwargs)
+
+        self._write_atomic(os.path.join(entry_dir, self._META_FILE),
+                           lambda f: f.write(json.dumps(meta, indent=2).encode('utf-8')))
+        return meta
+
+    def load_index(self, fingerprint: str) -> Optional[np.ndarray]:
+        """!
+        @brief Load the file index for a cache entry.
+
+        @param fingerprint The cache key returned by @ref fingerprint().
+
+        @return The index data in @ref fusion_engine_client.analysis.file_reader.FileIndex.RAW_DTYPE "raw format", or
+                `None` if not cached.
+        """
+        try:
+            return np.load(os.path.join(self.get_entry_dir(fingerprint), self._INDEX_FILE), mmap_mode='r')
+        except (OSError, ValueError):
+            return None
+
+    def save_index(self, fingerprint: str, raw_index: np.ndarray):
+        """!
+        @brief Store the file index for a cache entry.
+
+        @param fingerprint The cache key returned by @ref fingerprint().
+        @param raw_index The index data in @ref fusion_engine_client.analysis.file_reader.FileIndex.RAW_DTYPE
+               "raw format".
+        """
+        entry_dir = self.get_entry_dir(fingerprint)
+        os.makedirs(entry_dir, exist_ok=True)
+        self._write_atomic(os.path.join(entry_dir, self._INDEX_FILE), lambda f: np.save(f, raw_index))
+
+        # Make sure the entry has a metadata file so it can be found (and evicted) later.
+        if self.load_metadata(fingerprint) is None:
+            self.update_metadata(fingerprint)
+
+        self.evict(keep=fingerprint)
+
+    def load_segments(self, fingerprint: str) -> Optional[np.ndarray]:
+        """!
+        @brief Load the P1 time segment table for a cache entry.
+
+        @param fingerprint The cache key returned by @ref fingerprint().
+
+        @return The segment table in
+                @ref fusion_engine_client.analysis.file_reader.FileIndex.SEGMENT_RAW_DTYPE "raw format", or `None` if
+                not cached.
+        """
+        try:
+            return np.load(os.path.join(self.get_entry_dir(fingerprint), self._SEGMENTS_FILE))
+        except (OSError, ValueError):
+            return None
+
+    def save_segments(self, fingerprint: str, raw_segments: np.ndarray):
+        """!
+        @brief Store the P1 time segment table for a cache entry.
+
+        @param fingerprint The cache key returned by @ref fingerprint().
+        @param raw_segments The segment table in
+               @ref fusion_engine_client.analysis.file_reader.FileIndex.SEGMENT_RAW_DTYPE "raw format".
+        """
+        entry_dir = self.get_entry_dir(fingerprint)
+        os.makedirs(entry_dir, exist_ok=True)
+        self._write_atomic(os.path.join(entry_dir, self._SEGMENTS_FILE), lambda f: np.save(f, raw_segments))
+
+    def load_columns(self, fingerprint: str, message_type: int,
+                     meta: dict = None) -> Optional[Dict[str, np.ndarray]]:
+        """!
+        @brief Load the cached numpy data for a message type.
+
+        The returned arrays are read-only and memory-mapped from the cache files.
+
+        @param fingerprint The cache key returned by @ref fingerprint().
+        @param message_type The desired message type.
+        @param meta The entry metadata, if already loaded.
+
+        @return A `dict` of arrays, or `None` if not cached.
+        """
+        if meta is None:
+            meta = self.load_metadata(fingerprint)
+            if meta is None:
+                return None
+
+        columns = meta['types'].get(str(int(message_type)), None)
+        if columns is None:
+            return None
+
+        type_dir = os.path.join(self.get_entry_dir(fingerprint), str(int(message_type)))
+        result = {}
+        try:
+            for name in columns:
+                result[name] = np.load(os.path.join(type_dir, name + '.npy'), mmap_mode='r')
+        except (OSError, ValueError) as e:
+            self.logger.debug('Error loading cached data for message type %d: %s' % (int(message_type), repr(e)))
+            return None
+
+        return result
+
+    def save_columns(self, fingerprint: str, message_type: int, columns: Dict[str, np.ndarray]) -> bool:
+        """!
+        @brief Store numpy data for a message type.
+
+        @param fingerprint The cache key returned by @ref fingerprint().
+        @param message_type The message type.
+        @param columns A `dict` of numeric numpy arrays.
+
+        @return `True` if the data was stored, or `False` if it contains values that cannot be cached.
+        """
+        for value in columns.values():
+            if not isinstance(value, np.ndarray) or value.dtype.kind not in 'biuf':
+                return False
+
+        type_dir = os.path.join(self.get_entry_dir(fingerprint), str(int(message_type)))
+        os.makedirs(type_dir, exist_ok=True)
+        for name, value in columns.items():
+            self._write_atomic(os.path.join(type_dir, name + '.npy'), lambda f: np.save(f, value))
+
+        # Note: The metadata is updated last so a partially written entry is never used.
+        meta = self.load_metadata(fingerprint)
+        types = meta['types'] if meta is not None else {}
+        types[str(int(message_type))] = list(columns.keys())
+        self.update_metadata(fingerprint, types=types)
+
+        self.evict(keep=fingerprint)
+        return True
+
+    def get_size_bytes(self) -> int:
+        """!
+        @brief Get the total size of all cache entries.
+        """
+        return sum(size for _, _, size in self._list_entries())
+
+    def evict(self, keep: str = None):
+        """!
+        @brief Delete the least recently used entries until the cache size is below the limit.
+
+        @param keep An entry that should not be deleted (e.g., the entry currently in use).
+        """
+        entries = self._list_entries()
+        total_size = sum(size for _, _, size in entries)
+        for fingerprint, _, size in sorted(entries, key=lambda e: e[1]):
+            if total_size <= self.max_size_bytes:
+                break
+            elif fingerprint == keep:
+                continue
+
+            self.logger.debug('Evicting cache entry %s. [size=%d B]' % (fingerprint, size))
+            shutil.rmtree(self.get_entry_dir(fingerprint), ignore_errors=True)
+            total_size -= size
+
+    def clear(self):
+        """!
+        @brief Delete all cache entries.
+        """
+        for fingerprint, _, _ in self._list_entries():
+            shutil.rmtree(self.get_entry_dir(fingerprint), ignore_errors=True)
+
+    def _list_entries(self):
+        """!
+        @brief List all entries as (fingerprint, last use time, size in bytes) tuples.
+
+        Only directories named with a fingerprint and containing a metadata file are considered cache entries.
+        """
+        entries = []
+        if not os.path.isdir(self.cache_dir):
+            return entries
+
+        for fingerprint in os.listdir(self.cache_dir):
+            if not self._FINGERPRINT_PATTERN.match(fingerprint):
+                continue
+
+            entry_dir = self.get_entry_dir(fingerprint)
+            try:
+                last_used = os.path.getmtime(os.path.join(entry_dir, self._META_FILE))
+            except OSError:
+                continue
+
+            size = 0
+            for dir_path, _, file_names in os.walk(entry_dir):
+                for file_name in file_names:
+                    try:
+                        size += os.path.getsize(os.path.join(dir_path, file_name))
+                    except OSError:
+                        pass
+
+            entries.append((fingerprint, last_used, size))
+
+        return entries
+
+    @classmethod
+    def _write_atomic(cls, path, write_func):
+        # Write to a temporary file and then rename it so readers never see a partially written file.
+        fd, temp_path = tempfile.mkstemp(dir=os.path.dirname(path), prefix='.tmp')
+        try:
+            with os.fdopen(fd, 'wb') as f:
+                write_func(f)
+            os.replace(temp_path, path)
+        except BaseException:
+            # Clean up without hiding the original error.
+            try:
+                os.remove(temp_path)
+            except OSError:
+                pass
+            raise
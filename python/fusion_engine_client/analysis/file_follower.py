@@ -0,0 +1,385 @@
+from typing import List, Optional, Tuple, Union
+
+import ctypes
+import ctypes.util
+import errno
+import logging
+import os
+import select
+import struct
+import sys
+import time
+
+from ..messages import *
+
+
+class _Inotify(object):
+    """!
+    @brief Minimal wrapper around the Linux inotify API.
+    """
+    IN_MODIFY = 0x00000002
+    IN_ATTRIB = 0x00000004
+    IN_MOVED_TO = 0x00000080
+    IN_CREATE = 0x00000100
+    IN_DELETE_SELF = 0x00000400
+    IN_MOVE_SELF = 0x00000800
+    IN_Q_OVERFLOW = 0x00004000
+    IN_IGNORED = 0x00008000
+
+    _IN_CLOEXEC = 0o2000000
+    _IN_NONBLOCK = 0o4000
+
+    _EVENT_FORMAT = 'iIII'
+    _EVENT_SIZE = struct.calcsize(_EVENT_FORMAT)
+
+    def __init__(self):
+        if not sys.platform.startswith('linux'):
+            raise OSError(errno.ENOSYS, 'inotify is only supported on Linux.')
+
+        libc = ctypes.CDLL(ctypes.util.find_library('c'), use_errno=True)
+        self._add_watch = libc.inotify_add_watch
+        self._add_watch.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.c_uint32]
+        self._add_watch.restype = ctypes.c_int
+        self._rm_watch = libc.inotify_rm_watch
+        self._rm_watch.argtypes = [ctypes.c_int, ctypes.c_int]
+        self._rm_watch.restype = ctypes.c_int
+
+        self.fd = libc.inotify_init1(self._IN_NONBLOCK | self._IN_CLOEXEC)
+        if self.fd < 0:
+            error = ctypes.get_errno()
+            raise OSError(error, os.strerror(error))
+
+    def close(self):
+        if self.fd >= 0:
+            os.close(self.fd)
+            self.fd = -1
+
+    def add_watch(self, path: str, mask: int) -> int:
+        wd = self._add_watch(self.fd, os.fsencode(path), mask)
+        if wd < 0:
+            error = ctypes.get_errno()
+            raise OSError(error, os.strerror(error), path)
+        return wd
+
+    def remove_watch(self, wd: int):
+        # Note: The watch is removed automatically if the file was deleted, in which case this will fail.
+        self._rm_watch(self.fd, wd)
+
+    def wait(self, timeout_sec: float = None) -> bool:
+        readable, _, _ = select.select([self.fd], [], [], timeout_sec)
+        return len(readable) > 0
+
+    def read_events(self) -> List[Tuple[int, int, str]]:
+        events = []
+        while True:
+            try:
+                buffer = os.read(self.fd, 4096)
+            except BlockingIOError:
+                break
+
+            offset = 0
+            while offset + self._EVENT_SIZE <= len(buffer):
+                wd, mask, _, name_length = struct.unpack_from(self._EVENT_FORMAT, buffer, offset)
+                offset += self._EVENT_SIZE
+                name = os.fsdecode(buffer[offset:offset + name_length].rstrip(b'\0'))
+                offset += name_length
+                events.append((wd, mask, name))
+        return events
+
+
+class FileFollower(object):
+    """!
+    @brief Decode messages from a FusionEngine binary file while it is being written (similar to `tail -F`).
+
+    On Linux, the follower uses inotify to sleep until new data is appended to the file, so it uses no CPU while the
+    file is idle and new messages are typically decoded within a few milliseconds of being written. On other platforms,
+    or if inotify is not available, the file is polled every `poll_interval_sec` seconds instead.
+
+    If the end of the file contains an incomplete message, the partial data is held until the remainder is written.
+    The follower also handles the following conditions:
+    - Truncation: If the file becomes smaller than the current read position, decoding restarts from the beginning of
+      the file.
+    - Rotation: If the file is renamed or deleted and a new file is created at the same path, the rest of the old file
+      is decoded and then the new file is decoded from the beginning.
+    - Invalid data: If the data does not contain a valid message (e.g., if following started in the middle of a
+      message), bytes are skipped until the next valid message is found.
+
+    ```{.py}
+    with FileFollower('/path/to/data.p1log', message_types=[PoseMessage]) as follower:
+        for header, message in follower.follow():
+            print(message)
+    ```
+    """
+    logger = logging.getLogger('point_one.fusion_engine.analysis.file_follower')
+
+    _READ_SIZE_BYTES = 64 * 1024
+
+    _FILE_EVENTS = _Inotify.IN_MODIFY | _Inotify.IN_ATTRIB | _Inotify.IN_MOVE_SELF | _Inotify.IN_DELETE_SELF
+    _DIRECTORY_EVENTS = _Inotify.IN_CREATE | _Inotify.IN_MOVED_TO
+
+    def __init__(self, path: str, message_types: Union[list, tuple] = None, from_start: bool = True,
+                 poll_interval_sec: float = 0.1, use_inotify: bool = True):
+        """!
+        @brief Start following a file.
+
+        @param path The path to the file. If the file does not exist yet, the follower will wait for it to be created.
+        @param message_types A list of one or more @ref fusion_engine_client.messages.defs.MessageType "MessageTypes"
+               or message classes to be returned. If `None` or an empty list, return all messages. Messages without a
+               Python message class are returned with a `None` message.
+        @param from_start If `True`, decode the existing file contents. Otherwise, start at the current end of the file.
+        @param poll_interval_sec The interval at which the file is checked for changes when inotify is not available.
+        @param use_inotify If `True`, use inotify when available.
+        """
+        self.path = os.path.abspath(path)
+
+        if message_types is None or len(message_types) == 0:
+            self.message_types = None
+        else:
+            self.message_types = set([(t if isinstance(t, MessageType) else t.MESSAGE_TYPE) for t in message_types])
+
+        self.poll_interval_sec = poll_interval_sec
+
+        ## The number of messages returned.
+        self.num_messages = 0
+        ## The number of bytes skipped because they did not contain a valid message.
+        self.num_skipped_bytes = 0
+        ## The number of messages skipped because their payload could not be decoded.
+        self.num_skipped_messages = 0
+        ## The number of times the file was truncated.
+        self.num_truncations = 0
+        ## The number of times the file was replaced by a new file.
+        self.num_rotations = 0
+
+        self._file = None
+        self._inode = None
+        self._read_offset = 0
+        self._buffer = bytearray()
+        self._pending = []
+
+        self._inotify = None
+        self._file_wd = None
+        self._directory_wd = None
+        if use_inotify:
+            try:
+                self._inotify = _Inotify()
+                self._directory_wd = self._inotify.add_watch(os.path.dirname(self.path), self._DIRECTORY_EVENTS)
+            except (OSError, AttributeError) as e:
+                self.logger.debug('inotify not available. Polling for changes. [%s]' % repr(e))
+                if self._inotify is not None:
+                    self._inotify.close()
+                    self._inotify = None
+
+        # Note: The file watch is added before reading any data so we cannot miss a write. If the writer is in the
+        # middle of a message when starting at the end of the file, the rest of that message will be skipped.
+        if self._open_file() and not from_start:
+            self._read_offset = os.fstat(self._file.fileno()).st_size
+            self._file.seek(self._read_offset)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    def close(self):
+        """!
+        @brief Stop following the file.
+        """
+        self._close_file()
+        if self._inotify is not None:
+            self._inotify.close()
+            self._inotify = None
+
+    def read(self, timeout_sec: float = None) -> List[Tuple[MessageHeader, Optional[MessagePayload]]]:
+        """!
+        @brief Wait for one or more new messages.
+
+        @param timeout_sec The maximum amount of time to wait (in seconds), or `None` to wait indefinitely.
+
+        @return A list of `(header, message)` tuples, in file order. The list will be empty if no messages arrived
+                before the timeout.
+        """
+        deadline = None if timeout_sec is None else (time.monotonic() + timeout_sec)
+        while True:
+            self._update()
+            if len(self._pending) > 0:
+                messages = self._pending
+                self._pending = []
+                self.num_messages += len(messages)
+                return messages
+
+            remaining_sec = None if deadline is None else (deadline - time.monotonic())
+            if remaining_sec is not None and remaining_sec <= 0.0:
+                return []
+            self._wait(remaining_sec)
+
+    def follow(self, timeout_sec: float = None):
+        """!
+        @brief Generate messages as they are written to the file.
+
+        @param timeout_sec If set, stop if no new messages arrive for the specified amount of time (in seconds).
+               Otherwise, continue indefinitely.
+
+        @return A generator of `(header, message)` tuples.
+        """
+        while True:
+            messages = self.read(timeout_sec=timeout_sec)
+            if len(messages) == 0:
+                return
+            yield from messages
+
+    def _wait(self, timeout_sec: float = None):
+        if self._inotify is not None:
+            # If the file does not exist yet, we rely on the directory watch to tell us when it is created.
+            if self._inotify.wait(timeout_sec):
+                self._handle_events(self._inotify.read_events())
+        else:
+            time.sleep(self.poll_interval_sec if timeout_sec is None else min(self.poll_interval_sec, timeout_sec))
+
+    def _handle_events(self, events):
+        for wd, mask, name in events:
+            if mask & _Inotify.IN_Q_OVERFLOW:
+                self.logger.debug('inotify event queue overflowed.')
+            elif wd == self._file_wd and mask & _Inotify.IN_IGNORED:
+                # The file was deleted and the watch was removed by the kernel.
+                self._file_wd = None
+
+    def _update(self):
+        # Read any new data from the current file, then check if the file was replaced (rotated). If so, switch to the
+        # new file only after the old one is exhausted, since the writer may still have been appending to it.
+        if self._file is None:
+            self._open_file()
+        if self._file is None:
+            return
+
+        if not self._read_available():
+            return
+
+        try:
+            inode = os.stat(self.path).st_ino
+        except OSError:
+            inode = None
+
+        if inode is not None and inode != self._inode:
+            self.logger.debug("File '%s' was replaced. Following new file." % self.path)
+            self._discard_partial_message()
+            self._close_file()
+            self.num_rotations += 1
+            if self._open_file():
+                self._read_available()
+
+    def _open_file(self) -> bool:
+        try:
+            file = open(self.path, 'rb')
+        except OSError:
+            return False
+
+        self._file = file
+        self._inode = os.fstat(file.fileno()).st_ino
+        self._read_offset = 0
+        self._buffer = bytearray()
+        if self._inotify is not None:
+            try:
+                self._file_wd = self._inotify.add_watch(self.path, self._FILE_EVENTS)
+            except OSError:
+                # The file may have been removed already. The next update will pick up its replacement.
+                self._file_wd = None
+        return True
+
+    def _close_file(self):
+        if self._file is not None:
+            self._file.close()
+            self._file = None
+        if self._file_wd is not None:
+            self._inotify.remove_watch(self._file_wd)
+            self._file_wd = None
+
+    def _read_available(self) -> bool:
+        # If the file shrank, it was truncated (e.g., by a recorder restarting the log in place).
+        file_size = os.fstat(self._file.fileno()).st_size
+        if file_size < self._read_offset:
+            self.logger.debug("File '%s' truncated from %d to %d bytes. Restarting from the beginning." %
+                              (self.path, self._read_offset, file_size))
+            self.num_truncations += 1
+            self._buffer = bytearray()
+            self._read_offset = 0
+            self._file.seek(0)
+
+        # Decode one chunk at a time, and stop as soon as messages are ready to be returned so a large existing file is
+        # not decoded all at once. Returns `True` if the end of the file was reached.
+        while True:
+            data = self._file.read(self._READ_SIZE_BYTES)
+            if not data:
+                return True
+            self._read_offset += len(data)
+            self._buffer += data
+            self._decode()
+            if len(self._pending) > 0:
+                return False
+
+    def _discard_partial_message(self):
+        if len(self._buffer) > 0:
+            self.logger.debug('Discarding %d bytes of incomplete data at end of file.' % len(self._buffer))
+            self.num_skipped_bytes += len(self._buffer)
+            self._buffer = bytearray()
+
+    def _decode(self):
+        HEADER_SIZE = MessageHeader.calcsize()
+        SYNC = bytes((MessageHeader._SYNC0, MessageHeader._SYNC1))
+
+        buffer = self._buffer
+        offset = 0
+        while True:
+            # Find the start of the next message.
+            sync_offset = buffer.find(SYNC, offset)
+            if sync_offset < 0:
+                # Keep the last byte in case it is the first sync byte.
+                end_offset = len(buffer) - 1 if buffer.endswith(SYNC[:1]) else len(buffer)
+                self.num_skipped_bytes += end_offset - offset
+                offset = end_offset
+                break
+            self.num_skipped_bytes += sync_offset - offset
+            offset = sync_offset
+
+            # Wait for the rest of the message.
+            if len(buffer) - offset < HEADER_SIZE:
+                break
+
+            header = MessageHeader()
+            header.unpack(buffer=buffer, offset=offset, warn_on_unrecognized=False)
+            message_size_bytes = HEADER_SIZE + header.payload_size_bytes
+            if header.payload_size_bytes <= MessageHeader._MAX_EXPECTED_SIZE_BYTES and \
+                    len(buffer) - offset < message_size_bytes:
+                break
+
+            try:
+                header.validate_crc(buffer, offset)
+            except ValueError as e:
+                self.logger.debug('Skipping invalid data @ %d: %s' %
+                                  (self._read_offset - len(buffer) + offset, repr(e)))
+                self.num_skipped_bytes += 1
+                offset += 1
+                continue
+
+            if self.message_types is None or header.message_type in self.message_types:
+                cls = message_type_to_class.get(header.message_type, None)
+                if cls is not None:
+                    try:
+                        contents = cls()
+                        contents.unpack(buffer=buffer, offset=offset + HEADER_SIZE)
+                    except Exception as e:
+                        # The CRC passed, so the message is framed correctly and only this payload is skipped (e.g.,
+                        # a version mismatch).
+                        self.logger.warning('Error decoding %s payload @ %d: %s' %
+                                            (header.get_type_string(), self._read_offset - len(buffer) + offset,
+                                             repr(e)))
+                        self.num_skipped_messages += 1
+                        offset += message_size_bytes
+                        continue
+                else:
+                    contents = None
+                self._pending.append((header, contents))
+
+            offset += message_size_bytes
+
+        del buffer[:offset]
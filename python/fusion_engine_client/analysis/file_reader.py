@@ -1,4 +1,4 @@
-from typing import Dict, Tuple, Union
+from typing import Dict, Optional, Tuple, Union
 
 from collections import deque
 from datetime import datetime
@@ -9,6 +9,8 @@ import os
 import numpy as np
 
 from ..messages import *
+from .column_cache import ColumnCache
+from .file_follower import FileFollower
 
 
 class MessageData(object):
@@ -54,32 +56,44 @@ class MessageData(object):
             if do_conversion:
                 self.__dict__.update(self.message_class.to_numpy(self.messages))
 
-                if remove_nan_times and 'p1_time' in self.__dict__:
-                    is_nan = np.isnan(self.p1_time)
-                    if np.any(is_nan):
-                        keep_idx = ~is_nan
-                        for key, value in self.__dict__.items():
-                            if (key not in ('message_type', 'message_class', 'params', 'messages') and
-                                isinstance(value, np.ndarray)):
-                                if len(value.shape) == 1:
-                                    self.__dict__[key] = value[keep_idx]
-                                elif len(value.shape) == 2:
-                                    if value.shape[0] == len(is_nan):
-                                        # Assuming first dimension is time.
-                                        self.__dict__[key] = value[keep_idx, :]
-                                    elif value.shape[1] == len(is_nan):
-                                        # Assuming second dimension is time.
-                                        self.__dict__[key] = value[:, keep_idx]
-                                    else:
-                                        # Unrecognized data shape.
-                                        pass
-                                else:
-                                    # Unrecognized data shape.
-                                    pass
+                if remove_nan_times:
+                    self._remove_nan_times()
         else:
             raise ValueError('Message type %s does not support numpy conversion.' %
                              MessageType.get_type_string(self.message_type))
 
+    def _remove_nan_times(self):
+        if 'p1_time' in self.__dict__:
+            is_nan = np.isnan(self.p1_time)
+            if np.any(is_nan):
+                self._select(~is_nan)
+
+    def _select(self, keep_idx: np.ndarray):
+        """!
+        @brief Keep only the specified entries in each numpy array.
+
+        @param keep_idx A boolean array, with one element for each time epoch.
+        """
+        num_entries = len(keep_idx)
+        for key, value in self.__dict__.items():
+            if (key not in ('message_type', 'message_class', 'params', 'messages') and
+                isinstance(value, np.ndarray)):
+                if len(value.shape) == 1:
+                    self.__dict__[key] = value[keep_idx]
+                elif len(value.shape) == 2:
+                    if value.shape[0] == num_entries:
+                        # Assuming first dimension is time.
+                        self.__dict__[key] = value[keep_idx, :]
+                    elif value.shape[1] == num_entries:
+                        # Assuming second dimension is time.
+                        self.__dict__[key] = value[:, keep_idx]
+                    else:
+                        # Unrecognized data shape.
+                        pass
+                else:
+                    # Unrecognized data shape.
+                    pass
+
 
 class FileIndex(object):
     # Note: To reduce the index file size, we've made the following limitations:
@@ -89,6 +103,16 @@ class FileIndex(object):
 
     DTYPE = np.dtype([('time', '<f8'), ('type', '<u2'), ('offset', '<u8')])
 
+    # Segments of continuous P1 time, stored in a separate `.p1s` file. Each segment contains the index entries
+    # [start, end). See detect_segments().
+    SEGMENT_RAW_DTYPE = np.dtype([('start', '<u8'), ('end', '<u8')])
+
+    SEGMENT_DTYPE = np.dtype([('start', '<u8'), ('end', '<u8'), ('start_time', '<f8'), ('end_time', '<f8')])
+
+    # The minimum decrease in P1 time (in seconds) between consecutive index entries that is treated as a time reset
+    # (e.g., a device reboot). Smaller decreases are treated as out-of-order messages.
+    TIME_RESET_THRESHOLD_SEC = 2.0
+
     @classmethod
     def load(cls, index_path):
         raw_data = np.fromfile(index_path, dtype=cls.RAW_DTYPE)
@@ -115,6 +139,151 @@ class FileIndex(object):
     def get_path(cls, data_path):
         return os.path.splitext(data_path)[0] + '.p1i'
 
+    @classmethod
+    def get_segment_path(cls, data_path):
+        return os.path.splitext(data_path)[0] + '.p1s'
+
+    @classmethod
+    def detect_segments(cls, data: np.ndarray, reset_indices: Union[np.ndarray, list] = None) -> np.ndarray:
+        """!
+        @brief Split the index into segments of continuous P1 time.
+
+        P1 time restarts when a device reboots, so a log spanning several power cycles contains more than one
+        timeline. A new segment starts at each entry whose time is more than @ref TIME_RESET_THRESHOLD_SEC earlier
+        than the previous entry with a valid time, and at each entry in `reset_indices`.
+
+        @param data The index data in @ref DTYPE format.
+        @param reset_indices An optional list of additional entry indices at which a new segment starts (e.g., where
+               message sequence numbers were reset).
+
+        @return The segment table in @ref SEGMENT_DTYPE format.
+        """
+        # Note: The index record fields are not aligned. Copying the times is significantly faster than operating on
+        # them in place for large indexes.
+        time = np.ascontiguousarray(data['time'])
+        num_entries = len(time)
+
+        # Compare each valid time with the most recent valid time before it.
+        valid = ~np.isnan(time)
+        last_valid_idx = np.maximum.accumulate(np.where(valid, np.arange(num_entries), -1))
+        prev_valid_idx = np.concatenate(([-1], last_valid_idx[:-1])) if num_entries > 0 else last_valid_idx
+        has_prev = prev_valid_idx >= 0
+        is_reset = np.full(num_entries, False)
+        is_reset[has_prev] = (time[has_prev] < time[prev_valid_idx[has_prev]] - cls.TIME_RESET_THRESHOLD_SEC)
+
+        if reset_indices is not None and len(reset_indices) > 0:
+            is_reset[np.asarray(reset_indices, dtype=int)] = True
+
+        if num_entries > 0:
+            is_reset[0] = True
+        starts = np.flatnonzero(is_reset)
+        ends = np.append(starts[1:], num_entries)
+        return cls._make_segments(data, starts, ends)
+
+    @classmethod
+    def load_segments(cls, segment_path, data: np.ndarray) -> Optional[np.ndarray]:
+        """!
+        @brief Load a segment table file.
+
+        @param segment_path The path to the segment table file.
+        @param data The corresponding index data in @ref DTYPE format.
+
+        @return The segment table in @ref SEGMENT_DTYPE format, or `None` if the file does not exist or does not match
+                the index.
+        """
+        try:
+            raw_segments = np.fromfile(segment_path, dtype=cls.SEGMENT_RAW_DTYPE)
+        except (OSError, ValueError):
+            return None
+
+        return cls._segments_from_raw(raw_segments, data)
+
+    @classmethod
+    def save_segments(cls, segment_path, segments: np.ndarray):
+        cls._segments_to_raw(segments).tofile(segment_path)
+
+    @classmethod
+    def get_search_times(cls, data: np.ndarray, segments: np.ndarray) -> np.ndarray:
+        """!
+        @brief Compute a non-decreasing search key for each segment, used by @ref find_range().
+
+        Messages are not always stored in strict time order, and some entries do not have P1 time. The key for each
+        entry is the largest valid time in its segment up to and including that entry (`-inf` if none).
+
+        @param data The index data in @ref DTYPE format.
+        @param segments The segment table in @ref SEGMENT_DTYPE format.
+
+        @return An array containing the key for each index entry.
+        """
+        time = np.where(np.isnan(data['time']), -np.inf, data['time'])
+        search_time = np.empty_like(time)
+        for segment in segments:
+            start, end = int(segment['start']), int(segment['end'])
+            np.maximum.accumulate(time[start:end], out=search_time[start:end])
+        return search_time
+
+    @classmethod
+    def find_range(cls, search_time: np.ndarray, segment: np.ndarray, start_time: float = None,
+                   end_time: float = None) -> Tuple[int, int]:
+        """!
+        @brief Find the range of index entries within a segment that may contain the specified (absolute) P1 times.
+
+        The search takes O(log n) time. Because messages may be slightly out of order, the returned range may contain
+        a small number of entries outside the requested time range, and the caller should check the times of the
+        entries in the returned range.
+
+        @param search_time The search keys returned by @ref get_search_times().
+        @param segment The segment table entry.
+        @param start_time The start of the time range, or `None`.
+        @param end_time The end of the time range, or `None`.
+
+        @return A tuple containing the start and end (exclusive) index entries.
+        """
+        start, end = int(segment['start']), int(segment['end'])
+        keys = search_time[start:end]
+        lo = 0 if start_time is None else int(np.searchsorted(keys, np.floor(start_time), side='left'))
+        hi = (end - start) if end_time is None else \
+            int(np.searchsorted(keys, end_time + cls.TIME_RESET_THRESHOLD_SEC, side='right'))
+        return start + lo, start + max(lo, hi)
+
+    @classmethod
+    def _make_segments(cls, data, starts, ends):
+        segments = np.zeros(len(starts), dtype=cls.SEGMENT_DTYPE)
+        segments['start'] = starts
+        segments['end'] = ends
+        time = data['time']
+        for i, (start, end) in enumerate(zip(starts, ends)):
+            segment_time = time[start:end]
+            valid_time = segment_time[~np.isnan(segment_time)]
+            if len(valid_time) > 0:
+                segments['start_time'][i] = valid_time[0]
+                segments['end_time'][i] = np.max(valid_time)
+            else:
+                segments['start_time'][i] = np.nan
+                segments['end_time'][i] = np.nan
+        return segments
+
+    @classmethod
+    def _segments_to_raw(cls, segments):
+        raw_segments = np.zeros(len(segments), dtype=cls.SEGMENT_RAW_DTYPE)
+        raw_segments['start'] = segments['start']
+        raw_segments['end'] = segments['end']
+        return raw_segments
+
+    @classmethod
+    def _segments_from_raw(cls, raw_segments, data):
+        # Make sure the segments cover the full index, in order.
+        raw_segments = np.asarray(raw_segments)
+        if raw_segments.dtype != cls.SEGMENT_RAW_DTYPE or len(raw_segments) == 0:
+            return None
+
+        starts = raw_segments['start'].astype(int)
+        ends = raw_segments['end'].astype(int)
+        if starts[0] != 0 or ends[-1] != len(data) or np.any(starts[1:] != ends[:-1]) or np.any(ends <= starts):
+            return None
+
+        return cls._make_segments(data, starts, ends)
+
     @classmethod
     def _from_raw(cls, raw_data):
         idx = raw_data['int'] == Timestamp._INVALID
@@ -134,11 +303,13 @@ class FileIndex(object):
 class FileReader(object):
     logger = logging.getLogger('point_one.fusion_engine.analysis.file_reader')
 
-    def __init__(self, path=None):
+    def __init__(self, path=None, cache: Union[ColumnCache, bool] = None):
         """!
         @brief Create a new reader instance.
 
         @param path The path to a FusionEngine binary file to open.
+        @param cache A @ref ColumnCache instance used to store decoded numpy data for faster reads when the same file is
+               opened again, or `True` to use a cache in the default location. See @ref read().
         """
         self.file = None
         self.file_size = 0
@@ -146,6 +317,16 @@ class FileReader(object):
         self.t0 = None
 
         self.index = None
+        self.segments = None
+        self._index_search_time = None
+
+        if cache is True:
+            self.cache = ColumnCache()
+        elif isinstance(cache, ColumnCache):
+            self.cache = cache
+        else:
+            self.cache = None
+        self.cache_key = None
 
         if path is not None:
             self.open(path)
@@ -170,9 +351,19 @@ class FileReader(object):
         if self.file_size == 0:
             raise RuntimeError("File '%s' is empty." % path)
 
+        # Locate the cache entry for this file.
+        if self.cache is not None:
+            self.cache_key = ColumnCache.fingerprint(self.file.name)
+            self.logger.debug("Using cache entry '%s'." % self.cache.get_entry_dir(self.cache_key))
+
         # Load the data index file if present.
         index_path = FileIndex.get_path(self.file.name)
-        if os.path.exists(index_path):
+        cached_index = self.cache.load_index(self.cache_key) if self.cache_key is not None else None
+        if cached_index is not None and not os.path.exists(index_path):
+            # Note: The cache key includes the file size, so there is no need to validate the cached index.
+            self.logger.debug("Using cached index file.")
+            self.index = FileIndex._from_raw(np.asarray(cached_index))
+        elif os.path.exists(index_path):
             self.logger.debug("Reading index file '%s'." % index_path)
             self.index = FileIndex.load(index_path)
 
@@ -204,10 +395,31 @@ class FileReader(object):
 
             if not index_valid:
                 os.remove(index_path)
+                segment_path = FileIndex.get_segment_path(self.file.name)
+                if os.path.exists(segment_path):
+                    os.remove(segment_path)
                 self.index = None
         else:
             self.index = None
 
+        # Load the segment table for the index, or detect segments using the index timestamps if not available (the
+        # segment table also includes sequence number resets, which are not stored in the index).
+        if self.index is not None:
+            segments = None
+            if os.path.exists(index_path):
+                segments = FileIndex.load_segments(FileIndex.get_segment_path(self.file.name), self.index)
+            elif self.cache_key is not None:
+                cached_segments = self.cache.load_segments(self.cache_key)
+                if cached_segments is not None:
+                    segments = FileIndex._segments_from_raw(cached_segments, self.index)
+
+            if segments is None:
+                self.logger.debug("Segment table not available. Detecting P1 time resets from index.")
+                segments = FileIndex.detect_segments(self.index)
+            self._set_segments(segments)
+        else:
+            self._set_segments(None)
+
         # Read the first message (with P1 time) in the file to set self.t0.
         #
         # Note that we explicitly set a start time since, if the time range is not specified, read() will include
@@ -225,6 +437,29 @@ class FileReader(object):
         """
         if self.file is not None:
             self.file = None
+            self.cache_key = None
+
+    def get_segments(self) -> np.ndarray:
+        """!
+        @brief Get the segments of continuous P1 time in the file.
+
+        P1 time restarts when a device reboots, so a log spanning several power cycles contains multiple timelines.
+        Segments are detected when the file is indexed, using P1 time regressions and message sequence number resets.
+        The index will be generated if it does not already exist.
+
+        @return The segment table in @ref FileIndex.SEGMENT_DTYPE format, with one entry per segment, in file order.
+                `start_time` and `end_time` contain the absolute P1 time range of each segment.
+        """
+        if self.index is None:
+            self.generate_index()
+        return self.segments
+
+    def _set_segments(self, segments: Optional[np.ndarray]):
+        self.segments = segments
+        if segments is None:
+            self._index_search_time = None
+        else:
+            self._index_search_time = FileIndex.get_search_times(self.index, segments)
 
     def generate_index(self):
         """!
@@ -241,11 +476,32 @@ class FileReader(object):
             if prev_data is not None:
                 self.data[MessageType.POSE] = prev_data
 
+    def follow(self, message_types: Union[list, tuple] = None, from_start: bool = False, timeout_sec: float = None):
+        """!
+        @brief Decode new messages as they are appended to the file (e.g., while a recorder is still writing it).
+
+        See @ref FileFollower for details.
+
+        @param message_types A list of one or more @ref fusion_engine_client.messages.defs.MessageType "MessageTypes"
+               or message classes to be returned. If `None` or an empty list, return all messages.
+        @param from_start If `True`, start with the first message in the file. Otherwise, return only messages written
+               after this call.
+        @param timeout_sec If set, stop if no new messages arrive for the specified amount of time (in seconds).
+               Otherwise, continue indefinitely.
+
+        @return A generator of `(header, message)` tuples.
+        """
+        if self.file is None or not isinstance(self.file.name, str):
+            raise RuntimeError('Follow mode requires a file opened by path.')
+
+        with FileFollower(self.file.name, message_types=message_types, from_start=from_start) as follower:
+            yield from follower.follow(timeout_sec=timeout_sec)
+
     def read(self, message_types: Union[list, tuple] = None,
              time_range: Tuple[Union[float, Timestamp], Union[float, Timestamp]] = None, absolute_time: bool = False,
              max_messages: int = None,
              return_numpy: bool = False, keep_messages: bool = False, remove_nan_times: bool = True,
-             generate_index: bool = True, show_progress: bool = False) \
+             generate_index: bool = True, show_progress: bool = False, segment: int = None) \
             -> Dict[MessageType, MessageData]:
         """!
         @brief Read data for one or more desired message types.
@@ -274,6 +530,14 @@ class FileReader(object):
         @param generate_index If `True` and an index file does not exist for this data file, read the entire data file
                and create an index file on the first call to this function. The file will be stored in the same
                directory as the input file.
+        @param segment If set, read only messages from the specified segment of continuous P1 time (see
+               @ref get_segments()). Negative values index from the last segment. If `absolute_time == False`,
+               `time_range` is relative to the start of the segment. An index file is required, and will be generated
+               if it does not exist.
+
+        If a @ref ColumnCache is enabled and `return_numpy == True`, `keep_messages == False`, and `max_messages` is not
+        set, the numpy data will be loaded from the cache if available. If not, the complete data for the requested
+        message types will be read and stored in the cache, and then the requested time range will be applied.
 
         @return A dictionary, keyed by @ref fusion_engine_client.messages.defs.MessageType "MessageType", containing
                @ref MessageData objects with the data read for each of the requested message types.
@@ -292,9 +556,17 @@ class FileReader(object):
         params = {
             'time_range': time_range,
             'absolute_time': absolute_time,
-            'max_messages': max_messages
+            'max_messages': max_messages,
+            'segment': segment
         }
 
+        # Segment lookups require the index.
+        if segment is not None:
+            if self.index is None:
+                self.generate_index()
+            if segment < -len(self.segments) or segment >= len(self.segments):
+                raise ValueError('Segment %d does not exist. [# segments=%d]' % (segment, len(self.segments)))
+
         # Allow the user to pass in a list of message classes for convenience and convert them to message types
         # automatically.
         message_types = [(t if isinstance(t, MessageType) else t.MESSAGE_TYPE) for t in message_types]
@@ -320,6 +592,16 @@ class FileReader(object):
 
         needed_message_types = [t for t in needed_message_types if message_class[t] is not None]
 
+        # If a cache is in use, load the numpy data from the cache if available. Otherwise, read the complete data for
+        # the requested types, store it in the cache, and then apply the requested time range.
+        if (self.cache_key is not None and return_numpy and not keep_messages and max_messages == 0 and
+                segment is None):
+            cacheable_types = [t for t in needed_message_types if hasattr(message_class[t], 'to_numpy')]
+            if len(cacheable_types) > 0:
+                self._read_cached(message_types=cacheable_types, params=params, remove_nan_times=remove_nan_times,
+                                  generate_index=generate_index, show_progress=show_progress)
+                needed_message_types = [t for t in needed_message_types if t not in cacheable_types]
+
         # Create a dict with references to the requested types only to be returned below.
         result = {t: self.data[t] for t in message_types}
 
@@ -340,6 +622,8 @@ class FileReader(object):
         # yet, it will be set later. If we already loaded an index file, t0 should have been set from that.
         if absolute_time:
             reference_time_sec = 0.0
+        elif segment is not None:
+            reference_time_sec = float(self.segments[segment]['start_time'])
         elif self.t0 is not None:
             reference_time_sec = float(self.t0)
         else:
@@ -347,21 +631,36 @@ class FileReader(object):
 
         # If there's an index file, use it to determine the offsets to all the messages we're interested in.
         if self.index is not None:
-            idx = np.full_like(self.index['time'], False, dtype=bool)
+            # Locate the entries in the requested time range within each segment using a binary search. If t0 has
+            # never been set, this is probably the "first message" read done in open() to set t0. Ignore the time
+            # range.
+            start_time = None
+            end_time = None
+            if self.t0 is not None:
+                if time_range[0] is not None:
+                    start_time = float(time_range[0]) + reference_time_sec
+                if time_range[1] is not None:
+                    end_time = float(time_range[1]) + reference_time_sec
+
+            segments = self.segments if segment is None else self.segments[[segment]]
+            entry_ranges = [FileIndex.find_range(self._index_search_time, s, start_time, end_time) for s in segments]
+            data_index = self.index[np.concatenate([np.zeros(0, dtype=int)] +
+                                                   [np.arange(start, end, dtype=int)
+                                                    for start, end in entry_ranges])]
+
+            idx = np.full_like(data_index['time'], False, dtype=bool)
             for type in needed_message_types:
-                idx = np.logical_or(idx, self.index['type'] == type)
+                idx = np.logical_or(idx, data_index['type'] == type)
 
-            # If t0 has never been set, this is probably the "first message" read done in open() to set t0. Ignore the
-            # time range.
             if self.t0 is not None:
-                limit_time = self.index['time'] - reference_time_sec
+                limit_time = data_index['time'] - reference_time_sec
                 if time_range[0] is not None:
                     # Note: The index stores only the integer part of the timestamp.
                     idx = np.logical_and(idx, limit_time >= np.floor(time_range[0]))
                 if time_range[1] is not None:
                     idx = np.logical_and(idx, limit_time <= time_range[1])
 
-            data_index = self.index[idx]
+            data_index = data_index[idx]
             if max_messages > 0:
                 data_index = data_index[:max_messages]
             elif max_messages < 0:
@@ -374,6 +673,8 @@ class FileReader(object):
         else:
             data_offsets = None
             index_entries = []
+            index_sequence_resets = []
+            last_sequence_number = {}
             self.file.seek(0, 0)
 
             if generate_index:
@@ -389,6 +690,8 @@ class FileReader(object):
 
         if absolute_time:
             reference_time_sec = 0.0
+        elif segment is not None:
+            reference_time_sec = float(self.segments[segment]['start_time'])
         elif self.t0 is not None:
             reference_time_sec = float(self.t0)
         else:
@@ -501,6 +804,12 @@ class FileReader(object):
                 # If we're building up an index file, add an entry for this message. If this is an unrecognized message
                 # type, we won't have P1 time so we'll just insert a nan.
                 if generate_index:
+                    # A decrease in the sequence number from a given source indicates the device restarted.
+                    prev_sequence_number = last_sequence_number.get(header.source_identifier, None)
+                    if prev_sequence_number is not None and header.sequence_number < prev_sequence_number:
+                        index_sequence_resets.append(len(index_entries))
+                    last_sequence_number[header.source_identifier] = header.sequence_number
+
                     index_entries.append((float(p1_time) if p1_time is not None else np.nan, int(header.message_type),
                                           message_offset_bytes))
 
@@ -590,6 +899,15 @@ class FileReader(object):
             self.logger.debug("Saving index file '%s' with %d entries." % (index_path, len(index_entries)))
             self.index = FileIndex.save(index_path, index_entries)
 
+            segments = FileIndex.detect_segments(self.index, index_sequence_resets)
+            self.logger.debug("Saving segment table with %d segments." % len(segments))
+            FileIndex.save_segments(FileIndex.get_segment_path(self.file.name), segments)
+            self._set_segments(segments)
+
+            if self.cache_key is not None:
+                self.cache.save_index(self.cache_key, FileIndex._to_raw(self.index))
+                self.cache.save_segments(self.cache_key, FileIndex._segments_to_raw(segments))
+
         # Convert the resulting message data to numpy (if supported).
         if return_numpy:
             FileReader.to_numpy(result, keep_messages=keep_messages, remove_nan_times=remove_nan_times)
@@ -597,6 +915,77 @@ class FileReader(object):
         # Done.
         return result
 
+    def _read_cached(self, message_types: list, params: dict, remove_nan_times: bool, generate_index: bool,
+                     show_progress: bool):
+        """!
+        @brief Populate numpy data for the specified message types using the column cache.
+        """
+        meta = self.cache.load_metadata(self.cache_key)
+        columns = {}
+        missing_types = []
+        for type in message_types:
+            data = self.cache.load_columns(self.cache_key, type, meta=meta) if meta is not None else None
+            if data is None:
+                missing_types.append(type)
+            else:
+                self.logger.debug('Loaded %s data from cache.' % MessageType.get_type_string(type))
+                columns[type] = data
+
+        # Read the full file for any types not currently in the cache. Disable the cache temporarily so the data is
+        # read from the file directly.
+        if len(missing_types) > 0:
+            self.logger.debug('Reading %d message types to be cached.' % len(missing_types))
+            for type in missing_types:
+                self.data.pop(type, None)
+
+            cache_key = self.cache_key
+            self.cache_key = None
+            try:
+                self.read(message_types=missing_types, return_numpy=True, keep_messages=False, remove_nan_times=False,
+                          generate_index=generate_index, show_progress=show_progress)
+            finally:
+                self.cache_key = cache_key
+
+            if self.index is not None and self.cache.load_index(self.cache_key) is None:
+                self.cache.save_index(self.cache_key, FileIndex._to_raw(self.index))
+                self.cache.save_segments(self.cache_key, FileIndex._segments_to_raw(self.segments))
+
+            for type in missing_types:
+                data = {key: value for key, value in self.data[type].__dict__.items()
+                        if isinstance(value, np.ndarray)}
+                if not self.cache.save_columns(self.cache_key, type, data):
+                    self.logger.debug('Unable to cache %s data.' % MessageType.get_type_string(type))
+                columns[type] = data
+
+            self.cache.update_metadata(self.cache_key, source_path=self.file.name)
+
+        # Now apply the requested time range.
+        time_range = params['time_range']
+        if params['absolute_time']:
+            reference_time_sec = 0.0
+        elif self.t0 is not None:
+            reference_time_sec = float(self.t0)
+        else:
+            reference_time_sec = np.nan
+
+        for type in message_types:
+            entry = MessageData(message_type=type, params=params)
+            entry.__dict__.update(columns[type])
+
+            if 'p1_time' in columns[type] and (time_range[0] is not None or time_range[1] is not None):
+                time_offset_sec = columns[type]['p1_time'] - reference_time_sec
+                keep_idx = np.full(time_offset_sec.shape, True)
+                if time_range[0] is not None:
+                    keep_idx = np.logical_and(keep_idx, time_offset_sec >= float(time_range[0]))
+                if time_range[1] is not None:
+                    keep_idx = np.logical_and(keep_idx, time_offset_sec <= float(time_range[1]))
+                entry._select(keep_idx)
+
+            if remove_nan_times:
+                entry._remove_nan_times()
+
+            self.data[type] = entry
+
     @classmethod
     def to_numpy(cls, data: dict, keep_messages: bool = True, remove_nan_times: bool = True):
         """!
@@ -50,9 +50,11 @@ class MessageType(IntEnum):
     GNSS_INFO = 10001
     GNSS_SATELLITE = 10002
     POSE_AUX = 10003
+    COMPACT_POSE = 10004
 
     # Sensor measurement messages.
     IMU_MEASUREMENT = 11000
+    IMU_MEASUREMENT_BATCH = 11001
 
     # ROS messages.
     ROS_POSE = 12000
@@ -158,18 +160,53 @@ class Timestamp:
         return '%.3f seconds' % self.seconds
 
 
+def _generate_crc_table(polynomial: int):
+    table = []
+    for i in range(256):
+        c = i
+        for j in range(8):
+            if c & 1:
+                c = polynomial ^ (c >> 1)
+            else:
+                c >>= 1
+        table.append(c)
+    return table
+
+
+_CRC32C_TABLE = _generate_crc_table(0x82F63B78)
+
+
+def crc32c(data: bytes, value: int = 0) -> int:
+    """!
+    @brief Calculate the CRC-32C (Castagnoli) value for a byte buffer.
+
+    @param data The data to be processed.
+    @param value The CRC of any preceding data, or 0.
+
+    @return The computed CRC.
+    """
+    c = value ^ 0xFFFFFFFF
+    table = _CRC32C_TABLE
+    for b in data:
+        c = table[(c ^ b) & 0xFF] ^ (c >> 8)
+    return c ^ 0xFFFFFFFF
+
+
 class MessageHeader:
     INVALID_SOURCE_ID = 0xFFFFFFFF
 
+    FLAG_CRC32C = 0x01
+
     _SYNC0 = 0x2E # '.'
     _SYNC1 = 0x31 # '1'
 
-    _FORMAT = '<BB2xIBxHIII'
+    _FORMAT = '<BBBxIBxHIII'
     _SIZE: int = struct.calcsize(_FORMAT)
 
     _MAX_EXPECTED_SIZE_BYTES = (1 << 24)
 
     def __init__(self, message_type: MessageType = MessageType.INVALID):
+        self.flags: int = 0
         self.crc: int = 0
         self.protocol_version: int = 2
         self.sequence_number: int = 0
@@ -184,6 +221,9 @@ class MessageHeader:
         """!
         @brief Calculate the CRC for this header and the specified payload.
 
+        The CRC-32C polynomial will be used if @ref FLAG_CRC32C is set in @ref flags. Otherwise, the standard CRC-32
+        polynomial will be used.
+
         @post
         @ref crc and @ref payload_size_bytes will be populated automatically on return.
 
@@ -193,8 +233,9 @@ class MessageHeader:
         # protocol_version, then add the payload into the CRC.
         self.payload_size_bytes = len(payload)
         header_buffer = self.pack()
-        self.crc = crc32(header_buffer[6:])
-        self.crc = crc32(payload, self.crc)
+        crc_func = self._get_crc_function()
+        self.crc = crc_func(header_buffer[8:])
+        self.crc = crc_func(payload, self.crc)
         return self.crc
 
     def validate_crc(self, buffer: bytes, offset: int = 0):
@@ -204,7 +245,7 @@ class MessageHeader:
                              (self.payload_size_bytes, MessageHeader._MAX_EXPECTED_SIZE_BYTES))
 
         message_size_bytes = MessageHeader._SIZE + self.payload_size_bytes
-        crc = crc32(buffer[(offset + 8):(offset + message_size_bytes)])
+        crc = self._get_crc_function()(buffer[(offset + 8):(offset + message_size_bytes)])
         if crc != self.crc:
             raise ValueError('CRC mismatch. [expected=0x%08x, computed=0x%08x]' % (self.crc, crc))
 
@@ -231,7 +272,8 @@ class MessageHeader:
         if payload is not None:
             self.calculate_crc(payload)
 
-        args = (self.crc, self.protocol_version, int(self.message_type), self.sequence_number, self.payload_size_bytes,
+        args = (MessageHeader._SYNC0, MessageHeader._SYNC1, self.flags,
+                self.crc, self.protocol_version, int(self.message_type), self.sequence_number, self.payload_size_bytes,
                 self.source_identifier)
         if buffer is None:
             buffer = struct.pack(MessageHeader._FORMAT, *args)
@@ -262,7 +304,7 @@ class MessageHeader:
 
         @return The size of the serialized header (in bytes).
         """
-        (sync0, sync1,
+        (sync0, sync1, self.flags,
          self.crc, self.protocol_version,
          message_type_int, self.sequence_number, self.payload_size_bytes, self.source_identifier) = \
             struct.unpack_from(MessageHeader._FORMAT, buffer=buffer, offset=offset)
@@ -284,6 +326,9 @@ class MessageHeader:
 
         return MessageHeader._SIZE
 
+    def _get_crc_function(self):
+        return crc32c if (self.flags & MessageHeader.FLAG_CRC32C) else crc32
+
     @classmethod
     def calcsize(cls) -> int:
         """!
@@ -1,3 +1,5 @@
+from typing import List
+
 import numpy as np
 
 from .defs import *
@@ -78,3 +80,132 @@ class IMUMeasurement(MessagePayload):
     @classmethod
     def calcsize(cls) -> int:
         return Timestamp.calcsize() + IMUMeasurement._SIZE
+
+
+class IMUMeasurementBatch(MessagePayload):
+    """!
+    @brief A batch of IMU sensor measurements sharing a single message header.
+
+    Individual samples are stored in @ref samples as @ref IMUMeasurement objects, with their absolute P1 times restored
+    from the per-sample time offsets.
+    """
+    MESSAGE_TYPE = MessageType.IMU_MEASUREMENT_BATCH
+
+    INVALID_TIME_OFFSET = 0xFFFFFFFF
+
+    _FORMAT = '<H2x'
+    _SIZE: int = struct.calcsize(_FORMAT)
+
+    _SAMPLE_FORMAT = '<I 3d 3d 3d 3d'
+    _SAMPLE_DATA_FORMAT = '<3d 3d 3d 3d'
+    _SAMPLE_SIZE: int = struct.calcsize(_SAMPLE_FORMAT)
+
+    _MAX_TIME_OFFSET_NS = INVALID_TIME_OFFSET - 1
+
+    def __init__(self):
+        self.p1_time = Timestamp()
+        self.samples: List[IMUMeasurement] = []
+
+    def get_type(self) -> MessageType:
+        return IMUMeasurementBatch.MESSAGE_TYPE
+
+    def pack(self, buffer: bytes = None, offset: int = 0, return_buffer: bool = True) -> (bytes, int):
+        if buffer is None:
+            buffer = bytearray(self.calcsize())
+
+        initial_offset = offset
+
+        # Use the first valid sample time as the batch base time if one was not set explicitly.
+        if not self.p1_time:
+            for sample in self.samples:
+                if sample.p1_time:
+                    self.p1_time = Timestamp(float(sample.p1_time))
+                    break
+
+        base_time_ns = self._to_ns(self.p1_time)
+
+        offset += self.p1_time.pack(buffer, offset, return_buffer=False)
+
+        struct.pack_into(IMUMeasurementBatch._FORMAT, buffer, offset, len(self.samples))
+        offset += IMUMeasurementBatch._SIZE
+
+        for sample in self.samples:
+            if sample.p1_time and base_time_ns is not None:
+                time_offset_ns = self._to_ns(sample.p1_time) - base_time_ns
+                if time_offset_ns < 0 or time_offset_ns > IMUMeasurementBatch._MAX_TIME_OFFSET_NS:
+                    raise ValueError('Sample time outside of batch range. [base=%s, sample=%s]' %
+                                     (str(self.p1_time), str(sample.p1_time)))
+            else:
+                time_offset_ns = IMUMeasurementBatch.INVALID_TIME_OFFSET
+
+            struct.pack_into(IMUMeasurementBatch._SAMPLE_FORMAT, buffer, offset,
+                             time_offset_ns,
+                             *sample.accel_mps2,
+                             *sample.accel_std_mps2,
+                             *sample.gyro_rps,
+                             *sample.gyro_std_rps)
+            offset += IMUMeasurementBatch._SAMPLE_SIZE
+
+        if return_buffer:
+            return buffer
+        else:
+            return offset - initial_offset
+
+    def unpack(self, buffer: bytes, offset: int = 0) -> int:
+        initial_offset = offset
+
+        offset += self.p1_time.unpack(buffer, offset)
+        base_time_ns = self._to_ns(self.p1_time)
+
+        (num_samples,) = struct.unpack_from(IMUMeasurementBatch._FORMAT, buffer=buffer, offset=offset)
+        offset += IMUMeasurementBatch._SIZE
+
+        self.samples = []
+        for i in range(num_samples):
+            sample = IMUMeasurement()
+            (time_offset_ns,) = struct.unpack_from('<I', buffer=buffer, offset=offset)
+            MessageHeader.unpack_values(IMUMeasurementBatch._SAMPLE_DATA_FORMAT, buffer, offset + 4,
+                                        sample.accel_mps2,
+                                        sample.accel_std_mps2,
+                                        sample.gyro_rps,
+                                        sample.gyro_std_rps)
+            offset += IMUMeasurementBatch._SAMPLE_SIZE
+
+            if time_offset_ns != IMUMeasurementBatch.INVALID_TIME_OFFSET and base_time_ns is not None:
+                sample.p1_time = Timestamp((base_time_ns + time_offset_ns) * 1e-9)
+
+            self.samples.append(sample)
+
+        return offset - initial_offset
+
+    def __repr__(self):
+        return '%s @ %s [%d samples]' % (self.MESSAGE_TYPE.name, self.p1_time, len(self.samples))
+
+    def __str__(self):
+        string = 'IMU measurement batch @ P1 time %s\n' % str(self.p1_time)
+        string += '  %d samples:' % len(self.samples)
+        for sample in self.samples:
+            string += '\n'
+            string += '    Sample @ P1 time %s:\n' % str(sample.p1_time)
+            string += '      Accel: %.2f, %.2f, %.2f (m/s^2, m/s^2, m/s^2)\n' % tuple(sample.accel_mps2)
+            string += '      Gyro: %.3f, %.3f, %.3f (rad/s, rad/s, rad/s)' % tuple(sample.gyro_rps)
+        return string
+
+    def calcsize(self) -> int:
+        return Timestamp.calcsize() + IMUMeasurementBatch._SIZE + len(self.samples) * IMUMeasurementBatch._SAMPLE_SIZE
+
+    @classmethod
+    def to_numpy(cls, messages):
+        """!
+        @brief Convert the samples from all batches into numpy arrays.
+
+        The results are identical in format to @ref IMUMeasurement.to_numpy(), with one column per sample.
+        """
+        return IMUMeasurement.to_numpy([sample for m in messages for sample in m.samples])
+
+    @classmethod
+    def _to_ns(cls, timestamp: Timestamp):
+        if timestamp:
+            return int(round(float(timestamp) * 1e9))
+        else:
+            return None
@@ -211,6 +211,237 @@ class PoseAuxMessage(MessagePayload):
         return result
 
 
+class CompactPoseMessage(MessagePayload):
+    """!
+    @brief Quantized platform pose solution for low-bandwidth links.
+
+    This message contains the same content as @ref PoseMessage, stored using fixed-point integers. The @ref
+    presence_mask bitmask indicates which groups of fields are populated. Use @ref from_pose() and @ref to_pose() to
+    convert to/from @ref PoseMessage.
+    """
+    MESSAGE_TYPE = MessageType.COMPACT_POSE
+
+    GPS_TIME_PRESENT = 0x01
+    POSITION_PRESENT = 0x02
+    POSITION_STD_PRESENT = 0x04
+    ATTITUDE_PRESENT = 0x08
+    ATTITUDE_STD_PRESENT = 0x10
+    VELOCITY_PRESENT = 0x20
+    VELOCITY_STD_PRESENT = 0x40
+    PROTECTION_LEVELS_PRESENT = 0x80
+
+    LATLON_SCALE_DEG = 1e-7
+    LATLON_HP_SCALE_DEG = 1e-9
+    ALTITUDE_SCALE_M = 1e-3
+    ALTITUDE_HP_SCALE_M = 1e-5
+    ANGLE_SCALE_DEG = 180.0 / 32768.0
+    VELOCITY_SCALE_MPS = 1e-2
+    POSITION_STD_SCALE_M = 1e-3
+    ANGLE_STD_SCALE_DEG = 1e-3
+    VELOCITY_STD_SCALE_MPS = 1e-3
+    PROTECTION_LEVEL_SCALE_M = 1e-2
+
+    _FORMAT = '<BB2x 2i i 3b x 3h 3h 3H 3H 3H 3H'
+    _SIZE: int = struct.calcsize(_FORMAT)
+
+    def __init__(self):
+        self.p1_time = Timestamp()
+        self.gps_time = Timestamp()
+
+        self.solution_type = SolutionType.Invalid
+        self.presence_mask = 0
+
+        self.latlon = np.zeros((2,), dtype=int)
+        self.altitude = 0
+        self.lla_hp = np.zeros((3,), dtype=int)
+
+        self.ypr = np.zeros((3,), dtype=int)
+        self.velocity_body = np.zeros((3,), dtype=int)
+
+        self.position_std_enu = np.zeros((3,), dtype=int)
+        self.ypr_std = np.zeros((3,), dtype=int)
+        self.velocity_std_body = np.zeros((3,), dtype=int)
+        self.protection_levels = np.zeros((3,), dtype=int)
+
+    def get_type(self) -> MessageType:
+        return CompactPoseMessage.MESSAGE_TYPE
+
+    def pack(self, buffer: bytes = None, offset: int = 0, return_buffer: bool = True) -> (bytes, int):
+        if buffer is None:
+            buffer = bytearray(self.calcsize())
+
+        initial_offset = offset
+
+        offset += self.p1_time.pack(buffer, offset, return_buffer=False)
+        offset += self.gps_time.pack(buffer, offset, return_buffer=False)
+
+        struct.pack_into(CompactPoseMessage._FORMAT, buffer, offset,
+                         int(self.solution_type), self.presence_mask,
+                         *[int(v) for v in self.latlon], int(self.altitude),
+                         *[int(v) for v in self.lla_hp],
+                         *[int(v) for v in self.ypr],
+                         *[int(v) for v in self.velocity_body],
+                         *[int(v) for v in self.position_std_enu],
+                         *[int(v) for v in self.ypr_std],
+                         *[int(v) for v in self.velocity_std_body],
+                         *[int(v) for v in self.protection_levels])
+        offset += CompactPoseMessage._SIZE
+
+        if return_buffer:
+            return buffer
+        else:
+            return offset - initial_offset
+
+    def unpack(self, buffer: bytes, offset: int = 0) -> int:
+        initial_offset = offset
+
+        offset += self.p1_time.unpack(buffer, offset)
+        offset += self.gps_time.unpack(buffer, offset)
+
+        values = struct.unpack_from(CompactPoseMessage._FORMAT, buffer=buffer, offset=offset)
+        (solution_type_int, self.presence_mask) = values[0:2]
+        self.latlon[:] = values[2:4]
+        self.altitude = values[4]
+        self.lla_hp[:] = values[5:8]
+        self.ypr[:] = values[8:11]
+        self.velocity_body[:] = values[11:14]
+        self.position_std_enu[:] = values[14:17]
+        self.ypr_std[:] = values[17:20]
+        self.velocity_std_body[:] = values[20:23]
+        self.protection_levels[:] = values[23:26]
+        offset += CompactPoseMessage._SIZE
+
+        self.solution_type = SolutionType(solution_type_int)
+
+        return offset - initial_offset
+
+    @classmethod
+    def from_pose(cls, pose: PoseMessage):
+        """!
+        @brief Create a compact pose from a @ref PoseMessage.
+
+        A field group is encoded only if all of its components are finite. Values are rounded to the nearest
+        representable value, and velocity (+/-327.67 m/s), standard deviations, and protection levels saturate at their
+        maximum representable values. Angles are wrapped to [-180, 180) degrees.
+
+        @param pose The pose to be converted.
+
+        @return A @ref CompactPoseMessage instance.
+        """
+        result = cls()
+        result.p1_time = Timestamp(float(pose.p1_time))
+        result.solution_type = pose.solution_type
+
+        if pose.gps_time:
+            result.gps_time = Timestamp(float(pose.gps_time))
+            result.presence_mask |= cls.GPS_TIME_PRESENT
+
+        if np.all(np.isfinite(pose.lla_deg)):
+            for i in range(2):
+                result.latlon[i], result.lla_hp[i] = cls._split_high_resolution(
+                    pose.lla_deg[i], cls.LATLON_SCALE_DEG, cls.LATLON_HP_SCALE_DEG)
+            result.altitude, result.lla_hp[2] = cls._split_high_resolution(
+                pose.lla_deg[2], cls.ALTITUDE_SCALE_M, cls.ALTITUDE_HP_SCALE_M)
+            result.presence_mask |= cls.POSITION_PRESENT
+
+        if np.all(np.isfinite(pose.ypr_deg)):
+            wrapped_deg = np.mod(pose.ypr_deg + 180.0, 360.0) - 180.0
+            quantized = np.round(wrapped_deg / cls.ANGLE_SCALE_DEG).astype(int)
+            quantized[quantized >= 32768] -= 65536
+            result.ypr[:] = quantized
+            result.presence_mask |= cls.ATTITUDE_PRESENT
+
+        if np.all(np.isfinite(pose.velocity_body_mps)):
+            result.velocity_body[:] = cls._quantize(pose.velocity_body_mps, cls.VELOCITY_SCALE_MPS, -32768, 32767)
+            result.presence_mask |= cls.VELOCITY_PRESENT
+
+        for (values, scale, field, flag) in (
+                (pose.position_std_enu_m, cls.POSITION_STD_SCALE_M, result.position_std_enu, cls.POSITION_STD_PRESENT),
+                (pose.ypr_std_deg, cls.ANGLE_STD_SCALE_DEG, result.ypr_std, cls.ATTITUDE_STD_PRESENT),
+                (pose.velocity_std_body_mps, cls.VELOCITY_STD_SCALE_MPS, result.velocity_std_body,
+                 cls.VELOCITY_STD_PRESENT),
+                (np.array([pose.aggregate_protection_level_m, pose.horizontal_protection_level_m,
+                           pose.vertical_protection_level_m]),
+                 cls.PROTECTION_LEVEL_SCALE_M, result.protection_levels, cls.PROTECTION_LEVELS_PRESENT)):
+            if np.all(np.isfinite(values)):
+                field[:] = cls._quantize(values, scale, 0, 65535)
+                result.presence_mask |= flag
+
+        return result
+
+    def to_pose(self) -> PoseMessage:
+        """!
+        @brief Convert this compact pose to a @ref PoseMessage.
+
+        @return A @ref PoseMessage instance. Fields not present in the compact pose are set to `NaN`.
+        """
+        pose = PoseMessage()
+        pose.p1_time = Timestamp(float(self.p1_time))
+        pose.solution_type = self.solution_type
+
+        if self.presence_mask & self.GPS_TIME_PRESENT:
+            pose.gps_time = Timestamp(float(self.gps_time))
+
+        if self.presence_mask & self.POSITION_PRESENT:
+            pose.lla_deg[0:2] = self.latlon * self.LATLON_SCALE_DEG + self.lla_hp[0:2] * self.LATLON_HP_SCALE_DEG
+            pose.lla_deg[2] = self.altitude * self.ALTITUDE_SCALE_M + self.lla_hp[2] * self.ALTITUDE_HP_SCALE_M
+
+        if self.presence_mask & self.POSITION_STD_PRESENT:
+            pose.position_std_enu_m[:] = self.position_std_enu * self.POSITION_STD_SCALE_M
+
+        if self.presence_mask & self.ATTITUDE_PRESENT:
+            pose.ypr_deg[:] = self.ypr * self.ANGLE_SCALE_DEG
+
+        if self.presence_mask & self.ATTITUDE_STD_PRESENT:
+            pose.ypr_std_deg[:] = self.ypr_std * self.ANGLE_STD_SCALE_DEG
+
+        if self.presence_mask & self.VELOCITY_PRESENT:
+            pose.velocity_body_mps[:] = self.velocity_body * self.VELOCITY_SCALE_MPS
+
+        if self.presence_mask & self.VELOCITY_STD_PRESENT:
+            pose.velocity_std_body_mps[:] = self.velocity_std_body * self.VELOCITY_STD_SCALE_MPS
+
+        if self.presence_mask & self.PROTECTION_LEVELS_PRESENT:
+            (pose.aggregate_protection_level_m,
+             pose.horizontal_protection_level_m,
+             pose.vertical_protection_level_m) = self.protection_levels * self.PROTECTION_LEVEL_SCALE_M
+
+        return pose
+
+    def __repr__(self):
+        return '%s @ %s' % (self.MESSAGE_TYPE.name, self.p1_time)
+
+    def __str__(self):
+        string = str(self.to_pose()).split('\n')
+        string[0] = 'Compact pose message @ P1 time %s' % str(self.p1_time)
+        return '\n'.join(string)
+
+    @classmethod
+    def calcsize(cls) -> int:
+        return 2 * Timestamp.calcsize() + CompactPoseMessage._SIZE
+
+    @classmethod
+    def to_numpy(cls, messages):
+        """!
+        @brief Convert compact pose messages to numpy arrays.
+
+        The results are identical in format to @ref PoseMessage.to_numpy().
+        """
+        return PoseMessage.to_numpy([m.to_pose() for m in messages])
+
+    @classmethod
+    def _quantize(cls, values, scale, min_value, max_value):
+        return np.clip(np.round(np.asarray(values, dtype=float) / scale), min_value, max_value).astype(int)
+
+    @classmethod
+    def _split_high_resolution(cls, value, scale, hp_scale):
+        ratio = int(round(scale / hp_scale))
+        total = int(round(value / hp_scale))
+        coarse = int(np.clip(round(value / scale), -2 ** 31, 2 ** 31 - 1))
+        fine = int(np.clip(total - coarse * ratio, -(ratio // 2), ratio // 2))
+        return coarse, fine
+
+
 class GNSSInfoMessage(MessagePayload):
     """!
     @brief Information about the GNSS data used in the @ref PoseMessage with the corresponding timestamp.
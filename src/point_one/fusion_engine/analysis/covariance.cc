@@ -0,0 +1,338 @@
+/**************************************************************************/ /**
+ * @brief Batched position covariance processing.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/analysis/covariance.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+using namespace point_one::fusion_engine::analysis;
+using namespace point_one::fusion_engine::geodesy;
+
+namespace {
+// Number of epochs processed together in each inner loop.
+constexpr size_t BLOCK_SIZE = 64;
+
+/******************************************************************************/
+inline void Cross(const double a[3], const double b[3], double result[3]) {
+  result[0] = a[1] * b[2] - a[2] * b[1];
+  result[1] = a[2] * b[0] - a[0] * b[2];
+  result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+/******************************************************************************/
+inline double Dot(const double a[3], const double b[3]) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/******************************************************************************/
+inline void Normalize(double v[3]) {
+  double norm = std::sqrt(Dot(v, v));
+  v[0] /= norm;
+  v[1] /= norm;
+  v[2] /= norm;
+}
+
+/******************************************************************************/
+// Compute a unit vector perpendicular to `v` (which must be a unit vector).
+void GetPerpendicular(const double v[3], double result[3]) {
+  // Cross with the axis least aligned with v.
+  double axis[3] = {0.0, 0.0, 0.0};
+  double abs_v[3] = {std::fabs(v[0]), std::fabs(v[1]), std::fabs(v[2])};
+  if (abs_v[0] <= abs_v[1] && abs_v[0] <= abs_v[2]) {
+    axis[0] = 1.0;
+  } else if (abs_v[1] <= abs_v[2]) {
+    axis[1] = 1.0;
+  } else {
+    axis[2] = 1.0;
+  }
+
+  Cross(v, axis, result);
+  Normalize(result);
+}
+
+/******************************************************************************/
+// Compute the eigenvector of symmetric matrix A for eigenvalue `lambda` as the
+// largest cross product between the rows of (A - lambda * I).
+void GetEigenvector(const double a[6], double lambda, double result[3]) {
+  double rows[3][3] = {{a[0] - lambda, a[1], a[2]},
+                       {a[1], a[3] - lambda, a[4]},
+                       {a[2], a[4], a[5] - lambda}};
+  double candidates[3][3];
+  Cross(rows[0], rows[1], candidates[0]);
+  Cross(rows[0], rows[2], candidates[1]);
+  Cross(rows[1], rows[2], candidates[2]);
+
+  int best = 0;
+  double best_norm2 = Dot(candidates[0], candidates[0]);
+  for (int i = 1; i < 3; ++i) {
+    double norm2 = Dot(candidates[i], candidates[i]);
+    if (norm2 > best_norm2) {
+      best = i;
+      best_norm2 = norm2;
+    }
+  }
+
+  double norm = std::sqrt(best_norm2);
+  for (int i = 0; i < 3; ++i) {
+    result[i] = candidates[best][i] / norm;
+  }
+}
+
+/******************************************************************************/
+// Compute the eigenvectors for a single matrix (upper triangle: xx, xy, xz,
+// yy, yz, zz), given its eigenvalues in descending order. The results are
+// stored as the columns of `vectors`.
+void ComputeEigenvectors(const double a[6], const double lambda[3],
+                         double vectors[9]) {
+  double v[3][3];
+  double scale = std::max(std::fabs(lambda[0]), std::fabs(lambda[2]));
+  double tolerance = 1e-12 * scale;
+
+  if (!(lambda[0] - lambda[2] > tolerance)) {
+    // All eigenvalues are equal (or the matrix contains NAN values): any basis
+    // is valid.
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        v[i][j] = (i == j) ? 1.0 : 0.0;
+      }
+    }
+
+    if (std::isnan(scale)) {
+      for (int i = 0; i < 3; ++i) {
+        v[i][0] = v[i][1] = v[i][2] = NAN;
+      }
+    }
+  } else if (lambda[0] - lambda[1] <= tolerance) {
+    // The two largest eigenvalues are repeated: only the smallest eigenvector
+    // is unique.
+    GetEigenvector(a, lambda[2], v[2]);
+    GetPerpendicular(v[2], v[0]);
+    Cross(v[2], v[0], v[1]);
+  } else if (lambda[1] - lambda[2] <= tolerance) {
+    // The two smallest eigenvalues are repeated.
+    GetEigenvector(a, lambda[0], v[0]);
+    GetPerpendicular(v[0], v[1]);
+    Cross(v[0], v[1], v[2]);
+  } else {
+    GetEigenvector(a, lambda[0], v[0]);
+    GetEigenvector(a, lambda[2], v[2]);
+
+    // Re-orthogonalize the smallest eigenvector against the largest one, then
+    // complete the right-handed basis.
+    double d = Dot(v[0], v[2]);
+    for (int i = 0; i < 3; ++i) {
+      v[2][i] -= d * v[0][i];
+    }
+    Normalize(v[2]);
+    Cross(v[2], v[0], v[1]);
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      vectors[i * 3 + j] = v[j][i];
+    }
+  }
+}
+
+/******************************************************************************/
+// Compute `R * P * R^T` for row-major 3x3 matrices.
+inline void Rotate(const double R[9], const double P[9], double result[9]) {
+  double RP[9];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      RP[i * 3 + j] = R[i * 3 + 0] * P[0 * 3 + j] +
+                      R[i * 3 + 1] * P[1 * 3 + j] +
+                      R[i * 3 + 2] * P[2 * 3 + j];
+    }
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      result[i * 3 + j] = RP[i * 3 + 0] * R[j * 3 + 0] +
+                          RP[i * 3 + 1] * R[j * 3 + 1] +
+                          RP[i * 3 + 2] * R[j * 3 + 2];
+    }
+  }
+}
+
+/******************************************************************************/
+void RotateCovariance(const double* input, const double* quaternions,
+                      size_t count, double* output, bool to_body) {
+  for (size_t i = 0; i < count; ++i) {
+    double C[9];
+    GetBodyToENURotationFromQuaternion(quaternions + i * 4, C);
+    if (to_body) {
+      // Transpose to get the ENU->body rotation.
+      std::swap(C[1], C[3]);
+      std::swap(C[2], C[6]);
+      std::swap(C[5], C[7]);
+    }
+
+    double P[9];
+    std::copy(input + i * 9, input + i * 9 + 9, P);
+    Rotate(C, P, output + i * 9);
+  }
+}
+
+/******************************************************************************/
+// Gaussian CDF for the norm of a `dimensions`-dimensional standard normal
+// vector (i.e., the chi distribution).
+double GetChiCDF(double k, int dimensions) {
+  switch (dimensions) {
+    case 1:
+      return std::erf(k / std::sqrt(2.0));
+    case 2:
+      return 1.0 - std::exp(-0.5 * k * k);
+    default:
+      return std::erf(k / std::sqrt(2.0)) -
+             std::sqrt(2.0 / PI) * k * std::exp(-0.5 * k * k);
+  }
+}
+} // namespace
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/******************************************************************************/
+void ComputeSymmetricEigen3x3(const double* matrices, size_t count,
+                              double* eigenvalues, double* eigenvectors) {
+  // Structure-of-arrays working storage for the upper triangle and results.
+  double a[6][BLOCK_SIZE];
+  double lambda[3][BLOCK_SIZE];
+
+  for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+    size_t n = std::min(BLOCK_SIZE, count - start);
+    const double* input = matrices + start * 9;
+
+    for (size_t i = 0; i < n; ++i) {
+      a[0][i] = input[i * 9 + 0];
+      a[1][i] = input[i * 9 + 1];
+      a[2][i] = input[i * 9 + 2];
+      a[3][i] = input[i * 9 + 4];
+      a[4][i] = input[i * 9 + 5];
+      a[5][i] = input[i * 9 + 8];
+    }
+
+    // Closed form solution of the characteristic polynomial (Smith, 1961).
+    for (size_t i = 0; i < n; ++i) {
+      double xx = a[0][i], xy = a[1][i], xz = a[2][i];
+      double yy = a[3][i], yz = a[4][i], zz = a[5][i];
+
+      double q = (xx + yy + zz) / 3.0;
+      double off_diag = xy * xy + xz * xz + yz * yz;
+      double dxx = xx - q, dyy = yy - q, dzz = zz - q;
+      double p = std::sqrt(
+          (dxx * dxx + dyy * dyy + dzz * dzz + 2.0 * off_diag) / 6.0);
+      double inv_p = p > 0.0 ? 1.0 / p : 0.0;
+
+      // B = (A - q * I) / p, r = det(B) / 2.
+      double bxx = dxx * inv_p, byy = dyy * inv_p, bzz = dzz * inv_p;
+      double bxy = xy * inv_p, bxz = xz * inv_p, byz = yz * inv_p;
+      double r = 0.5 * (bxx * (byy * bzz - byz * byz) -
+                        bxy * (bxy * bzz - byz * bxz) +
+                        bxz * (bxy * byz - byy * bxz));
+      r = r < -1.0 ? -1.0 : (r > 1.0 ? 1.0 : r);
+
+      double phi = std::acos(r) / 3.0;
+      double l0 = q + 2.0 * p * std::cos(phi);
+      double l2 = q + 2.0 * p * std::cos(phi + 2.0 * PI / 3.0);
+      lambda[0][i] = l0;
+      lambda[1][i] = 3.0 * q - l0 - l2;
+      lambda[2][i] = l2;
+    }
+
+    double* output = eigenvalues + start * 3;
+    for (size_t i = 0; i < n; ++i) {
+      output[i * 3 + 0] = lambda[0][i];
+      output[i * 3 + 1] = lambda[1][i];
+      output[i * 3 + 2] = lambda[2][i];
+    }
+
+    if (eigenvectors != nullptr) {
+      for (size_t i = 0; i < n; ++i) {
+        double upper[6] = {a[0][i], a[1][i], a[2][i],
+                           a[3][i], a[4][i], a[5][i]};
+        ComputeEigenvectors(upper, output + i * 3,
+                            eigenvectors + (start + i) * 9);
+      }
+    }
+  }
+}
+
+/******************************************************************************/
+void ComputeErrorEllipses(const double* cov_enu_m2, size_t count,
+                          ErrorEllipse* ellipses, double scale) {
+  double ee[BLOCK_SIZE], en[BLOCK_SIZE], nn[BLOCK_SIZE];
+
+  for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+    size_t n = std::min(BLOCK_SIZE, count - start);
+    const double* input = cov_enu_m2 + start * 9;
+
+    for (size_t i = 0; i < n; ++i) {
+      ee[i] = input[i * 9 + 0];
+      en[i] = input[i * 9 + 1];
+      nn[i] = input[i * 9 + 4];
+    }
+
+    ErrorEllipse* output = ellipses + start;
+    for (size_t i = 0; i < n; ++i) {
+      double mean = 0.5 * (ee[i] + nn[i]);
+      double half_diff = 0.5 * (ee[i] - nn[i]);
+      double radius = std::sqrt(half_diff * half_diff + en[i] * en[i]);
+      double minor_var = mean - radius;
+      // Note: Written so that NAN propagates to the result.
+      minor_var = minor_var < 0.0 ? 0.0 : minor_var;
+
+      output[i].semi_major_m = std::sqrt(mean + radius) * scale;
+      output[i].semi_minor_m = std::sqrt(minor_var) * scale;
+      output[i].orientation_deg =
+          0.5 * std::atan2(2.0 * en[i], ee[i] - nn[i]) * RAD_TO_DEG;
+    }
+  }
+}
+
+/******************************************************************************/
+double GetConfidenceScale(double probability, int dimensions) {
+  if (!(probability > 0.0 && probability < 1.0) || dimensions < 1 ||
+      dimensions > 3) {
+    return NAN;
+  } else if (dimensions == 2) {
+    return std::sqrt(-2.0 * std::log(1.0 - probability));
+  }
+
+  // No closed form inverse: bisect the CDF, which is monotonic in k.
+  double low = 0.0, high = 40.0;
+  for (int i = 0; i < 100 && high - low > 1e-12; ++i) {
+    double mid = 0.5 * (low + high);
+    if (GetChiCDF(mid, dimensions) < probability) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return 0.5 * (low + high);
+}
+
+/******************************************************************************/
+void RotateCovarianceENUToBody(const double* cov_enu,
+                               const double* quaternions, size_t count,
+                               double* cov_body) {
+  RotateCovariance(cov_enu, quaternions, count, cov_body, true);
+}
+
+/******************************************************************************/
+void RotateCovarianceBodyToENU(const double* cov_body,
+                               const double* quaternions, size_t count,
+                               double* cov_enu) {
+  RotateCovariance(cov_body, quaternions, count, cov_enu, false);
+}
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,140 @@
+/**************************************************************************/ /**
+ * @brief Batched position covariance processing.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+#include "point_one/fusion_engine/common/portability.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/**
+ * @defgroup covariance Covariance Processing
+ * @brief Eigendecomposition, error ellipses, and frame rotation for 3x3
+ *        position covariance matrices.
+ *
+ * All functions operate on a batch of epochs stored contiguously, using the
+ * same layout as the corresponding message fields so data can be copied
+ * directly from a sequence of @ref messages::PoseAuxMessage:
+ * - Covariance matrices are 3x3, row-major, 9 values per epoch (see @ref
+ *   messages::PoseAuxMessage::position_cov_enu_m2).
+ * - Quaternions are 4 values per epoch, scalar last (see @ref
+ *   messages::PoseAuxMessage::attitude_quaternion).
+ *
+ * Epochs are processed in fixed-size blocks whose inner loops use closed form,
+ * branch-free expressions, so they are suitable for auto-vectorization by the
+ * compiler. Epochs containing `NAN` values produce `NAN` outputs.
+ * @{
+ */
+
+/**
+ * @brief A horizontal error ellipse.
+ */
+struct ErrorEllipse {
+  /** The length of the semi-major axis (in meters). */
+  double semi_major_m;
+
+  /** The length of the semi-minor axis (in meters). */
+  double semi_minor_m;
+
+  /**
+   * The orientation of the semi-major axis (in degrees), measured from east in
+   * a counter-clockwise direction, in the range (-90, 90] (same convention as
+   * @ref messages::PoseMessage::ypr_deg yaw).
+   */
+  double orientation_deg;
+};
+
+/**
+ * @brief Compute the eigenvalues, and optionally eigenvectors, of a batch of
+ *        symmetric 3x3 matrices.
+ *
+ * Only the upper triangle of each matrix is used.
+ *
+ * @param matrices The input matrices (9 values per epoch).
+ * @param count The number of epochs.
+ * @param[out] eigenvalues The eigenvalues of each matrix, in descending order
+ *        (3 values per epoch).
+ * @param[out] eigenvectors If not `nullptr`, the corresponding unit
+ *        eigenvectors, stored as the columns of a row-major 3x3 matrix (9
+ *        values per epoch). The columns form a right-handed orthonormal basis.
+ */
+P1_EXPORT void ComputeSymmetricEigen3x3(const double* matrices, size_t count,
+                                        double* eigenvalues,
+                                        double* eigenvectors = nullptr);
+
+/**
+ * @brief Compute the horizontal (east/north) error ellipse for a batch of ENU
+ *        covariance matrices.
+ *
+ * @param cov_enu_m2 The input ENU covariance matrices (9 values per epoch).
+ * @param count The number of epochs.
+ * @param[out] ellipses The error ellipse for each epoch.
+ * @param scale A scale factor applied to the ellipse axes (e.g., computed
+ *        using @ref GetConfidenceScale() with `dimensions == 2`). By default,
+ *        the 1-sigma ellipse is returned.
+ */
+P1_EXPORT void ComputeErrorEllipses(const double* cov_enu_m2, size_t count,
+                                    ErrorEllipse* ellipses, double scale = 1.0);
+
+/**
+ * @brief Get the factor by which 1-sigma uncertainties must be scaled to
+ *        contain the specified probability for a Gaussian distribution.
+ *
+ * For example, `GetConfidenceScale(0.95, 2)` returns 2.4477: the 95% error
+ * ellipse axes are 2.4477 times the 1-sigma axes.
+ *
+ * @param probability The desired probability, in the range (0, 1).
+ * @param dimensions The number of dimensions (1, 2, or 3).
+ *
+ * @return The scale factor, or `NAN` if the arguments are invalid.
+ */
+P1_EXPORT double GetConfidenceScale(double probability, int dimensions);
+
+/**
+ * @brief Rotate a batch of covariance matrices from the local ENU frame to the
+ *        platform body frame.
+ *
+ * Computes `C^T * P * C`, where `C` is the body->ENU rotation described by
+ * each quaternion.
+ *
+ * @param cov_enu The input ENU covariance matrices (9 values per epoch).
+ * @param quaternions The body orientation with respect to ENU for each epoch
+ *        (x, y, z, w). Quaternions do not need to be normalized.
+ * @param count The number of epochs.
+ * @param[out] cov_body The output body frame covariance matrices (9 values per
+ *        epoch). May be the same as `cov_enu`.
+ */
+P1_EXPORT void RotateCovarianceENUToBody(const double* cov_enu,
+                                         const double* quaternions,
+                                         size_t count, double* cov_body);
+
+/**
+ * @brief Rotate a batch of covariance matrices from the platform body frame to
+ *        the local ENU frame.
+ *
+ * Computes `C * P * C^T`, where `C` is the body->ENU rotation described by
+ * each quaternion.
+ *
+ * @param cov_body The input body frame covariance matrices (9 values per
+ *        epoch).
+ * @param quaternions The body orientation with respect to ENU for each epoch
+ *        (x, y, z, w). Quaternions do not need to be normalized.
+ * @param count The number of epochs.
+ * @param[out] cov_enu The output ENU covariance matrices (9 values per epoch).
+ *        May be the same as `cov_body`.
+ */
+P1_EXPORT void RotateCovarianceBodyToENU(const double* cov_body,
+                                         const double* quaternions,
+                                         size_t count, double* cov_enu);
+
+/** @} */
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
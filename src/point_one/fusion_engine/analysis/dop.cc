@@ -0,0 +1,248 @@
+/**************************************************************************/ /**
+ * @brief Dilution of precision (DOP) computation from satellite geometry.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/analysis/dop.h"
+
+#include <cstring>
+#include <vector>
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+using namespace point_one::fusion_engine::analysis;
+using namespace point_one::fusion_engine::geodesy;
+using namespace point_one::fusion_engine::messages;
+
+namespace {
+constexpr size_t MAX_SYSTEMS = 32;
+
+/**
+ * @brief The ENU line-of-sight unit vector to a satellite.
+ */
+struct LineOfSight {
+  double u[3];
+  float elevation_deg;
+  uint32_t system_bit;
+  uint8_t system;
+  bool used;
+};
+
+/**
+ * @brief Normal equation terms for the position states. Clock states are
+ *        represented by the per-system sums of the position terms.
+ */
+struct Accumulator {
+  // Upper triangle of sum(u * u^T): xx, xy, xz, yy, yz, zz.
+  double a[6];
+  // Per-system sum(u) and satellite count.
+  double b[MAX_SYSTEMS][3];
+  uint16_t n[MAX_SYSTEMS];
+  uint32_t systems_present;
+  uint16_t num_satellites;
+};
+
+/******************************************************************************/
+size_t ComputeLinesOfSight(const SatelliteInfo* satellites, size_t count,
+                           LineOfSight* los) {
+  size_t num_valid = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const SatelliteInfo& sv = satellites[i];
+    if (std::isnan(sv.azimuth_deg) || std::isnan(sv.elevation_deg)) {
+      continue;
+    }
+
+    double az = sv.azimuth_deg * DEG_TO_RAD;
+    double el = sv.elevation_deg * DEG_TO_RAD;
+    LineOfSight& entry = los[num_valid++];
+    entry.u[0] = std::cos(el) * std::sin(az);
+    entry.u[1] = std::cos(el) * std::cos(az);
+    entry.u[2] = std::sin(el);
+    entry.elevation_deg = sv.elevation_deg;
+    uint8_t system = static_cast<uint8_t>(sv.system);
+    entry.system_bit = system < MAX_SYSTEMS ? (1u << system) : 0u;
+    entry.system = system;
+    entry.used = (sv.usage & SatelliteInfo::SATELLITE_USED) != 0;
+  }
+  return num_valid;
+}
+
+/******************************************************************************/
+void Accumulate(const LineOfSight* los, size_t count, const DOPOptions& options,
+                Accumulator* acc) {
+  std::memset(acc, 0, sizeof(*acc));
+  for (size_t i = 0; i < count; ++i) {
+    const LineOfSight& entry = los[i];
+    if ((entry.system_bit & options.system_mask) == 0 ||
+        entry.elevation_deg < options.min_elevation_deg ||
+        (options.used_only && !entry.used)) {
+      continue;
+    }
+
+    const double* u = entry.u;
+    acc->a[0] += u[0] * u[0];
+    acc->a[1] += u[0] * u[1];
+    acc->a[2] += u[0] * u[2];
+    acc->a[3] += u[1] * u[1];
+    acc->a[4] += u[1] * u[2];
+    acc->a[5] += u[2] * u[2];
+
+    // Entries that passed the mask test above have system < MAX_SYSTEMS.
+    size_t system = entry.system;
+    acc->b[system][0] += u[0];
+    acc->b[system][1] += u[1];
+    acc->b[system][2] += u[2];
+    ++acc->n[system];
+    acc->systems_present |= entry.system_bit;
+    ++acc->num_satellites;
+  }
+}
+
+/******************************************************************************/
+// Subtract b * b^T / n from the upper triangle of a symmetric matrix.
+inline void SubtractOuterProduct(const double b[3], double n, double m[6]) {
+  m[0] -= b[0] * b[0] / n;
+  m[1] -= b[0] * b[1] / n;
+  m[2] -= b[0] * b[2] / n;
+  m[3] -= b[1] * b[1] / n;
+  m[4] -= b[1] * b[2] / n;
+  m[5] -= b[2] * b[2] / n;
+}
+
+/******************************************************************************/
+DOPResult Solve(const Accumulator& acc, DOPOptions::ClockModel clock_model) {
+  DOPResult result;
+  result.num_satellites = acc.num_satellites;
+
+  // Eliminate the clock state(s) from the normal equations. For normal matrix
+  // [A b; b^T n], the position block of the inverse is (A - b b^T / n)^-1.
+  double m[6];
+  std::memcpy(m, acc.a, sizeof(m));
+  double total_b[3] = {0.0, 0.0, 0.0};
+  size_t num_clocks = 0;
+  for (size_t s = 0; s < MAX_SYSTEMS; ++s) {
+    if ((acc.systems_present & (1u << s)) == 0) {
+      continue;
+    }
+
+    if (clock_model == DOPOptions::ClockModel::PER_SYSTEM) {
+      SubtractOuterProduct(acc.b[s], acc.n[s], m);
+      ++num_clocks;
+    } else {
+      for (int j = 0; j < 3; ++j) {
+        total_b[j] += acc.b[s][j];
+      }
+      num_clocks = 1;
+    }
+  }
+
+  if (clock_model == DOPOptions::ClockModel::SINGLE && num_clocks > 0) {
+    SubtractOuterProduct(total_b, acc.num_satellites, m);
+  }
+
+  if (acc.num_satellites < 3 + num_clocks) {
+    return result;
+  }
+
+  // Invert the 3x3 symmetric matrix using cofactors.
+  double c00 = m[3] * m[5] - m[4] * m[4];
+  double c01 = m[2] * m[4] - m[1] * m[5];
+  double c02 = m[1] * m[4] - m[2] * m[3];
+  double c11 = m[0] * m[5] - m[2] * m[2];
+  double c12 = m[1] * m[2] - m[0] * m[4];
+  double c22 = m[0] * m[3] - m[1] * m[1];
+  double det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+
+  // Reject degenerate geometries (e.g., all satellites in a plane).
+  double scale = (m[0] + m[3] + m[5]) / 3.0;
+  if (!(det > 1e-9 * scale * scale * scale)) {
+    return result;
+  }
+
+  double q00 = c00 / det, q11 = c11 / det, q22 = c22 / det;
+  result.hdop = static_cast<float>(std::sqrt(q00 + q11));
+  result.vdop = static_cast<float>(std::sqrt(q22));
+  result.pdop = static_cast<float>(std::sqrt(q00 + q11 + q22));
+
+  if (clock_model == DOPOptions::ClockModel::SINGLE) {
+    // Clock variance: 1 / n + b^T Q b / n^2.
+    double n = acc.num_satellites;
+    const double* b = total_b;
+    double bQb = (c00 * b[0] * b[0] + c11 * b[1] * b[1] + c22 * b[2] * b[2] +
+                  2.0 * (c01 * b[0] * b[1] + c02 * b[0] * b[2] +
+                         c12 * b[1] * b[2])) /
+                 det;
+    double q_tt = 1.0 / n + bQb / (n * n);
+    result.tdop = static_cast<float>(std::sqrt(q_tt));
+    result.gdop = static_cast<float>(std::sqrt(q00 + q11 + q22 + q_tt));
+  }
+
+  return result;
+}
+} // namespace
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/******************************************************************************/
+void ComputeDOPs(const SatelliteInfo* satellites, const size_t* epoch_offsets,
+                 size_t num_epochs, const DOPOptions* options,
+                 size_t num_options, DOPResult* results) {
+  std::vector<LineOfSight> los;
+  Accumulator acc;
+  for (size_t i = 0; i < num_epochs; ++i) {
+    size_t first = epoch_offsets[i];
+    size_t count = epoch_offsets[i + 1] - first;
+    if (los.size() < count) {
+      los.resize(count);
+    }
+
+    size_t num_valid = ComputeLinesOfSight(satellites + first, count,
+                                           los.data());
+    for (size_t j = 0; j < num_options; ++j) {
+      Accumulate(los.data(), num_valid, options[j], &acc);
+      results[i * num_options + j] = Solve(acc, options[j].clock_model);
+    }
+  }
+}
+
+/******************************************************************************/
+DOPResult ComputeDOP(const SatelliteInfo* satellites, size_t num_satellites,
+                     const DOPOptions& options) {
+  size_t epoch_offsets[2] = {0, num_satellites};
+  DOPResult result;
+  ComputeDOPs(satellites, epoch_offsets, 1, &options, 1, &result);
+  return result;
+}
+
+/******************************************************************************/
+bool ComputeDOP(const void* payload, size_t payload_size_bytes,
+                const DOPOptions& options, DOPResult* result) {
+  if (payload_size_bytes < sizeof(GNSSSatelliteMessage)) {
+    return false;
+  }
+
+  GNSSSatelliteMessage message;
+  std::memcpy(&message, payload, sizeof(message));
+  if (payload_size_bytes < sizeof(GNSSSatelliteMessage) +
+                               message.num_satellites * sizeof(SatelliteInfo)) {
+    return false;
+  }
+
+  // Copy the satellites to guarantee alignment.
+  std::vector<SatelliteInfo> satellites(message.num_satellites);
+  if (!satellites.empty()) {
+    std::memcpy(satellites.data(),
+                static_cast<const uint8_t*>(payload) +
+                    sizeof(GNSSSatelliteMessage),
+                satellites.size() * sizeof(SatelliteInfo));
+  }
+
+  *result = ComputeDOP(satellites.data(), satellites.size(), options);
+  return true;
+}
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
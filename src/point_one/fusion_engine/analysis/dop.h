@@ -0,0 +1,154 @@
+/**************************************************************************/ /**
+ * @brief Dilution of precision (DOP) computation from satellite geometry.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cmath> // For NAN
+#include <cstddef>
+#include <cstdint>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/**
+ * @defgroup dop Dilution of Precision
+ * @brief Recompute DOP values from the satellite azimuth and elevation angles
+ *        reported in @ref messages::GNSSSatelliteMessage.
+ *
+ * DOP values describe how satellite geometry amplifies range errors into
+ * position and clock errors, assuming equally weighted, uncorrelated range
+ * measurements. In addition to reproducing the values reported in @ref
+ * messages::GNSSInfoMessage, DOPs may be computed for hypothetical subsets of
+ * satellites (e.g., GPS only, or above an elevation mask) to study
+ * constellation availability.
+ *
+ * Each receiver clock parameter is eliminated analytically from the normal
+ * equations, so every DOP computation reduces to accumulating and inverting a
+ * single 3x3 matrix, regardless of the number of satellites.
+ * @{
+ */
+
+/**
+ * @brief Get the bit corresponding to a satellite system in @ref
+ *        DOPOptions::system_mask.
+ */
+constexpr uint32_t GetSystemMask(messages::SatelliteType system) {
+  return 1u << static_cast<uint8_t>(system);
+}
+
+/**
+ * @brief Satellite selection and clock model for a DOP computation.
+ */
+struct DOPOptions {
+  enum class ClockModel : uint8_t {
+    /** A single receiver clock bias shared by all satellites. */
+    SINGLE = 0,
+    /**
+     * A separate receiver clock bias for each satellite system (i.e., inter-
+     * system biases are estimated). @ref DOPResult::tdop and @ref
+     * DOPResult::gdop are not defined for this model and are set to `NAN`.
+     */
+    PER_SYSTEM = 1,
+  };
+
+  /**
+   * A bitmask of the satellite systems to be included (see @ref
+   * GetSystemMask()). By default, all systems are included.
+   */
+  uint32_t system_mask = 0xFFFFFFFF;
+
+  /** Exclude satellites below this elevation (in degrees). */
+  float min_elevation_deg = -90.0f;
+
+  /**
+   * If `true`, only include satellites used in the navigation solution (@ref
+   * messages::SatelliteInfo::SATELLITE_USED). Otherwise, include all satellites
+   * with a valid azimuth and elevation.
+   */
+  bool used_only = true;
+
+  ClockModel clock_model = ClockModel::SINGLE;
+};
+
+/**
+ * @brief The DOP values for a single epoch.
+ *
+ * All values are set to `NAN` if the geometry is insufficient (too few
+ * satellites, or a degenerate geometry).
+ */
+struct DOPResult {
+  float gdop = NAN;
+  float pdop = NAN;
+  float hdop = NAN;
+  float vdop = NAN;
+  float tdop = NAN;
+
+  /** The number of satellites included in the computation. */
+  uint16_t num_satellites = 0;
+};
+
+/**
+ * @brief Compute DOP values for a batch of epochs, optionally for several
+ *        satellite selections at once.
+ *
+ * Satellites for all epochs are stored contiguously: the satellites for epoch
+ * `i` are `satellites[epoch_offsets[i]]` through
+ * `satellites[epoch_offsets[i + 1] - 1]`. Line-of-sight vectors are computed
+ * once per satellite and shared by all selections.
+ *
+ * @param satellites The satellites for all epochs.
+ * @param epoch_offsets The index of the first satellite for each epoch
+ *        (`num_epochs + 1` values, where the last value is the total number of
+ *        satellites).
+ * @param num_epochs The number of epochs.
+ * @param options The satellite selections to be evaluated.
+ * @param num_options The number of selections.
+ * @param[out] results The DOP values (`num_epochs * num_options` values). The
+ *        result for epoch `i` and selection `j` is stored at index
+ *        `i * num_options + j`.
+ */
+P1_EXPORT void ComputeDOPs(const messages::SatelliteInfo* satellites,
+                           const size_t* epoch_offsets, size_t num_epochs,
+                           const DOPOptions* options, size_t num_options,
+                           DOPResult* results);
+
+/**
+ * @brief Compute DOP values for a single epoch.
+ *
+ * @param satellites The satellites.
+ * @param num_satellites The number of satellites.
+ * @param options The satellite selection.
+ *
+ * @return The DOP values.
+ */
+P1_EXPORT DOPResult ComputeDOP(const messages::SatelliteInfo* satellites,
+                               size_t num_satellites,
+                               const DOPOptions& options = DOPOptions());
+
+/**
+ * @brief Compute DOP values from a serialized @ref
+ *        messages::GNSSSatelliteMessage payload.
+ *
+ * @param payload The message payload, including the trailing @ref
+ *        messages::SatelliteInfo entries.
+ * @param payload_size_bytes The size of the payload.
+ * @param options The satellite selection.
+ * @param[out] result The DOP values.
+ *
+ * @return `true` on success, or `false` if the payload is too small for the
+ *         number of satellites it specifies.
+ */
+P1_EXPORT bool ComputeDOP(const void* payload, size_t payload_size_bytes,
+                          const DOPOptions& options, DOPResult* result);
+
+/** @} */
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,327 @@
+/**************************************************************************/ /**
+ * @brief Streaming detection of solution quality events.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/analysis/event_detector.h"
+
+#include <cstring> // For memcpy()
+#include <fstream>
+
+using namespace point_one::fusion_engine::analysis;
+using namespace point_one::fusion_engine::messages;
+
+namespace {
+#pragma pack(push, 4)
+struct EventIndexFileHeader {
+  static constexpr uint32_t MAGIC = 0x56453150; // 'P1EV'
+  static constexpr uint16_t VERSION = 1;
+
+  uint32_t magic = MAGIC;
+  uint16_t version = VERSION;
+  uint16_t record_size_bytes = sizeof(EventRecord);
+  uint64_t log_size_bytes = 0;
+  uint64_t num_records = 0;
+};
+#pragma pack(pop)
+
+/******************************************************************************/
+bool IsValid(const Timestamp& time) {
+  return time.seconds != Timestamp::INVALID &&
+         time.fraction_ns != Timestamp::INVALID;
+}
+
+/******************************************************************************/
+// Copy a payload into a local message, checking that the payload is large
+// enough first. Payloads may be truncated or unaligned.
+template <typename T>
+bool ReadPayload(const MessageHeader& header, const void* payload, T& message) {
+  if (header.payload_size_bytes < sizeof(T)) {
+    return false;
+  } else {
+    std::memcpy(&message, payload, sizeof(T));
+    return true;
+  }
+}
+
+/******************************************************************************/
+double ToSeconds(const Timestamp& time) {
+  return time.seconds + (time.fraction_ns * 1e-9);
+}
+
+/******************************************************************************/
+EventRecord MakeEvent(const MessageHeader& header, const Timestamp& p1_time,
+                      uint64_t offset_bytes, EventType type,
+                      double previous_value, double current_value) {
+  EventRecord event;
+  event.offset_bytes = offset_bytes;
+  event.p1_time = p1_time;
+  event.type = type;
+  event.source_identifier = header.source_identifier;
+  event.previous_value = previous_value;
+  event.current_value = current_value;
+  return event;
+}
+} // namespace
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/******************************************************************************/
+std::string to_string(EventType type) {
+  switch (type) {
+    case EventType::INVALID:
+      return "Invalid";
+
+    case EventType::SOLUTION_TYPE_CHANGED:
+      return "Solution Type Changed";
+
+    case EventType::PROTECTION_LEVEL_EXCEEDED:
+      return "Protection Level Exceeded";
+
+    case EventType::PROTECTION_LEVEL_RECOVERED:
+      return "Protection Level Recovered";
+
+    case EventType::DIFFERENTIAL_STALE:
+      return "Differential Corrections Stale";
+
+    case EventType::DIFFERENTIAL_RESTORED:
+      return "Differential Corrections Restored";
+
+    default:
+      if (static_cast<uint16_t>(type) >=
+          static_cast<uint16_t>(EventType::USER_DEFINED)) {
+        return "User-Defined Event (" + std::to_string((int)type) + ")";
+      } else {
+        return "Unrecognized Event (" + std::to_string((int)type) + ")";
+      }
+  }
+}
+
+/******************************************************************************/
+void SolutionTypeChangeRule::OnMessage(const MessageHeader& header,
+                                       const void* payload,
+                                       uint64_t offset_bytes,
+                                       const EventCallback& emit) {
+  if (header.message_type != MessageType::POSE) {
+    return;
+  }
+
+  PoseMessage pose;
+  if (!ReadPayload(header, payload, pose)) {
+    return;
+  }
+
+  auto it = last_type_.emplace(header.source_identifier, SolutionType::Invalid)
+                .first;
+  if (pose.solution_type != it->second) {
+    emit(MakeEvent(header, pose.p1_time, offset_bytes,
+                   EventType::SOLUTION_TYPE_CHANGED,
+                   static_cast<double>(it->second),
+                   static_cast<double>(pose.solution_type)));
+    it->second = pose.solution_type;
+  }
+}
+
+/******************************************************************************/
+void ProtectionLevelRule::OnMessage(const MessageHeader& header,
+                                    const void* payload, uint64_t offset_bytes,
+                                    const EventCallback& emit) {
+  if (header.message_type != MessageType::POSE) {
+    return;
+  }
+
+  PoseMessage pose;
+  if (!ReadPayload(header, payload, pose)) {
+    return;
+  }
+
+  float value_m;
+  switch (level_) {
+    case Level::AGGREGATE:
+      value_m = pose.aggregate_protection_level_m;
+      break;
+    case Level::HORIZONTAL:
+      value_m = pose.horizontal_protection_level_m;
+      break;
+    case Level::VERTICAL:
+    default:
+      value_m = pose.vertical_protection_level_m;
+      break;
+  }
+
+  if (std::isnan(value_m)) {
+    return;
+  }
+
+  bool& exceeded = exceeded_.emplace(header.source_identifier, false)
+                       .first->second;
+  if (!exceeded && value_m > threshold_m_) {
+    exceeded = true;
+    EventRecord event =
+        MakeEvent(header, pose.p1_time, offset_bytes,
+                  EventType::PROTECTION_LEVEL_EXCEEDED, threshold_m_, value_m);
+    event.detail = static_cast<uint16_t>(level_);
+    emit(event);
+  } else if (exceeded && value_m <= threshold_m_ - hysteresis_m_) {
+    exceeded = false;
+    EventRecord event =
+        MakeEvent(header, pose.p1_time, offset_bytes,
+                  EventType::PROTECTION_LEVEL_RECOVERED, threshold_m_, value_m);
+    event.detail = static_cast<uint16_t>(level_);
+    emit(event);
+  }
+}
+
+/******************************************************************************/
+void DifferentialAgeRule::OnMessage(const MessageHeader& header,
+                                    const void* payload, uint64_t offset_bytes,
+                                    const EventCallback& emit) {
+  if (header.message_type != MessageType::GNSS_INFO) {
+    return;
+  }
+
+  GNSSInfoMessage info;
+  if (!ReadPayload(header, payload, info) || !IsValid(info.p1_time)) {
+    return;
+  }
+
+  double age_sec = NAN;
+  if (IsValid(info.last_differential_time)) {
+    age_sec = ToSeconds(info.p1_time) - ToSeconds(info.last_differential_time);
+  }
+
+  // A negative age means the two times do not share a time base (e.g., the
+  // correction time is from before a receiver restart), so the age is unknown.
+  bool stale = std::isnan(age_sec) || age_sec < 0.0 || age_sec > max_age_sec_;
+
+  State& state = state_[header.source_identifier];
+  if (stale != state.stale) {
+    emit(MakeEvent(header, info.p1_time, offset_bytes,
+                   stale ? EventType::DIFFERENTIAL_STALE
+                         : EventType::DIFFERENTIAL_RESTORED,
+                   state.age_sec, age_sec));
+    state.stale = stale;
+  }
+  state.age_sec = age_sec;
+}
+
+/******************************************************************************/
+void EventDetector::AddDefaultRules(float horizontal_protection_level_m,
+                                    double max_differential_age_sec) {
+  AddRule(std::unique_ptr<EventRule>(new SolutionTypeChangeRule()));
+  AddRule(std::unique_ptr<EventRule>(
+      new ProtectionLevelRule(ProtectionLevelRule::Level::HORIZONTAL,
+                              horizontal_protection_level_m)));
+  AddRule(std::unique_ptr<EventRule>(
+      new DifferentialAgeRule(max_differential_age_sec)));
+}
+
+/******************************************************************************/
+void EventDetector::OnMessage(const MessageHeader& header, const void* payload,
+                              uint64_t offset_bytes) {
+  // Note: The callback is created for each message, rather than stored, so it
+  // never refers to a moved-from detector.
+  EventCallback emit = [this](const EventRecord& event) {
+    if (store_events_) {
+      events_.push_back(event);
+    }
+
+    if (callback_) {
+      callback_(event);
+    }
+  };
+
+  for (auto& rule : rules_) {
+    rule->OnMessage(header, payload, offset_bytes, emit);
+  }
+}
+
+/******************************************************************************/
+void EventDetector::Reset() {
+  for (auto& rule : rules_) {
+    rule->Reset();
+  }
+  events_.clear();
+}
+
+/******************************************************************************/
+std::string GetEventIndexPath(const std::string& log_path) {
+  size_t dot = log_path.find_last_of('.');
+  size_t slash = log_path.find_last_of("/\\");
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    return log_path + ".p1e";
+  } else {
+    return log_path.substr(0, dot) + ".p1e";
+  }
+}
+
+/******************************************************************************/
+bool SaveEventIndex(const std::string& path,
+                    const std::vector<EventRecord>& events,
+                    uint64_t log_size_bytes) {
+  std::ofstream stream(path, std::ofstream::binary);
+  if (!stream) {
+    return false;
+  }
+
+  EventIndexFileHeader header;
+  header.log_size_bytes = log_size_bytes;
+  header.num_records = events.size();
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!events.empty()) {
+    stream.write(reinterpret_cast<const char*>(events.data()),
+                 events.size() * sizeof(EventRecord));
+  }
+
+  return static_cast<bool>(stream);
+}
+
+/******************************************************************************/
+bool LoadEventIndex(const std::string& path, std::vector<EventRecord>& events,
+                    uint64_t expected_log_size_bytes) {
+  events.clear();
+
+  std::ifstream stream(path, std::ifstream::binary);
+  if (!stream) {
+    return false;
+  }
+
+  EventIndexFileHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!stream || header.magic != EventIndexFileHeader::MAGIC ||
+      header.version != EventIndexFileHeader::VERSION ||
+      header.record_size_bytes != sizeof(EventRecord)) {
+    return false;
+  } else if (expected_log_size_bytes != 0 &&
+             header.log_size_bytes != expected_log_size_bytes) {
+    return false;
+  }
+
+  // Sanity check the record count against the file size before allocating.
+  stream.seekg(0, stream.end);
+  uint64_t file_size_bytes = static_cast<uint64_t>(stream.tellg());
+  if (file_size_bytes !=
+      sizeof(header) + header.num_records * sizeof(EventRecord)) {
+    return false;
+  }
+  stream.seekg(sizeof(header), stream.beg);
+
+  events.resize(static_cast<size_t>(header.num_records));
+  if (!events.empty()) {
+    stream.read(reinterpret_cast<char*>(events.data()),
+                events.size() * sizeof(EventRecord));
+    if (!stream) {
+      events.clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,340 @@
+/**************************************************************************/ /**
+ * @brief Streaming detection of solution quality events.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cmath> // For NAN
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/**
+ * @defgroup event_detection Solution Quality Event Detection
+ * @brief Extract solution quality transitions from a message stream.
+ *
+ * @ref EventDetector applies a set of @ref EventRule objects to each incoming
+ * message and records an @ref EventRecord every time a rule detects a
+ * transition. Each record includes the byte offset of the triggering message
+ * within the log, so events can be used to seek directly to the relevant data.
+ *
+ * Detected events may be stored in a sidecar event index file (`.p1e`) next to
+ * the log, using @ref SaveEventIndex() and @ref LoadEventIndex(), so they do
+ * not need to be recomputed every time the log is opened.
+ * @{
+ */
+
+/**
+ * @brief Event type identifiers.
+ */
+enum class EventType : uint16_t {
+  INVALID = 0,
+  /** The @ref messages::SolutionType changed. */
+  SOLUTION_TYPE_CHANGED = 1,
+  /** A protection level exceeded its configured threshold. */
+  PROTECTION_LEVEL_EXCEEDED = 2,
+  /** A protection level returned below its configured threshold. */
+  PROTECTION_LEVEL_RECOVERED = 3,
+  /** The age of the differential corrections exceeded its limit. */
+  DIFFERENTIAL_STALE = 4,
+  /** Differential corrections are current again. */
+  DIFFERENTIAL_RESTORED = 5,
+
+  /**
+   * Values at or above this are reserved for user-defined @ref EventRule
+   * implementations.
+   */
+  USER_DEFINED = 0x8000,
+};
+
+/**
+ * @brief Get a human-friendly string name for the specified @ref EventType.
+ *
+ * @param type The desired event type.
+ *
+ * @return The corresponding string name.
+ */
+P1_EXPORT std::string to_string(EventType type);
+
+/**
+ * @brief @ref EventType stream operator.
+ */
+inline std::ostream& operator<<(std::ostream& stream, EventType type) {
+  return (stream << to_string(type));
+}
+
+// Enforce 4-byte alignment and packing of all data structures and values so
+// that floating point values are aligned on platforms that require it.
+#pragma pack(push, 4)
+
+/**
+ * @brief A detected event.
+ *
+ * This structure is stored directly in the event index file.
+ */
+struct EventRecord {
+  /** The byte offset of the message that triggered the event. */
+  uint64_t offset_bytes = 0;
+
+  /** The P1 time of the message that triggered the event. */
+  messages::Timestamp p1_time;
+
+  /** The type of event. */
+  EventType type = EventType::INVALID;
+
+  /**
+   * A rule-specific qualifier. For protection level events, this is a @ref
+   * ProtectionLevelRule::Level value.
+   */
+  uint16_t detail = 0;
+
+  /** The @ref messages::MessageHeader::source_identifier of the message. */
+  uint32_t source_identifier = messages::MessageHeader::INVALID_SOURCE_ID;
+
+  /**
+   * The value before the transition (e.g., the previous solution type).
+   */
+  double previous_value = NAN;
+
+  /** The value after the transition (e.g., the new solution type). */
+  double current_value = NAN;
+};
+
+#pragma pack(pop)
+
+/**
+ * @brief Function called for each detected event.
+ */
+typedef std::function<void(const EventRecord& event)> EventCallback;
+
+/**
+ * @brief Base class for event detection rules.
+ *
+ * Rules are called for every message in the stream and should return quickly
+ * for message types they do not use. Rules must track their state separately
+ * for each @ref messages::MessageHeader::source_identifier.
+ */
+class P1_EXPORT EventRule {
+ public:
+  virtual ~EventRule() = default;
+
+  /**
+   * @brief Process an incoming message.
+   *
+   * @param header The message header.
+   * @param payload The message payload.
+   * @param offset_bytes The byte offset of the message within the log.
+   * @param emit A function to be called for each detected event.
+   */
+  virtual void OnMessage(const messages::MessageHeader& header,
+                         const void* payload, uint64_t offset_bytes,
+                         const EventCallback& emit) = 0;
+
+  /**
+   * @brief Clear all internal state.
+   */
+  virtual void Reset() = 0;
+};
+
+/**
+ * @brief Detect changes in @ref messages::PoseMessage::solution_type.
+ *
+ * The solution type is initially assumed to be @ref
+ * messages::SolutionType::Invalid, so the first valid solution generates an
+ * event.
+ */
+class P1_EXPORT SolutionTypeChangeRule : public EventRule {
+ public:
+  void OnMessage(const messages::MessageHeader& header, const void* payload,
+                 uint64_t offset_bytes, const EventCallback& emit) override;
+  void Reset() override { last_type_.clear(); }
+
+ private:
+  std::unordered_map<uint32_t, messages::SolutionType> last_type_;
+};
+
+/**
+ * @brief Detect when a @ref messages::PoseMessage protection level exceeds a
+ *        threshold.
+ *
+ * A @ref EventType::PROTECTION_LEVEL_EXCEEDED event is generated when the
+ * protection level rises above `threshold_m`, and a @ref
+ * EventType::PROTECTION_LEVEL_RECOVERED event is generated when it falls back
+ * to or below `threshold_m - hysteresis_m`. `NAN` values are ignored.
+ */
+class P1_EXPORT ProtectionLevelRule : public EventRule {
+ public:
+  enum class Level : uint16_t { AGGREGATE = 0, HORIZONTAL = 1, VERTICAL = 2 };
+
+  ProtectionLevelRule(Level level, float threshold_m, float hysteresis_m = 0.0f)
+      : level_(level), threshold_m_(threshold_m), hysteresis_m_(hysteresis_m) {}
+
+  void OnMessage(const messages::MessageHeader& header, const void* payload,
+                 uint64_t offset_bytes, const EventCallback& emit) override;
+  void Reset() override { exceeded_.clear(); }
+
+ private:
+  Level level_;
+  float threshold_m_;
+  float hysteresis_m_;
+  std::unordered_map<uint32_t, bool> exceeded_;
+};
+
+/**
+ * @brief Detect when differential corrections go stale, based on @ref
+ *        messages::GNSSInfoMessage::last_differential_time.
+ *
+ * Corrections are initially assumed to be stale, so the first message with
+ * current corrections generates a @ref EventType::DIFFERENTIAL_RESTORED event.
+ * The event values contain the correction age (in seconds), or `NAN` if no
+ * corrections have been received. A negative age (correction time after the
+ * message time) is treated as stale.
+ */
+class P1_EXPORT DifferentialAgeRule : public EventRule {
+ public:
+  explicit DifferentialAgeRule(double max_age_sec)
+      : max_age_sec_(max_age_sec) {}
+
+  void OnMessage(const messages::MessageHeader& header, const void* payload,
+                 uint64_t offset_bytes, const EventCallback& emit) override;
+  void Reset() override { state_.clear(); }
+
+ private:
+  struct State {
+    bool stale = true;
+    double age_sec = NAN;
+  };
+
+  double max_age_sec_;
+  std::unordered_map<uint32_t, State> state_;
+};
+
+/**
+ * @brief Apply a set of @ref EventRule objects to a message stream.
+ *
+ * ```{.cpp}
+ * EventDetector detector;
+ * detector.AddDefaultRules();
+ * framer.SetMessageCallback(
+ *     [&](const MessageHeader& header, const void* payload, uint64_t offset) {
+ *       detector.OnMessage(header, payload, offset);
+ *     });
+ * ...
+ * SaveEventIndex(GetEventIndexPath(log_path), detector.GetEvents(), log_size);
+ * ```
+ */
+class P1_EXPORT EventDetector {
+ public:
+  /**
+   * @brief Add a rule to be evaluated.
+   *
+   * @param rule The rule to add.
+   */
+  void AddRule(std::unique_ptr<EventRule> rule) {
+    rules_.push_back(std::move(rule));
+  }
+
+  /**
+   * @brief Add the standard rules: solution type changes, horizontal
+   *        protection level above `horizontal_protection_level_m`, and
+   *        differential corrections older than `max_differential_age_sec`.
+   */
+  void AddDefaultRules(float horizontal_protection_level_m = 0.5f,
+                       double max_differential_age_sec = 10.0);
+
+  /**
+   * @brief Set a function to be called for each detected event, in addition
+   *        to storing the event.
+   */
+  void SetEventCallback(EventCallback callback) {
+    callback_ = std::move(callback);
+  }
+
+  /**
+   * @brief Enable or disable storage of detected events (enabled by default).
+   */
+  void SetStoreEvents(bool store) { store_events_ = store; }
+
+  /**
+   * @brief Process an incoming message.
+   *
+   * @param header The message header.
+   * @param payload The message payload.
+   * @param offset_bytes The byte offset of the message within the log.
+   */
+  void OnMessage(const messages::MessageHeader& header, const void* payload,
+                 uint64_t offset_bytes);
+
+  /**
+   * @brief Clear all rule state and stored events.
+   */
+  void Reset();
+
+  /**
+   * @brief Get all events detected so far, in stream order.
+   */
+  const std::vector<EventRecord>& GetEvents() const { return events_; }
+
+ private:
+  std::vector<std::unique_ptr<EventRule>> rules_;
+  std::vector<EventRecord> events_;
+  EventCallback callback_;
+  bool store_events_ = true;
+};
+
+/**
+ * @brief Get the path of the event index file for a log file.
+ *
+ * @param log_path The path to the log (e.g., `/path/to/data.p1log`).
+ *
+ * @return The event index path (e.g., `/path/to/data.p1e`).
+ */
+P1_EXPORT std::string GetEventIndexPath(const std::string& log_path);
+
+/**
+ * @brief Write an event index file.
+ *
+ * @param path The output file path.
+ * @param events The events to be written.
+ * @param log_size_bytes The size of the log from which the events were
+ *        extracted, used to detect stale index files.
+ *
+ * @return `true` on success.
+ */
+P1_EXPORT bool SaveEventIndex(const std::string& path,
+                              const std::vector<EventRecord>& events,
+                              uint64_t log_size_bytes);
+
+/**
+ * @brief Read an event index file.
+ *
+ * @param path The input file path.
+ * @param[out] events The events read from the file.
+ * @param expected_log_size_bytes If nonzero, fail if the index was generated
+ *        from a log of a different size (e.g., the log is still being
+ *        recorded).
+ *
+ * @return `true` on success, or `false` if the file does not exist, is
+ *         invalid, or is stale.
+ */
+P1_EXPORT bool LoadEventIndex(const std::string& path,
+                              std::vector<EventRecord>& events,
+                              uint64_t expected_log_size_bytes = 0);
+
+/** @} */
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,649 @@
+/**************************************************************************/ /**
+ * @brief Cache-friendly time index for large collections of log messages.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/analysis/log_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  define P1_HAVE_SSE2 1
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  define P1_HAVE_NEON 1
+#  include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define P1_PREFETCH(address) __builtin_prefetch(address)
+#else
+#  define P1_PREFETCH(address) ((void)(address))
+#endif
+
+using namespace point_one::fusion_engine::analysis;
+using namespace point_one::fusion_engine::messages;
+
+namespace {
+constexpr size_t NODE_SIZE = LogIndex::NODE_SIZE;
+constexpr size_t FANOUT = NODE_SIZE + 1;
+constexpr size_t CACHE_LINE_SIZE_BYTES = 64;
+constexpr int32_t KEY_MAX = std::numeric_limits<int32_t>::max();
+
+// The number of queries interleaved by batch lookups.
+constexpr size_t BATCH_SIZE = 16;
+
+// The size of a `.p1i` record: `<u4` time, `<u2` type, `<u8` offset, packed.
+constexpr size_t P1I_RECORD_SIZE_BYTES = 14;
+constexpr size_t P1I_BLOCK_SIZE = 4096;
+
+#pragma pack(push, 4)
+struct LogIndexFileHeader {
+  static constexpr uint32_t MAGIC = 0x58493150; // 'P1IX'
+  static constexpr uint16_t VERSION = 1;
+
+  uint32_t magic = MAGIC;
+  uint16_t version = VERSION;
+  uint16_t node_size = NODE_SIZE;
+  uint32_t num_types = 0;
+  uint32_t type_index_size_bytes = 0;
+  uint64_t num_entries = 0;
+  uint64_t data_size_bytes = 0;
+};
+#pragma pack(pop)
+
+/******************************************************************************/
+// Map unsigned times to signed keys with the same ordering, so nodes can be
+// searched using signed SIMD comparisons.
+inline int32_t ToKey(uint32_t p1_time_sec) {
+  return static_cast<int32_t>(p1_time_sec ^ 0x80000000u);
+}
+
+/******************************************************************************/
+inline uint32_t FromKey(int32_t key) {
+  return static_cast<uint32_t>(key) ^ 0x80000000u;
+}
+
+/******************************************************************************/
+// Count the keys in a (sorted, 64-byte aligned) node that are less than `key`.
+inline size_t CountLess(const int32_t* node, int32_t key) {
+#if P1_HAVE_SSE2
+  const __m128i* vectors = reinterpret_cast<const __m128i*>(node);
+  __m128i value = _mm_set1_epi32(key);
+  __m128i less0 = _mm_cmpgt_epi32(value, _mm_load_si128(vectors + 0));
+  __m128i less1 = _mm_cmpgt_epi32(value, _mm_load_si128(vectors + 1));
+  __m128i less2 = _mm_cmpgt_epi32(value, _mm_load_si128(vectors + 2));
+  __m128i less3 = _mm_cmpgt_epi32(value, _mm_load_si128(vectors + 3));
+  __m128i packed = _mm_packs_epi16(_mm_packs_epi32(less0, less1),
+                                   _mm_packs_epi32(less2, less3));
+  uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(packed));
+#  if defined(__GNUC__) || defined(__clang__)
+  return static_cast<size_t>(__builtin_popcount(mask));
+#  else
+  // The keys are sorted, so the matches form a prefix of the mask.
+  size_t count = 0;
+  while (mask & 1) {
+    mask >>= 1;
+    ++count;
+  }
+  return count;
+#  endif
+#elif P1_HAVE_NEON
+  int32x4_t value = vdupq_n_s32(key);
+  uint32x4_t sum = vshrq_n_u32(vcltq_s32(vld1q_s32(node + 0), value), 31);
+  sum = vaddq_u32(sum, vshrq_n_u32(vcltq_s32(vld1q_s32(node + 4), value), 31));
+  sum = vaddq_u32(sum, vshrq_n_u32(vcltq_s32(vld1q_s32(node + 8), value), 31));
+  sum =
+      vaddq_u32(sum, vshrq_n_u32(vcltq_s32(vld1q_s32(node + 12), value), 31));
+  return vaddvq_u32(sum);
+#else
+  size_t count = 0;
+  for (size_t i = 0; i < NODE_SIZE; ++i) {
+    count += node[i] < key ? 1 : 0;
+  }
+  return count;
+#endif
+}
+
+/******************************************************************************/
+uint64_t AlignSize(uint64_t size_bytes) {
+  return (size_bytes + CACHE_LINE_SIZE_BYTES - 1) &
+         ~static_cast<uint64_t>(CACHE_LINE_SIZE_BYTES - 1);
+}
+
+/******************************************************************************/
+// Compute the number of levels and the number of nodes in each level for a
+// tree with `count` keys.
+size_t GetLevelSizes(uint64_t count, uint64_t* level_size) {
+  size_t num_levels = 0;
+  uint64_t span = NODE_SIZE;
+  do {
+    level_size[num_levels++] = (count + span - 1) / span;
+    if (span >= count) {
+      break;
+    }
+    span *= FANOUT;
+  } while (num_levels < LogIndex::MAX_LEVELS);
+  return num_levels;
+}
+
+/******************************************************************************/
+void DecodeP1IRecord(const uint8_t* data, IndexEntry& entry) {
+  uint16_t type;
+  std::memcpy(&entry.p1_time_sec, data, 4);
+  std::memcpy(&type, data + 4, 2);
+  std::memcpy(&entry.offset_bytes, data + 6, 8);
+  entry.type = static_cast<MessageType>(type);
+}
+
+/******************************************************************************/
+void EncodeP1IRecord(const IndexEntry& entry, uint8_t* data) {
+  uint16_t type = static_cast<uint16_t>(entry.type);
+  std::memcpy(data, &entry.p1_time_sec, 4);
+  std::memcpy(data + 4, &type, 2);
+  std::memcpy(data + 6, &entry.offset_bytes, 8);
+}
+} // namespace
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+constexpr size_t LogIndex::NODE_SIZE;
+constexpr size_t LogIndex::MAX_LEVELS;
+
+/******************************************************************************/
+void LogIndex::Build(const IndexEntry* entries, size_t count) {
+  std::vector<int32_t> slots(1 << 16, -1);
+  std::vector<uint16_t> types;
+  std::vector<size_t> counts;
+  for (size_t i = 0; i < count; ++i) {
+    uint16_t type = static_cast<uint16_t>(entries[i].type);
+    if (slots[type] < 0) {
+      slots[type] = static_cast<int32_t>(types.size());
+      types.push_back(type);
+      counts.push_back(0);
+    }
+    ++counts[slots[type]];
+  }
+
+  std::vector<std::vector<TimeAndOffset>> groups(types.size());
+  for (size_t i = 0; i < types.size(); ++i) {
+    groups[i].reserve(counts[i]);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    groups[slots[static_cast<uint16_t>(entries[i].type)]].push_back(
+        {entries[i].p1_time_sec, entries[i].offset_bytes});
+  }
+
+  BuildTypes(types, groups);
+}
+
+/******************************************************************************/
+bool LogIndex::LoadP1I(const std::string& path) {
+  Clear();
+
+  std::ifstream stream(path, std::ifstream::binary);
+  if (!stream) {
+    return false;
+  }
+
+  stream.seekg(0, stream.end);
+  uint64_t file_size_bytes = static_cast<uint64_t>(stream.tellg());
+  if (file_size_bytes % P1I_RECORD_SIZE_BYTES != 0) {
+    return false;
+  }
+  uint64_t num_records = file_size_bytes / P1I_RECORD_SIZE_BYTES;
+
+  // Read the file twice: once to count the entries for each type, and once to
+  // store them, so the per-type arrays are allocated exactly once.
+  std::vector<uint8_t> buffer(P1I_BLOCK_SIZE * P1I_RECORD_SIZE_BYTES);
+  std::vector<int32_t> slots(1 << 16, -1);
+  std::vector<uint16_t> types;
+  std::vector<std::vector<TimeAndOffset>> groups;
+  std::vector<uint64_t> counts;
+  for (int pass = 0; pass < 2; ++pass) {
+    stream.clear();
+    stream.seekg(0, stream.beg);
+    for (uint64_t offset = 0; offset < num_records; offset += P1I_BLOCK_SIZE) {
+      size_t count = static_cast<size_t>(
+          std::min<uint64_t>(P1I_BLOCK_SIZE, num_records - offset));
+      stream.read(reinterpret_cast<char*>(buffer.data()),
+                  count * P1I_RECORD_SIZE_BYTES);
+      if (!stream) {
+        return false;
+      }
+
+      IndexEntry entry;
+      for (size_t i = 0; i < count; ++i) {
+        DecodeP1IRecord(buffer.data() + i * P1I_RECORD_SIZE_BYTES, entry);
+        uint16_t type = static_cast<uint16_t>(entry.type);
+        if (pass == 0) {
+          if (slots[type] < 0) {
+            slots[type] = static_cast<int32_t>(types.size());
+            types.push_back(type);
+            counts.push_back(0);
+          }
+          ++counts[slots[type]];
+        } else {
+          groups[slots[type]].push_back(
+              {entry.p1_time_sec, entry.offset_bytes});
+        }
+      }
+    }
+
+    if (pass == 0) {
+      groups.resize(types.size());
+      for (size_t i = 0; i < types.size(); ++i) {
+        groups[i].reserve(static_cast<size_t>(counts[i]));
+      }
+    }
+  }
+
+  BuildTypes(types, groups);
+  return true;
+}
+
+/******************************************************************************/
+bool LogIndex::SaveP1I(const std::string& path) const {
+  std::ofstream stream(path, std::ofstream::binary);
+  if (!stream) {
+    return false;
+  }
+
+  std::vector<IndexEntry> entries;
+  GetEntries(entries);
+
+  std::vector<uint8_t> buffer(P1I_BLOCK_SIZE * P1I_RECORD_SIZE_BYTES);
+  for (size_t offset = 0; offset < entries.size(); offset += P1I_BLOCK_SIZE) {
+    size_t count = std::min(P1I_BLOCK_SIZE, entries.size() - offset);
+    for (size_t i = 0; i < count; ++i) {
+      EncodeP1IRecord(entries[offset + i],
+                      buffer.data() + i * P1I_RECORD_SIZE_BYTES);
+    }
+    stream.write(reinterpret_cast<const char*>(buffer.data()),
+                 count * P1I_RECORD_SIZE_BYTES);
+  }
+
+  return static_cast<bool>(stream);
+}
+
+/******************************************************************************/
+void LogIndex::GetEntries(std::vector<IndexEntry>& entries) const {
+  entries.clear();
+  entries.reserve(static_cast<size_t>(num_entries_));
+  for (const TypeIndex& index : types_) {
+    const int32_t* keys = GetNodes(index, 0);
+    const uint64_t* offsets =
+        reinterpret_cast<const uint64_t*>(data_ + index.offsets_offset);
+    IndexEntry entry;
+    entry.type = static_cast<MessageType>(index.type);
+    for (uint64_t i = 0; i < index.count; ++i) {
+      entry.p1_time_sec = FromKey(keys[i]);
+      entry.offset_bytes = offsets[i];
+      entries.push_back(entry);
+    }
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const IndexEntry& a, const IndexEntry& b) {
+              return a.offset_bytes < b.offset_bytes;
+            });
+}
+
+/******************************************************************************/
+bool LogIndex::Load(const std::string& path) {
+  Clear();
+
+  std::ifstream stream(path, std::ifstream::binary);
+  if (!stream) {
+    return false;
+  }
+
+  LogIndexFileHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!stream || header.magic != LogIndexFileHeader::MAGIC ||
+      header.version != LogIndexFileHeader::VERSION ||
+      header.node_size != NODE_SIZE ||
+      header.type_index_size_bytes != sizeof(TypeIndex)) {
+    return false;
+  }
+
+  // Sanity check the sizes against the file size before allocating.
+  stream.seekg(0, stream.end);
+  uint64_t file_size_bytes = static_cast<uint64_t>(stream.tellg());
+  if (header.num_types > (1 << 16) ||
+      file_size_bytes != sizeof(header) +
+                             header.num_types * sizeof(TypeIndex) +
+                             header.data_size_bytes) {
+    return false;
+  }
+  stream.seekg(sizeof(header), stream.beg);
+
+  types_.resize(header.num_types);
+  if (!types_.empty()) {
+    stream.read(reinterpret_cast<char*>(types_.data()),
+                types_.size() * sizeof(TypeIndex));
+  }
+  Allocate(static_cast<size_t>(header.data_size_bytes));
+  if (data_size_bytes_ > 0) {
+    stream.read(reinterpret_cast<char*>(data_),
+                static_cast<std::streamsize>(data_size_bytes_));
+  }
+  num_entries_ = header.num_entries;
+
+  if (!stream || !ValidateLayout()) {
+    Clear();
+    return false;
+  }
+
+  return true;
+}
+
+/******************************************************************************/
+bool LogIndex::Save(const std::string& path) const {
+  std::ofstream stream(path, std::ofstream::binary);
+  if (!stream) {
+    return false;
+  }
+
+  LogIndexFileHeader header;
+  header.num_types = static_cast<uint32_t>(types_.size());
+  header.type_index_size_bytes = sizeof(TypeIndex);
+  header.num_entries = num_entries_;
+  header.data_size_bytes = data_size_bytes_;
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!types_.empty()) {
+    stream.write(reinterpret_cast<const char*>(types_.data()),
+                 types_.size() * sizeof(TypeIndex));
+  }
+  if (data_size_bytes_ > 0) {
+    stream.write(reinterpret_cast<const char*>(data_),
+                 static_cast<std::streamsize>(data_size_bytes_));
+  }
+
+  return static_cast<bool>(stream);
+}
+
+/******************************************************************************/
+void LogIndex::Clear() {
+  types_.clear();
+  storage_.clear();
+  storage_.shrink_to_fit();
+  data_ = nullptr;
+  data_size_bytes_ = 0;
+  num_entries_ = 0;
+}
+
+/******************************************************************************/
+std::vector<MessageType> LogIndex::GetTypes() const {
+  std::vector<MessageType> types;
+  types.reserve(types_.size());
+  for (const TypeIndex& index : types_) {
+    types.push_back(static_cast<MessageType>(index.type));
+  }
+  return types;
+}
+
+/******************************************************************************/
+size_t LogIndex::GetCount(MessageType type) const {
+  const TypeIndex* index = Find(type);
+  return index == nullptr ? 0 : static_cast<size_t>(index->count);
+}
+
+/******************************************************************************/
+size_t LogIndex::LowerBound(MessageType type, uint32_t p1_time_sec) const {
+  const TypeIndex* index = Find(type);
+  if (index == nullptr) {
+    return 0;
+  }
+
+  int32_t key = ToKey(p1_time_sec);
+  uint64_t node = 0;
+  for (size_t level = index->num_levels - 1; level > 0; --level) {
+    node = node * FANOUT +
+           CountLess(GetNodes(*index, level) + node * NODE_SIZE, key);
+    // The key is larger than every key in the last (partial) subtree.
+    if (node >= index->level_size[level - 1]) {
+      return static_cast<size_t>(index->count);
+    }
+  }
+
+  uint64_t position =
+      node * NODE_SIZE + CountLess(GetNodes(*index, 0) + node * NODE_SIZE, key);
+  return static_cast<size_t>(std::min(position, index->count));
+}
+
+/******************************************************************************/
+void LogIndex::LowerBound(MessageType type, const uint32_t* p1_time_sec,
+                          size_t count, size_t* positions) const {
+  const TypeIndex* index = Find(type);
+  if (index == nullptr) {
+    std::fill(positions, positions + count, 0);
+    return;
+  }
+
+  // Process queries in groups, one tree level at a time. The next node for
+  // each query is prefetched while the remaining queries in the group are
+  // searched.
+  const uint64_t DONE = std::numeric_limits<uint64_t>::max();
+  int32_t keys[BATCH_SIZE];
+  uint64_t nodes[BATCH_SIZE];
+  for (size_t start = 0; start < count; start += BATCH_SIZE) {
+    size_t batch_size = std::min(BATCH_SIZE, count - start);
+    for (size_t i = 0; i < batch_size; ++i) {
+      keys[i] = ToKey(p1_time_sec[start + i]);
+      nodes[i] = 0;
+    }
+
+    for (size_t level = index->num_levels - 1; level > 0; --level) {
+      const int32_t* level_nodes = GetNodes(*index, level);
+      const int32_t* child_nodes = GetNodes(*index, level - 1);
+      for (size_t i = 0; i < batch_size; ++i) {
+        if (nodes[i] == DONE) {
+          continue;
+        }
+
+        uint64_t child =
+            nodes[i] * FANOUT +
+            CountLess(level_nodes + nodes[i] * NODE_SIZE, keys[i]);
+        if (child >= index->level_size[level - 1]) {
+          nodes[i] = DONE;
+        } else {
+          nodes[i] = child;
+          P1_PREFETCH(child_nodes + child * NODE_SIZE);
+        }
+      }
+    }
+
+    const int32_t* leaves = GetNodes(*index, 0);
+    for (size_t i = 0; i < batch_size; ++i) {
+      uint64_t position =
+          nodes[i] == DONE
+              ? index->count
+              : nodes[i] * NODE_SIZE +
+                    CountLess(leaves + nodes[i] * NODE_SIZE, keys[i]);
+      positions[start + i] =
+          static_cast<size_t>(std::min(position, index->count));
+    }
+  }
+}
+
+/******************************************************************************/
+IndexEntry LogIndex::GetEntry(MessageType type, size_t position) const {
+  IndexEntry entry;
+  const TypeIndex* index = Find(type);
+  if (index != nullptr && position < index->count) {
+    entry.p1_time_sec = FromKey(GetNodes(*index, 0)[position]);
+    entry.type = type;
+    entry.offset_bytes = reinterpret_cast<const uint64_t*>(
+        data_ + index->offsets_offset)[position];
+  }
+  return entry;
+}
+
+/******************************************************************************/
+const uint64_t* LogIndex::GetOffsets(MessageType type) const {
+  const TypeIndex* index = Find(type);
+  return index == nullptr ? nullptr
+                          : reinterpret_cast<const uint64_t*>(
+                                data_ + index->offsets_offset);
+}
+
+/******************************************************************************/
+void LogIndex::BuildTypes(std::vector<uint16_t>& types,
+                          std::vector<std::vector<TimeAndOffset>>& entries) {
+  Clear();
+
+  // Sort the types so they can be located using a binary search.
+  std::vector<size_t> order(types.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) { return types[a] < types[b]; });
+
+  // Compute the layout: for each type, each tree level (leaves first),
+  // followed by the entry offsets, each aligned to a cache line.
+  uint64_t size_bytes = 0;
+  types_.resize(types.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    TypeIndex& index = types_[i];
+    index.type = types[order[i]];
+    index.count = entries[order[i]].size();
+    index.num_levels =
+        static_cast<uint16_t>(GetLevelSizes(index.count, index.level_size));
+    for (size_t level = 0; level < index.num_levels; ++level) {
+      index.level_offset[level] = size_bytes;
+      size_bytes +=
+          index.level_size[level] * NODE_SIZE * sizeof(int32_t);
+    }
+    index.offsets_offset = size_bytes;
+    size_bytes = AlignSize(size_bytes + index.count * sizeof(uint64_t));
+    num_entries_ += index.count;
+  }
+
+  Allocate(static_cast<size_t>(size_bytes));
+
+  for (size_t i = 0; i < order.size(); ++i) {
+    TypeIndex& index = types_[i];
+    std::vector<TimeAndOffset>& group = entries[order[i]];
+    std::sort(group.begin(), group.end(),
+              [](const TimeAndOffset& a, const TimeAndOffset& b) {
+                return a.p1_time_sec < b.p1_time_sec ||
+                       (a.p1_time_sec == b.p1_time_sec &&
+                        a.offset_bytes < b.offset_bytes);
+              });
+
+    // Leaves: the sorted keys, padded to a full node.
+    int32_t* leaves = reinterpret_cast<int32_t*>(data_ + index.level_offset[0]);
+    uint64_t* offsets =
+        reinterpret_cast<uint64_t*>(data_ + index.offsets_offset);
+    for (size_t j = 0; j < group.size(); ++j) {
+      leaves[j] = ToKey(group[j].p1_time_sec);
+      offsets[j] = group[j].offset_bytes;
+    }
+    std::fill(leaves + group.size(),
+              leaves + index.level_size[0] * NODE_SIZE, KEY_MAX);
+
+    // Internal nodes: separator i of node k is the largest key in the subtree
+    // of child (k * FANOUT + i).
+    uint64_t child_span = NODE_SIZE;
+    for (size_t level = 1; level < index.num_levels; ++level) {
+      int32_t* nodes =
+          reinterpret_cast<int32_t*>(data_ + index.level_offset[level]);
+      for (uint64_t k = 0; k < index.level_size[level]; ++k) {
+        for (size_t i = 0; i < NODE_SIZE; ++i) {
+          uint64_t child = k * FANOUT + i;
+          if (child < index.level_size[level - 1]) {
+            uint64_t end = std::min((child + 1) * child_span, index.count);
+            nodes[k * NODE_SIZE + i] = leaves[end - 1];
+          } else {
+            nodes[k * NODE_SIZE + i] = KEY_MAX;
+          }
+        }
+      }
+      child_span *= FANOUT;
+    }
+
+    group.clear();
+    group.shrink_to_fit();
+  }
+}
+
+/******************************************************************************/
+void LogIndex::Allocate(size_t size_bytes) {
+  // Align the data to a cache line so each node occupies exactly one line.
+  storage_.resize(size_bytes + CACHE_LINE_SIZE_BYTES);
+  uintptr_t address = reinterpret_cast<uintptr_t>(storage_.data());
+  data_ = storage_.data() + ((CACHE_LINE_SIZE_BYTES -
+                              (address % CACHE_LINE_SIZE_BYTES)) %
+                             CACHE_LINE_SIZE_BYTES);
+  data_size_bytes_ = size_bytes;
+}
+
+/******************************************************************************/
+bool LogIndex::ValidateLayout() const {
+  uint64_t num_entries = 0;
+  for (size_t i = 0; i < types_.size(); ++i) {
+    const TypeIndex& index = types_[i];
+    if (i > 0 && index.type <= types_[i - 1].type) {
+      return false;
+    }
+
+    uint64_t level_size[MAX_LEVELS];
+    size_t num_levels = GetLevelSizes(index.count, level_size);
+    if (index.count == 0 || index.num_levels != num_levels) {
+      return false;
+    }
+
+    for (size_t level = 0; level < num_levels; ++level) {
+      if (index.level_size[level] != level_size[level] ||
+          index.level_offset[level] % CACHE_LINE_SIZE_BYTES != 0 ||
+          index.level_offset[level] > data_size_bytes_ ||
+          level_size[level] * NODE_SIZE * sizeof(int32_t) >
+              data_size_bytes_ - index.level_offset[level]) {
+        return false;
+      }
+    }
+
+    if (index.offsets_offset % sizeof(uint64_t) != 0 ||
+        index.offsets_offset > data_size_bytes_ ||
+        index.count * sizeof(uint64_t) >
+            data_size_bytes_ - index.offsets_offset) {
+      return false;
+    }
+
+    num_entries += index.count;
+  }
+
+  return num_entries == num_entries_;
+}
+
+/******************************************************************************/
+const LogIndex::TypeIndex* LogIndex::Find(MessageType type) const {
+  uint16_t value = static_cast<uint16_t>(type);
+  auto it = std::lower_bound(
+      types_.begin(), types_.end(), value,
+      [](const TypeIndex& index, uint16_t type) { return index.type < type; });
+  return (it != types_.end() && it->type == value) ? &*it : nullptr;
+}
+
+/******************************************************************************/
+std::string GetLogIndexPath(const std::string& log_path) {
+  size_t dot = log_path.find_last_of('.');
+  size_t slash = log_path.find_last_of("/\\");
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    return log_path + ".p1x";
+  } else {
+    return log_path.substr(0, dot) + ".p1x";
+  }
+}
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,264 @@
+/**************************************************************************/ /**
+ * @brief Cache-friendly time index for large collections of log messages.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/defs.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/**
+ * @defgroup log_index Log Index
+ * @brief Locate messages by type and time in very large indexes.
+ *
+ * The Python `FileReader` stores a `.p1i` index next to each log: a flat array
+ * of `(time, type, offset)` entries in file order (see
+ * `fusion_engine_client.analysis.file_reader.FileIndex`). Binary searching a
+ * flat array costs roughly one cache miss per probe, which becomes the
+ * dominant cost for fleet-wide indexes with billions of entries.
+ *
+ * @ref LogIndex stores a separate sub-index for each message type. Each
+ * sub-index is a static B+-tree whose nodes are exactly one 64-byte cache line
+ * (16 keys): the leaf level is the sorted array of entry times, and each
+ * internal node holds the maximum time of each of its 17 children. A lookup
+ * visits one node per level, and each node is searched using SIMD comparisons
+ * (SSE2 or NEON, where available). Batch lookups interleave several queries
+ * level by level, prefetching the next node of each query while the others
+ * are searched.
+ *
+ * The in-memory layout is written to disk unchanged (see @ref
+ * LogIndex::Save()), so loading an index does not require any rebuilding.
+ * @{
+ */
+
+/**
+ * @brief A single log index entry, equivalent to a `.p1i` record.
+ */
+struct IndexEntry {
+  /**
+   * The P1 time of the message, in whole seconds (rounded down), or @ref
+   * messages::Timestamp::INVALID if not available.
+   */
+  uint32_t p1_time_sec = messages::Timestamp::INVALID;
+
+  /** The message type. */
+  messages::MessageType type = messages::MessageType::INVALID;
+
+  /** The offset of the message within the log file (in bytes). */
+  uint64_t offset_bytes = 0;
+};
+
+/**
+ * @brief A per-message type time index with a cache-optimized layout.
+ *
+ * Entry times use the `.p1i` resolution of whole seconds, so a lookup may
+ * return messages up to 1 second before the requested time; callers that need
+ * exact times should check the decoded messages. Entries without a valid time
+ * are sorted after all other entries of the same type.
+ *
+ * ```{.cpp}
+ * LogIndex index;
+ * index.LoadP1I("/path/to/data.p1i");
+ * size_t start = index.LowerBound(MessageType::POSE, 1234);
+ * size_t end = index.LowerBound(MessageType::POSE, 1240);
+ * for (size_t i = start; i < end; ++i) {
+ *   IndexEntry entry = index.GetEntry(MessageType::POSE, i);
+ *   ...
+ * }
+ * ```
+ */
+class P1_EXPORT LogIndex {
+ public:
+  /** The number of keys in each tree node. */
+  static constexpr size_t NODE_SIZE = 16;
+
+  /** The maximum tree height supported. */
+  static constexpr size_t MAX_LEVELS = 16;
+
+  LogIndex() = default;
+  LogIndex(LogIndex&&) = default;
+  LogIndex& operator=(LogIndex&&) = default;
+
+  LogIndex(const LogIndex&) = delete;
+  LogIndex& operator=(const LogIndex&) = delete;
+
+  /**
+   * @brief Build the index from a list of entries (in any order).
+   *
+   * @param entries The index entries.
+   * @param count The number of entries.
+   */
+  void Build(const IndexEntry* entries, size_t count);
+
+  /**
+   * @brief Build the index from a `.p1i` file.
+   *
+   * @param path The input file path.
+   *
+   * @return `true` on success, or `false` if the file could not be read.
+   */
+  bool LoadP1I(const std::string& path);
+
+  /**
+   * @brief Write the index to a `.p1i` file, with entries in file offset
+   *        order.
+   *
+   * @param path The output file path.
+   *
+   * @return `true` on success.
+   */
+  bool SaveP1I(const std::string& path) const;
+
+  /**
+   * @brief Get all entries, sorted by file offset (i.e., `.p1i` order).
+   *
+   * @param[out] entries The index entries.
+   */
+  void GetEntries(std::vector<IndexEntry>& entries) const;
+
+  /**
+   * @brief Read an index previously written using @ref Save().
+   *
+   * @param path The input file path.
+   *
+   * @return `true` on success, or `false` if the file does not exist or is
+   *         invalid.
+   */
+  bool Load(const std::string& path);
+
+  /**
+   * @brief Write the index in its native (cache-optimized) format.
+   *
+   * @param path The output file path.
+   *
+   * @return `true` on success.
+   */
+  bool Save(const std::string& path) const;
+
+  /**
+   * @brief Remove all entries.
+   */
+  void Clear();
+
+  /**
+   * @brief Get the total number of entries.
+   */
+  uint64_t GetNumEntries() const { return num_entries_; }
+
+  /**
+   * @brief Get the message types present in the index, in ascending order.
+   */
+  std::vector<messages::MessageType> GetTypes() const;
+
+  /**
+   * @brief Get the number of entries for a message type.
+   */
+  size_t GetCount(messages::MessageType type) const;
+
+  /**
+   * @brief Find the first entry of a message type at or after the specified
+   *        time.
+   *
+   * @param type The message type.
+   * @param p1_time_sec The P1 time (in whole seconds).
+   *
+   * @return The position of the entry, in the range [0, @ref GetCount()].
+   *         Entries are sorted by time, then by offset.
+   */
+  size_t LowerBound(messages::MessageType type, uint32_t p1_time_sec) const;
+
+  /**
+   * @brief Perform @ref LowerBound() for a batch of times.
+   *
+   * Batch lookups overlap the memory accesses of several queries, and are
+   * significantly faster than individual lookups for very large indexes.
+   *
+   * @param type The message type.
+   * @param p1_time_sec The P1 times (in whole seconds).
+   * @param count The number of times.
+   * @param[out] positions The position for each time.
+   */
+  void LowerBound(messages::MessageType type, const uint32_t* p1_time_sec,
+                  size_t count, size_t* positions) const;
+
+  /**
+   * @brief Get an entry of a message type.
+   *
+   * @param type The message type.
+   * @param position The entry position. Must be less than @ref GetCount().
+   *
+   * @return The entry.
+   */
+  IndexEntry GetEntry(messages::MessageType type, size_t position) const;
+
+  /**
+   * @brief Get the file offsets of all entries of a message type, in time
+   *        order.
+   *
+   * @param type The message type.
+   *
+   * @return A pointer to @ref GetCount() offsets, or `nullptr` if the type is
+   *         not present.
+   */
+  const uint64_t* GetOffsets(messages::MessageType type) const;
+
+ private:
+  struct TypeIndex {
+    uint16_t type = 0;
+    uint16_t num_levels = 0;
+    uint32_t reserved = 0;
+    uint64_t count = 0;
+    /** Offset of the nodes in each level (level 0 = leaves) in the data. */
+    uint64_t level_offset[MAX_LEVELS] = {0};
+    /** Number of nodes in each level. */
+    uint64_t level_size[MAX_LEVELS] = {0};
+    /** Offset of the entry file offsets in the data. */
+    uint64_t offsets_offset = 0;
+  };
+
+  struct TimeAndOffset {
+    uint32_t p1_time_sec;
+    uint64_t offset_bytes;
+  };
+
+  void BuildTypes(std::vector<uint16_t>& types,
+                  std::vector<std::vector<TimeAndOffset>>& entries);
+  void Allocate(size_t size_bytes);
+  bool ValidateLayout() const;
+  const TypeIndex* Find(messages::MessageType type) const;
+  const int32_t* GetNodes(const TypeIndex& index, size_t level) const {
+    return reinterpret_cast<const int32_t*>(data_ +
+                                            index.level_offset[level]);
+  }
+
+  std::vector<TypeIndex> types_;
+  std::vector<uint8_t> storage_;
+  uint8_t* data_ = nullptr;
+  uint64_t data_size_bytes_ = 0;
+  uint64_t num_entries_ = 0;
+};
+
+/**
+ * @brief Get the path of the native @ref LogIndex file for a log file.
+ *
+ * @param log_path The path to the log (e.g., `/path/to/data.p1log`).
+ *
+ * @return The index path (e.g., `/path/to/data.p1x`).
+ */
+P1_EXPORT std::string GetLogIndexPath(const std::string& log_path);
+
+/** @} */
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
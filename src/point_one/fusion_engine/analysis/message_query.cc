@@ -0,0 +1,734 @@
+/**************************************************************************/ /**
+ * @brief Compiled filter expressions over message fields.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/analysis/message_query.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib> // For strtod()
+#include <cstring> // For memcpy(), memset(), strlen()
+#include <memory>
+
+#include "point_one/fusion_engine/messages/reflection.h"
+
+using namespace point_one::fusion_engine::analysis;
+using namespace point_one::fusion_engine::messages;
+
+/******************************************************************************/
+// Parsed Expressions
+/******************************************************************************/
+
+struct MessageQuery::Expression {
+  enum class Kind : uint8_t { AND, OR, NOT, COMPARE };
+
+  struct Term {
+    bool is_constant = false;
+    double value = 0.0;
+    std::string field;
+    int index = -1;
+  };
+
+  Kind kind = Kind::COMPARE;
+  Node::Op op = Node::Op::EQ;
+  std::unique_ptr<Expression> lhs;
+  std::unique_ptr<Expression> rhs;
+  Term a;
+  Term b;
+};
+
+/**
+ * @brief Recursive descent parser for query expressions.
+ *
+ * ```
+ * or_expr    := and_expr ('||' and_expr)*
+ * and_expr   := unary ('&&' unary)*
+ * unary      := '!' unary | '(' or_expr ')' | comparison
+ * comparison := term ('==' | '!=' | '<' | '<=' | '>' | '>=') term
+ * term       := number | identifier ('[' integer ']')?
+ * ```
+ */
+class MessageQuery::Parser {
+ public:
+  explicit Parser(const std::string& text) : text_(text) {}
+
+  std::unique_ptr<Expression> Parse() {
+    std::unique_ptr<Expression> expression = ParseOr();
+    if (expression) {
+      SkipWhitespace();
+      if (position_ != text_.size()) {
+        return Fail("Unexpected '" + text_.substr(position_, 1) + "'");
+      }
+    }
+    return expression;
+  }
+
+  const std::string& GetError() const { return error_; }
+
+ private:
+  std::unique_ptr<Expression> Fail(const std::string& message) {
+    if (error_.empty()) {
+      error_ = message + " at position " + std::to_string(position_) + ".";
+    }
+    return nullptr;
+  }
+
+  void SkipWhitespace() {
+    while (position_ < text_.size() &&
+           std::isspace(static_cast<unsigned char>(text_[position_]))) {
+      ++position_;
+    }
+  }
+
+  bool Accept(const char* token) {
+    SkipWhitespace();
+    size_t length = std::strlen(token);
+    if (text_.compare(position_, length, token) == 0) {
+      position_ += length;
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  std::unique_ptr<Expression> MakeBinary(Expression::Kind kind,
+                                         std::unique_ptr<Expression> lhs,
+                                         std::unique_ptr<Expression> rhs) {
+    std::unique_ptr<Expression> expression(new Expression());
+    expression->kind = kind;
+    expression->lhs = std::move(lhs);
+    expression->rhs = std::move(rhs);
+    return expression;
+  }
+
+  std::unique_ptr<Expression> ParseOr() {
+    std::unique_ptr<Expression> lhs = ParseAnd();
+    while (lhs && Accept("||")) {
+      std::unique_ptr<Expression> rhs = ParseAnd();
+      if (!rhs) {
+        return nullptr;
+      }
+      lhs = MakeBinary(Expression::Kind::OR, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  std::unique_ptr<Expression> ParseAnd() {
+    std::unique_ptr<Expression> lhs = ParseUnary();
+    while (lhs && Accept("&&")) {
+      std::unique_ptr<Expression> rhs = ParseUnary();
+      if (!rhs) {
+        return nullptr;
+      }
+      lhs = MakeBinary(Expression::Kind::AND, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  std::unique_ptr<Expression> ParseUnary() {
+    SkipWhitespace();
+    if (position_ < text_.size() && text_[position_] == '!' &&
+        (position_ + 1 >= text_.size() || text_[position_ + 1] != '=')) {
+      ++position_;
+      std::unique_ptr<Expression> operand = ParseUnary();
+      if (!operand) {
+        return nullptr;
+      }
+      std::unique_ptr<Expression> expression(new Expression());
+      expression->kind = Expression::Kind::NOT;
+      expression->lhs = std::move(operand);
+      return expression;
+    } else if (Accept("(")) {
+      std::unique_ptr<Expression> expression = ParseOr();
+      if (expression && !Accept(")")) {
+        return Fail("Expected ')'");
+      }
+      return expression;
+    } else {
+      return ParseComparison();
+    }
+  }
+
+  std::unique_ptr<Expression> ParseComparison() {
+    std::unique_ptr<Expression> expression(new Expression());
+    if (!ParseTerm(expression->a)) {
+      return nullptr;
+    }
+
+    // Note: Two-character operators must be checked first.
+    if (Accept("==")) {
+      expression->op = Node::Op::EQ;
+    } else if (Accept("!=")) {
+      expression->op = Node::Op::NE;
+    } else if (Accept("<=")) {
+      expression->op = Node::Op::LE;
+    } else if (Accept(">=")) {
+      expression->op = Node::Op::GE;
+    } else if (Accept("<")) {
+      expression->op = Node::Op::LT;
+    } else if (Accept(">")) {
+      expression->op = Node::Op::GT;
+    } else {
+      return Fail("Expected comparison operator");
+    }
+
+    if (!ParseTerm(expression->b)) {
+      return nullptr;
+    }
+
+    return expression;
+  }
+
+  bool ParseTerm(Expression::Term& term) {
+    SkipWhitespace();
+    if (position_ >= text_.size()) {
+      Fail("Unexpected end of expression");
+      return false;
+    }
+
+    size_t start_position = position_;
+    const char* start = text_.c_str() + position_;
+    if (std::isalpha(static_cast<unsigned char>(*start)) || *start == '_') {
+      size_t end = position_;
+      while (end < text_.size() &&
+             (std::isalnum(static_cast<unsigned char>(text_[end])) ||
+              text_[end] == '_')) {
+        ++end;
+      }
+
+      std::string name = text_.substr(position_, end - position_);
+      position_ = end;
+
+      if (Accept("[")) {
+        SkipWhitespace();
+        char* index_end;
+        long index = std::strtol(text_.c_str() + position_, &index_end, 10);
+        if (index_end == text_.c_str() + position_ || index < 0) {
+          Fail("Expected array index");
+          return false;
+        }
+        position_ = static_cast<size_t>(index_end - text_.c_str());
+        if (!Accept("]")) {
+          Fail("Expected ']'");
+          return false;
+        }
+        term.index = static_cast<int>(index);
+      }
+
+      if (term.index < 0 && ResolveSymbol(name, term.value)) {
+        term.is_constant = true;
+      } else if (IsKnownField(name, term.index)) {
+        term.field = name;
+      } else {
+        position_ = start_position;
+        Fail("Unknown field or value '" + name +
+             (term.index >= 0 ? "[" + std::to_string(term.index) + "]" : "") +
+             "'");
+        return false;
+      }
+    } else {
+      char* end;
+      term.value = std::strtod(start, &end);
+      if (end == start) {
+        Fail("Expected field name or value");
+        return false;
+      }
+      term.is_constant = true;
+      position_ += static_cast<size_t>(end - start);
+    }
+
+    return true;
+  }
+
+  const std::string& text_;
+  size_t position_ = 0;
+  std::string error_;
+};
+
+/******************************************************************************/
+// Symbol and Field Resolution
+/******************************************************************************/
+
+namespace {
+struct SymbolDefinition {
+  const char* name;
+  double value;
+};
+
+const SymbolDefinition SYMBOLS[] = {
+    {"INVALID", static_cast<double>(MessageType::INVALID)},
+    {"POSE", static_cast<double>(MessageType::POSE)},
+    {"GNSS_INFO", static_cast<double>(MessageType::GNSS_INFO)},
+    {"GNSS_SATELLITE", static_cast<double>(MessageType::GNSS_SATELLITE)},
+    {"POSE_AUX", static_cast<double>(MessageType::POSE_AUX)},
+    {"COMPACT_POSE", static_cast<double>(MessageType::COMPACT_POSE)},
+    {"IMU_MEASUREMENT", static_cast<double>(MessageType::IMU_MEASUREMENT)},
+    {"IMU_MEASUREMENT_BATCH",
+     static_cast<double>(MessageType::IMU_MEASUREMENT_BATCH)},
+    {"ROS_POSE", static_cast<double>(MessageType::ROS_POSE)},
+    {"ROS_GPS_FIX", static_cast<double>(MessageType::ROS_GPS_FIX)},
+    {"ROS_IMU", static_cast<double>(MessageType::ROS_IMU)},
+    {"Invalid", static_cast<double>(SolutionType::Invalid)},
+    {"AutonomousGPS", static_cast<double>(SolutionType::AutonomousGPS)},
+    {"DGPS", static_cast<double>(SolutionType::DGPS)},
+    {"RTKFixed", static_cast<double>(SolutionType::RTKFixed)},
+    {"RTKFloat", static_cast<double>(SolutionType::RTKFloat)},
+    {"Integrate", static_cast<double>(SolutionType::Integrate)},
+    {"Visual", static_cast<double>(SolutionType::Visual)},
+    {"PPP", static_cast<double>(SolutionType::PPP)},
+};
+
+const char* const TYPE_FIELD = "type";
+
+/** Message types with field definitions. */
+const MessageType PAYLOAD_TYPES[] = {
+    MessageType::POSE,
+    MessageType::POSE_AUX,
+    MessageType::COMPACT_POSE,
+    MessageType::GNSS_INFO,
+    MessageType::GNSS_SATELLITE,
+    MessageType::IMU_MEASUREMENT,
+    MessageType::IMU_MEASUREMENT_BATCH,
+    MessageType::ROS_POSE,
+    MessageType::ROS_GPS_FIX,
+    MessageType::ROS_IMU,
+};
+
+/** Resolve header fields only, for message types with no field definitions. */
+constexpr int GENERIC_MESSAGE_TYPE = -1;
+/** Resolve fields from any message type. */
+constexpr int ANY_MESSAGE_TYPE = -2;
+} // namespace
+
+/******************************************************************************/
+bool MessageQuery::ResolveSymbol(const std::string& name, double& value) {
+  for (const auto& symbol : SYMBOLS) {
+    if (name == symbol.name) {
+      value = symbol.value;
+      return true;
+    }
+  }
+  return false;
+}
+
+/******************************************************************************/
+bool MessageQuery::ResolveField(int message_type, const std::string& name,
+                                int index, Operand& operand,
+                                uint32_t& required_size_bytes) {
+  auto match = [&](const FieldDescriptor& field) {
+    if (name != field.name) {
+      return false;
+    } else if (field.array_length == 0) {
+      return index < 0;
+    } else {
+      return index >= 0 && static_cast<size_t>(index) < field.array_length;
+    }
+  };
+
+  auto bind = [&](const FieldDescriptor& field, Operand::Source source) {
+    operand.source = source;
+    operand.field = field;
+    operand.index = index < 0 ? 0 : static_cast<size_t>(index);
+    operand.name = name;
+    if (index >= 0) {
+      operand.name += "[" + std::to_string(index) + "]";
+    }
+  };
+
+  // Header fields are available for all message types. `type` is an alias for
+  // `message_type`.
+  typedef MessageReflection<MessageHeader> HeaderReflection;
+  for (const auto& field : HeaderReflection::fields) {
+    if (match(field) ||
+        (name == TYPE_FIELD && index < 0 &&
+         std::strcmp(field.name, "message_type") == 0)) {
+      bind(field, Operand::Source::HEADER);
+      return true;
+    }
+  }
+
+  // Resolve payload fields for the requested message type.
+  if (message_type == GENERIC_MESSAGE_TYPE) {
+    return false;
+  }
+
+  for (MessageType type : PAYLOAD_TYPES) {
+    if (message_type != ANY_MESSAGE_TYPE &&
+        static_cast<int>(type) != message_type) {
+      continue;
+    }
+
+    const MessageDescriptor* descriptor = GetMessageDescriptor(type);
+    for (size_t i = 0; i < descriptor->num_fields; ++i) {
+      if (match(descriptor->fields[i])) {
+        bind(descriptor->fields[i], Operand::Source::PAYLOAD);
+        if (descriptor->size_bytes > required_size_bytes) {
+          required_size_bytes = static_cast<uint32_t>(descriptor->size_bytes);
+        }
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+/******************************************************************************/
+bool MessageQuery::IsKnownField(const std::string& name, int index) {
+  Operand operand;
+  uint32_t required_size_bytes = 0;
+  return ResolveField(ANY_MESSAGE_TYPE, name, index, operand,
+                      required_size_bytes);
+}
+
+/******************************************************************************/
+// Compilation
+/******************************************************************************/
+
+namespace {
+/******************************************************************************/
+template <typename Op>
+bool Compare(Op op, double a, double b) {
+  switch (op) {
+    case Op::EQ:
+      return a == b;
+    case Op::NE:
+      return a != b;
+    case Op::LT:
+      return a < b;
+    case Op::LE:
+      return a <= b;
+    case Op::GT:
+      return a > b;
+    case Op::GE:
+      return a >= b;
+    default:
+      return false;
+  }
+}
+} // namespace
+
+/******************************************************************************/
+bool MessageQuery::Compile(const std::string& expression,
+                           std::string* error_message) {
+  compiled_ = false;
+  programs_.clear();
+  generic_program_ = Program();
+  generic_may_match_ = false;
+
+  Parser parser(expression);
+  std::unique_ptr<Expression> parsed = parser.Parse();
+  if (!parsed) {
+    if (error_message != nullptr) {
+      *error_message = parser.GetError();
+    }
+    return false;
+  }
+
+  // Compile a program for each message type with known fields, skipping those
+  // that can never match.
+  for (MessageType type : PAYLOAD_TYPES) {
+    Program program;
+    program.root = Specialize(*parsed, static_cast<int>(type), program);
+    if (program.nodes[program.root].op != Node::Op::ALWAYS_FALSE) {
+      programs_[static_cast<uint16_t>(type)] = std::move(program);
+    } else {
+      programs_[static_cast<uint16_t>(type)] = Program();
+    }
+  }
+
+  // All other message types may only use header fields.
+  generic_program_.root =
+      Specialize(*parsed, GENERIC_MESSAGE_TYPE, generic_program_);
+  generic_may_match_ =
+      generic_program_.nodes[generic_program_.root].op !=
+      Node::Op::ALWAYS_FALSE;
+
+  compiled_ = true;
+  return true;
+}
+
+/******************************************************************************/
+uint32_t MessageQuery::Specialize(const Expression& expression,
+                                  int message_type, Program& program) {
+  auto add_constant = [&program](bool value) {
+    Node node;
+    node.op = value ? Node::Op::ALWAYS_TRUE : Node::Op::ALWAYS_FALSE;
+    program.nodes.push_back(node);
+    return static_cast<uint32_t>(program.nodes.size() - 1);
+  };
+
+  auto is_constant = [&program](uint32_t index, bool value) {
+    return program.nodes[index].op ==
+           (value ? Node::Op::ALWAYS_TRUE : Node::Op::ALWAYS_FALSE);
+  };
+
+  switch (expression.kind) {
+    case Expression::Kind::AND:
+    case Expression::Kind::OR: {
+      bool is_and = expression.kind == Expression::Kind::AND;
+      uint32_t lhs = Specialize(*expression.lhs, message_type, program);
+      // Short circuit: false && x == false, true || x == true.
+      if (is_constant(lhs, !is_and)) {
+        return lhs;
+      }
+
+      uint32_t rhs = Specialize(*expression.rhs, message_type, program);
+      if (is_constant(rhs, !is_and)) {
+        return rhs;
+      } else if (is_constant(lhs, is_and)) {
+        return rhs;
+      } else if (is_constant(rhs, is_and)) {
+        return lhs;
+      }
+
+      Node node;
+      node.op = is_and ? Node::Op::AND : Node::Op::OR;
+      node.lhs = lhs;
+      node.rhs = rhs;
+      program.nodes.push_back(node);
+      return static_cast<uint32_t>(program.nodes.size() - 1);
+    }
+
+    case Expression::Kind::NOT: {
+      uint32_t operand = Specialize(*expression.lhs, message_type, program);
+      if (is_constant(operand, true)) {
+        return add_constant(false);
+      } else if (is_constant(operand, false)) {
+        return add_constant(true);
+      }
+
+      Node node;
+      node.op = Node::Op::NOT;
+      node.lhs = operand;
+      program.nodes.push_back(node);
+      return static_cast<uint32_t>(program.nodes.size() - 1);
+    }
+
+    case Expression::Kind::COMPARE:
+    default: {
+      Node node;
+      node.op = expression.op;
+
+      // Bind each term to a constant or a field offset.
+      const Expression::Term* terms[2] = {&expression.a, &expression.b};
+      Operand* operands[2] = {&node.a, &node.b};
+      for (size_t i = 0; i < 2; ++i) {
+        const Expression::Term& term = *terms[i];
+        Operand& operand = *operands[i];
+        if (term.is_constant) {
+          operand.source = Operand::Source::CONSTANT;
+          operand.value = term.value;
+        } else if (message_type != GENERIC_MESSAGE_TYPE &&
+                   term.field == TYPE_FIELD) {
+          operand.source = Operand::Source::CONSTANT;
+          operand.value = message_type;
+        } else if (!ResolveField(message_type, term.field, term.index, operand,
+                                 program.min_payload_size_bytes)) {
+          // Field not present in this message type.
+          return add_constant(false);
+        }
+      }
+
+      if (node.a.source == Operand::Source::CONSTANT &&
+          node.b.source == Operand::Source::CONSTANT) {
+        return add_constant(Compare(node.op, node.a.value, node.b.value));
+      }
+
+      program.nodes.push_back(node);
+      return static_cast<uint32_t>(program.nodes.size() - 1);
+    }
+  }
+}
+
+/******************************************************************************/
+// Evaluation
+/******************************************************************************/
+
+/******************************************************************************/
+const MessageQuery::Program* MessageQuery::GetProgram(MessageType type) const {
+  if (!compiled_) {
+    return nullptr;
+  }
+
+  auto it = programs_.find(static_cast<uint16_t>(type));
+  if (it != programs_.end()) {
+    return it->second.nodes.empty() ? nullptr : &it->second;
+  } else {
+    return generic_may_match_ ? &generic_program_ : nullptr;
+  }
+}
+
+/******************************************************************************/
+double MessageQuery::Load(const Operand& operand, const MessageHeader& header,
+                          const uint8_t* payload) {
+  switch (operand.source) {
+    case Operand::Source::CONSTANT:
+      return operand.value;
+    case Operand::Source::HEADER:
+      return GetFieldValue(&header, operand.field, operand.index);
+    case Operand::Source::PAYLOAD:
+    default:
+      return GetFieldValue(payload, operand.field, operand.index);
+  }
+}
+
+/******************************************************************************/
+bool MessageQuery::Evaluate(const Program& program, uint32_t index,
+                            const MessageHeader& header,
+                            const uint8_t* payload) {
+  const Node& node = program.nodes[index];
+  switch (node.op) {
+    case Node::Op::ALWAYS_FALSE:
+      return false;
+    case Node::Op::ALWAYS_TRUE:
+      return true;
+    case Node::Op::AND:
+      return Evaluate(program, node.lhs, header, payload) &&
+             Evaluate(program, node.rhs, header, payload);
+    case Node::Op::OR:
+      return Evaluate(program, node.lhs, header, payload) ||
+             Evaluate(program, node.rhs, header, payload);
+    case Node::Op::NOT:
+      return !Evaluate(program, node.lhs, header, payload);
+    default:
+      return Compare(node.op, Load(node.a, header, payload),
+                     Load(node.b, header, payload));
+  }
+}
+
+/******************************************************************************/
+bool MessageQuery::Matches(const MessageHeader& header,
+                           const void* payload) const {
+  const Program* program = GetProgram(header.message_type);
+  if (program == nullptr ||
+      header.payload_size_bytes < program->min_payload_size_bytes) {
+    return false;
+  } else {
+    return Evaluate(*program, program->root, header,
+                    static_cast<const uint8_t*>(payload));
+  }
+}
+
+/******************************************************************************/
+size_t MessageQuery::Evaluate(const void* const* messages, size_t count,
+                              uint8_t* results) const {
+  // Messages are typically grouped by type, so cache the program lookup.
+  MessageType last_type = MessageType::INVALID;
+  const Program* program = GetProgram(last_type);
+
+  size_t num_matches = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const uint8_t* message = static_cast<const uint8_t*>(messages[i]);
+
+    // Note: Copying the header since the message may not be aligned.
+    MessageHeader header;
+    std::memcpy(&header, message, sizeof(header));
+    if (header.message_type != last_type) {
+      last_type = header.message_type;
+      program = GetProgram(last_type);
+    }
+
+    bool match = program != nullptr &&
+                 header.payload_size_bytes >= program->min_payload_size_bytes &&
+                 Evaluate(*program, program->root, header,
+                          message + sizeof(MessageHeader));
+    results[i] = match ? 1 : 0;
+    num_matches += match ? 1 : 0;
+  }
+
+  return num_matches;
+}
+
+/******************************************************************************/
+void MessageQuery::EvaluateColumns(const Program& program, uint32_t index,
+                                   size_t count, const ColumnLookup& columns,
+                                   uint8_t* results) {
+  const Node& node = program.nodes[index];
+  switch (node.op) {
+    case Node::Op::ALWAYS_FALSE:
+    case Node::Op::ALWAYS_TRUE:
+      std::memset(results, node.op == Node::Op::ALWAYS_TRUE ? 1 : 0, count);
+      return;
+
+    case Node::Op::AND:
+    case Node::Op::OR: {
+      EvaluateColumns(program, node.lhs, count, columns, results);
+      std::vector<uint8_t> rhs(count);
+      EvaluateColumns(program, node.rhs, count, columns, rhs.data());
+      if (node.op == Node::Op::AND) {
+        for (size_t i = 0; i < count; ++i) {
+          results[i] &= rhs[i];
+        }
+      } else {
+        for (size_t i = 0; i < count; ++i) {
+          results[i] |= rhs[i];
+        }
+      }
+      return;
+    }
+
+    case Node::Op::NOT:
+      EvaluateColumns(program, node.lhs, count, columns, results);
+      for (size_t i = 0; i < count; ++i) {
+        results[i] ^= 1;
+      }
+      return;
+
+    default: {
+      const double* a = nullptr;
+      const double* b = nullptr;
+      if (node.a.source != Operand::Source::CONSTANT) {
+        a = columns(node.a.name);
+      }
+      if (node.b.source != Operand::Source::CONSTANT) {
+        b = columns(node.b.name);
+      }
+
+      if ((node.a.source != Operand::Source::CONSTANT && a == nullptr) ||
+          (node.b.source != Operand::Source::CONSTANT && b == nullptr)) {
+        std::memset(results, 0, count);
+        return;
+      }
+
+      // Specialize the common field-vs-constant case so the compiler can
+      // vectorize the loop.
+      if (b == nullptr) {
+        double value = node.b.value;
+        for (size_t i = 0; i < count; ++i) {
+          results[i] = Compare(node.op, a[i], value) ? 1 : 0;
+        }
+      } else if (a == nullptr) {
+        double value = node.a.value;
+        for (size_t i = 0; i < count; ++i) {
+          results[i] = Compare(node.op, value, b[i]) ? 1 : 0;
+        }
+      } else {
+        for (size_t i = 0; i < count; ++i) {
+          results[i] = Compare(node.op, a[i], b[i]) ? 1 : 0;
+        }
+      }
+      return;
+    }
+  }
+}
+
+/******************************************************************************/
+size_t MessageQuery::EvaluateColumns(MessageType type, size_t count,
+                                     const ColumnLookup& columns,
+                                     uint8_t* results) const {
+  const Program* program = GetProgram(type);
+  if (program == nullptr) {
+    std::memset(results, 0, count);
+    return 0;
+  }
+
+  EvaluateColumns(*program, program->root, count, columns, results);
+
+  size_t num_matches = 0;
+  for (size_t i = 0; i < count; ++i) {
+    num_matches += results[i];
+  }
+  return num_matches;
+}
@@ -0,0 +1,231 @@
+/**************************************************************************/ /**
+ * @brief Compiled filter expressions over message fields.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef> // For size_t
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/reflection.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/**
+ * @defgroup message_query Message Query Expressions
+ * @brief Select messages using filter expressions on header and payload
+ *        fields.
+ *
+ * Query expressions use a C-like syntax:
+ *
+ * ```
+ * type == POSE && solution_type == RTKFixed && vertical_protection_level_m > 1
+ * type == GNSS_INFO && (hdop > 2 || p1_time >= 3600)
+ * lla_deg[2] < -10 && !(source_identifier == 1)
+ * ```
+ *
+ * - Comparison operators: `==`, `!=`, `<`, `<=`, `>`, `>=`
+ * - Logical operators: `&&`, `||`, `!`, and parentheses
+ * - Operands: numbers, field names, @ref messages::MessageType names (e.g.,
+ *   `POSE`), and @ref messages::SolutionType names (e.g., `RTKFixed`)
+ * - Header fields (available for all messages): `type` (or `message_type`),
+ *   `sequence_number`, `source_identifier`, `payload_size_bytes`, etc.
+ * - Payload fields use the names from the message definitions (see @ref
+ *   reflection), e.g., `horizontal_protection_level_m`. Array elements are
+ *   selected with `[i]`.
+ *   @ref messages::Timestamp fields (e.g., `p1_time`) are compared in seconds,
+ *   and are `NAN` if invalid.
+ *
+ * A field that does not exist in a given message type makes its comparison
+ * `false` for that message. All values are compared as `double`.
+ * @{
+ */
+
+/**
+ * @brief A compiled message filter expression.
+ *
+ * The expression is compiled once into a separate predicate tree for each
+ * message type, with field references bound directly to payload offsets and
+ * constant subexpressions (including `type` comparisons) folded. Message types
+ * that can never match are rejected using only the @ref messages::MessageHeader.
+ *
+ * ```{.cpp}
+ * MessageQuery query;
+ * std::string error;
+ * if (!query.Compile("type == POSE && solution_type == RTKFixed", &error)) {
+ *   ...
+ * }
+ *
+ * if (query.Matches(header, payload)) {
+ *   ...
+ * }
+ * ```
+ */
+class P1_EXPORT MessageQuery {
+ public:
+  /**
+   * @brief Look up a column of values for columnar evaluation.
+   *
+   * @param field The field name, including an array index if applicable (e.g.,
+   *        `lla_deg[2]`).
+   *
+   * @return A pointer to the column values, or `nullptr` if not available.
+   */
+  typedef std::function<const double*(const std::string& field)> ColumnLookup;
+
+  /**
+   * @brief Compile a query expression.
+   *
+   * @param expression The expression to compile.
+   * @param[out] error_message If not `nullptr`, set to a description of the
+   *             error on failure.
+   *
+   * @return `true` on success.
+   */
+  bool Compile(const std::string& expression,
+               std::string* error_message = nullptr);
+
+  /**
+   * @brief Check if a query has been compiled successfully.
+   */
+  bool IsCompiled() const { return compiled_; }
+
+  /**
+   * @brief Check if any message of the specified type could match the query.
+   *
+   * @param type The message type.
+   *
+   * @return `false` if messages of this type are always rejected.
+   */
+  bool MayMatch(messages::MessageType type) const {
+    return GetProgram(type) != nullptr;
+  }
+
+  /**
+   * @brief Evaluate the query for a single message.
+   *
+   * @param header The message header.
+   * @param payload The message payload. Need not be aligned.
+   *
+   * @return `true` if the message matches.
+   */
+  bool Matches(const messages::MessageHeader& header,
+               const void* payload) const;
+
+  /**
+   * @brief Evaluate the query for a batch of messages.
+   *
+   * @param messages An array of pointers to complete messages (header and
+   *        payload). Messages need not be aligned.
+   * @param count The number of messages.
+   * @param[out] results Set to 1 for each message that matches, 0 otherwise.
+   *
+   * @return The number of matching messages.
+   */
+  size_t Evaluate(const void* const* messages, size_t count,
+                  uint8_t* results) const;
+
+  /**
+   * @brief Evaluate the query for a batch of messages of the same type stored
+   *        in columnar form (one array of values per field).
+   *
+   * @param type The type of all messages in the batch.
+   * @param count The number of messages.
+   * @param columns A function returning the column data for a field.
+   * @param[out] results Set to 1 for each message that matches, 0 otherwise.
+   *
+   * @return The number of matching messages.
+   */
+  size_t EvaluateColumns(messages::MessageType type, size_t count,
+                         const ColumnLookup& columns, uint8_t* results) const;
+
+ private:
+  struct Operand {
+    enum class Source : uint8_t { CONSTANT, HEADER, PAYLOAD };
+
+    Source source = Source::CONSTANT;
+    messages::FieldDescriptor field = {"", 0, messages::FieldType::DOUBLE, 0,
+                                       ""};
+    size_t index = 0;
+    double value = 0.0;
+    /** The field name, used for columnar evaluation. */
+    std::string name;
+  };
+
+  struct Node {
+    enum class Op : uint8_t {
+      ALWAYS_FALSE,
+      ALWAYS_TRUE,
+      AND,
+      OR,
+      NOT,
+      EQ,
+      NE,
+      LT,
+      LE,
+      GT,
+      GE,
+    };
+
+    Op op = Op::ALWAYS_FALSE;
+    uint32_t lhs = 0;
+    uint32_t rhs = 0;
+    Operand a;
+    Operand b;
+  };
+
+  struct Program {
+    std::vector<Node> nodes;
+    uint32_t root = 0;
+    /** The minimum payload size required to evaluate all fields. */
+    uint32_t min_payload_size_bytes = 0;
+  };
+
+  struct Expression;
+  class Parser;
+
+  const Program* GetProgram(messages::MessageType type) const;
+
+  static bool ResolveSymbol(const std::string& name, double& value);
+
+  static bool ResolveField(int message_type, const std::string& name,
+                           int index, Operand& operand,
+                           uint32_t& required_size_bytes);
+
+  static bool IsKnownField(const std::string& name, int index);
+
+  static uint32_t Specialize(const Expression& expression, int message_type,
+                             Program& program);
+
+  static double Load(const Operand& operand,
+                     const messages::MessageHeader& header,
+                     const uint8_t* payload);
+
+  static bool Evaluate(const Program& program, uint32_t index,
+                       const messages::MessageHeader& header,
+                       const uint8_t* payload);
+
+  static void EvaluateColumns(const Program& program, uint32_t index,
+                              size_t count, const ColumnLookup& columns,
+                              uint8_t* results);
+
+  bool compiled_ = false;
+  std::unordered_map<uint16_t, Program> programs_;
+  /** The program for message types with no payload field definitions. */
+  Program generic_program_;
+  bool generic_may_match_ = false;
+};
+
+/** @} */
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
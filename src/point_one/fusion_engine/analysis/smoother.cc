@@ -0,0 +1,1051 @@
+/**************************************************************************/ /**
+ * @brief Offline forward-backward trajectory smoothing.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/analysis/smoother.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+#include "point_one/fusion_engine/messages/crc.h"
+#include "point_one/fusion_engine/messages/imu_batch.h"
+#include "point_one/fusion_engine/messages/solution.h"
+#include "point_one/fusion_engine/parsers/fusion_engine_framer.h"
+
+using namespace point_one::fusion_engine::analysis;
+using namespace point_one::fusion_engine::geodesy;
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::parsers;
+
+namespace {
+constexpr double EARTH_ROTATION_RATE_RPS = 7.2921151467e-5;
+
+// Initial velocity variance for a segment without a velocity measurement.
+constexpr double INITIAL_VELOCITY_VAR_M2PS2 = 1e4;
+
+constexpr size_t READ_BUFFER_SIZE_BYTES = 64 * 1024;
+
+enum class RecordType : uint8_t {
+  POSE = 0,
+  IMU = 1,
+};
+
+// A time-ordered measurement, stored in the intermediate measurement file.
+// Values are in the ECEF frame.
+struct MeasurementRecord {
+  uint64_t pose_index = 0;
+  RecordType type = RecordType::POSE;
+  uint8_t has_velocity = 0;
+  uint8_t reserved[6] = {0};
+  double p1_time_sec = 0.0;
+  // Pose: position and velocity. IMU: acceleration (excluding Coriolis) in the
+  // first 3 elements.
+  double value[6] = {0.0};
+  // Pose: position and velocity covariance (3x3, row-major).
+  double position_cov_m2[9] = {0.0};
+  double velocity_cov_m2ps2[9] = {0.0};
+};
+
+// The forward filter state at a pose, stored in the per-worker intermediate
+// file for the backward pass.
+struct FilterNode {
+  uint64_t pose_index = 0;
+  double dt_sec = 0.0;
+  double x_pred[6] = {0.0};
+  double P_pred[36] = {0.0};
+  double x[6] = {0.0};
+  double P[36] = {0.0};
+};
+
+// The smoothed solution for a pose, stored in the results file at an offset
+// determined by the pose index.
+struct SmoothedRecord {
+  uint8_t valid = 0;
+  uint8_t reserved[7] = {0};
+  double lla_deg[3] = {0.0};
+  double velocity_enu_mps[3] = {0.0};
+  double position_cov_enu_m2[9] = {0.0};
+  double velocity_cov_enu_m2ps2[9] = {0.0};
+};
+
+struct Segment {
+  uint64_t first_record = 0;
+  uint64_t num_records = 0;
+};
+
+/******************************************************************************/
+double ToSeconds(const Timestamp& time) {
+  if (time.seconds == Timestamp::INVALID ||
+      time.fraction_ns == Timestamp::INVALID) {
+    return NAN;
+  } else {
+    return time.seconds + (time.fraction_ns * 1e-9);
+  }
+}
+
+/******************************************************************************/
+bool IsFinite(const double* values, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (!std::isfinite(values[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/******************************************************************************/
+// Compute `C * P * C^T` (`transpose == false`) or `C^T * P * C`
+// (`transpose == true`) for 3x3 matrices.
+void RotateCovariance(const double C[9], const double P[9], bool transpose,
+                      double result[9]) {
+  double Ct[9];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      Ct[i * 3 + j] = transpose ? C[j * 3 + i] : C[i * 3 + j];
+    }
+  }
+
+  double CP[9];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      CP[i * 3 + j] = Ct[i * 3 + 0] * P[0 * 3 + j] +
+                      Ct[i * 3 + 1] * P[1 * 3 + j] +
+                      Ct[i * 3 + 2] * P[2 * 3 + j];
+    }
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      result[i * 3 + j] = CP[i * 3 + 0] * Ct[j * 3 + 0] +
+                          CP[i * 3 + 1] * Ct[j * 3 + 1] +
+                          CP[i * 3 + 2] * Ct[j * 3 + 2];
+    }
+  }
+}
+
+/******************************************************************************/
+// Compute `C * v` (`transpose == false`) or `C^T * v` (`transpose == true`).
+void Rotate(const double C[9], const double v[3], bool transpose,
+            double result[3]) {
+  for (int i = 0; i < 3; ++i) {
+    result[i] = transpose ? (C[0 * 3 + i] * v[0] + C[1 * 3 + i] * v[1] +
+                             C[2 * 3 + i] * v[2])
+                          : (C[i * 3 + 0] * v[0] + C[i * 3 + 1] * v[1] +
+                             C[i * 3 + 2] * v[2]);
+  }
+}
+
+/******************************************************************************/
+// Solve `S * X = B` in place for a symmetric positive definite n x n matrix
+// `S` (overwritten by its Cholesky factor) and an n x k matrix `B`.
+bool CholeskySolve(double* S, size_t n, double* B, size_t k) {
+  for (size_t j = 0; j < n; ++j) {
+    double d = S[j * n + j];
+    for (size_t p = 0; p < j; ++p) {
+      d -= S[j * n + p] * S[j * n + p];
+    }
+    if (!(d > 0.0)) {
+      return false;
+    }
+    d = std::sqrt(d);
+    S[j * n + j] = d;
+    for (size_t i = j + 1; i < n; ++i) {
+      double value = S[i * n + j];
+      for (size_t p = 0; p < j; ++p) {
+        value -= S[i * n + p] * S[j * n + p];
+      }
+      S[i * n + j] = value / d;
+    }
+  }
+
+  for (size_t c = 0; c < k; ++c) {
+    // Forward substitution: L * y = b.
+    for (size_t i = 0; i < n; ++i) {
+      double value = B[i * k + c];
+      for (size_t p = 0; p < i; ++p) {
+        value -= S[i * n + p] * B[p * k + c];
+      }
+      B[i * k + c] = value / S[i * n + i];
+    }
+
+    // Back substitution: L^T * x = y.
+    for (size_t ii = n; ii-- > 0;) {
+      double value = B[ii * k + c];
+      for (size_t p = ii + 1; p < n; ++p) {
+        value -= S[p * n + ii] * B[p * k + c];
+      }
+      B[ii * k + c] = value / S[ii * n + ii];
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************/
+void Symmetrize(double* P, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = i + 1; j < n; ++j) {
+      double value = 0.5 * (P[i * n + j] + P[j * n + i]);
+      P[i * n + j] = value;
+      P[j * n + i] = value;
+    }
+  }
+}
+
+/******************************************************************************/
+// Propagate the state `x = [r, v]` and covariance by `dt_sec` with constant
+// acceleration `accel` and white acceleration noise `accel_noise`.
+void Predict(double x[6], double P[36], double dt_sec, const double accel[3],
+             double accel_noise) {
+  double dt2 = dt_sec * dt_sec;
+  for (int i = 0; i < 3; ++i) {
+    x[i] += dt_sec * x[i + 3] + 0.5 * dt2 * accel[i];
+    x[i + 3] += dt_sec * accel[i];
+  }
+
+  // P = F * P * F^T, F = [I, dt * I; 0, I]
+  double result[36];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      result[i * 6 + j] =
+          P[i * 6 + j] + dt_sec * (P[i * 6 + j + 3] + P[(i + 3) * 6 + j]) +
+          dt2 * P[(i + 3) * 6 + j + 3];
+      result[i * 6 + j + 3] =
+          P[i * 6 + j + 3] + dt_sec * P[(i + 3) * 6 + j + 3];
+      result[(i + 3) * 6 + j] =
+          P[(i + 3) * 6 + j] + dt_sec * P[(i + 3) * 6 + j + 3];
+      result[(i + 3) * 6 + j + 3] = P[(i + 3) * 6 + j + 3];
+    }
+  }
+
+  double q = accel_noise * accel_noise;
+  for (int i = 0; i < 3; ++i) {
+    result[i * 6 + i] += q * dt2 * dt_sec / 3.0;
+    result[i * 6 + i + 3] += q * dt2 / 2.0;
+    result[(i + 3) * 6 + i] += q * dt2 / 2.0;
+    result[(i + 3) * 6 + i + 3] += q * dt_sec;
+  }
+
+  std::memcpy(P, result, sizeof(result));
+}
+
+/******************************************************************************/
+// Apply a direct measurement of the first `m` states.
+bool Update(double x[6], double P[36], const double* z, const double* R,
+            size_t m) {
+  // S = H * P * H^T + R
+  double S[36];
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < m; ++j) {
+      S[i * m + j] = P[i * 6 + j] + R[i * m + j];
+    }
+  }
+
+  // X = S^-1 * H * P = K^T
+  double X[36];
+  std::memcpy(X, P, m * 6 * sizeof(double));
+  if (!CholeskySolve(S, m, X, 6)) {
+    return false;
+  }
+
+  double y[6];
+  for (size_t i = 0; i < m; ++i) {
+    y[i] = z[i] - x[i];
+  }
+
+  for (size_t i = 0; i < 6; ++i) {
+    for (size_t p = 0; p < m; ++p) {
+      x[i] += X[p * 6 + i] * y[p];
+    }
+  }
+
+  // P = P - K * H * P
+  double HP[36];
+  std::memcpy(HP, P, m * 6 * sizeof(double));
+  for (size_t i = 0; i < 6; ++i) {
+    for (size_t j = 0; j < 6; ++j) {
+      double value = 0.0;
+      for (size_t p = 0; p < m; ++p) {
+        value += X[p * 6 + i] * HP[p * 6 + j];
+      }
+      P[i * 6 + j] -= value;
+    }
+  }
+  Symmetrize(P, 6);
+
+  return true;
+}
+
+/******************************************************************************/
+// Apply the RTS correction for one epoch, given the smoothed state at the next
+// epoch and the prediction to that epoch.
+bool SmoothStep(const FilterNode& node, const FilterNode& next,
+                const double x_next[6], const double P_next[36], double x[6],
+                double P[36]) {
+  // X = P_pred^-1 * F * P = G^T, where G = P * F^T * P_pred^-1 is the smoother
+  // gain.
+  double X[36];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 6; ++j) {
+      X[i * 6 + j] = node.P[i * 6 + j] + next.dt_sec * node.P[(i + 3) * 6 + j];
+      X[(i + 3) * 6 + j] = node.P[(i + 3) * 6 + j];
+    }
+  }
+
+  double S[36];
+  std::memcpy(S, next.P_pred, sizeof(S));
+  if (!CholeskySolve(S, 6, X, 6)) {
+    return false;
+  }
+
+  double dx[6];
+  for (int i = 0; i < 6; ++i) {
+    dx[i] = x_next[i] - next.x_pred[i];
+  }
+
+  for (int i = 0; i < 6; ++i) {
+    x[i] = node.x[i];
+    for (int p = 0; p < 6; ++p) {
+      x[i] += X[p * 6 + i] * dx[p];
+    }
+  }
+
+  // P = P_f + G * (P_next - P_pred) * G^T
+  double D[36];
+  for (int i = 0; i < 36; ++i) {
+    D[i] = P_next[i] - next.P_pred[i];
+  }
+
+  double DX[36];
+  for (int i = 0; i < 6; ++i) {
+    for (int j = 0; j < 6; ++j) {
+      double value = 0.0;
+      for (int p = 0; p < 6; ++p) {
+        value += D[i * 6 + p] * X[p * 6 + j];
+      }
+      DX[i * 6 + j] = value;
+    }
+  }
+
+  for (int i = 0; i < 6; ++i) {
+    for (int j = 0; j < 6; ++j) {
+      double value = node.P[i * 6 + j];
+      for (int p = 0; p < 6; ++p) {
+        value += X[p * 6 + i] * DX[p * 6 + j];
+      }
+      P[i * 6 + j] = value;
+    }
+  }
+  Symmetrize(P, 6);
+
+  return true;
+}
+
+/******************************************************************************/
+// Compute normal gravity (in m/s^2) using the Somigliana formula, with a linear
+// height correction.
+double GetNormalGravity(double latitude_deg, double height_m) {
+  double sin_lat = std::sin(latitude_deg * DEG_TO_RAD);
+  double sin2 = sin_lat * sin_lat;
+  return 9.7803253359 * (1.0 + 0.00193185265241 * sin2) /
+             std::sqrt(1.0 - 0.00669437999013 * sin2) -
+         3.086e-6 * height_m;
+}
+
+/******************************************************************************/
+bool ReadLog(const std::string& path, FusionEngineFramer& framer) {
+  std::ifstream stream(path, std::ifstream::binary);
+  if (!stream) {
+    return false;
+  }
+
+  std::vector<char> buffer(READ_BUFFER_SIZE_BYTES);
+  while (stream) {
+    stream.read(buffer.data(), buffer.size());
+    std::streamsize count = stream.gcount();
+    if (count <= 0) {
+      break;
+    }
+    framer.OnData(buffer.data(), static_cast<size_t>(count));
+  }
+
+  return stream.eof();
+}
+
+/******************************************************************************/
+// Convert log messages to time-ordered ECEF measurements, split into segments.
+class MeasurementWriter {
+ public:
+  MeasurementWriter(std::ofstream& stream, const SmootherOptions& options)
+      : stream_(stream), options_(options) {}
+
+  void OnMessage(const MessageHeader& header, const void* payload);
+  void Finish();
+
+  const std::vector<Segment>& GetSegments() const { return segments_; }
+  uint64_t GetNumPoses() const { return pose_count_; }
+  uint64_t GetNumPoseRecords() const { return pose_record_count_; }
+  uint64_t GetNumIMUMeasurements() const { return imu_count_; }
+
+ private:
+  void FlushPose();
+  void AddIMU(double p1_time_sec, const double accel_mps2[3]);
+  void EndSegment();
+  void Write(const MeasurementRecord& record);
+
+  std::ofstream& stream_;
+  SmootherOptions options_;
+
+  bool pending_ = false;
+  bool pending_aux_valid_ = false;
+  PoseMessage pending_pose_;
+  PoseAuxMessage pending_aux_;
+  uint64_t pending_index_ = 0;
+  uint64_t pose_count_ = 0;
+  uint64_t pose_record_count_ = 0;
+  uint64_t imu_count_ = 0;
+
+  // The most recent pose attitude and location, used to rotate IMU data.
+  bool attitude_valid_ = false;
+  double C_body_to_enu_[9];
+  double C_enu_to_ecef_[9];
+  double gravity_mps2_ = 0.0;
+
+  bool segment_open_ = false;
+  double last_pose_time_sec_ = NAN;
+  double last_record_time_sec_ = NAN;
+  uint64_t num_records_ = 0;
+  std::vector<Segment> segments_;
+};
+
+/******************************************************************************/
+void MeasurementWriter::OnMessage(const MessageHeader& header,
+                                  const void* payload) {
+  if (header.message_type == MessageType::POSE &&
+      header.payload_size_bytes >= sizeof(PoseMessage)) {
+    FlushPose();
+
+    PoseMessage pose;
+    std::memcpy(&pose, payload, sizeof(pose));
+    uint64_t pose_index = pose_count_++;
+    if (pose.solution_type == SolutionType::Invalid ||
+        std::isnan(ToSeconds(pose.p1_time)) || !IsFinite(pose.lla_deg, 3)) {
+      EndSegment();
+      return;
+    }
+
+    pending_ = true;
+    pending_aux_valid_ = false;
+    pending_pose_ = pose;
+    pending_index_ = pose_index;
+  } else if (header.message_type == MessageType::POSE_AUX &&
+             header.payload_size_bytes >= sizeof(PoseAuxMessage)) {
+    if (pending_) {
+      std::memcpy(&pending_aux_, payload, sizeof(pending_aux_));
+      pending_aux_valid_ =
+          pending_aux_.p1_time.seconds == pending_pose_.p1_time.seconds &&
+          pending_aux_.p1_time.fraction_ns == pending_pose_.p1_time.fraction_ns;
+    }
+  } else if (header.message_type == MessageType::IMU_MEASUREMENT &&
+             header.payload_size_bytes >= sizeof(IMUMeasurement)) {
+    FlushPose();
+    if (options_.use_imu) {
+      IMUMeasurement imu;
+      std::memcpy(&imu, payload, sizeof(imu));
+      AddIMU(ToSeconds(imu.p1_time), imu.accel_mps2);
+    }
+  } else if (header.message_type == MessageType::IMU_MEASUREMENT_BATCH) {
+    FlushPose();
+    if (options_.use_imu) {
+      IMUBatchView batch(payload, header.payload_size_bytes);
+      for (const IMUMeasurement& imu : batch) {
+        AddIMU(ToSeconds(imu.p1_time), imu.accel_mps2);
+      }
+    }
+  }
+}
+
+/******************************************************************************/
+void MeasurementWriter::Finish() {
+  FlushPose();
+  EndSegment();
+}
+
+/******************************************************************************/
+void MeasurementWriter::FlushPose() {
+  if (!pending_) {
+    return;
+  }
+  pending_ = false;
+
+  const PoseMessage& pose = pending_pose_;
+  double p1_time_sec = ToSeconds(pose.p1_time);
+  if (segment_open_ && (!(p1_time_sec > last_record_time_sec_) ||
+                        p1_time_sec - last_pose_time_sec_ >
+                            options_.max_gap_sec)) {
+    EndSegment();
+  }
+
+  double C_enu_to_ecef[9];
+  GetENUToECEFRotation(pose.lla_deg[0], pose.lla_deg[1], C_enu_to_ecef);
+
+  attitude_valid_ = IsFinite(pose.ypr_deg, 3);
+  if (attitude_valid_) {
+    GetBodyToENURotation(pose.ypr_deg, C_body_to_enu_);
+  }
+  std::memcpy(C_enu_to_ecef_, C_enu_to_ecef, sizeof(C_enu_to_ecef_));
+  gravity_mps2_ = GetNormalGravity(pose.lla_deg[0], pose.lla_deg[2]);
+
+  MeasurementRecord record;
+  record.pose_index = pending_index_;
+  record.type = RecordType::POSE;
+  record.p1_time_sec = p1_time_sec;
+  GeodeticToECEF(pose.lla_deg, record.value);
+
+  // Position covariance: use the full ENU covariance if available.
+  double cov_enu[9] = {0.0};
+  if (pending_aux_valid_ && IsFinite(pending_aux_.position_cov_enu_m2, 9)) {
+    std::memcpy(cov_enu, pending_aux_.position_cov_enu_m2, sizeof(cov_enu));
+  } else {
+    for (int i = 0; i < 3; ++i) {
+      double std_m = std::isfinite(pose.position_std_enu_m[i])
+                         ? pose.position_std_enu_m[i]
+                         : options_.default_position_std_m;
+      cov_enu[i * 3 + i] = std_m * std_m;
+    }
+  }
+  RotateCovariance(C_enu_to_ecef, cov_enu, false, record.position_cov_m2);
+
+  // Velocity: use the ENU velocity if available, otherwise rotate the body
+  // velocity using the reported attitude.
+  if (options_.use_velocity) {
+    double velocity_enu[3];
+    double velocity_cov[9] = {0.0};
+    if (pending_aux_valid_ && IsFinite(pending_aux_.velocity_enu_mps, 3)) {
+      std::memcpy(velocity_enu, pending_aux_.velocity_enu_mps,
+                  sizeof(velocity_enu));
+      for (int i = 0; i < 3; ++i) {
+        double std_mps = std::isfinite(pending_aux_.velocity_std_enu_mps[i])
+                             ? pending_aux_.velocity_std_enu_mps[i]
+                             : options_.default_velocity_std_mps;
+        velocity_cov[i * 3 + i] = std_mps * std_mps;
+      }
+      record.has_velocity = 1;
+    } else if (attitude_valid_ && IsFinite(pose.velocity_body_mps, 3)) {
+      Rotate(C_body_to_enu_, pose.velocity_body_mps, false, velocity_enu);
+      double velocity_cov_body[9] = {0.0};
+      for (int i = 0; i < 3; ++i) {
+        double std_mps = std::isfinite(pose.velocity_std_body_mps[i])
+                             ? pose.velocity_std_body_mps[i]
+                             : options_.default_velocity_std_mps;
+        velocity_cov_body[i * 3 + i] = std_mps * std_mps;
+      }
+      RotateCovariance(C_body_to_enu_, velocity_cov_body, false, velocity_cov);
+      record.has_velocity = 1;
+    }
+
+    if (record.has_velocity) {
+      Rotate(C_enu_to_ecef, velocity_enu, false, record.value + 3);
+      RotateCovariance(C_enu_to_ecef, velocity_cov, false,
+                       record.velocity_cov_m2ps2);
+    }
+  }
+
+  if (!segment_open_) {
+    segment_open_ = true;
+    segments_.emplace_back();
+    segments_.back().first_record = num_records_;
+  }
+
+  last_pose_time_sec_ = p1_time_sec;
+  ++pose_record_count_;
+  Write(record);
+}
+
+/******************************************************************************/
+void MeasurementWriter::AddIMU(double p1_time_sec, const double accel_mps2[3]) {
+  // IMU data is only used between poses within a segment, and must be in time
+  // order.
+  if (!segment_open_ || !attitude_valid_ ||
+      !(p1_time_sec >= last_record_time_sec_) || !IsFinite(accel_mps2, 3)) {
+    return;
+  }
+
+  // Convert specific force to kinematic acceleration: a = C * f + g.
+  double accel_enu[3];
+  Rotate(C_body_to_enu_, accel_mps2, false, accel_enu);
+  accel_enu[2] -= gravity_mps2_;
+
+  MeasurementRecord record;
+  record.type = RecordType::IMU;
+  record.p1_time_sec = p1_time_sec;
+  Rotate(C_enu_to_ecef_, accel_enu, false, record.value);
+  ++imu_count_;
+  Write(record);
+}
+
+/******************************************************************************/
+void MeasurementWriter::EndSegment() {
+  if (segment_open_) {
+    segment_open_ = false;
+    segments_.back().num_records = num_records_ - segments_.back().first_record;
+  }
+  attitude_valid_ = false;
+  last_pose_time_sec_ = NAN;
+  last_record_time_sec_ = NAN;
+}
+
+/******************************************************************************/
+void MeasurementWriter::Write(const MeasurementRecord& record) {
+  stream_.write(reinterpret_cast<const char*>(&record), sizeof(record));
+  last_record_time_sec_ = record.p1_time_sec;
+  ++num_records_;
+}
+
+/******************************************************************************/
+// Run the forward filter over a segment, writing the filter state at each pose
+// to `nodes`.
+bool FilterSegment(const Segment& segment, std::ifstream& measurements,
+                   std::fstream& nodes, const SmootherOptions& options,
+                   size_t* num_nodes) {
+  *num_nodes = 0;
+  measurements.clear();
+  measurements.seekg(segment.first_record * sizeof(MeasurementRecord));
+  nodes.clear();
+  nodes.seekp(0);
+
+  size_t block_size = std::max<size_t>(options.block_size, 1);
+  std::vector<MeasurementRecord> block(block_size);
+
+  FilterNode node;
+  double time_sec = NAN;
+  double last_pose_time_sec = NAN;
+  double accel[3] = {0.0, 0.0, 0.0};
+  double accel_time_sec = NAN;
+  for (uint64_t offset = 0; offset < segment.num_records;
+       offset += block_size) {
+    size_t count = static_cast<size_t>(
+        std::min<uint64_t>(block_size, segment.num_records - offset));
+    measurements.read(reinterpret_cast<char*>(block.data()),
+                      count * sizeof(MeasurementRecord));
+    if (!measurements) {
+      return false;
+    }
+
+    for (size_t r = 0; r < count; ++r) {
+      const MeasurementRecord& record = block[r];
+
+      // Propagate to the measurement time.
+      if (*num_nodes > 0 && record.p1_time_sec > time_sec) {
+        bool use_imu = record.p1_time_sec - accel_time_sec <=
+                       options.max_imu_age_sec;
+        double a[3] = {0.0, 0.0, 0.0};
+        if (use_imu) {
+          // Add the Coriolis acceleration: -2 * w_ie x v.
+          a[0] = accel[0] + 2.0 * EARTH_ROTATION_RATE_RPS * node.x[4];
+          a[1] = accel[1] - 2.0 * EARTH_ROTATION_RATE_RPS * node.x[3];
+          a[2] = accel[2];
+        }
+        Predict(node.x, node.P, record.p1_time_sec - time_sec, a,
+                use_imu ? options.imu_accel_noise_mps2
+                        : options.accel_noise_mps2);
+        time_sec = record.p1_time_sec;
+      }
+
+      if (record.type == RecordType::IMU) {
+        std::memcpy(accel, record.value, sizeof(accel));
+        accel_time_sec = record.p1_time_sec;
+        continue;
+      }
+
+      if (*num_nodes == 0) {
+        // Initialize the state from the first pose.
+        std::memset(node.x, 0, sizeof(node.x));
+        std::memset(node.P, 0, sizeof(node.P));
+        for (int i = 0; i < 3; ++i) {
+          node.x[i] = record.value[i];
+          if (record.has_velocity) {
+            node.x[i + 3] = record.value[i + 3];
+          }
+          for (int j = 0; j < 3; ++j) {
+            node.P[i * 6 + j] = record.position_cov_m2[i * 3 + j];
+            if (record.has_velocity) {
+              node.P[(i + 3) * 6 + j + 3] =
+                  record.velocity_cov_m2ps2[i * 3 + j];
+            }
+          }
+          if (!record.has_velocity) {
+            node.P[(i + 3) * 6 + i + 3] = INITIAL_VELOCITY_VAR_M2PS2;
+          }
+        }
+        node.dt_sec = 0.0;
+        std::memcpy(node.x_pred, node.x, sizeof(node.x));
+        std::memcpy(node.P_pred, node.P, sizeof(node.P));
+        time_sec = record.p1_time_sec;
+      } else {
+        node.dt_sec = record.p1_time_sec - last_pose_time_sec;
+        std::memcpy(node.x_pred, node.x, sizeof(node.x));
+        std::memcpy(node.P_pred, node.P, sizeof(node.P));
+
+        double z[6];
+        double R[36] = {0.0};
+        size_t m = record.has_velocity ? 6 : 3;
+        std::memcpy(z, record.value, m * sizeof(double));
+        for (int i = 0; i < 3; ++i) {
+          for (int j = 0; j < 3; ++j) {
+            R[i * m + j] = record.position_cov_m2[i * 3 + j];
+            if (record.has_velocity) {
+              R[(i + 3) * m + j + 3] = record.velocity_cov_m2ps2[i * 3 + j];
+            }
+          }
+        }
+        Update(node.x, node.P, z, R, m);
+      }
+
+      node.pose_index = record.pose_index;
+      last_pose_time_sec = record.p1_time_sec;
+      nodes.write(reinterpret_cast<const char*>(&node), sizeof(node));
+      ++*num_nodes;
+    }
+  }
+
+  nodes.flush();
+  return static_cast<bool>(nodes);
+}
+
+/******************************************************************************/
+void ToSmoothedRecord(const double x[6], const double P[36],
+                      SmoothedRecord* result) {
+  result->valid = 1;
+  ECEFToGeodetic(x, result->lla_deg);
+
+  double C_enu_to_ecef[9];
+  GetENUToECEFRotation(result->lla_deg[0], result->lla_deg[1], C_enu_to_ecef);
+  Rotate(C_enu_to_ecef, x + 3, true, result->velocity_enu_mps);
+
+  double position_cov[9];
+  double velocity_cov[9];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      position_cov[i * 3 + j] = P[i * 6 + j];
+      velocity_cov[i * 3 + j] = P[(i + 3) * 6 + j + 3];
+    }
+  }
+  RotateCovariance(C_enu_to_ecef, position_cov, true,
+                   result->position_cov_enu_m2);
+  RotateCovariance(C_enu_to_ecef, velocity_cov, true,
+                   result->velocity_cov_enu_m2ps2);
+}
+
+/******************************************************************************/
+// Run the backward pass over the filter states in `nodes`, writing the
+// smoothed solution for each pose to `results`.
+bool SmoothSegment(std::fstream& nodes, size_t num_nodes,
+                   std::fstream& results, const SmootherOptions& options) {
+  size_t block_size = std::max<size_t>(options.block_size, 1);
+  std::vector<FilterNode> block(block_size);
+
+  FilterNode next;
+  double x_next[6] = {0.0};
+  double P_next[36] = {0.0};
+  double x[6];
+  double P[36];
+  SmoothedRecord smoothed;
+  for (size_t end = num_nodes; end > 0;) {
+    size_t start = end > block_size ? end - block_size : 0;
+    nodes.clear();
+    nodes.seekg(start * sizeof(FilterNode));
+    nodes.read(reinterpret_cast<char*>(block.data()),
+               (end - start) * sizeof(FilterNode));
+    if (!nodes) {
+      return false;
+    }
+
+    for (size_t k = end; k-- > start;) {
+      const FilterNode& node = block[k - start];
+      if (k == num_nodes - 1 ||
+          !SmoothStep(node, next, x_next, P_next, x, P)) {
+        std::memcpy(x, node.x, sizeof(x));
+        std::memcpy(P, node.P, sizeof(P));
+      }
+
+      ToSmoothedRecord(x, P, &smoothed);
+      results.seekp(node.pose_index * sizeof(SmoothedRecord));
+      results.write(reinterpret_cast<const char*>(&smoothed),
+                    sizeof(smoothed));
+
+      next = node;
+      std::memcpy(x_next, x, sizeof(x_next));
+      std::memcpy(P_next, P, sizeof(P_next));
+    }
+
+    end = start;
+  }
+
+  return static_cast<bool>(results);
+}
+
+/******************************************************************************/
+// Process segments until none remain.
+void RunWorker(const std::string& measurements_path,
+               const std::string& results_path, const std::string& nodes_path,
+               const std::vector<Segment>& segments,
+               std::atomic<size_t>* next_segment, std::atomic<bool>* success,
+               const SmootherOptions& options) {
+  std::ifstream measurements(measurements_path, std::ifstream::binary);
+  std::fstream results(results_path, std::fstream::binary |
+                                         std::fstream::in | std::fstream::out);
+  std::fstream nodes(nodes_path, std::fstream::binary | std::fstream::in |
+                                     std::fstream::out | std::fstream::trunc);
+  if (!measurements || !results || !nodes) {
+    *success = false;
+    return;
+  }
+
+  for (size_t index = (*next_segment)++; index < segments.size() && *success;
+       index = (*next_segment)++) {
+    size_t num_nodes = 0;
+    if (!FilterSegment(segments[index], measurements, nodes, options,
+                       &num_nodes) ||
+        !SmoothSegment(nodes, num_nodes, results, options)) {
+      *success = false;
+    }
+  }
+
+  results.flush();
+  if (!results) {
+    *success = false;
+  }
+  nodes.close();
+  std::remove(nodes_path.c_str());
+}
+
+/******************************************************************************/
+void WriteMessage(std::ofstream& stream, const MessageHeader& header,
+                  const void* payload) {
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  stream.write(static_cast<const char*>(payload), header.payload_size_bytes);
+}
+
+/******************************************************************************/
+// Write a modified message, recomputing the CRC.
+template <typename T>
+void WriteModifiedMessage(std::ofstream& stream, const MessageHeader& header,
+                          const void* payload, const T& message,
+                          std::vector<uint8_t>& buffer) {
+  buffer.resize(sizeof(MessageHeader) + header.payload_size_bytes);
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  std::memcpy(buffer.data() + sizeof(header), payload,
+              header.payload_size_bytes);
+  std::memcpy(buffer.data() + sizeof(header), &message, sizeof(message));
+  MessageHeader* output_header =
+      reinterpret_cast<MessageHeader*>(buffer.data());
+  output_header->crc = CalculateCRC(buffer.data());
+  stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+/******************************************************************************/
+// Copy the input log, replacing pose solutions with smoothed values.
+bool WriteSmoothedLog(const std::string& input_path,
+                      const std::string& results_path,
+                      const std::string& output_path) {
+  std::ifstream results(results_path, std::ifstream::binary);
+  std::ofstream output(output_path, std::ofstream::binary);
+  if (!results || !output) {
+    return false;
+  }
+
+  bool success = true;
+  std::vector<uint8_t> buffer;
+  SmoothedRecord smoothed;
+  PoseMessage last_pose;
+  FusionEngineFramer framer(MessageHeader::MAX_MESSAGE_SIZE_BYTES);
+  framer.SetMessageCallback([&](const MessageHeader& header,
+                                const void* payload, size_t) {
+    if (header.message_type == MessageType::POSE &&
+        header.payload_size_bytes >= sizeof(PoseMessage)) {
+      std::memcpy(&last_pose, payload, sizeof(last_pose));
+      if (!results.read(reinterpret_cast<char*>(&smoothed),
+                        sizeof(smoothed))) {
+        success = false;
+        smoothed.valid = 0;
+      }
+
+      if (smoothed.valid) {
+        PoseMessage pose = last_pose;
+        std::memcpy(pose.lla_deg, smoothed.lla_deg, sizeof(pose.lla_deg));
+        for (int i = 0; i < 3; ++i) {
+          pose.position_std_enu_m[i] = static_cast<float>(
+              std::sqrt(smoothed.position_cov_enu_m2[i * 3 + i]));
+        }
+
+        if (IsFinite(pose.ypr_deg, 3)) {
+          double C[9];
+          double velocity_cov_body[9];
+          GetBodyToENURotation(pose.ypr_deg, C);
+          Rotate(C, smoothed.velocity_enu_mps, true, pose.velocity_body_mps);
+          RotateCovariance(C, smoothed.velocity_cov_enu_m2ps2, true,
+                           velocity_cov_body);
+          for (int i = 0; i < 3; ++i) {
+            pose.velocity_std_body_mps[i] =
+                static_cast<float>(std::sqrt(velocity_cov_body[i * 3 + i]));
+          }
+        }
+
+        WriteModifiedMessage(output, header, payload, pose, buffer);
+        return;
+      }
+    } else if (header.message_type == MessageType::POSE_AUX &&
+               header.payload_size_bytes >= sizeof(PoseAuxMessage) &&
+               smoothed.valid) {
+      PoseAuxMessage aux;
+      std::memcpy(&aux, payload, sizeof(aux));
+      if (aux.p1_time.seconds == last_pose.p1_time.seconds &&
+          aux.p1_time.fraction_ns == last_pose.p1_time.fraction_ns) {
+        std::memcpy(aux.position_cov_enu_m2, smoothed.position_cov_enu_m2,
+                    sizeof(aux.position_cov_enu_m2));
+        std::memcpy(aux.velocity_enu_mps, smoothed.velocity_enu_mps,
+                    sizeof(aux.velocity_enu_mps));
+        for (int i = 0; i < 3; ++i) {
+          aux.velocity_std_enu_mps[i] = static_cast<float>(
+              std::sqrt(smoothed.velocity_cov_enu_m2ps2[i * 3 + i]));
+        }
+
+        if (IsFinite(last_pose.ypr_deg, 3)) {
+          double C[9];
+          double position_cov_body[9];
+          GetBodyToENURotation(last_pose.ypr_deg, C);
+          RotateCovariance(C, smoothed.position_cov_enu_m2, true,
+                           position_cov_body);
+          for (int i = 0; i < 3; ++i) {
+            aux.position_std_body_m[i] =
+                static_cast<float>(std::sqrt(position_cov_body[i * 3 + i]));
+          }
+        }
+
+        WriteModifiedMessage(output, header, payload, aux, buffer);
+        return;
+      }
+    }
+
+    WriteMessage(output, header, payload);
+  });
+
+  if (!ReadLog(input_path, framer)) {
+    return false;
+  }
+
+  output.flush();
+  return success && static_cast<bool>(output);
+}
+} // namespace
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/******************************************************************************/
+bool SmoothLog(const std::string& input_path, const std::string& output_path,
+               const SmootherOptions& options, SmootherStatistics* statistics) {
+  const std::string measurements_path = output_path + ".measurements.tmp";
+  const std::string results_path = output_path + ".results.tmp";
+
+  // Pass 1: convert the log to time-ordered measurements and find segments.
+  std::vector<Segment> segments;
+  uint64_t num_poses = 0;
+  uint64_t num_smoothed_poses = 0;
+  uint64_t num_imu_measurements = 0;
+  {
+    std::ofstream measurements(measurements_path, std::ofstream::binary);
+    if (!measurements) {
+      return false;
+    }
+
+    MeasurementWriter writer(measurements, options);
+    FusionEngineFramer framer(MessageHeader::MAX_MESSAGE_SIZE_BYTES);
+    framer.SetMessageCallback(
+        [&](const MessageHeader& header, const void* payload, size_t) {
+          writer.OnMessage(header, payload);
+        });
+    bool success = ReadLog(input_path, framer);
+    writer.Finish();
+    measurements.flush();
+    if (!success || !measurements) {
+      measurements.close();
+      std::remove(measurements_path.c_str());
+      return false;
+    }
+
+    segments = writer.GetSegments();
+    num_poses = writer.GetNumPoses();
+    num_smoothed_poses = writer.GetNumPoseRecords();
+    num_imu_measurements = writer.GetNumIMUMeasurements();
+  }
+
+  // Create the results file, with an (invalid) entry for every pose.
+  bool success = true;
+  {
+    std::ofstream results(results_path, std::ofstream::binary);
+    std::vector<SmoothedRecord> block(std::max<size_t>(options.block_size, 1));
+    for (uint64_t offset = 0; offset < num_poses && results;
+         offset += block.size()) {
+      size_t count = static_cast<size_t>(
+          std::min<uint64_t>(block.size(), num_poses - offset));
+      results.write(reinterpret_cast<const char*>(block.data()),
+                    count * sizeof(SmoothedRecord));
+    }
+    results.flush();
+    success = static_cast<bool>(results);
+  }
+
+  // Pass 2: filter and smooth each segment.
+  if (success && !segments.empty()) {
+    size_t num_threads = options.num_threads;
+    if (num_threads == 0) {
+      num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    num_threads = std::min(num_threads, segments.size());
+
+    std::atomic<size_t> next_segment(0);
+    std::atomic<bool> worker_success(true);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; ++i) {
+      threads.emplace_back(RunWorker, measurements_path, results_path,
+                           output_path + ".nodes" + std::to_string(i) + ".tmp",
+                           std::cref(segments), &next_segment, &worker_success,
+                           std::cref(options));
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    success = worker_success;
+  }
+
+  // Pass 3: write the output log.
+  if (success) {
+    success = WriteSmoothedLog(input_path, results_path, output_path);
+  }
+
+  std::remove(measurements_path.c_str());
+  std::remove(results_path.c_str());
+
+  if (success && statistics != nullptr) {
+    statistics->num_segments = segments.size();
+    statistics->num_poses = num_smoothed_poses;
+    statistics->num_imu_measurements = num_imu_measurements;
+  }
+
+  return success;
+}
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
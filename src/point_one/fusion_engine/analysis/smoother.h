@@ -0,0 +1,136 @@
+/**************************************************************************/ /**
+ * @brief Offline forward-backward trajectory smoothing.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "point_one/fusion_engine/common/portability.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace analysis {
+
+/**
+ * @defgroup smoother Trajectory Smoothing
+ * @brief Post-process a recorded log using a Rauch-Tung-Striebel (RTS)
+ *        fixed-interval smoother.
+ *
+ * The smoother treats the position and velocity reported in each @ref
+ * messages::PoseMessage (with covariance from the matching @ref
+ * messages::PoseAuxMessage, if present) as measurements of a position/velocity
+ * state in the ECEF frame. Between poses, the state is propagated using @ref
+ * messages::IMUMeasurement (or @ref messages::IMUMeasurementBatch)
+ * specific force, rotated into ECEF using the most recent pose attitude. If no
+ * IMU data is available, a constant velocity model is used instead.
+ *
+ * The log is split into independent segments wherever poses are missing for
+ * longer than @ref SmootherOptions::max_gap_sec (or are invalid). Each segment
+ * is filtered forward and then smoothed backward, and segments are processed
+ * in parallel. Intermediate results are stored in temporary files next to the
+ * output file, so memory use does not depend on the length of the log.
+ * @{
+ */
+
+/**
+ * @brief Trajectory smoother configuration.
+ */
+struct SmootherOptions {
+  /**
+   * The maximum time between poses (in seconds). Larger gaps start a new
+   * segment.
+   */
+  double max_gap_sec = 1.0;
+
+  /**
+   * Acceleration process noise (in m/s^2/sqrt(Hz)) used when IMU data is
+   * available.
+   */
+  double imu_accel_noise_mps2 = 0.2;
+
+  /**
+   * Acceleration process noise (in m/s^2/sqrt(Hz)) used by the constant
+   * velocity model when IMU data is not available.
+   */
+  double accel_noise_mps2 = 2.0;
+
+  /**
+   * The maximum age of an IMU measurement (in seconds) used to propagate the
+   * state. Older measurements are ignored.
+   */
+  double max_imu_age_sec = 0.1;
+
+  /** The position standard deviation (in meters) used if none is reported. */
+  double default_position_std_m = 10.0;
+
+  /** The velocity standard deviation (in m/s) used if none is reported. */
+  double default_velocity_std_mps = 1.0;
+
+  /** If `true`, use IMU measurements to propagate the state. */
+  bool use_imu = true;
+
+  /** If `true`, use the reported velocity as a measurement. */
+  bool use_velocity = true;
+
+  /**
+   * The number of worker threads, or 0 to use one per available processor.
+   */
+  size_t num_threads = 0;
+
+  /** The number of filter epochs read at a time during the backward pass. */
+  size_t block_size = 1024;
+};
+
+/**
+ * @brief Trajectory smoother results.
+ */
+struct SmootherStatistics {
+  /** The number of independent segments. */
+  size_t num_segments = 0;
+
+  /** The number of @ref messages::PoseMessage smoothed. */
+  uint64_t num_poses = 0;
+
+  /** The number of IMU measurements used to propagate the state. */
+  uint64_t num_imu_measurements = 0;
+};
+
+/**
+ * @brief Smooth the trajectory in a log file.
+ *
+ * The output log contains all messages from the input log in their original
+ * order. The following fields are replaced by their smoothed values, and the
+ * message CRCs are updated:
+ * - @ref messages::PoseMessage: `lla_deg`, `position_std_enu_m`,
+ *   `velocity_body_mps`, `velocity_std_body_mps`
+ * - @ref messages::PoseAuxMessage (matched by `p1_time`):
+ *   `position_std_body_m`, `position_cov_enu_m2`, `velocity_enu_mps`,
+ *   `velocity_std_enu_mps`
+ *
+ * Poses that could not be smoothed (e.g., invalid solutions) are copied
+ * unmodified. Bytes that are not part of a valid FusionEngine message are not
+ * copied.
+ *
+ * @param input_path The input log path.
+ * @param output_path The output log path. Temporary files are created using
+ *        this path as a prefix, and are removed before returning.
+ * @param options The smoother configuration.
+ * @param[out] statistics If not `nullptr`, set to the smoother results.
+ *
+ * @return `true` on success, or `false` if a file could not be read or
+ *         written.
+ */
+P1_EXPORT bool SmoothLog(const std::string& input_path,
+                         const std::string& output_path,
+                         const SmootherOptions& options = SmootherOptions(),
+                         SmootherStatistics* statistics = nullptr);
+
+/** @} */
+
+} // namespace analysis
+} // namespace fusion_engine
+} // namespace point_one
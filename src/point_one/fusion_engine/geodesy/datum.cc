@@ -0,0 +1,315 @@
+/**************************************************************************/ /**
+ * @brief Reference frame (datum) and epoch transformations.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/geodesy/datum.h"
+
+#include <cmath>
+#include <string>
+
+using namespace point_one::fusion_engine::geodesy;
+using namespace point_one::fusion_engine::messages;
+
+namespace {
+constexpr double MAS_TO_RAD = 3.14159265358979323846 / (180.0 * 3600.0 * 1e3);
+
+// All transformations are expressed relative to ITRF2020 at this epoch.
+constexpr double COMMON_EPOCH_YR = 2015.0;
+
+// Number of positions converted at a time in TransformPositions().
+constexpr size_t BLOCK_SIZE = 256;
+
+struct RawParameters {
+  // T (mm), D (ppb), R (mas), T rate (mm/yr), D rate (ppb/yr), R rate
+  // (mas/yr), reference epoch.
+  double t[3];
+  double d;
+  double r[3];
+  double t_rate[3];
+  double d_rate;
+  double r_rate[3];
+  double epoch;
+};
+
+// ITRF2020 -> ITRFyy, as published by IGN for ITRF2020.
+constexpr RawParameters ITRF2020_TO_ITRF2014 = {
+    {-1.4, -0.9, 1.4}, -0.42, {0.0, 0.0, 0.0},
+    {0.0, -0.1, 0.2},  0.00,  {0.0, 0.0, 0.0}, 2015.0};
+constexpr RawParameters ITRF2020_TO_ITRF2008 = {
+    {0.2, 1.0, 3.3}, -0.29, {0.0, 0.0, 0.0},
+    {0.0, -0.1, 0.1}, 0.03, {0.0, 0.0, 0.0}, 2015.0};
+constexpr RawParameters ITRF2020_TO_ITRF2005 = {
+    {2.7, 0.1, -1.4}, 0.65, {0.0, 0.0, 0.0},
+    {0.3, -0.1, 0.1}, 0.03, {0.0, 0.0, 0.0}, 2015.0};
+constexpr RawParameters ITRF2020_TO_ITRF2000 = {
+    {-0.2, 0.8, -34.2}, 2.25, {0.0, 0.0, 0.0},
+    {0.1, 0.0, -1.7},   0.11, {0.0, 0.0, 0.0}, 2015.0};
+
+// ITRF2014 -> NAD83(2011), as published by NGS. NGS uses the coordinate frame
+// rotation convention, so the rotation signs are inverted here.
+constexpr RawParameters ITRF2014_TO_NAD83_2011 = {
+    {1005.30, -1902.10, -541.57},
+    0.36891,
+    {-26.78138, 0.42027, -10.93206},
+    {0.79, -0.60, -1.44},
+    -0.07201,
+    {-0.06667, 0.75744, 0.05133},
+    2010.0};
+
+// ITRF2014 plate motion model (Altamimi et al., 2017): plate rotation rates
+// (mas/yr), indexed by TectonicPlate.
+constexpr double PLATE_ROTATION_MAS_PER_YR[][3] = {
+    {0.099, -0.614, 0.733},   // AFRICA (Nubia)
+    {-0.248, -0.324, 0.675},  // ANTARCTICA
+    {1.154, -0.136, 1.444},   // ARABIA
+    {1.510, 1.182, 1.215},    // AUSTRALIA
+    {-0.085, -0.531, 0.770},  // EURASIA
+    {1.154, -0.005, 1.454},   // INDIA
+    {-0.333, -1.544, 1.623},  // NAZCA
+    {0.024, -0.694, -0.063},  // NORTH_AMERICA
+    {-0.409, 1.047, -2.169},  // PACIFIC
+    {-0.121, -0.794, 0.884},  // SOMALIA
+    {-0.270, -0.301, -0.140}, // SOUTH_AMERICA
+};
+
+// ITRF2014 plate motion model origin rate bias (mm/yr).
+constexpr double PLATE_MODEL_ORIGIN_RATE_MM_PER_YR[3] = {0.37, 0.35, 0.74};
+
+/******************************************************************************/
+// Convert published parameters to SI units at the common epoch.
+HelmertParameters ToHelmert(const RawParameters& raw) {
+  HelmertParameters params;
+  double dt = COMMON_EPOCH_YR - raw.epoch;
+  for (int i = 0; i < 3; ++i) {
+    params.translation_m[i] = (raw.t[i] + raw.t_rate[i] * dt) * 1e-3;
+    params.rotation_mas[i] = raw.r[i] + raw.r_rate[i] * dt;
+    params.translation_rate_m_per_yr[i] = raw.t_rate[i] * 1e-3;
+    params.rotation_rate_mas_per_yr[i] = raw.r_rate[i];
+  }
+  params.scale_ppb = raw.d + raw.d_rate * dt;
+  params.scale_rate_ppb_per_yr = raw.d_rate;
+  params.reference_epoch_yr = COMMON_EPOCH_YR;
+  return params;
+}
+
+/******************************************************************************/
+// Combine two (small) transformations at the common epoch, to first order:
+// result = a + sign * b.
+HelmertParameters Combine(const HelmertParameters& a,
+                          const HelmertParameters& b, double sign) {
+  HelmertParameters result;
+  for (int i = 0; i < 3; ++i) {
+    result.translation_m[i] = a.translation_m[i] + sign * b.translation_m[i];
+    result.rotation_mas[i] = a.rotation_mas[i] + sign * b.rotation_mas[i];
+    result.translation_rate_m_per_yr[i] = a.translation_rate_m_per_yr[i] +
+                                          sign * b.translation_rate_m_per_yr[i];
+    result.rotation_rate_mas_per_yr[i] =
+        a.rotation_rate_mas_per_yr[i] + sign * b.rotation_rate_mas_per_yr[i];
+  }
+  result.scale_ppb = a.scale_ppb + sign * b.scale_ppb;
+  result.scale_rate_ppb_per_yr =
+      a.scale_rate_ppb_per_yr + sign * b.scale_rate_ppb_per_yr;
+  result.reference_epoch_yr = COMMON_EPOCH_YR;
+  return result;
+}
+
+/******************************************************************************/
+// Get the transformation from ITRF2020 to the specified frame.
+HelmertParameters GetFromITRF2020(ReferenceFrame frame) {
+  switch (frame) {
+    case ReferenceFrame::ITRF2014:
+    case ReferenceFrame::WGS84:
+      return ToHelmert(ITRF2020_TO_ITRF2014);
+    case ReferenceFrame::ITRF2008:
+      return ToHelmert(ITRF2020_TO_ITRF2008);
+    case ReferenceFrame::ITRF2005:
+      return ToHelmert(ITRF2020_TO_ITRF2005);
+    case ReferenceFrame::ITRF2000:
+      return ToHelmert(ITRF2020_TO_ITRF2000);
+    case ReferenceFrame::NAD83_2011:
+      return Combine(ToHelmert(ITRF2020_TO_ITRF2014),
+                     ToHelmert(ITRF2014_TO_NAD83_2011), 1.0);
+    case ReferenceFrame::ITRF2020:
+    default:
+      return HelmertParameters();
+  }
+}
+
+/******************************************************************************/
+// Apply the parameters evaluated at a single epoch to one position.
+inline void Apply(const double T[3], double D, const double R[3],
+                  const double in[3], double out[3]) {
+  double x = in[0], y = in[1], z = in[2];
+  out[0] = x + T[0] + D * x - R[2] * y + R[1] * z;
+  out[1] = y + T[1] + R[2] * x + D * y - R[0] * z;
+  out[2] = z + T[2] - R[1] * x + R[0] * y + D * z;
+}
+
+/******************************************************************************/
+// Evaluate the parameters at the specified epoch, in SI units.
+inline void Evaluate(const HelmertParameters& params, double epoch_yr,
+                     double T[3], double* D, double R[3]) {
+  double dt = epoch_yr - params.reference_epoch_yr;
+  for (int i = 0; i < 3; ++i) {
+    T[i] = params.translation_m[i] + params.translation_rate_m_per_yr[i] * dt;
+    R[i] = (params.rotation_mas[i] + params.rotation_rate_mas_per_yr[i] * dt) *
+           MAS_TO_RAD;
+  }
+  *D = (params.scale_ppb + params.scale_rate_ppb_per_yr * dt) * 1e-9;
+}
+
+/******************************************************************************/
+// Civil date -> days since 1970/1/1 (proleptic Gregorian calendar).
+int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day) {
+  year -= month <= 2;
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  unsigned yoe = static_cast<unsigned>(year - era * 400);
+  unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+} // namespace
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/******************************************************************************/
+std::string to_string(ReferenceFrame frame) {
+  switch (frame) {
+    case ReferenceFrame::ITRF2020:
+      return "ITRF2020";
+    case ReferenceFrame::ITRF2014:
+      return "ITRF2014";
+    case ReferenceFrame::ITRF2008:
+      return "ITRF2008";
+    case ReferenceFrame::ITRF2005:
+      return "ITRF2005";
+    case ReferenceFrame::ITRF2000:
+      return "ITRF2000";
+    case ReferenceFrame::NAD83_2011:
+      return "NAD83(2011)";
+    case ReferenceFrame::WGS84:
+      return "WGS-84";
+    default:
+      return "Unrecognized Frame (" + std::to_string((int)frame) + ")";
+  }
+}
+
+/******************************************************************************/
+HelmertParameters GetHelmertParameters(ReferenceFrame from,
+                                       ReferenceFrame to) {
+  // from -> to = (ITRF2020 -> to) - (ITRF2020 -> from).
+  return Combine(GetFromITRF2020(to), GetFromITRF2020(from), -1.0);
+}
+
+/******************************************************************************/
+void ApplyHelmert(const HelmertParameters& params, double epoch_yr,
+                  const double* ecef_in, size_t count, double* ecef_out) {
+  double T[3], D, R[3];
+  Evaluate(params, epoch_yr, T, &D, R);
+  for (size_t i = 0; i < count; ++i) {
+    double in[3] = {ecef_in[i * 3 + 0], ecef_in[i * 3 + 1], ecef_in[i * 3 + 2]};
+    Apply(T, D, R, in, ecef_out + i * 3);
+  }
+}
+
+/******************************************************************************/
+void ApplyHelmert(const HelmertParameters& params, const double* epochs_yr,
+                  const double* ecef_in, size_t count, double* ecef_out) {
+  for (size_t i = 0; i < count; ++i) {
+    double T[3], D, R[3];
+    Evaluate(params, epochs_yr[i], T, &D, R);
+    double in[3] = {ecef_in[i * 3 + 0], ecef_in[i * 3 + 1], ecef_in[i * 3 + 2]};
+    Apply(T, D, R, in, ecef_out + i * 3);
+  }
+}
+
+/******************************************************************************/
+void PropagateEpoch(ReferenceFrame frame, TectonicPlate plate,
+                    double from_epoch_yr, double to_epoch_yr,
+                    const double* ecef_in, size_t count, double* ecef_out) {
+  // The displacement over dt is (omega x X + origin_rate) * dt, which is a
+  // Helmert transformation with R = omega * dt and T = origin_rate * dt.
+  double dt = to_epoch_yr - from_epoch_yr;
+  const double* omega =
+      PLATE_ROTATION_MAS_PER_YR[static_cast<size_t>(plate)];
+
+  double T[3], R[3];
+  for (int i = 0; i < 3; ++i) {
+    if (frame == ReferenceFrame::NAD83_2011) {
+      // NAD83 is fixed to the North American plate.
+      const double* omega_na = PLATE_ROTATION_MAS_PER_YR[static_cast<size_t>(
+          TectonicPlate::NORTH_AMERICA)];
+      R[i] = (omega[i] - omega_na[i]) * MAS_TO_RAD * dt;
+      T[i] = 0.0;
+    } else {
+      R[i] = omega[i] * MAS_TO_RAD * dt;
+      T[i] = PLATE_MODEL_ORIGIN_RATE_MM_PER_YR[i] * 1e-3 * dt;
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    double in[3] = {ecef_in[i * 3 + 0], ecef_in[i * 3 + 1], ecef_in[i * 3 + 2]};
+    Apply(T, 0.0, R, in, ecef_out + i * 3);
+  }
+}
+
+/******************************************************************************/
+void TransformPositions(ReferenceFrame from, double from_epoch_yr,
+                        ReferenceFrame to, double to_epoch_yr,
+                        TectonicPlate plate, const double* lla_in_deg,
+                        size_t count, double* lla_out_deg,
+                        const Ellipsoid& ellipsoid) {
+  HelmertParameters params = GetHelmertParameters(from, to);
+
+  double ecef[BLOCK_SIZE * 3];
+  for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+    size_t n = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+    for (size_t i = 0; i < n; ++i) {
+      GeodeticToECEF(lla_in_deg + (start + i) * 3, ecef + i * 3, ellipsoid);
+    }
+
+    ApplyHelmert(params, from_epoch_yr, ecef, n, ecef);
+    if (to_epoch_yr != from_epoch_yr) {
+      PropagateEpoch(to, plate, from_epoch_yr, to_epoch_yr, ecef, n, ecef);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      ECEFToGeodetic(ecef + i * 3, lla_out_deg + (start + i) * 3, ellipsoid);
+    }
+  }
+}
+
+/******************************************************************************/
+double GPSTimeToDecimalYear(const Timestamp& gps_time) {
+  if (gps_time.seconds == Timestamp::INVALID ||
+      gps_time.fraction_ns == Timestamp::INVALID) {
+    return NAN;
+  }
+
+  // Note: Leap seconds are ignored; the resulting error is negligible for
+  // transformation epochs.
+  static const int64_t GPS_EPOCH_DAYS = DaysFromCivil(1980, 1, 6);
+  double days = GPS_EPOCH_DAYS +
+                (gps_time.seconds + gps_time.fraction_ns * 1e-9) / 86400.0;
+
+  // Find the calendar year containing the specified day.
+  int64_t year = 1970 + static_cast<int64_t>(days / 365.2425);
+  while (DaysFromCivil(year, 1, 1) > days) {
+    --year;
+  }
+  while (DaysFromCivil(year + 1, 1, 1) <= days) {
+    ++year;
+  }
+
+  double year_start = static_cast<double>(DaysFromCivil(year, 1, 1));
+  double year_length =
+      static_cast<double>(DaysFromCivil(year + 1, 1, 1)) - year_start;
+  return year + (days - year_start) / year_length;
+}
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,208 @@
+/**************************************************************************/ /**
+ * @brief Reference frame (datum) and epoch transformations.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/geodesy/frames.h"
+#include "point_one/fusion_engine/messages/defs.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/**
+ * @addtogroup geodesy
+ * @{
+ */
+
+/**
+ * @brief Supported terrestrial reference frames.
+ *
+ * See @ref messages::PoseMessage::lla_deg for a discussion of the datum used by
+ * each @ref messages::SolutionType.
+ */
+enum class ReferenceFrame : uint8_t {
+  ITRF2020 = 0,
+  ITRF2014 = 1,
+  ITRF2008 = 2,
+  ITRF2005 = 3,
+  ITRF2000 = 4,
+  /** NAD83(2011), fixed to the North American plate. */
+  NAD83_2011 = 5,
+  /**
+   * WGS-84 as broadcast by GPS. Recent realizations (G1762 and later) agree
+   * with ITRF2014 at the centimeter level, and are treated as identical.
+   */
+  WGS84 = 6,
+};
+
+/**
+ * @brief Get a human-friendly string name for the specified @ref
+ *        ReferenceFrame.
+ */
+P1_EXPORT std::string to_string(ReferenceFrame frame);
+
+/**
+ * @brief @ref ReferenceFrame stream operator.
+ */
+inline std::ostream& operator<<(std::ostream& stream, ReferenceFrame frame) {
+  return (stream << to_string(frame));
+}
+
+/**
+ * @brief Tectonic plates supported by the plate motion model.
+ */
+enum class TectonicPlate : uint8_t {
+  AFRICA = 0,
+  ANTARCTICA = 1,
+  ARABIA = 2,
+  AUSTRALIA = 3,
+  EURASIA = 4,
+  INDIA = 5,
+  NAZCA = 6,
+  NORTH_AMERICA = 7,
+  PACIFIC = 8,
+  SOMALIA = 9,
+  SOUTH_AMERICA = 10,
+};
+
+/**
+ * @brief 14-parameter Helmert transformation parameters.
+ *
+ * Parameters follow the IERS convention:
+ *
+ * ```
+ * X_to = X_from + T + D * X_from + R * X_from
+ *
+ *     [  0  -R3  R2 ]
+ * R = [  R3  0  -R1 ]
+ *     [ -R2  R1  0  ]
+ * ```
+ *
+ * where each parameter `P` is evaluated at epoch `t` (decimal years) as
+ * `P(t) = P + P_rate * (t - reference_epoch_yr)`.
+ */
+struct HelmertParameters {
+  double translation_m[3] = {0.0, 0.0, 0.0};
+  double scale_ppb = 0.0;
+  double rotation_mas[3] = {0.0, 0.0, 0.0};
+  double translation_rate_m_per_yr[3] = {0.0, 0.0, 0.0};
+  double scale_rate_ppb_per_yr = 0.0;
+  double rotation_rate_mas_per_yr[3] = {0.0, 0.0, 0.0};
+  double reference_epoch_yr = 2015.0;
+};
+
+/**
+ * @brief Get the transformation parameters between two reference frames.
+ *
+ * Parameters are derived from the published ITRF2020 -> ITRFyy transformations
+ * and the NGS ITRF2014 -> NAD83(2011) transformation, chained through
+ * ITRF2020 as needed.
+ *
+ * @param from The source frame.
+ * @param to The destination frame.
+ *
+ * @return The transformation parameters.
+ */
+P1_EXPORT HelmertParameters GetHelmertParameters(ReferenceFrame from,
+                                                 ReferenceFrame to);
+
+/**
+ * @brief Apply a Helmert transformation to a batch of ECEF positions at a
+ *        single epoch.
+ *
+ * @param params The transformation parameters.
+ * @param epoch_yr The epoch of the positions (decimal years).
+ * @param ecef_in The input positions (3 values per position).
+ * @param count The number of positions.
+ * @param[out] ecef_out The output positions. May be the same as `ecef_in`.
+ */
+P1_EXPORT void ApplyHelmert(const HelmertParameters& params, double epoch_yr,
+                            const double* ecef_in, size_t count,
+                            double* ecef_out);
+
+/**
+ * @brief Apply a Helmert transformation to a batch of ECEF positions, each at
+ *        its own epoch.
+ *
+ * @param params The transformation parameters.
+ * @param epochs_yr The epoch of each position (decimal years).
+ * @param ecef_in The input positions (3 values per position).
+ * @param count The number of positions.
+ * @param[out] ecef_out The output positions. May be the same as `ecef_in`.
+ */
+P1_EXPORT void ApplyHelmert(const HelmertParameters& params,
+                            const double* epochs_yr, const double* ecef_in,
+                            size_t count, double* ecef_out);
+
+/**
+ * @brief Propagate a batch of ECEF positions from one epoch to another within
+ *        a reference frame using a rigid plate rotation model.
+ *
+ * Plate rotations are taken from the ITRF2014 plate motion model (Altamimi et
+ * al., 2017), and apply to all ITRF/WGS-84 frames. For NAD83(2011), motion is
+ * computed relative to the North American plate. Positions near plate
+ * boundaries (e.g., western North America) are subject to additional
+ * deformation not captured by this model.
+ *
+ * @param frame The reference frame of the positions.
+ * @param plate The tectonic plate on which the positions lie.
+ * @param from_epoch_yr The current epoch of the positions.
+ * @param to_epoch_yr The desired epoch.
+ * @param ecef_in The input positions (3 values per position).
+ * @param count The number of positions.
+ * @param[out] ecef_out The output positions. May be the same as `ecef_in`.
+ */
+P1_EXPORT void PropagateEpoch(ReferenceFrame frame, TectonicPlate plate,
+                              double from_epoch_yr, double to_epoch_yr,
+                              const double* ecef_in, size_t count,
+                              double* ecef_out);
+
+/**
+ * @brief Transform a batch of geodetic positions between reference frames and
+ *        epochs.
+ *
+ * Positions are first transformed from `from` to `to` at the observation epoch
+ * `from_epoch_yr`, and then propagated within `to` to `to_epoch_yr` using the
+ * plate motion model (see @ref PropagateEpoch()).
+ *
+ * @param from The source frame.
+ * @param from_epoch_yr The observation epoch of the positions.
+ * @param to The destination frame.
+ * @param to_epoch_yr The desired epoch in the destination frame.
+ * @param plate The tectonic plate on which the positions lie.
+ * @param lla_in_deg The input positions (3 values per position).
+ * @param count The number of positions.
+ * @param[out] lla_out_deg The output positions. May be the same as
+ *        `lla_in_deg`.
+ * @param ellipsoid The reference ellipsoid used for geodetic coordinates.
+ */
+P1_EXPORT void TransformPositions(ReferenceFrame from, double from_epoch_yr,
+                                  ReferenceFrame to, double to_epoch_yr,
+                                  TectonicPlate plate, const double* lla_in_deg,
+                                  size_t count, double* lla_out_deg,
+                                  const Ellipsoid& ellipsoid = WGS84);
+
+/**
+ * @brief Convert a GPS time to a decimal year (e.g., for use as a
+ *        transformation epoch).
+ *
+ * @param gps_time The GPS time (see @ref messages::PoseMessage::gps_time).
+ *
+ * @return The decimal year, or `NAN` if the time is invalid.
+ */
+P1_EXPORT double GPSTimeToDecimalYear(const messages::Timestamp& gps_time);
+
+/** @} */
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,140 @@
+/**************************************************************************/ /**
+ * @brief Reference ellipsoids and coordinate frame conversions.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+#include <cmath>
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/******************************************************************************/
+void GeodeticToECEF(const double lla_deg[3], double ecef_m[3],
+                    const Ellipsoid& ellipsoid) {
+  double lat_rad = lla_deg[0] * DEG_TO_RAD;
+  double lon_rad = lla_deg[1] * DEG_TO_RAD;
+  double sin_lat = std::sin(lat_rad), cos_lat = std::cos(lat_rad);
+  double e2 = ellipsoid.GetEccentricitySquared();
+  double N =
+      ellipsoid.semi_major_axis_m / std::sqrt(1.0 - e2 * sin_lat * sin_lat);
+
+  ecef_m[0] = (N + lla_deg[2]) * cos_lat * std::cos(lon_rad);
+  ecef_m[1] = (N + lla_deg[2]) * cos_lat * std::sin(lon_rad);
+  ecef_m[2] = (N * (1.0 - e2) + lla_deg[2]) * sin_lat;
+}
+
+/******************************************************************************/
+void ECEFToGeodetic(const double ecef_m[3], double lla_deg[3],
+                    const Ellipsoid& ellipsoid) {
+  double a = ellipsoid.semi_major_axis_m;
+  double b = ellipsoid.GetSemiMinorAxis();
+  double e2 = ellipsoid.GetEccentricitySquared();
+  double ep2 = e2 / (1.0 - e2);
+
+  double x = ecef_m[0], y = ecef_m[1], z = ecef_m[2];
+  double p = std::sqrt(x * x + y * y);
+
+  // Bowring's method, iterated on the parametric latitude. Two iterations
+  // converge to well below 0.1 mm for terrestrial positions.
+  double beta = std::atan2(a * z, b * p);
+  double lat_rad = 0.0;
+  for (int i = 0; i < 2; ++i) {
+    double sin_beta = std::sin(beta), cos_beta = std::cos(beta);
+    lat_rad = std::atan2(z + ep2 * b * sin_beta * sin_beta * sin_beta,
+                         p - e2 * a * cos_beta * cos_beta * cos_beta);
+    beta = std::atan2((1.0 - ellipsoid.flattening) * std::sin(lat_rad),
+                      std::cos(lat_rad));
+  }
+
+  double sin_lat = std::sin(lat_rad), cos_lat = std::cos(lat_rad);
+  double N = a / std::sqrt(1.0 - e2 * sin_lat * sin_lat);
+  double altitude_m;
+  if (std::fabs(cos_lat) > 1e-3) {
+    altitude_m = p / cos_lat - N;
+  } else {
+    altitude_m = z / sin_lat - N * (1.0 - e2);
+  }
+
+  lla_deg[0] = lat_rad * RAD_TO_DEG;
+  lla_deg[1] = std::atan2(y, x) * RAD_TO_DEG;
+  lla_deg[2] = altitude_m;
+}
+
+/******************************************************************************/
+void GetRadiiOfCurvature(double latitude_deg, double* meridian_radius_m,
+                         double* prime_vertical_radius_m,
+                         const Ellipsoid& ellipsoid) {
+  double sin_lat = std::sin(latitude_deg * DEG_TO_RAD);
+  double e2 = ellipsoid.GetEccentricitySquared();
+  double denom = 1.0 - e2 * sin_lat * sin_lat;
+  double N = ellipsoid.semi_major_axis_m / std::sqrt(denom);
+  *meridian_radius_m = N * (1.0 - e2) / denom;
+  *prime_vertical_radius_m = N;
+}
+
+/******************************************************************************/
+void GetENUToECEFRotation(double latitude_deg, double longitude_deg,
+                          double C[9]) {
+  double sin_lat = std::sin(latitude_deg * DEG_TO_RAD);
+  double cos_lat = std::cos(latitude_deg * DEG_TO_RAD);
+  double sin_lon = std::sin(longitude_deg * DEG_TO_RAD);
+  double cos_lon = std::cos(longitude_deg * DEG_TO_RAD);
+
+  // Columns: east, north, up unit vectors expressed in ECEF.
+  C[0] = -sin_lon;
+  C[1] = -sin_lat * cos_lon;
+  C[2] = cos_lat * cos_lon;
+  C[3] = cos_lon;
+  C[4] = -sin_lat * sin_lon;
+  C[5] = cos_lat * sin_lon;
+  C[6] = 0.0;
+  C[7] = cos_lat;
+  C[8] = sin_lat;
+}
+
+/******************************************************************************/
+void GetBodyToENURotation(const double ypr_deg[3], double C[9]) {
+  // Z-Y-X rotation sequence: yaw about +z (up), pitch about +y (left), roll
+  // about +x (forward).
+  double cy = std::cos(ypr_deg[0] * DEG_TO_RAD);
+  double sy = std::sin(ypr_deg[0] * DEG_TO_RAD);
+  double cp = std::cos(ypr_deg[1] * DEG_TO_RAD);
+  double sp = std::sin(ypr_deg[1] * DEG_TO_RAD);
+  double cr = std::cos(ypr_deg[2] * DEG_TO_RAD);
+  double sr = std::sin(ypr_deg[2] * DEG_TO_RAD);
+
+  C[0] = cy * cp;
+  C[1] = cy * sp * sr - sy * cr;
+  C[2] = cy * sp * cr + sy * sr;
+  C[3] = sy * cp;
+  C[4] = sy * sp * sr + cy * cr;
+  C[5] = sy * sp * cr - cy * sr;
+  C[6] = -sp;
+  C[7] = cp * sr;
+  C[8] = cp * cr;
+}
+
+/******************************************************************************/
+void GetBodyToENURotationFromQuaternion(const double quaternion[4],
+                                        double C[9]) {
+  double x = quaternion[0], y = quaternion[1], z = quaternion[2],
+         w = quaternion[3];
+  double s = 2.0 / (x * x + y * y + z * z + w * w);
+
+  C[0] = 1.0 - s * (y * y + z * z);
+  C[1] = s * (x * y - z * w);
+  C[2] = s * (x * z + y * w);
+  C[3] = s * (x * y + z * w);
+  C[4] = 1.0 - s * (x * x + z * z);
+  C[5] = s * (y * z - x * w);
+  C[6] = s * (x * z - y * w);
+  C[7] = s * (y * z + x * w);
+  C[8] = 1.0 - s * (x * x + y * y);
+}
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
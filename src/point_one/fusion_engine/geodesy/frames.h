@@ -0,0 +1,161 @@
+/**************************************************************************/ /**
+ * @brief Reference ellipsoids and coordinate frame conversions.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cmath> // For floor()
+
+#include "point_one/fusion_engine/common/portability.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/**
+ * @defgroup geodesy Geodesy Support
+ * @brief Coordinate frame conversions and geodetic computations.
+ *
+ * Frame conventions match the FusionEngine messages:
+ * - Geodetic positions are (latitude, longitude, altitude) in degrees and
+ *   meters above the ellipsoid (see @ref messages::PoseMessage::lla_deg).
+ * - The local tangent frame is east, north, up (ENU).
+ * - The platform body frame is +x forward, +y left, +z up, and attitude is
+ *   expressed as yaw, pitch, roll (see @ref messages::PoseMessage::ypr_deg) or
+ *   a scalar-last quaternion (see @ref
+ *   messages::PoseAuxMessage::attitude_quaternion).
+ * - 3x3 matrices are stored in row-major order.
+ * @{
+ */
+
+/** The ratio of a circle's circumference to its diameter. */
+constexpr double PI = 3.14159265358979323846;
+
+/** Multiply by this value to convert degrees to radians. */
+constexpr double DEG_TO_RAD = PI / 180.0;
+
+/** Multiply by this value to convert radians to degrees. */
+constexpr double RAD_TO_DEG = 180.0 / PI;
+
+/**
+ * @brief Wrap a longitude or longitude difference to [-180, 180).
+ *
+ * @param longitude_deg The longitude (in degrees).
+ *
+ * @return The equivalent longitude in [-180, 180).
+ */
+inline double WrapLongitudeDeg(double longitude_deg) {
+  return longitude_deg - 360.0 * std::floor((longitude_deg + 180.0) / 360.0);
+}
+
+/**
+ * @brief Wrap a longitude or longitude difference to [-pi, pi).
+ *
+ * @param longitude_rad The longitude (in radians).
+ *
+ * @return The equivalent longitude in [-pi, pi).
+ */
+inline double WrapLongitudeRad(double longitude_rad) {
+  return longitude_rad -
+         2.0 * PI * std::floor((longitude_rad + PI) / (2.0 * PI));
+}
+
+/**
+ * @brief A reference ellipsoid definition.
+ */
+struct Ellipsoid {
+  /** The semi-major axis (in meters). */
+  double semi_major_axis_m;
+
+  /** The flattening. */
+  double flattening;
+
+  constexpr double GetSemiMinorAxis() const {
+    return semi_major_axis_m * (1.0 - flattening);
+  }
+
+  constexpr double GetEccentricitySquared() const {
+    return flattening * (2.0 - flattening);
+  }
+};
+
+/** The WGS-84 ellipsoid. */
+constexpr Ellipsoid WGS84 = {6378137.0, 1.0 / 298.257223563};
+
+/** The GRS-80 ellipsoid (used by ITRF and ETRF realizations). */
+constexpr Ellipsoid GRS80 = {6378137.0, 1.0 / 298.257222101};
+
+/**
+ * @brief Convert a geodetic position to ECEF.
+ *
+ * @param lla_deg The geodetic position (latitude and longitude in degrees,
+ *        altitude in meters).
+ * @param[out] ecef_m The ECEF position (in meters).
+ * @param ellipsoid The reference ellipsoid.
+ */
+P1_EXPORT void GeodeticToECEF(const double lla_deg[3], double ecef_m[3],
+                              const Ellipsoid& ellipsoid = WGS84);
+
+/**
+ * @brief Convert an ECEF position to geodetic coordinates.
+ *
+ * Accurate to better than 0.1 mm for altitudes between -5 km and 1000 km.
+ *
+ * @param ecef_m The ECEF position (in meters).
+ * @param[out] lla_deg The geodetic position (latitude and longitude in
+ *        degrees, altitude in meters).
+ * @param ellipsoid The reference ellipsoid.
+ */
+P1_EXPORT void ECEFToGeodetic(const double ecef_m[3], double lla_deg[3],
+                              const Ellipsoid& ellipsoid = WGS84);
+
+/**
+ * @brief Compute the meridian and prime vertical radii of curvature.
+ *
+ * @param latitude_deg The geodetic latitude (in degrees).
+ * @param[out] meridian_radius_m The meridian radius of curvature (in meters).
+ * @param[out] prime_vertical_radius_m The prime vertical radius of curvature
+ *        (in meters).
+ * @param ellipsoid The reference ellipsoid.
+ */
+P1_EXPORT void GetRadiiOfCurvature(double latitude_deg,
+                                   double* meridian_radius_m,
+                                   double* prime_vertical_radius_m,
+                                   const Ellipsoid& ellipsoid = WGS84);
+
+/**
+ * @brief Compute the rotation from the local ENU frame to ECEF.
+ *
+ * @param latitude_deg The geodetic latitude (in degrees).
+ * @param longitude_deg The longitude (in degrees).
+ * @param[out] C The ENU->ECEF rotation matrix.
+ */
+P1_EXPORT void GetENUToECEFRotation(double latitude_deg, double longitude_deg,
+                                    double C[9]);
+
+/**
+ * @brief Compute the rotation from the platform body frame to the local ENU
+ *        frame from yaw, pitch, and roll.
+ *
+ * @param ypr_deg The yaw, pitch, and roll angles (in degrees).
+ * @param[out] C The body->ENU rotation matrix.
+ */
+P1_EXPORT void GetBodyToENURotation(const double ypr_deg[3], double C[9]);
+
+/**
+ * @brief Compute the rotation from the platform body frame to the local ENU
+ *        frame from a quaternion.
+ *
+ * @param quaternion The body orientation with respect to ENU (x, y, z, w). The
+ *        quaternion does not need to be normalized.
+ * @param[out] C The body->ENU rotation matrix.
+ */
+P1_EXPORT void GetBodyToENURotationFromQuaternion(const double quaternion[4],
+                                                  double C[9]);
+
+/** @} */
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,239 @@
+/**************************************************************************/ /**
+ * @brief Geodesic (shortest path) distance computation on the ellipsoid.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/geodesy/geodesic.h"
+
+#include <cmath>
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+using namespace point_one::fusion_engine::geodesy;
+
+namespace {
+constexpr int MAX_ITERATIONS = 32;
+constexpr double CONVERGENCE_THRESHOLD_RAD = 1e-15;
+
+// 8-point Gauss-Legendre quadrature nodes and weights on [-1, 1] (symmetric
+// about 0).
+constexpr double GL_NODES[4] = {0.1834346424956498, 0.5255324099163290,
+                                0.7966664774136267, 0.9602898564975363};
+constexpr double GL_WEIGHTS[4] = {0.3626837833783620, 0.3137066458778873,
+                                  0.2223810344533745, 0.1012285362903763};
+
+/******************************************************************************/
+// Get the sine and cosine of the reduced latitude.
+inline void GetReducedLatitude(double latitude_rad, double flattening,
+                               double* sin_beta, double* cos_beta) {
+  double s = (1.0 - flattening) * std::sin(latitude_rad);
+  double c = std::cos(latitude_rad);
+  double norm = std::hypot(s, c);
+  *sin_beta = s / norm;
+  *cos_beta = c / norm;
+}
+
+/******************************************************************************/
+// Evaluate the longitude integral (Karney 2013, eq. 8):
+//   I3 = integral of (2 - f) / (1 + (1 - f) * sqrt(1 + k^2 sin^2(s))) ds
+// over [sigma1, sigma2].
+double IntegrateLongitude(double sigma1, double sigma2, double k2,
+                          double flattening) {
+  double mid = 0.5 * (sigma1 + sigma2);
+  double half = 0.5 * (sigma2 - sigma1);
+  double sum = 0.0;
+  for (int i = 0; i < 4; ++i) {
+    for (int sign = -1; sign <= 1; sign += 2) {
+      double s = std::sin(mid + sign * half * GL_NODES[i]);
+      sum += GL_WEIGHTS[i] * (2.0 - flattening) /
+             (1.0 + (1.0 - flattening) * std::sqrt(1.0 + k2 * s * s));
+    }
+  }
+  return half * sum;
+}
+
+/******************************************************************************/
+// Evaluate the normalized distance integral (Karney 2013, eq. 15-18):
+//   s / b = A1 * (sigma + I1(sigma)), I1(sigma) = sum C1l sin(2 l sigma)
+// between sigma1 and sigma2.
+double IntegrateDistance(double sigma1, double sigma2, double k2) {
+  double sqrt_k = std::sqrt(1.0 + k2);
+  double eps = (sqrt_k - 1.0) / (sqrt_k + 1.0);
+  double eps2 = eps * eps, eps3 = eps2 * eps, eps4 = eps3 * eps,
+         eps5 = eps4 * eps, eps6 = eps5 * eps;
+
+  double A1 = (1.0 + eps2 / 4.0 + eps4 / 64.0 + eps6 / 256.0) / (1.0 - eps);
+  double C1[6] = {
+      -eps / 2.0 + 3.0 / 16.0 * eps3 - eps5 / 32.0,
+      -eps2 / 16.0 + eps4 / 32.0 - 9.0 / 2048.0 * eps6,
+      -eps3 / 48.0 + 3.0 / 256.0 * eps5,
+      -5.0 / 512.0 * eps4 + 3.0 / 512.0 * eps6,
+      -7.0 / 1280.0 * eps5,
+      -7.0 / 2048.0 * eps6,
+  };
+
+  double I1 = 0.0;
+  for (int l = 0; l < 6; ++l) {
+    I1 += C1[l] * (std::sin(2.0 * (l + 1) * sigma2) -
+                   std::sin(2.0 * (l + 1) * sigma1));
+  }
+  return A1 * (sigma2 - sigma1 + I1);
+}
+
+/******************************************************************************/
+// Approximate the distance between two nearby points using the radii of
+// curvature at their midpoint.
+inline double GetShortDistance(double latitude1_rad, double latitude2_rad,
+                               double delta_lon_rad, double a, double e2) {
+  double mid_latitude = 0.5 * (latitude1_rad + latitude2_rad);
+  double sin_lat = std::sin(mid_latitude);
+  double denom = 1.0 - e2 * sin_lat * sin_lat;
+  double N = a / std::sqrt(denom);
+  double M = N * (1.0 - e2) / denom;
+  double north_m = M * (latitude2_rad - latitude1_rad);
+  double east_m = N * std::cos(mid_latitude) * delta_lon_rad;
+  return std::sqrt(north_m * north_m + east_m * east_m);
+}
+} // namespace
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/******************************************************************************/
+bool InverseGeodesic(double latitude1_deg, double longitude1_deg,
+                     double latitude2_deg, double longitude2_deg,
+                     double* distance_m, double* azimuth1_deg,
+                     double* azimuth2_deg, const Ellipsoid& ellipsoid) {
+  double f = ellipsoid.flattening;
+  double b = ellipsoid.GetSemiMinorAxis();
+  double e2 = ellipsoid.GetEccentricitySquared();
+  double ep2 = e2 / (1.0 - e2);
+
+  double sin_beta1, cos_beta1, sin_beta2, cos_beta2;
+  GetReducedLatitude(latitude1_deg * DEG_TO_RAD, f, &sin_beta1, &cos_beta1);
+  GetReducedLatitude(latitude2_deg * DEG_TO_RAD, f, &sin_beta2, &cos_beta2);
+  double delta_lon =
+      WrapLongitudeRad((longitude2_deg - longitude1_deg) * DEG_TO_RAD);
+
+  // Iterate on the longitude difference on the auxiliary sphere, omega, until
+  // the corresponding geodesic longitude difference matches the target.
+  double omega = delta_lon;
+  double sin_sigma = 0.0, cos_sigma = 1.0, sigma1 = 0.0, sigma = 0.0;
+  double sin_alpha1 = 0.0, cos_alpha1 = 1.0, k2 = 0.0;
+  bool converged = false;
+  for (int i = 0; i < MAX_ITERATIONS; ++i) {
+    double sin_omega = std::sin(omega), cos_omega = std::cos(omega);
+    double y = cos_beta2 * sin_omega;
+    double x = cos_beta1 * sin_beta2 - sin_beta1 * cos_beta2 * cos_omega;
+    sin_sigma = std::hypot(y, x);
+    cos_sigma = sin_beta1 * sin_beta2 + cos_beta1 * cos_beta2 * cos_omega;
+
+    if (sin_sigma == 0.0) {
+      // Coincident or exactly antipodal points. Antipodal points are joined by
+      // a meridian through the poles.
+      sin_alpha1 = 0.0;
+      cos_alpha1 = 1.0;
+      sigma1 = std::atan2(sin_beta1, cos_beta1);
+      sigma = cos_sigma > 0.0 ? 0.0 : PI;
+      k2 = ep2;
+      converged = true;
+      break;
+    }
+
+    sin_alpha1 = y / sin_sigma;
+    cos_alpha1 = x / sin_sigma;
+    sigma = std::atan2(sin_sigma, cos_sigma);
+    sigma1 = std::atan2(sin_beta1, cos_alpha1 * cos_beta1);
+
+    double sin_alpha0 = sin_alpha1 * cos_beta1;
+    k2 = ep2 * (1.0 - sin_alpha0 * sin_alpha0);
+
+    double next_omega =
+        delta_lon + f * sin_alpha0 *
+                        IntegrateLongitude(sigma1, sigma1 + sigma, k2, f);
+    if (std::fabs(next_omega - omega) <= CONVERGENCE_THRESHOLD_RAD) {
+      converged = true;
+      break;
+    } else if (std::fabs(next_omega) > PI) {
+      // The geodesic wraps past the antipodal meridian: no convergence.
+      break;
+    }
+    omega = next_omega;
+  }
+
+  *distance_m = b * IntegrateDistance(sigma1, sigma1 + sigma, k2);
+
+  if (azimuth1_deg != nullptr) {
+    *azimuth1_deg = std::atan2(sin_alpha1, cos_alpha1) * RAD_TO_DEG;
+  }
+  if (azimuth2_deg != nullptr) {
+    double cos_omega = std::cos(omega);
+    *azimuth2_deg =
+        std::atan2(cos_beta1 * std::sin(omega),
+                   -sin_beta1 * cos_beta2 + cos_beta1 * sin_beta2 * cos_omega) *
+        RAD_TO_DEG;
+  }
+
+  return converged;
+}
+
+/******************************************************************************/
+double GetGeodesicDistance(double latitude1_deg, double longitude1_deg,
+                           double latitude2_deg, double longitude2_deg,
+                           const Ellipsoid& ellipsoid) {
+  double latitude1_rad = latitude1_deg * DEG_TO_RAD;
+  double latitude2_rad = latitude2_deg * DEG_TO_RAD;
+  double delta_lon_rad =
+      WrapLongitudeRad((longitude2_deg - longitude1_deg) * DEG_TO_RAD);
+  double a = ellipsoid.semi_major_axis_m;
+
+  // Conservative (spherical, using the semi-major axis) distance estimate to
+  // select the short distance approximation. NaN inputs fail this test and
+  // propagate through InverseGeodesic().
+  double delta_lat_rad = latitude2_rad - latitude1_rad;
+  double rough_m = a * (std::fabs(delta_lat_rad) + std::fabs(delta_lon_rad));
+  if (rough_m < SHORT_GEODESIC_DISTANCE_M) {
+    return GetShortDistance(latitude1_rad, latitude2_rad, delta_lon_rad, a,
+                            ellipsoid.GetEccentricitySquared());
+  }
+
+  double distance_m;
+  InverseGeodesic(latitude1_deg, longitude1_deg, latitude2_deg, longitude2_deg,
+                  &distance_m, nullptr, nullptr, ellipsoid);
+  return distance_m;
+}
+
+/******************************************************************************/
+void GetGeodesicDistances(const double* lla_deg, size_t count,
+                          double* distances_m, const Ellipsoid& ellipsoid) {
+  for (size_t i = 1; i < count; ++i) {
+    const double* lla1 = lla_deg + (i - 1) * 3;
+    const double* lla2 = lla_deg + i * 3;
+    distances_m[i - 1] =
+        GetGeodesicDistance(lla1[0], lla1[1], lla2[0], lla2[1], ellipsoid);
+  }
+}
+
+/******************************************************************************/
+void GetAlongTrackDistances(const double* lla_deg, size_t count,
+                            double* along_track_m,
+                            const Ellipsoid& ellipsoid) {
+  const double* previous = nullptr;
+  double total_m = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    const double* lla = lla_deg + i * 3;
+    if (!std::isnan(lla[0]) && !std::isnan(lla[1])) {
+      if (previous != nullptr) {
+        total_m += GetGeodesicDistance(previous[0], previous[1], lla[0],
+                                       lla[1], ellipsoid);
+      }
+      previous = lla;
+    }
+    along_track_m[i] = total_m;
+  }
+}
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
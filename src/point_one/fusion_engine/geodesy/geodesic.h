@@ -0,0 +1,123 @@
+/**************************************************************************/ /**
+ * @brief Geodesic (shortest path) distance computation on the ellipsoid.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/**
+ * @addtogroup geodesy
+ * @{
+ */
+
+/**
+ * @brief Positions closer than this distance are handled by @ref
+ *        GetGeodesicDistance() using a local ellipsoidal approximation instead
+ *        of solving the full inverse problem (error below 0.01 mm).
+ */
+constexpr double SHORT_GEODESIC_DISTANCE_M = 500.0;
+
+/**
+ * @brief Solve the inverse geodesic problem: find the shortest distance
+ *        between two points on the ellipsoid.
+ *
+ * The solution is computed on the auxiliary sphere (Karney, "Algorithms for
+ * geodesics", 2013): distance is evaluated using Karney's 6th order series in
+ * the ellipsoid's third flattening, and the longitude integral is evaluated by
+ * Gauss-Legendre quadrature at each iteration, giving results accurate to a few
+ * nanometers.
+ *
+ * The iteration may fail to converge for nearly antipodal points (within ~0.5
+ * deg of the antipode), which are not expected in vehicle trajectories. In that
+ * case, the returned values are from the final iteration and should not be
+ * relied upon.
+ *
+ * @param latitude1_deg The latitude of the first point.
+ * @param longitude1_deg The longitude of the first point.
+ * @param latitude2_deg The latitude of the second point.
+ * @param longitude2_deg The longitude of the second point.
+ * @param[out] distance_m The geodesic distance.
+ * @param[out] azimuth1_deg If not `nullptr`, the azimuth of the geodesic at the
+ *        first point (degrees clockwise from north).
+ * @param[out] azimuth2_deg If not `nullptr`, the azimuth of the geodesic at the
+ *        second point.
+ * @param ellipsoid The reference ellipsoid.
+ *
+ * @return `true` if the solution converged, `false` otherwise.
+ */
+P1_EXPORT bool InverseGeodesic(double latitude1_deg, double longitude1_deg,
+                               double latitude2_deg, double longitude2_deg,
+                               double* distance_m,
+                               double* azimuth1_deg = nullptr,
+                               double* azimuth2_deg = nullptr,
+                               const Ellipsoid& ellipsoid = WGS84);
+
+/**
+ * @brief Compute the geodesic distance between two points.
+ *
+ * Points closer than @ref SHORT_GEODESIC_DISTANCE_M (the common case for
+ * consecutive poses) use a local approximation based on the radii of curvature
+ * at the midpoint, which is much faster than @ref InverseGeodesic(). All other
+ * pairs are solved with @ref InverseGeodesic().
+ *
+ * @param latitude1_deg The latitude of the first point.
+ * @param longitude1_deg The longitude of the first point.
+ * @param latitude2_deg The latitude of the second point.
+ * @param longitude2_deg The longitude of the second point.
+ * @param ellipsoid The reference ellipsoid.
+ *
+ * @return The geodesic distance (in meters), or `NAN` if either point is
+ *         invalid.
+ */
+P1_EXPORT double GetGeodesicDistance(double latitude1_deg,
+                                     double longitude1_deg,
+                                     double latitude2_deg,
+                                     double longitude2_deg,
+                                     const Ellipsoid& ellipsoid = WGS84);
+
+/**
+ * @brief Compute the geodesic distance between consecutive positions in a
+ *        batch.
+ *
+ * See @ref GetGeodesicDistance().
+ *
+ * @param lla_deg The positions (3 values per position, e.g., @ref
+ *        messages::PoseMessage::lla_deg). Altitude is ignored.
+ * @param count The number of positions.
+ * @param[out] distances_m The distance from each position to the next
+ *        (`count - 1` values). Set to `NAN` if either position is invalid.
+ * @param ellipsoid The reference ellipsoid.
+ */
+P1_EXPORT void GetGeodesicDistances(const double* lla_deg, size_t count,
+                                    double* distances_m,
+                                    const Ellipsoid& ellipsoid = WGS84);
+
+/**
+ * @brief Compute the cumulative along-track distance of each position in a
+ *        batch.
+ *
+ * @param lla_deg The positions (3 values per position).
+ * @param count The number of positions.
+ * @param[out] along_track_m The distance traveled from the first position to
+ *        each position (`count` values). Invalid positions are skipped, and
+ *        are assigned the distance of the preceding valid position.
+ * @param ellipsoid The reference ellipsoid.
+ */
+P1_EXPORT void GetAlongTrackDistances(const double* lla_deg, size_t count,
+                                      double* along_track_m,
+                                      const Ellipsoid& ellipsoid = WGS84);
+
+/** @} */
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,428 @@
+/**************************************************************************/ /**
+ * @brief Geoid model lookup for orthometric heights.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/geodesy/geoid.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+#if !defined(_WIN32)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define P1_HAVE_MMAP 1
+#endif
+
+using namespace point_one::fusion_engine::geodesy;
+
+namespace {
+constexpr size_t TILE_SIZE = GeoidModel::TILE_SIZE;
+
+// Each tile includes 1 row/column before and 2 after its cells, so bicubic
+// lookups never cross a tile boundary.
+constexpr size_t TILE_STRIDE = TILE_SIZE + 3;
+constexpr size_t TILE_NUM_SAMPLES = TILE_STRIDE * TILE_STRIDE;
+
+// Maximum accepted PGM header value (width, height, or maximum sample value).
+constexpr long MAX_HEADER_VALUE = 1000000;
+
+/**
+ * @brief Accessor for grid samples stored in the source (file or user) layout.
+ */
+struct GridView {
+  // Big endian 16-bit samples, scaled by `scale_m` and `offset_m`.
+  const uint8_t* pgm_data = nullptr;
+  float offset_m = 0.0f;
+  float scale_m = 0.0f;
+
+  // Floating point samples.
+  const float* float_data = nullptr;
+
+  int64_t num_rows = 0;
+  int64_t num_columns = 0;
+
+  // Get the sample at the specified row and column. Rows past either pole
+  // continue over the pole onto the opposite meridian, and columns wrap.
+  float Get(int64_t row, int64_t column) const {
+    if (row < 0) {
+      row = -row;
+      column += num_columns / 2;
+    } else if (row >= num_rows) {
+      row = 2 * (num_rows - 1) - row;
+      column += num_columns / 2;
+    }
+
+    column %= num_columns;
+    if (column < 0) {
+      column += num_columns;
+    }
+
+    size_t index = static_cast<size_t>(row * num_columns + column);
+    if (pgm_data != nullptr) {
+      const uint8_t* ptr = pgm_data + index * 2;
+      uint16_t raw = static_cast<uint16_t>((ptr[0] << 8) | ptr[1]);
+      return offset_m + scale_m * raw;
+    } else {
+      return float_data[index];
+    }
+  }
+};
+
+/******************************************************************************/
+bool ParsePGMHeader(const uint8_t* data, size_t size, size_t* header_size,
+                    GridView* view) {
+  if (size < 2 || data[0] != 'P' || data[1] != '5') {
+    return false;
+  }
+
+  // Read the width, height, and maximum value fields, extracting the offset and
+  // scale from any comments along the way.
+  bool have_offset = false, have_scale = false;
+  long values[3];
+  size_t offset = 2;
+  for (int i = 0; i < 3; ++i) {
+    while (offset < size) {
+      if (data[offset] == '#') {
+        size_t end = offset;
+        while (end < size && data[end] != '\n') {
+          ++end;
+        }
+
+        std::string comment(reinterpret_cast<const char*>(data) + offset,
+                            end - offset);
+        if (comment.compare(0, 9, "# Offset ") == 0) {
+          view->offset_m = std::strtof(comment.c_str() + 9, nullptr);
+          have_offset = true;
+        } else if (comment.compare(0, 8, "# Scale ") == 0) {
+          view->scale_m = std::strtof(comment.c_str() + 8, nullptr);
+          have_scale = true;
+        }
+        offset = end;
+      } else if (std::isspace(data[offset])) {
+        ++offset;
+      } else {
+        break;
+      }
+    }
+
+    // Reject implausibly large values while parsing, before they can overflow.
+    values[i] = 0;
+    size_t start = offset;
+    while (offset < size && data[offset] >= '0' && data[offset] <= '9') {
+      values[i] = values[i] * 10 + (data[offset] - '0');
+      if (values[i] > MAX_HEADER_VALUE) {
+        return false;
+      }
+      ++offset;
+    }
+
+    if (offset == start || offset >= size) {
+      return false;
+    }
+  }
+
+  // A single whitespace character separates the header from the data.
+  if (!std::isspace(data[offset]) || !have_offset || !have_scale ||
+      values[2] != 65535) {
+    return false;
+  }
+
+  *header_size = offset + 1;
+  view->num_columns = values[0];
+  view->num_rows = values[1];
+  return true;
+}
+
+/******************************************************************************/
+bool IsValidGrid(int64_t num_rows, int64_t num_columns) {
+  // The grid must cover both poles and the full range of longitudes, with the
+  // same spacing in both directions.
+  return num_columns >= 4 && num_columns % 2 == 0 &&
+         num_rows == num_columns / 2 + 1;
+}
+
+/******************************************************************************/
+size_t GetPGMDataSize(const GridView& view) {
+  return static_cast<size_t>(view.num_rows * view.num_columns) * 2;
+}
+
+/******************************************************************************/
+void BuildTiles(const GridView& view, std::vector<float>* tiles,
+                size_t* num_tile_columns) {
+  // Each tile covers TILE_SIZE cells, where the last grid row (-90 deg) has
+  // no cells of its own.
+  size_t num_tile_rows =
+      (static_cast<size_t>(view.num_rows) - 1 + TILE_SIZE - 1) / TILE_SIZE;
+  *num_tile_columns =
+      (static_cast<size_t>(view.num_columns) + TILE_SIZE - 1) / TILE_SIZE;
+
+  tiles->resize(num_tile_rows * *num_tile_columns * TILE_NUM_SAMPLES);
+  float* out = tiles->data();
+  for (size_t tile_row = 0; tile_row < num_tile_rows; ++tile_row) {
+    for (size_t tile_column = 0; tile_column < *num_tile_columns;
+         ++tile_column) {
+      int64_t row0 = static_cast<int64_t>(tile_row * TILE_SIZE) - 1;
+      int64_t column0 = static_cast<int64_t>(tile_column * TILE_SIZE) - 1;
+      for (size_t i = 0; i < TILE_STRIDE; ++i) {
+        int64_t row = row0 + static_cast<int64_t>(i);
+        // Clamp rows in the unused portion of the last tile row.
+        if (row > view.num_rows) {
+          row = view.num_rows;
+        }
+
+        for (size_t j = 0; j < TILE_STRIDE; ++j) {
+          *out++ = view.Get(row, column0 + static_cast<int64_t>(j));
+        }
+      }
+    }
+  }
+}
+
+/******************************************************************************/
+// Cubic convolution weights (Keys, a = -0.5) for samples at offsets -1, 0, 1,
+// and 2 from the interpolation point.
+inline void GetCubicWeights(double t, double w[4]) {
+  double t2 = t * t, t3 = t2 * t;
+  w[0] = -0.5 * t3 + t2 - 0.5 * t;
+  w[1] = 1.5 * t3 - 2.5 * t2 + 1.0;
+  w[2] = -1.5 * t3 + 2.0 * t2 + 0.5 * t;
+  w[3] = 0.5 * t3 - 0.5 * t2;
+}
+
+/******************************************************************************/
+// Interpolate a 4x4 patch of samples, where `sample(i, j)` returns the sample
+// at row offset `i - 1` and column offset `j - 1` from the cell origin.
+template <typename Sampler>
+inline double InterpolateBicubic(Sampler sample, double fx, double fy) {
+  double wx[4], wy[4];
+  GetCubicWeights(fx, wx);
+  GetCubicWeights(fy, wy);
+  double result = 0.0;
+  for (int i = 0; i < 4; ++i) {
+    double row = wx[0] * sample(i, 0) + wx[1] * sample(i, 1) +
+                 wx[2] * sample(i, 2) + wx[3] * sample(i, 3);
+    result += wy[i] * row;
+  }
+  return result;
+}
+
+/******************************************************************************/
+// Interpolate a 2x2 patch of samples, where `sample(i, j)` returns the sample
+// at row offset `i` and column offset `j` from the cell origin.
+template <typename Sampler>
+inline double InterpolateBilinear(Sampler sample, double fx, double fy) {
+  double top = sample(0, 0) + fx * (sample(0, 1) - sample(0, 0));
+  double bottom = sample(1, 0) + fx * (sample(1, 1) - sample(1, 0));
+  return top + fy * (bottom - top);
+}
+} // namespace
+
+constexpr size_t GeoidModel::TILE_SIZE;
+
+/******************************************************************************/
+GeoidModel::~GeoidModel() { Close(); }
+
+/******************************************************************************/
+bool GeoidModel::Load(const std::string& path, bool use_mmap) {
+  Close();
+
+  GridView view;
+  size_t header_size = 0;
+
+#if P1_HAVE_MMAP
+  if (use_mmap) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+
+    struct stat info;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      base = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                  MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+      return false;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    const uint8_t* data = static_cast<const uint8_t*>(base);
+    if (!ParsePGMHeader(data, size, &header_size, &view) ||
+        !IsValidGrid(view.num_rows, view.num_columns) ||
+        size < header_size + GetPGMDataSize(view)) {
+      munmap(base, size);
+      return false;
+    }
+
+    // Lookups touch a few samples at scattered locations: disable read-ahead.
+    madvise(base, size, MADV_RANDOM);
+
+    mapped_base_ = base;
+    mapped_size_ = size;
+    mapped_data_ = data + header_size;
+    offset_m_ = view.offset_m;
+    scale_m_ = view.scale_m;
+    num_rows_ = view.num_rows;
+    num_columns_ = view.num_columns;
+    rows_per_deg_ = (num_rows_ - 1) / 180.0;
+    columns_per_deg_ = num_columns_ / 360.0;
+    return true;
+  }
+#else
+  (void)use_mmap;
+#endif
+
+  std::ifstream stream(path, std::ifstream::binary);
+  if (!stream) {
+    return false;
+  }
+
+  stream.seekg(0, stream.end);
+  size_t size = static_cast<size_t>(stream.tellg());
+  stream.seekg(0, stream.beg);
+  std::vector<uint8_t> data(size);
+  stream.read(reinterpret_cast<char*>(data.data()), size);
+  if (!stream || !ParsePGMHeader(data.data(), size, &header_size, &view) ||
+      !IsValidGrid(view.num_rows, view.num_columns) ||
+      size < header_size + GetPGMDataSize(view)) {
+    return false;
+  }
+
+  view.pgm_data = data.data() + header_size;
+  BuildTiles(view, &tiles_, &num_tile_columns_);
+  num_rows_ = view.num_rows;
+  num_columns_ = view.num_columns;
+  rows_per_deg_ = (num_rows_ - 1) / 180.0;
+  columns_per_deg_ = num_columns_ / 360.0;
+  return true;
+}
+
+/******************************************************************************/
+bool GeoidModel::Load(const float* undulations_m, size_t num_rows,
+                      size_t num_columns) {
+  Close();
+
+  GridView view;
+  view.float_data = undulations_m;
+  view.num_rows = static_cast<int64_t>(num_rows);
+  view.num_columns = static_cast<int64_t>(num_columns);
+  if (undulations_m == nullptr ||
+      !IsValidGrid(view.num_rows, view.num_columns)) {
+    return false;
+  }
+
+  BuildTiles(view, &tiles_, &num_tile_columns_);
+  num_rows_ = num_rows;
+  num_columns_ = num_columns;
+  rows_per_deg_ = (num_rows_ - 1) / 180.0;
+  columns_per_deg_ = num_columns_ / 360.0;
+  return true;
+}
+
+/******************************************************************************/
+void GeoidModel::Close() {
+#if P1_HAVE_MMAP
+  if (mapped_base_ != nullptr) {
+    munmap(mapped_base_, mapped_size_);
+  }
+#endif
+
+  mapped_base_ = nullptr;
+  mapped_size_ = 0;
+  mapped_data_ = nullptr;
+  tiles_.clear();
+  tiles_.shrink_to_fit();
+  num_tile_columns_ = 0;
+  num_rows_ = 0;
+  num_columns_ = 0;
+}
+
+/******************************************************************************/
+double GeoidModel::GetUndulation(double latitude_deg, double longitude_deg,
+                                 GeoidInterpolation interpolation) const {
+  if (num_rows_ == 0 || !(std::fabs(latitude_deg) <= 90.0) ||
+      !std::isfinite(longitude_deg)) {
+    return NAN;
+  }
+
+  // Locate the grid cell containing the position, and the fractional position
+  // within the cell.
+  double longitude = std::fmod(longitude_deg, 360.0);
+  if (longitude < 0.0) {
+    longitude += 360.0;
+  }
+
+  double y = (90.0 - latitude_deg) * rows_per_deg_;
+  double x = longitude * columns_per_deg_;
+  size_t row = static_cast<size_t>(y);
+  size_t column = static_cast<size_t>(x);
+  if (row > num_rows_ - 2) {
+    row = num_rows_ - 2;
+  }
+  if (column > num_columns_ - 1) {
+    column = num_columns_ - 1;
+  }
+  double fy = y - row;
+  double fx = x - column;
+
+  if (mapped_data_ == nullptr) {
+    size_t tile_index =
+        (row / TILE_SIZE) * num_tile_columns_ + (column / TILE_SIZE);
+    const float* cell = tiles_.data() + tile_index * TILE_NUM_SAMPLES +
+                        (row % TILE_SIZE + 1) * TILE_STRIDE +
+                        (column % TILE_SIZE + 1);
+    if (interpolation == GeoidInterpolation::BICUBIC) {
+      const float* patch = cell - TILE_STRIDE - 1;
+      return InterpolateBicubic(
+          [patch](int i, int j) { return patch[i * TILE_STRIDE + j]; }, fx,
+          fy);
+    } else {
+      return InterpolateBilinear(
+          [cell](int i, int j) { return cell[i * TILE_STRIDE + j]; }, fx, fy);
+    }
+  } else {
+    GridView view;
+    view.pgm_data = mapped_data_;
+    view.offset_m = offset_m_;
+    view.scale_m = scale_m_;
+    view.num_rows = num_rows_;
+    view.num_columns = num_columns_;
+    int64_t r = static_cast<int64_t>(row), c = static_cast<int64_t>(column);
+    if (interpolation == GeoidInterpolation::BICUBIC) {
+      return InterpolateBicubic(
+          [&](int i, int j) { return view.Get(r + i - 1, c + j - 1); }, fx,
+          fy);
+    } else {
+      return InterpolateBilinear(
+          [&](int i, int j) { return view.Get(r + i, c + j); }, fx, fy);
+    }
+  }
+}
+
+/******************************************************************************/
+void GeoidModel::GetUndulations(const double* lla_deg, size_t count,
+                                double* undulations_m,
+                                GeoidInterpolation interpolation) const {
+  for (size_t i = 0; i < count; ++i) {
+    undulations_m[i] =
+        GetUndulation(lla_deg[i * 3 + 0], lla_deg[i * 3 + 1], interpolation);
+  }
+}
+
+/******************************************************************************/
+void GeoidModel::GetOrthometricHeights(const double* lla_deg, size_t count,
+                                       double* heights_m,
+                                       GeoidInterpolation interpolation) const {
+  for (size_t i = 0; i < count; ++i) {
+    heights_m[i] =
+        lla_deg[i * 3 + 2] -
+        GetUndulation(lla_deg[i * 3 + 0], lla_deg[i * 3 + 1], interpolation);
+  }
+}
@@ -0,0 +1,180 @@
+/**************************************************************************/ /**
+ * @brief Geoid model lookup for orthometric heights.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/**
+ * @addtogroup geodesy
+ * @{
+ */
+
+/**
+ * @brief Interpolation methods supported by @ref GeoidModel.
+ */
+enum class GeoidInterpolation : uint8_t {
+  /** Bilinear interpolation of the 4 surrounding grid points. */
+  BILINEAR = 0,
+  /** Cubic convolution over the 16 surrounding grid points. */
+  BICUBIC = 1,
+};
+
+/**
+ * @brief A global geoid undulation grid (e.g., EGM96 or EGM2008).
+ *
+ * The orthometric height (height above the geoid) of a position is:
+ *
+ * ```
+ * H = h - N
+ * ```
+ *
+ * where `h` is the ellipsoidal altitude (@ref messages::PoseMessage::lla_deg)
+ * and `N` is the geoid undulation returned by this class.
+ *
+ * Grids are loaded from GeographicLib PGM files (e.g., `egm96-5.pgm`,
+ * `egm2008-2_5.pgm`): 16-bit big endian samples with `# Offset` and `# Scale`
+ * header comments, rows ordered from 90 deg to -90 deg latitude (inclusive),
+ * and columns ordered eastward from 0 deg longitude.
+ *
+ * By default, the grid is decoded into square tiles, each stored contiguously
+ * along with a border of neighboring samples. Every lookup reads from a single
+ * tile (a few cache lines), regardless of where it falls in the grid, so
+ * nearby lookups stay in cache. Alternatively, the file may be memory mapped
+ * and sampled in place, which avoids decoding the grid and loading it into
+ * memory (e.g., for the 1 arcminute EGM2008 grid, ~470 MB) at the cost of
+ * slower lookups.
+ *
+ * Lookups do not modify the model and may be performed concurrently from any
+ * number of threads. @ref Load() and @ref Close() must not be called
+ * concurrently with lookups.
+ */
+class P1_EXPORT GeoidModel {
+ public:
+  /** The number of grid cells along each side of a tile. */
+  static constexpr size_t TILE_SIZE = 32;
+
+  GeoidModel() = default;
+  ~GeoidModel();
+
+  GeoidModel(const GeoidModel&) = delete;
+  GeoidModel& operator=(const GeoidModel&) = delete;
+
+  /**
+   * @brief Load a geoid grid from a PGM file.
+   *
+   * @param path The path to the grid file.
+   * @param use_mmap If `true`, memory map the file and sample it in place
+   *        instead of decoding it into memory. Ignored on platforms without
+   *        `mmap()` support.
+   *
+   * @return `true` on success, or `false` if the file could not be read or is
+   *         not a valid global grid.
+   */
+  bool Load(const std::string& path, bool use_mmap = false);
+
+  /**
+   * @brief Load a geoid grid from memory.
+   *
+   * The grid uses the same layout as the PGM file format: `num_rows` rows
+   * spanning 90 deg to -90 deg latitude (inclusive), and `num_columns` columns
+   * spanning 0 deg to 360 deg longitude (exclusive).
+   *
+   * @param undulations_m The geoid undulation at each grid point (row major).
+   * @param num_rows The number of rows.
+   * @param num_columns The number of columns. Must be even.
+   *
+   * @return `true` on success, or `false` if the dimensions are invalid.
+   */
+  bool Load(const float* undulations_m, size_t num_rows, size_t num_columns);
+
+  /**
+   * @brief Unload the current grid.
+   */
+  void Close();
+
+  /**
+   * @brief Check if a grid is loaded.
+   */
+  bool IsLoaded() const { return num_rows_ != 0; }
+
+  /**
+   * @brief Check if the grid is being sampled from a memory mapped file.
+   */
+  bool IsMemoryMapped() const { return mapped_data_ != nullptr; }
+
+  /**
+   * @brief Get the geoid undulation at the specified position.
+   *
+   * @param latitude_deg The geodetic latitude.
+   * @param longitude_deg The longitude.
+   * @param interpolation The interpolation method.
+   *
+   * @return The geoid undulation (meters), or `NAN` if no grid is loaded or the
+   *         position is invalid.
+   */
+  double GetUndulation(
+      double latitude_deg, double longitude_deg,
+      GeoidInterpolation interpolation = GeoidInterpolation::BILINEAR) const;
+
+  /**
+   * @brief Get the geoid undulation for a batch of positions.
+   *
+   * @param lla_deg The positions (3 values per position, e.g., @ref
+   *        messages::PoseMessage::lla_deg).
+   * @param count The number of positions.
+   * @param[out] undulations_m The geoid undulation of each position.
+   * @param interpolation The interpolation method.
+   */
+  void GetUndulations(
+      const double* lla_deg, size_t count, double* undulations_m,
+      GeoidInterpolation interpolation = GeoidInterpolation::BILINEAR) const;
+
+  /**
+   * @brief Get the orthometric height for a batch of positions.
+   *
+   * @param lla_deg The positions (3 values per position, e.g., @ref
+   *        messages::PoseMessage::lla_deg).
+   * @param count The number of positions.
+   * @param[out] heights_m The height of each position above the geoid.
+   * @param interpolation The interpolation method.
+   */
+  void GetOrthometricHeights(
+      const double* lla_deg, size_t count, double* heights_m,
+      GeoidInterpolation interpolation = GeoidInterpolation::BILINEAR) const;
+
+ private:
+  size_t num_rows_ = 0;
+  size_t num_columns_ = 0;
+  double rows_per_deg_ = 0.0;
+  double columns_per_deg_ = 0.0;
+
+  // Tiled storage: each tile stores (TILE_SIZE + 3)^2 samples, covering grid
+  // rows/columns [-1, TILE_SIZE + 2) relative to the tile origin.
+  std::vector<float> tiles_;
+  size_t num_tile_columns_ = 0;
+
+  // Memory mapped storage.
+  const uint8_t* mapped_data_ = nullptr;
+  void* mapped_base_ = nullptr;
+  size_t mapped_size_ = 0;
+  float offset_m_ = 0.0f;
+  float scale_m_ = 0.0f;
+};
+
+/** @} */
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,135 @@
+/**************************************************************************/ /**
+ * @brief Lever arm translation of poses to other points on the vehicle.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/geodesy/lever_arm.h"
+
+#include <cmath>
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+using namespace point_one::fusion_engine::messages;
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/******************************************************************************/
+bool ApplyLeverArms(const LeverArmInput& input,
+                    const double* lever_arms_body_m, size_t num_lever_arms,
+                    double* lla_deg, double* velocity_body_mps,
+                    double* velocity_enu_mps) {
+  bool have_ypr = input.ypr_deg != nullptr;
+  bool have_quaternion = input.attitude_quaternion != nullptr;
+  bool need_velocity =
+      velocity_body_mps != nullptr || velocity_enu_mps != nullptr;
+  if (input.lla_deg == nullptr || have_ypr == have_quaternion ||
+      (need_velocity && input.velocity_body_mps == nullptr)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < input.num_epochs; ++i) {
+    // Compute the per-epoch terms once for all lever arms.
+    const double* lla_in = input.lla_deg + i * 3;
+    double C[9];
+    if (have_ypr) {
+      GetBodyToENURotation(input.ypr_deg + i * 3, C);
+    } else {
+      GetBodyToENURotationFromQuaternion(input.attitude_quaternion + i * 4, C);
+    }
+
+    double meridian_radius_m, prime_vertical_radius_m;
+    GetRadiiOfCurvature(lla_in[0], &meridian_radius_m,
+                        &prime_vertical_radius_m);
+    double lat_scale = RAD_TO_DEG / (meridian_radius_m + lla_in[2]);
+    double lon_scale = RAD_TO_DEG / ((prime_vertical_radius_m + lla_in[2]) *
+                                     std::cos(lla_in[0] * DEG_TO_RAD));
+
+    const double* velocity_in =
+        need_velocity ? input.velocity_body_mps + i * 3 : nullptr;
+    const double* omega = input.gyro_rps ? input.gyro_rps + i * 3 : nullptr;
+
+    for (size_t j = 0; j < num_lever_arms; ++j) {
+      const double* r = lever_arms_body_m + j * 3;
+      size_t out_index = (i * num_lever_arms + j) * 3;
+
+      // Position.
+      double d_enu[3];
+      for (int k = 0; k < 3; ++k) {
+        d_enu[k] =
+            C[k * 3 + 0] * r[0] + C[k * 3 + 1] * r[1] + C[k * 3 + 2] * r[2];
+      }
+
+      double* lla_out = lla_deg + out_index;
+      lla_out[0] = lla_in[0] + d_enu[1] * lat_scale;
+      lla_out[1] = lla_in[1] + d_enu[0] * lon_scale;
+      lla_out[2] = lla_in[2] + d_enu[2];
+
+      // Velocity.
+      if (!need_velocity) {
+        continue;
+      }
+
+      double v_body[3] = {velocity_in[0], velocity_in[1], velocity_in[2]};
+      if (omega != nullptr) {
+        v_body[0] += omega[1] * r[2] - omega[2] * r[1];
+        v_body[1] += omega[2] * r[0] - omega[0] * r[2];
+        v_body[2] += omega[0] * r[1] - omega[1] * r[0];
+      }
+
+      if (velocity_body_mps != nullptr) {
+        for (int k = 0; k < 3; ++k) {
+          velocity_body_mps[out_index + k] = v_body[k];
+        }
+      }
+
+      if (velocity_enu_mps != nullptr) {
+        for (int k = 0; k < 3; ++k) {
+          velocity_enu_mps[out_index + k] = C[k * 3 + 0] * v_body[0] +
+                                            C[k * 3 + 1] * v_body[1] +
+                                            C[k * 3 + 2] * v_body[2];
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************/
+bool ApplyLeverArm(const PoseMessage& pose, const double lever_arm_body_m[3],
+                   const double* gyro_rps, PoseMessage* result) {
+  if (std::isnan(pose.lla_deg[0]) || std::isnan(pose.ypr_deg[0])) {
+    return false;
+  }
+
+  LeverArmInput input;
+  input.num_epochs = 1;
+  input.lla_deg = pose.lla_deg;
+  input.ypr_deg = pose.ypr_deg;
+  input.velocity_body_mps = pose.velocity_body_mps;
+  input.gyro_rps = gyro_rps;
+
+  double lla_deg[3];
+  double velocity_body_mps[3];
+  if (!ApplyLeverArms(input, lever_arm_body_m, 1, lla_deg,
+                      velocity_body_mps)) {
+    return false;
+  }
+
+  if (result != &pose) {
+    *result = pose;
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    result->lla_deg[i] = lla_deg[i];
+    result->velocity_body_mps[i] = velocity_body_mps[i];
+  }
+
+  return true;
+}
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
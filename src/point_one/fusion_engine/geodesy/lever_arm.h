@@ -0,0 +1,121 @@
+/**************************************************************************/ /**
+ * @brief Lever arm translation of poses to other points on the vehicle.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/**
+ * @addtogroup geodesy
+ * @{
+ */
+
+/**
+ * @brief A batch of poses to be translated, stored as contiguous arrays with
+ *        the same layout as the corresponding message fields.
+ *
+ * Exactly one of @ref ypr_deg or @ref attitude_quaternion must be set.
+ */
+struct LeverArmInput {
+  /** The number of epochs. */
+  size_t num_epochs = 0;
+
+  /** Position of the reported body point (3 values per epoch). Required. */
+  const double* lla_deg = nullptr;
+
+  /** Attitude as yaw, pitch, roll (3 values per epoch). */
+  const double* ypr_deg = nullptr;
+
+  /** Attitude as a scalar-last quaternion (4 values per epoch). */
+  const double* attitude_quaternion = nullptr;
+
+  /**
+   * Velocity of the reported body point, resolved in the body frame (3 values
+   * per epoch). Required to compute output velocities.
+   */
+  const double* velocity_body_mps = nullptr;
+
+  /**
+   * Body rotation rates, e.g., from time-aligned @ref
+   * messages::IMUMeasurement::gyro_rps (3 values per epoch). If `nullptr`, the
+   * rotation rate contribution to the output velocities is omitted.
+   */
+  const double* gyro_rps = nullptr;
+};
+
+/**
+ * @brief Translate a batch of poses to one or more points on the vehicle.
+ *
+ * For each epoch, the attitude rotation and ellipsoid radii are computed once
+ * and applied to every lever arm. The position of each point is:
+ *
+ * ```
+ * p_point = p_body + C_body->enu * lever_arm
+ * ```
+ *
+ * applied to latitude, longitude, and altitude using the local radii of
+ * curvature (error below 0.1 mm for lever arms up to 30 m). The velocity of
+ * each point includes the rotation rate term:
+ *
+ * ```
+ * v_point = v_body + omega x lever_arm
+ * ```
+ *
+ * Outputs are stored epoch-major: the result for epoch `i` and lever arm `j`
+ * starts at index `(i * num_lever_arms + j) * 3`.
+ *
+ * @param input The input poses.
+ * @param lever_arms_body_m The lever arms from the reported body point to each
+ *        desired point, resolved in the body frame (+x forward, +y left, +z up)
+ *        (3 values per lever arm).
+ * @param num_lever_arms The number of lever arms.
+ * @param[out] lla_deg The position of each point.
+ * @param[out] velocity_body_mps If not `nullptr`, the velocity of each point
+ *        resolved in the body frame.
+ * @param[out] velocity_enu_mps If not `nullptr`, the velocity of each point
+ *        resolved in the local ENU frame.
+ *
+ * @return `true` on success, or `false` if a required input is missing.
+ */
+P1_EXPORT bool ApplyLeverArms(const LeverArmInput& input,
+                              const double* lever_arms_body_m,
+                              size_t num_lever_arms, double* lla_deg,
+                              double* velocity_body_mps = nullptr,
+                              double* velocity_enu_mps = nullptr);
+
+/**
+ * @brief Translate a single pose message to another point on the vehicle.
+ *
+ * Updates @ref messages::PoseMessage::lla_deg and @ref
+ * messages::PoseMessage::velocity_body_mps. All other fields are copied.
+ *
+ * @param pose The input pose.
+ * @param lever_arm_body_m The lever arm from the reported body point to the
+ *        desired point, resolved in the body frame.
+ * @param gyro_rps If not `nullptr`, the body rotation rates used to compute the
+ *        velocity of the desired point.
+ * @param[out] result The translated pose. May be the same as `pose`.
+ *
+ * @return `true` on success, or `false` if the pose does not contain a valid
+ *         position and attitude, or a required input is missing (see @ref
+ *         ApplyLeverArms()). `result` is not modified on failure.
+ */
+P1_EXPORT bool ApplyLeverArm(const messages::PoseMessage& pose,
+                             const double lever_arm_body_m[3],
+                             const double* gyro_rps,
+                             messages::PoseMessage* result);
+
+/** @} */
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
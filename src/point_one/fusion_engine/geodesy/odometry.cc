@@ -0,0 +1,155 @@
+/**************************************************************************/ /**
+ * @brief Geodesic odometry: distance traveled and speed statistics.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/geodesy/odometry.h"
+
+#include <cstring>
+
+#include "point_one/fusion_engine/geodesy/geodesic.h"
+
+using namespace point_one::fusion_engine::geodesy;
+using namespace point_one::fusion_engine::messages;
+
+constexpr size_t GeodesicOdometer::MAX_SOLUTION_TYPES;
+
+/******************************************************************************/
+void GeodesicOdometer::OnMessage(const MessageHeader& header,
+                                 const void* payload) {
+  if (header.message_type == MessageType::POSE &&
+      header.payload_size_bytes >= sizeof(PoseMessage)) {
+    PoseMessage pose;
+    std::memcpy(&pose, payload, sizeof(pose));
+    OnPose(pose);
+  }
+}
+
+/******************************************************************************/
+void GeodesicOdometer::OnPose(const PoseMessage& pose) {
+  double p1_time_sec = NAN;
+  if (pose.p1_time.seconds != Timestamp::INVALID &&
+      pose.p1_time.fraction_ns != Timestamp::INVALID) {
+    p1_time_sec = pose.p1_time.seconds + (pose.p1_time.fraction_ns * 1e-9);
+  }
+
+  AddPose(p1_time_sec, pose.lla_deg, pose.solution_type);
+}
+
+/******************************************************************************/
+void GeodesicOdometer::AddPose(double p1_time_sec, const double lla_deg[3],
+                               SolutionType solution_type) {
+  // Invalid poses end the current segment.
+  if (solution_type == SolutionType::Invalid || std::isnan(p1_time_sec) ||
+      std::isnan(lla_deg[0]) || std::isnan(lla_deg[1]) ||
+      (config_.include_altitude && std::isnan(lla_deg[2]))) {
+    EndSegment();
+    return;
+  }
+
+  if (!segment_open_) {
+    StartSegment(p1_time_sec, lla_deg);
+    return;
+  }
+
+  // Ignore duplicate or out of order poses.
+  double dt_sec = p1_time_sec - last_time_sec_;
+  if (dt_sec <= 0.0) {
+    return;
+  } else if (dt_sec > config_.max_gap_sec) {
+    StartSegment(p1_time_sec, lla_deg);
+    return;
+  }
+
+  double step_m = GetGeodesicDistance(anchor_lla_deg_[0], anchor_lla_deg_[1],
+                                      lla_deg[0], lla_deg[1],
+                                      config_.ellipsoid);
+  if (config_.include_altitude) {
+    step_m = std::hypot(step_m, lla_deg[2] - anchor_lla_deg_[2]);
+  }
+
+  double step_time_sec = p1_time_sec - anchor_time_sec_;
+  double speed_mps = step_m / step_time_sec;
+  if (speed_mps > config_.max_speed_mps) {
+    StartSegment(p1_time_sec, lla_deg);
+    return;
+  }
+
+  OdometrySegment& segment = segments_.back();
+  size_t type_index = static_cast<size_t>(solution_type);
+  if (type_index < MAX_SOLUTION_TYPES) {
+    duration_sec_[type_index] += dt_sec;
+  }
+
+  if (step_m >= config_.min_step_m) {
+    total_distance_m_ += step_m;
+    segment.distance_m += step_m;
+    if (type_index < MAX_SOLUTION_TYPES) {
+      distance_m_[type_index] += step_m;
+    }
+    if (speed_mps > segment.max_speed_mps) {
+      segment.max_speed_mps = speed_mps;
+    }
+
+    anchor_time_sec_ = p1_time_sec;
+    std::memcpy(anchor_lla_deg_, lla_deg, sizeof(anchor_lla_deg_));
+  }
+
+  segment.end_time_sec = p1_time_sec;
+  ++segment.num_poses;
+  last_time_sec_ = p1_time_sec;
+}
+
+/******************************************************************************/
+void GeodesicOdometer::AddPoses(const double* p1_time_sec,
+                                const double* lla_deg,
+                                const SolutionType* solution_type, size_t count,
+                                double* along_track_m) {
+  for (size_t i = 0; i < count; ++i) {
+    AddPose(p1_time_sec[i], lla_deg + i * 3, solution_type[i]);
+    if (along_track_m != nullptr) {
+      along_track_m[i] = total_distance_m_;
+    }
+  }
+}
+
+/******************************************************************************/
+void GeodesicOdometer::Reset() {
+  segment_open_ = false;
+  last_time_sec_ = NAN;
+  anchor_time_sec_ = NAN;
+  total_distance_m_ = 0.0;
+  for (size_t i = 0; i < MAX_SOLUTION_TYPES; ++i) {
+    distance_m_[i] = 0.0;
+    duration_sec_[i] = 0.0;
+  }
+  segments_.clear();
+}
+
+/******************************************************************************/
+double GeodesicOdometer::GetDistance(SolutionType type) const {
+  size_t type_index = static_cast<size_t>(type);
+  return type_index < MAX_SOLUTION_TYPES ? distance_m_[type_index] : 0.0;
+}
+
+/******************************************************************************/
+double GeodesicOdometer::GetDurationSec(SolutionType type) const {
+  size_t type_index = static_cast<size_t>(type);
+  return type_index < MAX_SOLUTION_TYPES ? duration_sec_[type_index] : 0.0;
+}
+
+/******************************************************************************/
+void GeodesicOdometer::StartSegment(double p1_time_sec,
+                                    const double lla_deg[3]) {
+  OdometrySegment segment;
+  segment.start_time_sec = p1_time_sec;
+  segment.end_time_sec = p1_time_sec;
+  segment.start_along_track_m = total_distance_m_;
+  segment.num_poses = 1;
+  segments_.push_back(segment);
+
+  segment_open_ = true;
+  last_time_sec_ = p1_time_sec;
+  anchor_time_sec_ = p1_time_sec;
+  std::memcpy(anchor_lla_deg_, lla_deg, sizeof(anchor_lla_deg_));
+}
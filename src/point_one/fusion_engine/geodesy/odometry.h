@@ -0,0 +1,189 @@
+/**************************************************************************/ /**
+ * @brief Geodesic odometry: distance traveled and speed statistics.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cmath> // For NAN
+#include <cstddef>
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/geodesy/frames.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/**
+ * @addtogroup geodesy
+ * @{
+ */
+
+/**
+ * @brief A continuous section of a trajectory.
+ */
+struct OdometrySegment {
+  /** The P1 time of the first pose in the segment (in seconds). */
+  double start_time_sec = NAN;
+
+  /** The P1 time of the last pose in the segment (in seconds). */
+  double end_time_sec = NAN;
+
+  /**
+   * The distance traveled from the start of the trajectory to the start of the
+   * segment.
+   */
+  double start_along_track_m = 0.0;
+
+  /** The distance traveled within the segment. */
+  double distance_m = 0.0;
+
+  /** The maximum speed between consecutive accumulated positions. */
+  double max_speed_mps = 0.0;
+
+  /** The number of poses in the segment. */
+  size_t num_poses = 0;
+
+  double GetDurationSec() const { return end_time_sec - start_time_sec; }
+
+  double GetMeanSpeedMPS() const {
+    double duration_sec = GetDurationSec();
+    return duration_sec > 0.0 ? distance_m / duration_sec : 0.0;
+  }
+};
+
+/**
+ * @brief Accumulate the distance traveled by a platform from a stream of
+ *        poses.
+ *
+ * Distances between consecutive poses are geodesic distances on the ellipsoid
+ * (see @ref GetGeodesicDistance()), optionally including the change in
+ * altitude. Each distance is attributed to the @ref messages::SolutionType of
+ * the later pose, as is the time elapsed between the poses.
+ *
+ * The trajectory is divided into segments at gaps in the data (poses more than
+ * @ref Config::max_gap_sec apart, or invalid poses) and at position jumps
+ * (steps implying a speed above @ref Config::max_speed_mps). Distance is not
+ * accumulated across segment boundaries.
+ *
+ * Position noise while stationary can inflate the accumulated distance. If
+ * @ref Config::min_step_m is set, distance is only accumulated once the
+ * position has moved at least that far from the last accumulated position.
+ */
+class P1_EXPORT GeodesicOdometer {
+ public:
+  /** The number of @ref messages::SolutionType values tracked. */
+  static constexpr size_t MAX_SOLUTION_TYPES = 16;
+
+  struct Config {
+    /** Start a new segment if consecutive poses are further apart in time. */
+    double max_gap_sec = 2.0;
+
+    /** Steps implying a higher speed are treated as position jumps. */
+    double max_speed_mps = 150.0;
+
+    /** The minimum displacement to be accumulated (0 to disable). */
+    double min_step_m = 0.0;
+
+    /** If `true`, include the change in altitude in each step. */
+    bool include_altitude = false;
+
+    /** The reference ellipsoid. */
+    Ellipsoid ellipsoid = WGS84;
+  };
+
+  GeodesicOdometer() : GeodesicOdometer(Config()) {}
+  explicit GeodesicOdometer(const Config& config) : config_(config) {}
+
+  /**
+   * @brief Process an incoming message, updating the odometer on @ref
+   *        messages::PoseMessage.
+   *
+   * @param header The message header.
+   * @param payload The message payload.
+   */
+  void OnMessage(const messages::MessageHeader& header, const void* payload);
+
+  /**
+   * @brief Add a pose.
+   *
+   * @param pose The pose message.
+   */
+  void OnPose(const messages::PoseMessage& pose);
+
+  /**
+   * @brief Add a pose.
+   *
+   * @param p1_time_sec The P1 time of the pose (in seconds).
+   * @param lla_deg The position (see @ref messages::PoseMessage::lla_deg).
+   * @param solution_type The type of the position solution.
+   */
+  void AddPose(double p1_time_sec, const double lla_deg[3],
+               messages::SolutionType solution_type);
+
+  /**
+   * @brief Add a batch of poses, e.g., from an entire log.
+   *
+   * @param p1_time_sec The P1 time of each pose.
+   * @param lla_deg The position of each pose (3 values per pose).
+   * @param solution_type The solution type of each pose.
+   * @param count The number of poses.
+   * @param[out] along_track_m If not `nullptr`, set to the distance traveled
+   *        at each pose.
+   */
+  void AddPoses(const double* p1_time_sec, const double* lla_deg,
+                const messages::SolutionType* solution_type, size_t count,
+                double* along_track_m = nullptr);
+
+  /**
+   * @brief Clear all accumulated results.
+   */
+  void Reset();
+
+  /**
+   * @brief Get the total distance traveled (i.e., the along-track position of
+   *        the most recent pose).
+   */
+  double GetTotalDistance() const { return total_distance_m_; }
+
+  /**
+   * @brief Get the distance traveled while using the specified solution type.
+   */
+  double GetDistance(messages::SolutionType type) const;
+
+  /**
+   * @brief Get the time spent in the specified solution type, excluding gaps.
+   */
+  double GetDurationSec(messages::SolutionType type) const;
+
+  /**
+   * @brief Get the trajectory segments, in time order. The last segment may
+   *        still be in progress.
+   */
+  const std::vector<OdometrySegment>& GetSegments() const { return segments_; }
+
+ private:
+  void EndSegment() { segment_open_ = false; }
+  void StartSegment(double p1_time_sec, const double lla_deg[3]);
+
+  Config config_;
+
+  bool segment_open_ = false;
+  double last_time_sec_ = NAN;
+  double anchor_time_sec_ = NAN;
+  double anchor_lla_deg_[3] = {NAN, NAN, NAN};
+
+  double total_distance_m_ = 0.0;
+  double distance_m_[MAX_SOLUTION_TYPES] = {0.0};
+  double duration_sec_[MAX_SOLUTION_TYPES] = {0.0};
+  std::vector<OdometrySegment> segments_;
+};
+
+/** @} */
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
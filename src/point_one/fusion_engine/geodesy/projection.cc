@@ -0,0 +1,491 @@
+/**************************************************************************/ /**
+ * @brief Transverse Mercator, UTM, and MGRS map projections.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/geodesy/projection.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+using namespace point_one::fusion_engine::geodesy;
+
+namespace {
+// Number of positions processed at a time using stack buffers.
+constexpr size_t BLOCK_SIZE = 256;
+
+constexpr double UTM_SCALE_FACTOR = 0.9996;
+constexpr double UTM_FALSE_EASTING_M = 500000.0;
+constexpr double UTM_FALSE_NORTHING_SOUTH_M = 10000000.0;
+
+constexpr char MGRS_BAND_LETTERS[] = "CDEFGHJKLMNPQRSTUVWX";
+constexpr char MGRS_ROW_LETTERS[] = "ABCDEFGHJKLMNPQRSTUV";
+constexpr const char* MGRS_COLUMN_LETTERS[3] = {"ABCDEFGH", "JKLMNPQR",
+                                               "STUVWXYZ"};
+
+/**
+ * @brief Krüger series coefficients for an ellipsoid (Karney 2011, eq. 14, 35,
+ *        36), to 6th order in the third flattening.
+ */
+struct KrugerSeries {
+  double rectifying_radius_m;
+  double eccentricity;
+  double alpha[6];
+  double beta[6];
+
+  explicit KrugerSeries(const Ellipsoid& ellipsoid) {
+    double f = ellipsoid.flattening;
+    double n = f / (2.0 - f);
+    double n2 = n * n, n3 = n2 * n, n4 = n3 * n, n5 = n4 * n, n6 = n5 * n;
+
+    rectifying_radius_m = ellipsoid.semi_major_axis_m / (1.0 + n) *
+                          (1.0 + n2 / 4.0 + n4 / 64.0 + n6 / 256.0);
+    eccentricity = std::sqrt(ellipsoid.GetEccentricitySquared());
+
+    alpha[0] = n / 2.0 - 2.0 / 3.0 * n2 + 5.0 / 16.0 * n3 +
+               41.0 / 180.0 * n4 - 127.0 / 288.0 * n5 +
+               7891.0 / 37800.0 * n6;
+    alpha[1] = 13.0 / 48.0 * n2 - 3.0 / 5.0 * n3 + 557.0 / 1440.0 * n4 +
+               281.0 / 630.0 * n5 - 1983433.0 / 1935360.0 * n6;
+    alpha[2] = 61.0 / 240.0 * n3 - 103.0 / 140.0 * n4 +
+               15061.0 / 26880.0 * n5 + 167603.0 / 181440.0 * n6;
+    alpha[3] = 49561.0 / 161280.0 * n4 - 179.0 / 168.0 * n5 +
+               6601661.0 / 7257600.0 * n6;
+    alpha[4] = 34729.0 / 80640.0 * n5 - 3418889.0 / 1995840.0 * n6;
+    alpha[5] = 212378941.0 / 319334400.0 * n6;
+
+    beta[0] = n / 2.0 - 2.0 / 3.0 * n2 + 37.0 / 96.0 * n3 - 1.0 / 360.0 * n4 -
+              81.0 / 512.0 * n5 + 96199.0 / 604800.0 * n6;
+    beta[1] = 1.0 / 48.0 * n2 + 1.0 / 15.0 * n3 - 437.0 / 1440.0 * n4 +
+              46.0 / 105.0 * n5 - 1118711.0 / 3870720.0 * n6;
+    beta[2] = 17.0 / 480.0 * n3 - 37.0 / 840.0 * n4 - 209.0 / 4480.0 * n5 +
+              5569.0 / 90720.0 * n6;
+    beta[3] = 4397.0 / 161280.0 * n4 - 11.0 / 504.0 * n5 -
+              830251.0 / 7257600.0 * n6;
+    beta[4] = 4583.0 / 161280.0 * n5 - 108847.0 / 3991680.0 * n6;
+    beta[5] = 20648693.0 / 638668800.0 * n6;
+  }
+};
+
+/******************************************************************************/
+// Evaluate sum_j c[j] * sin(2j xi) cosh(2j eta) and
+// sum_j c[j] * cos(2j xi) sinh(2j eta), using angle addition to compute the
+// higher harmonics from the first.
+inline void SumHarmonics(const double c[6], double xi, double eta,
+                         double* xi_sum, double* eta_sum) {
+  double s1 = std::sin(2.0 * xi), c1 = std::cos(2.0 * xi);
+  double sh1 = std::sinh(2.0 * eta), ch1 = std::cosh(2.0 * eta);
+  double s = s1, c_ = c1, sh = sh1, ch = ch1;
+  double sum_xi = 0.0, sum_eta = 0.0;
+  for (int j = 0; j < 6; ++j) {
+    sum_xi += c[j] * s * ch;
+    sum_eta += c[j] * c_ * sh;
+
+    double s_next = s * c1 + c_ * s1;
+    double c_next = c_ * c1 - s * s1;
+    double sh_next = sh * ch1 + ch * sh1;
+    double ch_next = ch * ch1 + sh * sh1;
+    s = s_next;
+    c_ = c_next;
+    sh = sh_next;
+    ch = ch_next;
+  }
+  *xi_sum = sum_xi;
+  *eta_sum = sum_eta;
+}
+
+/******************************************************************************/
+// Project positions relative to the central meridian to unscaled-origin grid
+// coordinates (x east, y north from the equator).
+void ForwardKernel(const KrugerSeries& series, double scale_factor,
+                   const double* latitude_deg, const double* delta_lon_deg,
+                   size_t count, double* x_m, double* y_m) {
+  double e = series.eccentricity;
+  double k0_A = scale_factor * series.rectifying_radius_m;
+  for (size_t i = 0; i < count; ++i) {
+    double sin_phi = std::sin(latitude_deg[i] * DEG_TO_RAD);
+    double lambda = delta_lon_deg[i] * DEG_TO_RAD;
+
+    // Tangent of the conformal latitude. Infinite at the poles, where the
+    // expressions below reduce to xi' = +/-pi/2, eta' = 0.
+    double tau_p =
+        std::sinh(std::atanh(sin_phi) - e * std::atanh(e * sin_phi));
+    double xi_p = std::atan2(tau_p, std::cos(lambda));
+    double eta_p =
+        std::atanh(std::sin(lambda) / std::sqrt(1.0 + tau_p * tau_p));
+
+    double xi_sum, eta_sum;
+    SumHarmonics(series.alpha, xi_p, eta_p, &xi_sum, &eta_sum);
+    x_m[i] = k0_A * (eta_p + eta_sum);
+    y_m[i] = k0_A * (xi_p + xi_sum);
+  }
+}
+
+/******************************************************************************/
+// Inverse of ForwardKernel().
+void InverseKernel(const KrugerSeries& series, double scale_factor,
+                   const double* x_m, const double* y_m, size_t count,
+                   double* latitude_deg, double* delta_lon_deg) {
+  double e = series.eccentricity;
+  double e2m = 1.0 - e * e;
+  double k0_A = scale_factor * series.rectifying_radius_m;
+  for (size_t i = 0; i < count; ++i) {
+    double xi = y_m[i] / k0_A;
+    double eta = x_m[i] / k0_A;
+
+    double xi_sum, eta_sum;
+    SumHarmonics(series.beta, xi, eta, &xi_sum, &eta_sum);
+    double xi_p = xi - xi_sum;
+    double eta_p = eta - eta_sum;
+
+    double sinh_eta_p = std::sinh(eta_p);
+    double sin_xi_p = std::sin(xi_p), cos_xi_p = std::cos(xi_p);
+    double r = std::sqrt(sinh_eta_p * sinh_eta_p + cos_xi_p * cos_xi_p);
+    double tau_p = sin_xi_p / r;
+
+    // Solve for the tangent of the geodetic latitude using Newton's method
+    // (Karney 2011, eq. 19-21). Two iterations converge to machine precision;
+    // a fixed count keeps the loop free of branches.
+    double tau = tau_p / e2m;
+    for (int j = 0; j < 3; ++j) {
+      double tau1 = std::sqrt(1.0 + tau * tau);
+      double sigma = std::sinh(e * std::atanh(e * tau / tau1));
+      double tau_p_j = tau * std::sqrt(1.0 + sigma * sigma) - sigma * tau1;
+      tau += (tau_p - tau_p_j) / std::sqrt(1.0 + tau_p_j * tau_p_j) *
+             (1.0 + e2m * tau * tau) / (e2m * tau1);
+    }
+
+    // At the poles r = 0 and tau is not finite.
+    latitude_deg[i] =
+        (r == 0.0 ? std::copysign(90.0 * DEG_TO_RAD, xi_p) : std::atan(tau)) *
+        RAD_TO_DEG;
+    delta_lon_deg[i] = std::atan2(sinh_eta_p, cos_xi_p) * RAD_TO_DEG;
+  }
+}
+
+/******************************************************************************/
+inline double GetUTMCentralMeridian(int zone) { return zone * 6.0 - 183.0; }
+} // namespace
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/******************************************************************************/
+void ProjectTransverseMercator(const TransverseMercator& projection,
+                               const double* latitude_deg,
+                               const double* longitude_deg, size_t count,
+                               double* easting_m, double* northing_m) {
+  KrugerSeries series(projection.ellipsoid);
+
+  // Northing of the origin latitude.
+  double zero = 0.0, origin_x_m, origin_y_m;
+  ForwardKernel(series, projection.scale_factor,
+                &projection.latitude_of_origin_deg, &zero, 1, &origin_x_m,
+                &origin_y_m);
+  double northing_offset_m = projection.false_northing_m - origin_y_m;
+
+  double delta_lon_deg[BLOCK_SIZE];
+  for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+    size_t n = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+    for (size_t i = 0; i < n; ++i) {
+      delta_lon_deg[i] = WrapLongitudeDeg(longitude_deg[start + i] -
+                                       projection.central_meridian_deg);
+    }
+
+    ForwardKernel(series, projection.scale_factor, latitude_deg + start,
+                  delta_lon_deg, n, easting_m + start, northing_m + start);
+
+    for (size_t i = start; i < start + n; ++i) {
+      easting_m[i] += projection.false_easting_m;
+      northing_m[i] += northing_offset_m;
+    }
+  }
+}
+
+/******************************************************************************/
+void UnprojectTransverseMercator(const TransverseMercator& projection,
+                                 const double* easting_m,
+                                 const double* northing_m, size_t count,
+                                 double* latitude_deg, double* longitude_deg) {
+  KrugerSeries series(projection.ellipsoid);
+
+  double zero = 0.0, origin_x_m, origin_y_m;
+  ForwardKernel(series, projection.scale_factor,
+                &projection.latitude_of_origin_deg, &zero, 1, &origin_x_m,
+                &origin_y_m);
+  double northing_offset_m = projection.false_northing_m - origin_y_m;
+
+  double x_m[BLOCK_SIZE], y_m[BLOCK_SIZE];
+  for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+    size_t n = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+    for (size_t i = 0; i < n; ++i) {
+      x_m[i] = easting_m[start + i] - projection.false_easting_m;
+      y_m[i] = northing_m[start + i] - northing_offset_m;
+    }
+
+    InverseKernel(series, projection.scale_factor, x_m, y_m, n,
+                  latitude_deg + start, longitude_deg + start);
+
+    for (size_t i = start; i < start + n; ++i) {
+      longitude_deg[i] =
+          WrapLongitudeDeg(longitude_deg[i] + projection.central_meridian_deg);
+    }
+  }
+}
+
+/******************************************************************************/
+int GetUTMZone(double latitude_deg, double longitude_deg) {
+  if (!(latitude_deg >= -80.0 && latitude_deg <= 84.0) ||
+      !std::isfinite(longitude_deg)) {
+    return 0;
+  }
+
+  double longitude = WrapLongitudeDeg(longitude_deg);
+  int zone = static_cast<int>(std::floor((longitude + 180.0) / 6.0)) + 1;
+  if (zone > 60) {
+    zone = 60;
+  }
+
+  // Southwestern Norway.
+  if (latitude_deg >= 56.0 && latitude_deg < 64.0 && longitude >= 3.0 &&
+      longitude < 12.0) {
+    return 32;
+  }
+
+  // Svalbard.
+  if (latitude_deg >= 72.0 && longitude >= 0.0 && longitude < 42.0) {
+    if (longitude < 9.0) {
+      return 31;
+    } else if (longitude < 21.0) {
+      return 33;
+    } else if (longitude < 33.0) {
+      return 35;
+    } else {
+      return 37;
+    }
+  }
+
+  return zone;
+}
+
+/******************************************************************************/
+void LatLonToUTM(const double* latitude_deg, const double* longitude_deg,
+                 size_t count, double* easting_m, double* northing_m,
+                 uint8_t* zone, bool* north, int force_zone) {
+  static const KrugerSeries series(WGS84);
+
+  if (force_zone < 0 || force_zone > 60) {
+    force_zone = 0;
+  }
+
+  double valid_latitude_deg[BLOCK_SIZE];
+  double delta_lon_deg[BLOCK_SIZE];
+  for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+    size_t n = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+
+    // Zone selection is done separately so the projection itself depends only
+    // on the offset from each position's central meridian.
+    for (size_t i = 0; i < n; ++i) {
+      double latitude = latitude_deg[start + i];
+      double longitude = longitude_deg[start + i];
+      int z = GetUTMZone(latitude, longitude);
+      if (z != 0 && force_zone != 0) {
+        z = force_zone;
+      }
+
+      zone[start + i] = static_cast<uint8_t>(z);
+      valid_latitude_deg[i] = z != 0 ? latitude : NAN;
+      delta_lon_deg[i] = WrapLongitudeDeg(longitude - GetUTMCentralMeridian(z));
+    }
+
+    ForwardKernel(series, UTM_SCALE_FACTOR, valid_latitude_deg, delta_lon_deg,
+                  n, easting_m + start, northing_m + start);
+
+    for (size_t i = 0; i < n; ++i) {
+      bool is_north = !(latitude_deg[start + i] < 0.0);
+      easting_m[start + i] += UTM_FALSE_EASTING_M;
+      northing_m[start + i] += is_north ? 0.0 : UTM_FALSE_NORTHING_SOUTH_M;
+      if (north) {
+        north[start + i] = is_north;
+      }
+    }
+  }
+}
+
+/******************************************************************************/
+void UTMToLatLon(const double* easting_m, const double* northing_m,
+                 const uint8_t* zone, const bool* north, size_t count,
+                 double* latitude_deg, double* longitude_deg) {
+  static const KrugerSeries series(WGS84);
+
+  double x_m[BLOCK_SIZE], y_m[BLOCK_SIZE];
+  for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+    size_t n = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+    for (size_t i = 0; i < n; ++i) {
+      bool valid = zone[start + i] >= 1 && zone[start + i] <= 60;
+      x_m[i] = valid ? easting_m[start + i] - UTM_FALSE_EASTING_M : NAN;
+      y_m[i] = northing_m[start + i] -
+               (north[start + i] ? 0.0 : UTM_FALSE_NORTHING_SOUTH_M);
+    }
+
+    InverseKernel(series, UTM_SCALE_FACTOR, x_m, y_m, n, latitude_deg + start,
+                  longitude_deg + start);
+
+    for (size_t i = 0; i < n; ++i) {
+      longitude_deg[start + i] = WrapLongitudeDeg(
+          longitude_deg[start + i] + GetUTMCentralMeridian(zone[start + i]));
+    }
+  }
+}
+
+/******************************************************************************/
+std::string LatLonToMGRS(double latitude_deg, double longitude_deg,
+                         int precision) {
+  if (precision < 0) {
+    precision = 0;
+  } else if (precision > 5) {
+    precision = 5;
+  }
+
+  double easting_m, northing_m;
+  uint8_t zone;
+  LatLonToUTM(&latitude_deg, &longitude_deg, 1, &easting_m, &northing_m,
+              &zone);
+  if (zone == 0) {
+    return "";
+  }
+
+  // Latitude band (8 degrees each, with band X extended to 84 deg N).
+  int band = static_cast<int>(std::floor((latitude_deg + 80.0) / 8.0));
+  if (band > 19) {
+    band = 19;
+  }
+
+  // 100 km square identifier. Column letters repeat every 3 zones, and row
+  // letters repeat every 2,000 km, offset by 500 km in even zones.
+  int64_t east = static_cast<int64_t>(std::floor(easting_m));
+  int64_t north = static_cast<int64_t>(std::floor(northing_m));
+  int column = static_cast<int>(east / 100000) - 1;
+  if (column < 0) {
+    column = 0;
+  } else if (column > 7) {
+    column = 7;
+  }
+  int row = static_cast<int>((north / 100000 + (zone % 2 == 0 ? 5 : 0)) % 20);
+
+  int64_t divisor = 1;
+  for (int i = precision; i < 5; ++i) {
+    divisor *= 10;
+  }
+
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%02d%c%c%c%0*lld%0*lld", (int)zone,
+                MGRS_BAND_LETTERS[band],
+                MGRS_COLUMN_LETTERS[(zone - 1) % 3][column],
+                MGRS_ROW_LETTERS[row], precision,
+                (long long)(east % 100000 / divisor), precision,
+                (long long)(north % 100000 / divisor));
+  if (precision == 0) {
+    // %0*lld prints "0" for a zero width field.
+    buffer[5] = '\0';
+  }
+  return buffer;
+}
+
+/******************************************************************************/
+bool MGRSToLatLon(const std::string& mgrs, double* latitude_deg,
+                  double* longitude_deg) {
+  std::string str;
+  for (char c : mgrs) {
+    if (!std::isspace(static_cast<unsigned char>(c))) {
+      str.push_back(
+          static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+    }
+  }
+
+  // Zone number (1 or 2 digits).
+  size_t offset = 0;
+  int zone = 0;
+  while (offset < str.size() && offset < 2 &&
+         std::isdigit(static_cast<unsigned char>(str[offset]))) {
+    zone = zone * 10 + (str[offset] - '0');
+    ++offset;
+  }
+  if (offset == 0 || zone < 1 || zone > 60 || str.size() < offset + 3) {
+    return false;
+  }
+
+  // Latitude band and 100 km square letters.
+  for (size_t i = offset; i < offset + 3; ++i) {
+    if (!std::isalpha(static_cast<unsigned char>(str[i]))) {
+      return false;
+    }
+  }
+
+  const char* band_ptr = std::strchr(MGRS_BAND_LETTERS, str[offset]);
+  const char* column_letters = MGRS_COLUMN_LETTERS[(zone - 1) % 3];
+  const char* column_ptr = std::strchr(column_letters, str[offset + 1]);
+  const char* row_ptr = std::strchr(MGRS_ROW_LETTERS, str[offset + 2]);
+  if (band_ptr == nullptr || column_ptr == nullptr || row_ptr == nullptr) {
+    return false;
+  }
+  int band = static_cast<int>(band_ptr - MGRS_BAND_LETTERS);
+  int column = static_cast<int>(column_ptr - column_letters);
+  int row = static_cast<int>(row_ptr - MGRS_ROW_LETTERS);
+  offset += 3;
+
+  // Easting and northing digits.
+  size_t num_digits = str.size() - offset;
+  if (num_digits % 2 != 0 || num_digits > 10) {
+    return false;
+  }
+
+  int precision = static_cast<int>(num_digits / 2);
+  double scale = 1.0;
+  for (int i = precision; i < 5; ++i) {
+    scale *= 10.0;
+  }
+
+  double east_digits = 0.0, north_digits = 0.0;
+  for (int i = 0; i < precision; ++i) {
+    char e = str[offset + i], n = str[offset + precision + i];
+    if (!std::isdigit(static_cast<unsigned char>(e)) ||
+        !std::isdigit(static_cast<unsigned char>(n))) {
+      return false;
+    }
+    east_digits = east_digits * 10.0 + (e - '0');
+    north_digits = north_digits * 10.0 + (n - '0');
+  }
+
+  double easting_m = (column + 1) * 100000.0 + east_digits * scale;
+  int row_index = (row - (zone % 2 == 0 ? 5 : 0) + 20) % 20;
+  double northing_m = row_index * 100000.0 + north_digits * scale;
+
+  // Resolve the 2,000 km row letter ambiguity using the latitude band: bands
+  // span less than 1,000 km, so choose the first candidate no more than 500
+  // km below the band's southern edge.
+  bool north = band >= 10;
+  double band_latitude_deg = -80.0 + band * 8.0;
+  double band_easting_m, band_northing_m;
+  uint8_t band_zone;
+  double central_meridian_deg = GetUTMCentralMeridian(zone);
+  LatLonToUTM(&band_latitude_deg, &central_meridian_deg, 1, &band_easting_m,
+              &band_northing_m, &band_zone, nullptr, zone);
+  double min_northing_m = band_northing_m - 500000.0;
+  northing_m +=
+      2000000.0 * std::ceil((min_northing_m - northing_m) / 2000000.0);
+
+  uint8_t zone_u8 = static_cast<uint8_t>(zone);
+  UTMToLatLon(&easting_m, &northing_m, &zone_u8, &north, 1, latitude_deg,
+              longitude_deg);
+  return true;
+}
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
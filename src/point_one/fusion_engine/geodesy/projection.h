@@ -0,0 +1,171 @@
+/**************************************************************************/ /**
+ * @brief Transverse Mercator, UTM, and MGRS map projections.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace geodesy {
+
+/**
+ * @addtogroup geodesy
+ * @{
+ */
+
+/**
+ * @brief Transverse Mercator projection parameters.
+ *
+ * Projections use the 6th order Krüger series (Karney, "Transverse Mercator
+ * with an accuracy of a few nanometers", 2011), accurate to better than 1 mm
+ * within 3900 km of the central meridian.
+ *
+ * The defaults define a local grid centered on the prime meridian and equator.
+ * Set the parameters to define a national or project-specific grid.
+ */
+struct TransverseMercator {
+  double central_meridian_deg = 0.0;
+  double latitude_of_origin_deg = 0.0;
+  double scale_factor = 1.0;
+  double false_easting_m = 0.0;
+  double false_northing_m = 0.0;
+  Ellipsoid ellipsoid = WGS84;
+};
+
+/**
+ * @brief Project a batch of geodetic positions to a transverse Mercator grid.
+ *
+ * Inputs and outputs are stored as separate arrays (structure of arrays), and
+ * the projection is computed without per-position branches so it may be
+ * vectorized by the compiler.
+ *
+ * @param projection The projection parameters.
+ * @param latitude_deg The latitude of each position.
+ * @param longitude_deg The longitude of each position.
+ * @param count The number of positions.
+ * @param[out] easting_m The easting of each position.
+ * @param[out] northing_m The northing of each position.
+ */
+P1_EXPORT void ProjectTransverseMercator(const TransverseMercator& projection,
+                                         const double* latitude_deg,
+                                         const double* longitude_deg,
+                                         size_t count, double* easting_m,
+                                         double* northing_m);
+
+/**
+ * @brief Convert a batch of transverse Mercator grid coordinates to geodetic
+ *        positions.
+ *
+ * @param projection The projection parameters.
+ * @param easting_m The easting of each position.
+ * @param northing_m The northing of each position.
+ * @param count The number of positions.
+ * @param[out] latitude_deg The latitude of each position.
+ * @param[out] longitude_deg The longitude of each position.
+ */
+P1_EXPORT void UnprojectTransverseMercator(const TransverseMercator& projection,
+                                           const double* easting_m,
+                                           const double* northing_m,
+                                           size_t count, double* latitude_deg,
+                                           double* longitude_deg);
+
+/**
+ * @brief Get the UTM zone containing the specified position.
+ *
+ * Includes the exceptions for southwestern Norway (zone 32V) and Svalbard
+ * (zones 31X-37X).
+ *
+ * @param latitude_deg The latitude.
+ * @param longitude_deg The longitude.
+ *
+ * @return The zone number (1-60), or 0 if the position is outside of the UTM
+ *         coverage area (80 deg S to 84 deg N).
+ */
+P1_EXPORT int GetUTMZone(double latitude_deg, double longitude_deg);
+
+/**
+ * @brief Convert a batch of geodetic positions to UTM coordinates.
+ *
+ * Positions outside of the UTM coverage area, or with invalid coordinates, are
+ * assigned zone 0 and a `NAN` easting and northing.
+ *
+ * @param latitude_deg The latitude of each position.
+ * @param longitude_deg The longitude of each position.
+ * @param count The number of positions.
+ * @param[out] easting_m The easting of each position.
+ * @param[out] northing_m The northing of each position.
+ * @param[out] zone The zone number of each position.
+ * @param[out] north If not `nullptr`, set to `true` for positions in the
+ *        northern hemisphere, and `false` for positions in the southern
+ *        hemisphere (which include a 10,000 km false northing).
+ * @param force_zone If nonzero, project all positions into the specified zone
+ *        instead of their natural zone (e.g., to keep a data set that crosses
+ *        a zone boundary on a single grid).
+ */
+P1_EXPORT void LatLonToUTM(const double* latitude_deg,
+                           const double* longitude_deg, size_t count,
+                           double* easting_m, double* northing_m,
+                           uint8_t* zone, bool* north = nullptr,
+                           int force_zone = 0);
+
+/**
+ * @brief Convert a batch of UTM coordinates to geodetic positions.
+ *
+ * @param easting_m The easting of each position.
+ * @param northing_m The northing of each position.
+ * @param zone The zone number of each position. Positions with an invalid zone
+ *        are set to `NAN`.
+ * @param north `true` for positions in the northern hemisphere.
+ * @param count The number of positions.
+ * @param[out] latitude_deg The latitude of each position.
+ * @param[out] longitude_deg The longitude of each position.
+ */
+P1_EXPORT void UTMToLatLon(const double* easting_m, const double* northing_m,
+                           const uint8_t* zone, const bool* north,
+                           size_t count, double* latitude_deg,
+                           double* longitude_deg);
+
+/**
+ * @brief Convert a geodetic position to an MGRS grid reference.
+ *
+ * For example, `38SMB4414084706` for 33.3 deg N, 44.4 deg E at 1 m precision.
+ * The polar (UPS) regions are not supported.
+ *
+ * @param latitude_deg The latitude.
+ * @param longitude_deg The longitude.
+ * @param precision The number of digits for each of easting and northing,
+ *        from 0 (100 km) to 5 (1 m).
+ *
+ * @return The grid reference, or an empty string if the position is outside of
+ *         the UTM coverage area.
+ */
+P1_EXPORT std::string LatLonToMGRS(double latitude_deg, double longitude_deg,
+                                   int precision = 5);
+
+/**
+ * @brief Convert an MGRS grid reference to a geodetic position.
+ *
+ * The returned position is the southwest corner of the referenced grid square.
+ *
+ * @param mgrs The grid reference, with or without spaces.
+ * @param[out] latitude_deg The latitude.
+ * @param[out] longitude_deg The longitude.
+ *
+ * @return `true` on success, or `false` if the grid reference is invalid.
+ */
+P1_EXPORT bool MGRSToLatLon(const std::string& mgrs, double* latitude_deg,
+                            double* longitude_deg);
+
+/** @} */
+
+} // namespace geodesy
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,378 @@
+/**************************************************************************/ /**
+ * @brief Naturally aligned compute representations of packed message structs.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef> // For size_t
+#include <cstdint>
+#include <cstdlib>
+#include <cstring> // For memcpy()
+#include <limits>
+#include <new>
+
+#include "point_one/fusion_engine/messages/measurements.h"
+#include "point_one/fusion_engine/messages/solution.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace messages {
+
+/**
+ * @defgroup aligned_messages Aligned Compute Message Representations
+ * @brief Naturally aligned mirrors of message structs for numeric processing.
+ *
+ * All message definitions are packed to 4-byte alignment (see @ref messages) so
+ * that they may be serialized directly. As a result, `double` arrays within a
+ * message may only be aligned to 4 bytes, which prevents aligned vector loads
+ * and incurs a penalty on some platforms.
+ *
+ * The types defined here mirror the content of the corresponding wire messages
+ * with every vector field aligned to 32 bytes (`double`) or 16 bytes (`float`).
+ * 3-element vectors are padded to 4 elements so that each field can be loaded
+ * with a single 256-bit (`double`) or 128-bit (`float`) instruction. The pad
+ * element is always set to 0.
+ *
+ * These types are _not_ wire compatible. Use @ref ToAligned() and @ref
+ * FromAligned() to convert to/from the serialized message structs.
+ * @{
+ */
+
+/**
+ * @brief Alignment (in bytes) used for `double` vector fields.
+ */
+static constexpr size_t ALIGNED_DOUBLE_VECTOR_BYTES = 32;
+
+/**
+ * @brief Alignment (in bytes) used for `float` vector fields.
+ */
+static constexpr size_t ALIGNED_FLOAT_VECTOR_BYTES = 16;
+
+/**
+ * @brief Aligned mirror of @ref PoseMessage.
+ */
+struct alignas(ALIGNED_DOUBLE_VECTOR_BYTES) AlignedPoseMessage {
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double lla_deg[4] = {NAN, NAN, NAN, 0.0};
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double ypr_deg[4] = {NAN, NAN, NAN, 0.0};
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double velocity_body_mps[4] = {
+      NAN, NAN, NAN, 0.0};
+
+  alignas(ALIGNED_FLOAT_VECTOR_BYTES) float position_std_enu_m[4] = {
+      NAN, NAN, NAN, 0.0f};
+  alignas(ALIGNED_FLOAT_VECTOR_BYTES) float ypr_std_deg[4] = {NAN, NAN, NAN,
+                                                              0.0f};
+  alignas(ALIGNED_FLOAT_VECTOR_BYTES) float velocity_std_body_mps[4] = {
+      NAN, NAN, NAN, 0.0f};
+
+  Timestamp p1_time;
+  Timestamp gps_time;
+
+  float aggregate_protection_level_m = NAN;
+  float horizontal_protection_level_m = NAN;
+  float vertical_protection_level_m = NAN;
+
+  SolutionType solution_type = SolutionType::Invalid;
+};
+
+/**
+ * @brief Aligned mirror of @ref PoseAuxMessage.
+ *
+ * @note
+ * The covariance matrix is stored row-major with each row padded to 4
+ * elements (i.e., `position_cov_enu_m2[row][col]`).
+ */
+struct alignas(ALIGNED_DOUBLE_VECTOR_BYTES) AlignedPoseAuxMessage {
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double position_cov_enu_m2[3][4] = {
+      {NAN, NAN, NAN, 0.0}, {NAN, NAN, NAN, 0.0}, {NAN, NAN, NAN, 0.0}};
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double attitude_quaternion[4] = {
+      NAN, NAN, NAN, NAN};
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double velocity_enu_mps[4] = {
+      NAN, NAN, NAN, 0.0};
+
+  alignas(ALIGNED_FLOAT_VECTOR_BYTES) float position_std_body_m[4] = {
+      NAN, NAN, NAN, 0.0f};
+  alignas(ALIGNED_FLOAT_VECTOR_BYTES) float velocity_std_enu_mps[4] = {
+      NAN, NAN, NAN, 0.0f};
+
+  Timestamp p1_time;
+};
+
+/**
+ * @brief Aligned mirror of @ref IMUMeasurement.
+ */
+struct alignas(ALIGNED_DOUBLE_VECTOR_BYTES) AlignedIMUMeasurement {
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double accel_mps2[4] = {NAN, NAN, NAN,
+                                                               0.0};
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double accel_std_mps2[4] = {NAN, NAN,
+                                                                   NAN, 0.0};
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double gyro_rps[4] = {NAN, NAN, NAN,
+                                                             0.0};
+  alignas(ALIGNED_DOUBLE_VECTOR_BYTES) double gyro_std_rps[4] = {NAN, NAN, NAN,
+                                                                 0.0};
+
+  Timestamp p1_time;
+};
+
+/**
+ * @brief Standard library allocator returning storage aligned for the aligned
+ *        message types.
+ *
+ * Prior to C++17, `operator new` is not required to honor alignment beyond
+ * `alignof(std::max_align_t)`. Use this allocator when storing aligned types in
+ * standard containers, e.g.:
+ *
+ * ```{.cpp}
+ * std::vector<AlignedPoseMessage, AlignedAllocator<AlignedPoseMessage>> poses;
+ * ```
+ */
+template <typename T>
+class AlignedAllocator {
+ public:
+  typedef T value_type;
+
+  template <typename U>
+  struct rebind {
+    typedef AlignedAllocator<U> other;
+  };
+
+  AlignedAllocator() = default;
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    static constexpr size_t alignment =
+        alignof(T) > ALIGNED_DOUBLE_VECTOR_BYTES ? alignof(T)
+                                                 : ALIGNED_DOUBLE_VECTOR_BYTES;
+    if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+      throw std::bad_alloc();
+    }
+
+    // Over-allocate and store the original pointer immediately before the
+    // aligned storage so it can be recovered in deallocate().
+    size_t size_bytes = count * sizeof(T) + alignment + sizeof(void*);
+    void* raw = std::malloc(size_bytes);
+    if (raw == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    uintptr_t address = reinterpret_cast<uintptr_t>(raw) + sizeof(void*);
+    address = (address + alignment - 1) & ~(alignment - 1);
+    reinterpret_cast<void**>(address)[-1] = raw;
+    return reinterpret_cast<T*>(address);
+  }
+
+  void deallocate(T* ptr, size_t) {
+    if (ptr != nullptr) {
+      std::free(reinterpret_cast<void**>(ptr)[-1]);
+    }
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U>&) const {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const AlignedAllocator<U>&) const {
+    return false;
+  }
+};
+
+/**
+ * @name Wire <-> Aligned Conversion
+ *
+ * The wire conversion functions read the source with `memcpy()` and so do not
+ * require the input messages to have any particular alignment. The bulk
+ * variants operate on contiguous arrays of messages (e.g., payloads previously
+ * extracted from a log into a `std::vector`), allowing the compiler to
+ * vectorize the copy loop.
+ * @{
+ */
+
+namespace detail {
+template <typename Out, typename In>
+inline void CopyVector3(Out (&out)[4], const In (&in)[3]) {
+  In tmp[3];
+  std::memcpy(tmp, in, sizeof(tmp));
+  out[0] = tmp[0];
+  out[1] = tmp[1];
+  out[2] = tmp[2];
+  out[3] = 0;
+}
+
+template <typename Out, typename In>
+inline void CopyVector3(Out (&out)[3], const In (&in)[4]) {
+  out[0] = in[0];
+  out[1] = in[1];
+  out[2] = in[2];
+}
+} // namespace detail
+
+/**
+ * @brief Convert a @ref PoseMessage to its aligned representation.
+ */
+inline void ToAligned(const PoseMessage& in, AlignedPoseMessage& out) {
+  detail::CopyVector3(out.lla_deg, in.lla_deg);
+  detail::CopyVector3(out.ypr_deg, in.ypr_deg);
+  detail::CopyVector3(out.velocity_body_mps, in.velocity_body_mps);
+  detail::CopyVector3(out.position_std_enu_m, in.position_std_enu_m);
+  detail::CopyVector3(out.ypr_std_deg, in.ypr_std_deg);
+  detail::CopyVector3(out.velocity_std_body_mps, in.velocity_std_body_mps);
+  out.p1_time = in.p1_time;
+  out.gps_time = in.gps_time;
+  out.aggregate_protection_level_m = in.aggregate_protection_level_m;
+  out.horizontal_protection_level_m = in.horizontal_protection_level_m;
+  out.vertical_protection_level_m = in.vertical_protection_level_m;
+  out.solution_type = in.solution_type;
+}
+
+/**
+ * @brief Convert an @ref AlignedPoseMessage back to its wire representation.
+ */
+inline void FromAligned(const AlignedPoseMessage& in, PoseMessage& out) {
+  detail::CopyVector3(out.lla_deg, in.lla_deg);
+  detail::CopyVector3(out.ypr_deg, in.ypr_deg);
+  detail::CopyVector3(out.velocity_body_mps, in.velocity_body_mps);
+  detail::CopyVector3(out.position_std_enu_m, in.position_std_enu_m);
+  detail::CopyVector3(out.ypr_std_deg, in.ypr_std_deg);
+  detail::CopyVector3(out.velocity_std_body_mps, in.velocity_std_body_mps);
+  out.p1_time = in.p1_time;
+  out.gps_time = in.gps_time;
+  out.aggregate_protection_level_m = in.aggregate_protection_level_m;
+  out.horizontal_protection_level_m = in.horizontal_protection_level_m;
+  out.vertical_protection_level_m = in.vertical_protection_level_m;
+  out.solution_type = in.solution_type;
+  // Reserved bytes are not stored in the aligned struct. Clear them so that
+  // no stale or uninitialized data is serialized.
+  std::memset(out.reserved, 0, sizeof(out.reserved));
+}
+
+/**
+ * @brief Convert a @ref PoseAuxMessage to its aligned representation.
+ */
+inline void ToAligned(const PoseAuxMessage& in, AlignedPoseAuxMessage& out) {
+  double cov[9];
+  std::memcpy(cov, in.position_cov_enu_m2, sizeof(cov));
+  for (size_t row = 0; row < 3; ++row) {
+    out.position_cov_enu_m2[row][0] = cov[row * 3];
+    out.position_cov_enu_m2[row][1] = cov[row * 3 + 1];
+    out.position_cov_enu_m2[row][2] = cov[row * 3 + 2];
+    out.position_cov_enu_m2[row][3] = 0.0;
+  }
+  std::memcpy(out.attitude_quaternion, in.attitude_quaternion,
+              sizeof(out.attitude_quaternion));
+  detail::CopyVector3(out.velocity_enu_mps, in.velocity_enu_mps);
+  detail::CopyVector3(out.position_std_body_m, in.position_std_body_m);
+  detail::CopyVector3(out.velocity_std_enu_mps, in.velocity_std_enu_mps);
+  out.p1_time = in.p1_time;
+}
+
+/**
+ * @brief Convert an @ref AlignedPoseAuxMessage back to its wire representation.
+ */
+inline void FromAligned(const AlignedPoseAuxMessage& in, PoseAuxMessage& out) {
+  for (size_t row = 0; row < 3; ++row) {
+    out.position_cov_enu_m2[row * 3] = in.position_cov_enu_m2[row][0];
+    out.position_cov_enu_m2[row * 3 + 1] = in.position_cov_enu_m2[row][1];
+    out.position_cov_enu_m2[row * 3 + 2] = in.position_cov_enu_m2[row][2];
+  }
+  std::memcpy(out.attitude_quaternion, in.attitude_quaternion,
+              sizeof(out.attitude_quaternion));
+  detail::CopyVector3(out.velocity_enu_mps, in.velocity_enu_mps);
+  detail::CopyVector3(out.position_std_body_m, in.position_std_body_m);
+  detail::CopyVector3(out.velocity_std_enu_mps, in.velocity_std_enu_mps);
+  out.p1_time = in.p1_time;
+}
+
+/**
+ * @brief Convert an @ref IMUMeasurement to its aligned representation.
+ */
+inline void ToAligned(const IMUMeasurement& in, AlignedIMUMeasurement& out) {
+  detail::CopyVector3(out.accel_mps2, in.accel_mps2);
+  detail::CopyVector3(out.accel_std_mps2, in.accel_std_mps2);
+  detail::CopyVector3(out.gyro_rps, in.gyro_rps);
+  detail::CopyVector3(out.gyro_std_rps, in.gyro_std_rps);
+  out.p1_time = in.p1_time;
+}
+
+/**
+ * @brief Convert an @ref AlignedIMUMeasurement back to its wire representation.
+ */
+inline void FromAligned(const AlignedIMUMeasurement& in, IMUMeasurement& out) {
+  detail::CopyVector3(out.accel_mps2, in.accel_mps2);
+  detail::CopyVector3(out.accel_std_mps2, in.accel_std_mps2);
+  detail::CopyVector3(out.gyro_rps, in.gyro_rps);
+  detail::CopyVector3(out.gyro_std_rps, in.gyro_std_rps);
+  out.p1_time = in.p1_time;
+}
+
+/**
+ * @brief Convert an array of wire messages to their aligned representation.
+ *
+ * @param in The input messages.
+ * @param out The output array, which must have space for `count` elements.
+ * @param count The number of messages to convert.
+ */
+template <typename WireType, typename AlignedType>
+inline void ToAligned(const WireType* in, AlignedType* out, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    ToAligned(in[i], out[i]);
+  }
+}
+
+/**
+ * @brief Convert an array of aligned messages back to their wire
+ *        representation.
+ *
+ * @param in The input messages.
+ * @param out The output array, which must have space for `count` elements.
+ * @param count The number of messages to convert.
+ */
+template <typename AlignedType, typename WireType>
+inline void FromAligned(const AlignedType* in, WireType* out, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    FromAligned(in[i], out[i]);
+  }
+}
+
+/**
+ * @brief Convert a message payload stored in a (possibly unaligned) byte buffer
+ *        to its aligned representation.
+ *
+ * @param payload A pointer to the payload immediately following the @ref
+ *        MessageHeader.
+ * @param out The output message.
+ */
+template <typename AlignedType>
+inline void PayloadToAligned(const void* payload, AlignedType& out);
+
+template <>
+inline void PayloadToAligned(const void* payload, AlignedPoseMessage& out) {
+  PoseMessage tmp;
+  std::memcpy(&tmp, payload, sizeof(tmp));
+  ToAligned(tmp, out);
+}
+
+template <>
+inline void PayloadToAligned(const void* payload, AlignedPoseAuxMessage& out) {
+  PoseAuxMessage tmp;
+  std::memcpy(&tmp, payload, sizeof(tmp));
+  ToAligned(tmp, out);
+}
+
+template <>
+inline void PayloadToAligned(const void* payload, AlignedIMUMeasurement& out) {
+  IMUMeasurement tmp;
+  std::memcpy(&tmp, payload, sizeof(tmp));
+  ToAligned(tmp, out);
+}
+
+/** @} */
+
+/** @} */
+
+} // namespace messages
+} // namespace fusion_engine
+} // namespace point_one
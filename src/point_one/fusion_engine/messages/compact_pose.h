@@ -0,0 +1,249 @@
+/**************************************************************************/ /**
+ * @brief Compact pose message conversion support.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "point_one/fusion_engine/messages/solution.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace messages {
+
+/**
+ * @defgroup compact_pose_support Compact Pose Conversion Support
+ * @brief Convert between @ref PoseMessage and @ref CompactPoseMessage.
+ *
+ * A field group is encoded only if all of its components are finite. When
+ * decoding, absent groups are set to `NAN`. The conversion is lossless within
+ * the resolution documented in @ref CompactPoseMessage (i.e., the decoded
+ * result is within half of one least significant bit of the original value).
+ * Velocity, standard deviations, and protection levels outside the
+ * representable range saturate.
+ * @{
+ */
+
+namespace detail {
+inline bool AllFinite(const double (&values)[3]) {
+  return std::isfinite(values[0]) && std::isfinite(values[1]) &&
+         std::isfinite(values[2]);
+}
+
+inline bool AllFinite(const float (&values)[3]) {
+  return std::isfinite(values[0]) && std::isfinite(values[1]) &&
+         std::isfinite(values[2]);
+}
+
+template <typename T>
+inline T QuantizeClamped(double value, double scale) {
+  double quantized = std::round(value / scale);
+  if (quantized < static_cast<double>(std::numeric_limits<T>::min())) {
+    return std::numeric_limits<T>::min();
+  } else if (quantized > static_cast<double>(std::numeric_limits<T>::max())) {
+    return std::numeric_limits<T>::max();
+  } else {
+    return static_cast<T>(quantized);
+  }
+}
+
+inline int16_t QuantizeAngle(double angle_deg) {
+  double wrapped_deg = std::fmod(angle_deg + 180.0, 360.0);
+  if (wrapped_deg < 0.0) {
+    wrapped_deg += 360.0;
+  }
+  wrapped_deg -= 180.0;
+
+  long quantized =
+      std::lround(wrapped_deg / CompactPoseMessage::ANGLE_SCALE_DEG);
+  if (quantized >= 32768) {
+    quantized -= 65536;
+  }
+  return static_cast<int16_t>(quantized);
+}
+
+inline void SplitHighResolution(double value, double scale, double hp_scale,
+                                int32_t& coarse, int8_t& fine) {
+  const int64_t ratio = static_cast<int64_t>(std::round(scale / hp_scale));
+  int64_t total = std::llround(value / hp_scale);
+  int64_t coarse_64 = std::llround(value / scale);
+  if (coarse_64 > INT32_MAX) {
+    coarse_64 = INT32_MAX;
+  } else if (coarse_64 < INT32_MIN) {
+    coarse_64 = INT32_MIN;
+  }
+
+  int64_t fine_64 = total - coarse_64 * ratio;
+  if (fine_64 > ratio / 2) {
+    fine_64 = ratio / 2;
+  } else if (fine_64 < -ratio / 2) {
+    fine_64 = -ratio / 2;
+  }
+
+  coarse = static_cast<int32_t>(coarse_64);
+  fine = static_cast<int8_t>(fine_64);
+}
+} // namespace detail
+
+/**
+ * @brief Convert a @ref PoseMessage to a @ref CompactPoseMessage.
+ *
+ * @param in The pose to be converted.
+ * @param out The resulting compact pose.
+ */
+inline void ToCompactPose(const PoseMessage& in, CompactPoseMessage& out) {
+  out = CompactPoseMessage();
+
+  out.p1_time = in.p1_time;
+  out.solution_type = in.solution_type;
+
+  if (in.gps_time.seconds != Timestamp::INVALID) {
+    out.gps_time = in.gps_time;
+    out.presence_mask |= CompactPoseMessage::GPS_TIME_PRESENT;
+  }
+
+  if (detail::AllFinite(in.lla_deg)) {
+    for (size_t i = 0; i < 2; ++i) {
+      detail::SplitHighResolution(in.lla_deg[i],
+                                  CompactPoseMessage::LATLON_SCALE_DEG,
+                                  CompactPoseMessage::LATLON_HP_SCALE_DEG,
+                                  out.latlon[i], out.lla_hp[i]);
+    }
+    detail::SplitHighResolution(
+        in.lla_deg[2], CompactPoseMessage::ALTITUDE_SCALE_M,
+        CompactPoseMessage::ALTITUDE_HP_SCALE_M, out.altitude, out.lla_hp[2]);
+    out.presence_mask |= CompactPoseMessage::POSITION_PRESENT;
+  }
+
+  if (detail::AllFinite(in.position_std_enu_m)) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.position_std_enu[i] = detail::QuantizeClamped<uint16_t>(
+          in.position_std_enu_m[i], CompactPoseMessage::POSITION_STD_SCALE_M);
+    }
+    out.presence_mask |= CompactPoseMessage::POSITION_STD_PRESENT;
+  }
+
+  if (detail::AllFinite(in.ypr_deg)) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.ypr[i] = detail::QuantizeAngle(in.ypr_deg[i]);
+    }
+    out.presence_mask |= CompactPoseMessage::ATTITUDE_PRESENT;
+  }
+
+  if (detail::AllFinite(in.ypr_std_deg)) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.ypr_std[i] = detail::QuantizeClamped<uint16_t>(
+          in.ypr_std_deg[i], CompactPoseMessage::ANGLE_STD_SCALE_DEG);
+    }
+    out.presence_mask |= CompactPoseMessage::ATTITUDE_STD_PRESENT;
+  }
+
+  if (detail::AllFinite(in.velocity_body_mps)) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.velocity_body[i] = detail::QuantizeClamped<int16_t>(
+          in.velocity_body_mps[i], CompactPoseMessage::VELOCITY_SCALE_MPS);
+    }
+    out.presence_mask |= CompactPoseMessage::VELOCITY_PRESENT;
+  }
+
+  if (detail::AllFinite(in.velocity_std_body_mps)) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.velocity_std_body[i] = detail::QuantizeClamped<uint16_t>(
+          in.velocity_std_body_mps[i],
+          CompactPoseMessage::VELOCITY_STD_SCALE_MPS);
+    }
+    out.presence_mask |= CompactPoseMessage::VELOCITY_STD_PRESENT;
+  }
+
+  const float protection_levels_m[3] = {in.aggregate_protection_level_m,
+                                        in.horizontal_protection_level_m,
+                                        in.vertical_protection_level_m};
+  if (detail::AllFinite(protection_levels_m)) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.protection_levels[i] = detail::QuantizeClamped<uint16_t>(
+          protection_levels_m[i], CompactPoseMessage::PROTECTION_LEVEL_SCALE_M);
+    }
+    out.presence_mask |= CompactPoseMessage::PROTECTION_LEVELS_PRESENT;
+  }
+}
+
+/**
+ * @brief Convert a @ref CompactPoseMessage to a @ref PoseMessage.
+ *
+ * @param in The compact pose to be converted.
+ * @param out The resulting pose. Fields not present in the compact pose are set
+ *        to `NAN` (or invalid for timestamps).
+ */
+inline void FromCompactPose(const CompactPoseMessage& in, PoseMessage& out) {
+  out = PoseMessage();
+
+  out.p1_time = in.p1_time;
+  out.solution_type = in.solution_type;
+
+  if (in.presence_mask & CompactPoseMessage::GPS_TIME_PRESENT) {
+    out.gps_time = in.gps_time;
+  }
+
+  if (in.presence_mask & CompactPoseMessage::POSITION_PRESENT) {
+    for (size_t i = 0; i < 2; ++i) {
+      out.lla_deg[i] =
+          in.latlon[i] * CompactPoseMessage::LATLON_SCALE_DEG +
+          in.lla_hp[i] * CompactPoseMessage::LATLON_HP_SCALE_DEG;
+    }
+    out.lla_deg[2] = in.altitude * CompactPoseMessage::ALTITUDE_SCALE_M +
+                     in.lla_hp[2] * CompactPoseMessage::ALTITUDE_HP_SCALE_M;
+  }
+
+  if (in.presence_mask & CompactPoseMessage::POSITION_STD_PRESENT) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.position_std_enu_m[i] = static_cast<float>(
+          in.position_std_enu[i] * CompactPoseMessage::POSITION_STD_SCALE_M);
+    }
+  }
+
+  if (in.presence_mask & CompactPoseMessage::ATTITUDE_PRESENT) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.ypr_deg[i] = in.ypr[i] * CompactPoseMessage::ANGLE_SCALE_DEG;
+    }
+  }
+
+  if (in.presence_mask & CompactPoseMessage::ATTITUDE_STD_PRESENT) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.ypr_std_deg[i] = static_cast<float>(
+          in.ypr_std[i] * CompactPoseMessage::ANGLE_STD_SCALE_DEG);
+    }
+  }
+
+  if (in.presence_mask & CompactPoseMessage::VELOCITY_PRESENT) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.velocity_body_mps[i] =
+          in.velocity_body[i] * CompactPoseMessage::VELOCITY_SCALE_MPS;
+    }
+  }
+
+  if (in.presence_mask & CompactPoseMessage::VELOCITY_STD_PRESENT) {
+    for (size_t i = 0; i < 3; ++i) {
+      out.velocity_std_body_mps[i] = static_cast<float>(
+          in.velocity_std_body[i] * CompactPoseMessage::VELOCITY_STD_SCALE_MPS);
+    }
+  }
+
+  if (in.presence_mask & CompactPoseMessage::PROTECTION_LEVELS_PRESENT) {
+    out.aggregate_protection_level_m = static_cast<float>(
+        in.protection_levels[0] * CompactPoseMessage::PROTECTION_LEVEL_SCALE_M);
+    out.horizontal_protection_level_m = static_cast<float>(
+        in.protection_levels[1] * CompactPoseMessage::PROTECTION_LEVEL_SCALE_M);
+    out.vertical_protection_level_m = static_cast<float>(
+        in.protection_levels[2] * CompactPoseMessage::PROTECTION_LEVEL_SCALE_M);
+  }
+}
+
+/** @} */
+
+} // namespace messages
+} // namespace fusion_engine
+} // namespace point_one
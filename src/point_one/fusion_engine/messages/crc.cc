@@ -5,32 +5,52 @@
 
 #include "point_one/fusion_engine/messages/crc.h"
 
+#include <cstring> // For memcpy()
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#  define P1_HAVE_SSE42_CRC32C 1
+#  include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#  define P1_HAVE_ARM_CRC32C 1
+#  include <arm_acle.h>
+#endif
+
 namespace {
+/******************************************************************************/
+const uint32_t* GenerateCRCTable(uint32_t polynomial, uint32_t* crc_table) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (size_t j = 0; j < 8; j++) {
+      if (c & 1) {
+        c = polynomial ^ (c >> 1);
+      } else {
+        c >>= 1;
+      }
+    }
+    crc_table[i] = c;
+  }
+
+  return crc_table;
+}
+
 /******************************************************************************/
 const uint32_t* GetCRCTable() {
   // Note: This is the CRC-32 polynomial.
   static constexpr uint32_t polynomial = 0xEDB88320;
 
-  static bool is_initialized = false;
   static uint32_t crc_table[256];
+  static const uint32_t* table = GenerateCRCTable(polynomial, crc_table);
+  return table;
+}
 
-  if (!is_initialized) {
-    for (uint32_t i = 0; i < 256; i++) {
-      uint32_t c = i;
-      for (size_t j = 0; j < 8; j++) {
-        if (c & 1) {
-          c = polynomial ^ (c >> 1);
-        } else {
-          c >>= 1;
-        }
-      }
-      crc_table[i] = c;
-    }
-
-    is_initialized = true;
-  }
+/******************************************************************************/
+const uint32_t* GetCRC32CTable() {
+  // Note: This is the CRC-32C (Castagnoli) polynomial.
+  static constexpr uint32_t polynomial = 0x82F63B78;
 
-  return crc_table;
+  static uint32_t crc_table[256];
+  static const uint32_t* table = GenerateCRCTable(polynomial, crc_table);
+  return table;
 }
 
 /******************************************************************************/
@@ -44,6 +64,70 @@ uint32_t CalculateCRC(const void* buffer, size_t length,
   }
   return c ^ 0xFFFFFFFF;
 }
+
+/******************************************************************************/
+uint32_t CalculateCRC32CSoftware(const void* buffer, size_t length,
+                                 uint32_t initial_value) {
+  static const uint32_t* crc_table = GetCRC32CTable();
+  uint32_t c = initial_value ^ 0xFFFFFFFF;
+  const uint8_t* u = static_cast<const uint8_t*>(buffer);
+  for (size_t i = 0; i < length; ++i) {
+    c = crc_table[(c ^ u[i]) & 0xFF] ^ (c >> 8);
+  }
+  return c ^ 0xFFFFFFFF;
+}
+
+#if P1_HAVE_SSE42_CRC32C
+/******************************************************************************/
+__attribute__((target("sse4.2"))) uint32_t CalculateCRC32CHardware(
+    const void* buffer, size_t length, uint32_t initial_value) {
+  const uint8_t* u = static_cast<const uint8_t*>(buffer);
+  uint64_t c = initial_value ^ 0xFFFFFFFF;
+  for (; length >= 8; length -= 8, u += 8) {
+    uint64_t value;
+    std::memcpy(&value, u, sizeof(value));
+    c = _mm_crc32_u64(c, value);
+  }
+
+  uint32_t c32 = static_cast<uint32_t>(c);
+  for (; length > 0; --length, ++u) {
+    c32 = _mm_crc32_u8(c32, *u);
+  }
+  return c32 ^ 0xFFFFFFFF;
+}
+
+/******************************************************************************/
+bool DetectHardwareCRC32C() { return __builtin_cpu_supports("sse4.2"); }
+#elif P1_HAVE_ARM_CRC32C
+/******************************************************************************/
+uint32_t CalculateCRC32CHardware(const void* buffer, size_t length,
+                                 uint32_t initial_value) {
+  const uint8_t* u = static_cast<const uint8_t*>(buffer);
+  uint32_t c = initial_value ^ 0xFFFFFFFF;
+  for (; length >= 8; length -= 8, u += 8) {
+    uint64_t value;
+    std::memcpy(&value, u, sizeof(value));
+    c = __crc32cd(c, value);
+  }
+
+  for (; length > 0; --length, ++u) {
+    c = __crc32cb(c, *u);
+  }
+  return c ^ 0xFFFFFFFF;
+}
+
+/******************************************************************************/
+bool DetectHardwareCRC32C() { return true; }
+#else
+/******************************************************************************/
+uint32_t CalculateCRC32CHardware(const void* buffer, size_t length,
+                                 uint32_t initial_value) {
+  return CalculateCRC32CSoftware(buffer, length, initial_value);
+}
+
+/******************************************************************************/
+bool DetectHardwareCRC32C() { return false; }
+#endif
 } // namespace
 
 namespace point_one {
@@ -56,8 +140,29 @@ uint32_t CalculateCRC(const void* buffer) {
   const MessageHeader& header = *static_cast<const MessageHeader*>(buffer);
   size_t size_bytes =
       (sizeof(MessageHeader) - offset) + header.payload_size_bytes;
-  return ::CalculateCRC(reinterpret_cast<const uint8_t*>(&header) + offset,
-                        size_bytes);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(&header) + offset;
+  if (header.flags & MessageHeader::FLAG_CRC32C) {
+    return CalculateCRC32C(data, size_bytes);
+  } else {
+    return ::CalculateCRC(data, size_bytes);
+  }
+}
+
+/******************************************************************************/
+uint32_t CalculateCRC32C(const void* buffer, size_t length,
+                         uint32_t initial_value) {
+  static const bool use_hardware = DetectHardwareCRC32C();
+  if (use_hardware) {
+    return CalculateCRC32CHardware(buffer, length, initial_value);
+  } else {
+    return CalculateCRC32CSoftware(buffer, length, initial_value);
+  }
+}
+
+/******************************************************************************/
+bool IsHardwareCRC32CSupported() {
+  static const bool use_hardware = DetectHardwareCRC32C();
+  return use_hardware;
 }
 
 } // namespace messages
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <cstddef> // For size_t
 #include <cstdint>
 #include <string>
 
@@ -24,12 +25,38 @@ namespace messages {
  * @brief Calculate the CRC for the message (header + payload) contained in the
  *        buffer.
  *
+ * The CRC algorithm is selected automatically using @ref MessageHeader::flags:
+ * CRC-32C if @ref MessageHeader::FLAG_CRC32C is set, or CRC-32 otherwise. To
+ * generate a CRC-32C message, set the flag before calling this function.
+ *
  * @param buffer A byte buffer containing a @ref MessageHeader and payload.
  *
  * @return The calculated CRC value.
  */
 P1_EXPORT uint32_t CalculateCRC(const void* buffer);
 
+/**
+ * @brief Calculate the CRC-32C (Castagnoli) value for an arbitrary byte buffer.
+ *
+ * Uses hardware acceleration when available (see @ref
+ * IsHardwareCRC32CSupported()).
+ *
+ * @param buffer The data to be processed.
+ * @param length The size of the data (in bytes).
+ * @param initial_value The CRC of any preceding data, or 0.
+ *
+ * @return The calculated CRC value.
+ */
+P1_EXPORT uint32_t CalculateCRC32C(const void* buffer, size_t length,
+                                   uint32_t initial_value = 0);
+
+/**
+ * @brief Check if CRC-32C calculation is hardware accelerated on this platform.
+ *
+ * @return `true` if a hardware CRC-32C instruction is available.
+ */
+P1_EXPORT bool IsHardwareCRC32CSupported();
+
 /**
  * @brief Check if the message contained in the buffer has a valid CRC.
  *
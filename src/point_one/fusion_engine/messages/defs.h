@@ -73,9 +73,11 @@ enum class MessageType : uint16_t {
   GNSS_INFO = 10001, ///< @ref GNSSInfoMessage
   GNSS_SATELLITE = 10002, ///< @ref GNSSSatelliteMessage
   POSE_AUX = 10003, ///< @ref PoseAuxMessage
+  COMPACT_POSE = 10004, ///< @ref CompactPoseMessage
 
   // Sensor measurement messages.
   IMU_MEASUREMENT = 11000, ///< @ref IMUMeasurement
+  IMU_MEASUREMENT_BATCH = 11001, ///< @ref IMUMeasurementBatch
 
   // ROS messages.
   ROS_POSE = 12000, ///< @ref ros::PoseMessage
@@ -122,16 +124,49 @@ struct MessageHeader {
    */
   static const size_t MAX_MESSAGE_SIZE_BYTES = (1 << 24);
 
+  /**
+   * @defgroup header_flags Bit definitions for the message header flags
+   *           (@ref MessageHeader::flags).
+   * @{
+   */
+  /**
+   * If set, @ref crc is computed using the CRC-32C (Castagnoli) polynomial
+   * instead of the standard CRC-32 polynomial.
+   *
+   * CRC-32C may be computed in hardware on many platforms (e.g., using the
+   * x86 SSE4.2 `crc32` instruction). It is intended for links where both ends
+   * are known to support it. Devices that do not support this flag will reject
+   * messages that use it as having an invalid CRC.
+   */
+  static constexpr uint8_t FLAG_CRC32C = 0x01;
+  /** @} */
+
   /** Message sync bytes: always set to ASCII `.1` (0x2E, 0x31). */
   uint8_t sync[2] = {SYNC0, SYNC1};
 
-  uint8_t reserved[2] = {0};
+  /**
+   * A bitmask of message flags. See @ref header_flags.
+   *
+   * @note
+   * This field is not covered by @ref crc. Corruption of the CRC mode flag
+   * causes the CRC to be checked with the wrong polynomial, so the message will
+   * still be rejected.
+   *
+   * @note
+   * This field and @ref reserved were previously declared as
+   * `uint8_t reserved[2]`. The wire format is unchanged, but code that accessed
+   * `reserved[0]` or `reserved[1]` must use `flags` or `reserved` instead.
+   */
+  uint8_t flags = 0;
+
+  uint8_t reserved = 0;
 
   /**
    * The 32-bit CRC of all bytes from and including the @ref protocol_version
-   * field to the last byte in the message, including the message payload. This
-   * uses the standard CRC-32 generator polynomial in reversed order
-   * (0xEDB88320).
+   * field to the last byte in the message, including the message payload. By
+   * default, this uses the standard CRC-32 generator polynomial in reversed
+   * order (0xEDB88320). If @ref FLAG_CRC32C is set in @ref flags, it instead
+   * uses the CRC-32C generator polynomial in reversed order (0x82F63B78).
    *
    * See also @ref crc_support.
    */
@@ -236,9 +271,15 @@ inline std::string to_string(MessageType type) {
     case MessageType::POSE_AUX:
       return "Pose Auxiliary";
 
+    case MessageType::COMPACT_POSE:
+      return "Compact Pose";
+
     case MessageType::IMU_MEASUREMENT:
       return "IMU Measurement";
 
+    case MessageType::IMU_MEASUREMENT_BATCH:
+      return "IMU Measurement Batch";
+
     case MessageType::ROS_POSE:
       return "ROS Pose";
 
@@ -0,0 +1,295 @@
+/**************************************************************************/ /**
+ * @brief IMU measurement batch encode/decode support.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef> // For size_t
+#include <cstdint>
+#include <cstring> // For memcpy()
+#include <iterator>
+
+#include "point_one/fusion_engine/messages/measurements.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace messages {
+
+/**
+ * @defgroup imu_batch_support IMU Measurement Batch Support
+ * @brief Encode and decode @ref IMUMeasurementBatch messages.
+ * @{
+ */
+
+/**
+ * @brief Read-only view of the samples contained in a serialized @ref
+ *        IMUMeasurementBatch payload.
+ *
+ * Samples are returned as @ref IMUMeasurement values with their absolute P1
+ * time restored, so code written for individual @ref IMUMeasurement messages
+ * can consume batches unchanged:
+ *
+ * ```{.cpp}
+ * IMUBatchView view(payload, header.payload_size_bytes);
+ * if (view.IsValid()) {
+ *   for (const IMUMeasurement& imu : view) {
+ *     ...
+ *   }
+ * }
+ * ```
+ *
+ * The payload does not need to be aligned. The view does not copy the payload,
+ * which must remain valid for the lifetime of the view.
+ */
+class IMUBatchView {
+ public:
+  /**
+   * @brief Forward iterator returning reconstructed @ref IMUMeasurement values.
+   */
+  class Iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef IMUMeasurement value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const IMUMeasurement* pointer;
+    typedef const IMUMeasurement& reference;
+
+    Iterator(const IMUBatchView* view, size_t index)
+        : view_(view), index_(index) {}
+
+    reference operator*() {
+      current_ = (*view_)[index_];
+      return current_;
+    }
+
+    pointer operator->() { return &**this; }
+
+    Iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator result = *this;
+      ++index_;
+      return result;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return view_ == other.view_ && index_ == other.index_;
+    }
+
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    const IMUBatchView* view_;
+    size_t index_;
+    IMUMeasurement current_;
+  };
+
+  /**
+   * @brief Create a view of a batch payload.
+   *
+   * @param payload A pointer to the payload immediately following the @ref
+   *        MessageHeader.
+   * @param payload_size_bytes The size of the payload (@ref
+   *        MessageHeader::payload_size_bytes).
+   */
+  IMUBatchView(const void* payload, size_t payload_size_bytes)
+      : payload_(static_cast<const uint8_t*>(payload)),
+        payload_size_bytes_(payload_size_bytes) {
+    if (payload_size_bytes_ >= sizeof(IMUMeasurementBatch)) {
+      std::memcpy(&batch_, payload_, sizeof(batch_));
+    }
+  }
+
+  /**
+   * @brief Check that the payload is large enough to contain the number of
+   *        samples specified in the batch.
+   */
+  bool IsValid() const {
+    return payload_size_bytes_ >= sizeof(IMUMeasurementBatch) &&
+           payload_size_bytes_ >= sizeof(IMUMeasurementBatch) +
+                                      batch_.num_samples *
+                                          sizeof(IMUBatchSample);
+  }
+
+  /** @brief Get the batch base time. */
+  const Timestamp& GetBaseTime() const { return batch_.p1_time; }
+
+  /** @brief Get the number of samples in the batch (0 if invalid). */
+  size_t size() const { return IsValid() ? batch_.num_samples : 0; }
+
+  /** @brief Check if the batch contains no samples. */
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Get the raw sample at the specified index.
+   *
+   * @param index The sample index. Must be less than @ref size().
+   *
+   * @return The sample, with its time still stored as an offset.
+   */
+  IMUBatchSample GetSample(size_t index) const {
+    IMUBatchSample sample;
+    std::memcpy(&sample,
+                payload_ + sizeof(IMUMeasurementBatch) +
+                    index * sizeof(IMUBatchSample),
+                sizeof(sample));
+    return sample;
+  }
+
+  /**
+   * @brief Get the sample at the specified index as an @ref IMUMeasurement.
+   *
+   * @param index The sample index. Must be less than @ref size().
+   *
+   * @return The measurement, with its absolute P1 time restored.
+   */
+  IMUMeasurement operator[](size_t index) const {
+    IMUBatchSample sample = GetSample(index);
+
+    IMUMeasurement result;
+    if (sample.time_offset_ns != IMUBatchSample::INVALID_TIME_OFFSET &&
+        batch_.p1_time.seconds != Timestamp::INVALID) {
+      uint64_t fraction_ns =
+          static_cast<uint64_t>(batch_.p1_time.fraction_ns) +
+          sample.time_offset_ns;
+      result.p1_time.seconds =
+          batch_.p1_time.seconds +
+          static_cast<uint32_t>(fraction_ns / 1000000000ull);
+      result.p1_time.fraction_ns =
+          static_cast<uint32_t>(fraction_ns % 1000000000ull);
+    }
+
+    std::memcpy(result.accel_mps2, sample.accel_mps2, sizeof(result.accel_mps2));
+    std::memcpy(result.accel_std_mps2, sample.accel_std_mps2,
+                sizeof(result.accel_std_mps2));
+    std::memcpy(result.gyro_rps, sample.gyro_rps, sizeof(result.gyro_rps));
+    std::memcpy(result.gyro_std_rps, sample.gyro_std_rps,
+                sizeof(result.gyro_std_rps));
+    return result;
+  }
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, size()); }
+
+ private:
+  const uint8_t* payload_;
+  size_t payload_size_bytes_;
+  IMUMeasurementBatch batch_;
+};
+
+/**
+ * @brief Get the payload size (in bytes) required for a batch of samples.
+ *
+ * @param num_samples The number of samples.
+ *
+ * @return The payload size (in bytes).
+ */
+inline size_t GetIMUBatchPayloadSize(size_t num_samples) {
+  return sizeof(IMUMeasurementBatch) + num_samples * sizeof(IMUBatchSample);
+}
+
+/**
+ * @brief Serialize a sequence of @ref IMUMeasurement values into an @ref
+ *        IMUMeasurementBatch payload.
+ *
+ * The batch base time is set to the time of the first sample with a valid P1
+ * time. Encoding stops early if:
+ * - The buffer is full
+ * - The batch reaches its maximum size (65535 samples)
+ * - A sample precedes the base time, or is more than ~4.29 seconds after it
+ *
+ * In that case, the remaining samples may be encoded in a subsequent batch.
+ *
+ * The caller is responsible for populating the @ref MessageHeader (including
+ * @ref MessageHeader::payload_size_bytes and @ref MessageHeader::crc).
+ *
+ * @param samples The measurements to be encoded.
+ * @param num_samples The number of entries in `samples`.
+ * @param buffer The output buffer for the payload (immediately following the
+ *        @ref MessageHeader).
+ * @param capacity_bytes The size of `buffer` (in bytes).
+ * @param num_encoded If not `nullptr`, set to the number of samples that were
+ *        encoded.
+ *
+ * @return The size of the serialized payload (in bytes), or 0 if the buffer is
+ *         too small to hold a batch.
+ */
+inline size_t EncodeIMUBatch(const IMUMeasurement* samples, size_t num_samples,
+                             void* buffer, size_t capacity_bytes,
+                             size_t* num_encoded = nullptr) {
+  static constexpr uint16_t MAX_SAMPLES = 0xFFFF;
+
+  if (num_encoded != nullptr) {
+    *num_encoded = 0;
+  }
+
+  if (capacity_bytes < sizeof(IMUMeasurementBatch)) {
+    return 0;
+  }
+
+  IMUMeasurementBatch batch;
+  for (size_t i = 0; i < num_samples; ++i) {
+    if (samples[i].p1_time.seconds != Timestamp::INVALID) {
+      batch.p1_time = samples[i].p1_time;
+      break;
+    }
+  }
+
+  const int64_t base_time_ns =
+      static_cast<int64_t>(batch.p1_time.seconds) * 1000000000ll +
+      batch.p1_time.fraction_ns;
+
+  uint8_t* sample_buffer =
+      static_cast<uint8_t*>(buffer) + sizeof(IMUMeasurementBatch);
+  size_t max_samples =
+      (capacity_bytes - sizeof(IMUMeasurementBatch)) / sizeof(IMUBatchSample);
+  if (max_samples > MAX_SAMPLES) {
+    max_samples = MAX_SAMPLES;
+  }
+
+  size_t count = 0;
+  for (; count < num_samples && count < max_samples; ++count) {
+    const IMUMeasurement& input = samples[count];
+
+    IMUBatchSample sample;
+    if (input.p1_time.seconds != Timestamp::INVALID) {
+      int64_t offset_ns =
+          static_cast<int64_t>(input.p1_time.seconds) * 1000000000ll +
+          input.p1_time.fraction_ns - base_time_ns;
+      if (offset_ns < 0 ||
+          offset_ns >= static_cast<int64_t>(IMUBatchSample::INVALID_TIME_OFFSET)) {
+        break;
+      }
+      sample.time_offset_ns = static_cast<uint32_t>(offset_ns);
+    }
+
+    std::memcpy(sample.accel_mps2, input.accel_mps2, sizeof(sample.accel_mps2));
+    std::memcpy(sample.accel_std_mps2, input.accel_std_mps2,
+                sizeof(sample.accel_std_mps2));
+    std::memcpy(sample.gyro_rps, input.gyro_rps, sizeof(sample.gyro_rps));
+    std::memcpy(sample.gyro_std_rps, input.gyro_std_rps,
+                sizeof(sample.gyro_std_rps));
+
+    std::memcpy(sample_buffer + count * sizeof(IMUBatchSample), &sample,
+                sizeof(sample));
+  }
+
+  batch.num_samples = static_cast<uint16_t>(count);
+  std::memcpy(buffer, &batch, sizeof(batch));
+
+  if (num_encoded != nullptr) {
+    *num_encoded = count;
+  }
+
+  return GetIMUBatchPayloadSize(count);
+}
+
+/** @} */
+
+} // namespace messages
+} // namespace fusion_engine
+} // namespace point_one
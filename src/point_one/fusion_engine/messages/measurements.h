@@ -53,6 +53,76 @@ struct IMUMeasurement {
   double gyro_std_rps[3] = {NAN, NAN, NAN};
 };
 
+/**
+ * @brief A batch of IMU sensor measurements sharing a single message header
+ *        (@ref MessageType::IMU_MEASUREMENT_BATCH).
+ * @ingroup messages
+ *
+ * This message is followed by `N` @ref IMUBatchSample objects, where `N` is
+ * equal to @ref num_samples. For example, a message with two samples would be
+ * serialized as:
+ *
+ * ```
+ * {MessageHeader, IMUMeasurementBatch, IMUBatchSample, IMUBatchSample, ...}
+ * ```
+ *
+ * The contents of each sample are identical to @ref IMUMeasurement, except that
+ * the sample time is stored as an offset from @ref p1_time. Batching samples
+ * amortizes the header and CRC overhead for high-rate IMU output.
+ *
+ * See also @ref IMUBatchView for iterating over the contained samples.
+ */
+struct IMUMeasurementBatch {
+  /**
+   * The base time of the batch, in P1 time (beginning at power-on). This is
+   * typically the time of the first sample.
+   */
+  Timestamp p1_time;
+
+  /** The number of samples in this batch. */
+  uint16_t num_samples = 0;
+
+  uint8_t reserved[2] = {0};
+};
+
+/**
+ * @brief An individual IMU measurement within an @ref IMUMeasurementBatch.
+ */
+struct IMUBatchSample {
+  static constexpr uint32_t INVALID_TIME_OFFSET = 0xFFFFFFFF;
+
+  /**
+   * The time of this sample relative to @ref IMUMeasurementBatch::p1_time (in
+   * nanoseconds). Set to @ref INVALID_TIME_OFFSET if the sample time is not
+   * known.
+   */
+  uint32_t time_offset_ns = INVALID_TIME_OFFSET;
+
+  /**
+   * Corrected vehicle x/y/z acceleration (in meters/second^2), resolved in the
+   * body frame.
+   */
+  double accel_mps2[3] = {NAN, NAN, NAN};
+
+  /**
+   * Corrected vehicle x/y/z acceleration standard deviation (in
+   * meters/second^2), resolved in the body frame.
+   */
+  double accel_std_mps2[3] = {NAN, NAN, NAN};
+
+  /**
+   * Corrected vehicle x/y/z rate of rotation (in radians/second), resolved in
+   * the body frame.
+   */
+  double gyro_rps[3] = {NAN, NAN, NAN};
+
+  /**
+   * Corrected vehicle x/y/z rate of rotation standard deviation (in
+   * radians/second), resolved in the body frame.
+   */
+  double gyro_std_rps[3] = {NAN, NAN, NAN};
+};
+
 #pragma pack(pop)
 
 } // namespace messages
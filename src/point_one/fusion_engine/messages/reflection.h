@@ -0,0 +1,557 @@
+/**************************************************************************/ /**
+ * @brief Compile-time field metadata for message structures.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef> // For offsetof(), size_t
+#include <cstdint>
+#include <cstring> // For memcpy()
+#include <type_traits>
+
+#include "point_one/fusion_engine/messages/core.h"
+#include "point_one/fusion_engine/messages/ros.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace messages {
+
+/**
+ * @defgroup reflection Message Field Reflection
+ * @brief Compile-time descriptions of the fields in each message structure.
+ *
+ * @ref MessageReflection is specialized for every message structure (including
+ * the @ref ros structures and sub-structures such as @ref SatelliteInfo). Each
+ * specialization provides a `constexpr` array of @ref FieldDescriptor entries,
+ * listed in memory order, covering every byte of the structure (including
+ * reserved fields). The descriptors are checked against the actual structure
+ * layout at compile time.
+ *
+ * ```{.cpp}
+ * typedef MessageReflection<PoseMessage> Reflection;
+ * for (size_t i = 0; i < Reflection::NUM_FIELDS; ++i) {
+ *   const FieldDescriptor& field = Reflection::fields[i];
+ *   printf("%s: %f %s\n", field.name, GetFieldValue(&pose, field),
+ *          field.unit);
+ * }
+ *
+ * static_assert(FindField<PoseMessage>("lla_deg") >= 0, "Field not found.");
+ * ```
+ * @{
+ */
+
+/**
+ * @brief Field element data types.
+ */
+enum class FieldType : uint8_t {
+  UINT8 = 0,
+  INT8 = 1,
+  UINT16 = 2,
+  INT16 = 3,
+  UINT32 = 4,
+  INT32 = 5,
+  FLOAT = 6,
+  DOUBLE = 7,
+  /** A @ref Timestamp, interpreted as seconds. */
+  TIMESTAMP = 8,
+};
+
+/**
+ * @brief Get the size of a single @ref FieldType element (in bytes).
+ */
+constexpr size_t GetFieldTypeSize(FieldType type) {
+  return type == FieldType::UINT8 || type == FieldType::INT8
+             ? 1
+             : type == FieldType::UINT16 || type == FieldType::INT16
+                   ? 2
+                   : type == FieldType::DOUBLE || type == FieldType::TIMESTAMP
+                         ? 8
+                         : 4;
+}
+
+/**
+ * @brief Description of a single structure field.
+ */
+struct FieldDescriptor {
+  /** The field name, matching the structure member name. */
+  const char* name;
+
+  /** The offset of the field from the start of the structure (in bytes). */
+  size_t offset;
+
+  /** The element type. Enumerations are described by their underlying type. */
+  FieldType type;
+
+  /** The number of array elements, or 0 if the field is not an array. */
+  size_t array_length;
+
+  /**
+   * The units of the field values, or an empty string if not applicable. For
+   * arrays with different units for each element, the units are separated by
+   * commas (e.g., `deg,deg,m`).
+   */
+  const char* unit;
+
+  /** Get the total size of the field (in bytes). */
+  constexpr size_t GetSize() const {
+    return GetFieldTypeSize(type) * (array_length == 0 ? 1 : array_length);
+  }
+};
+
+namespace detail {
+template <typename T, typename Enable = void>
+struct FieldTypeOf;
+
+template <>
+struct FieldTypeOf<uint8_t> {
+  static constexpr FieldType value = FieldType::UINT8;
+};
+
+template <>
+struct FieldTypeOf<int8_t> {
+  static constexpr FieldType value = FieldType::INT8;
+};
+
+template <>
+struct FieldTypeOf<uint16_t> {
+  static constexpr FieldType value = FieldType::UINT16;
+};
+
+template <>
+struct FieldTypeOf<int16_t> {
+  static constexpr FieldType value = FieldType::INT16;
+};
+
+template <>
+struct FieldTypeOf<uint32_t> {
+  static constexpr FieldType value = FieldType::UINT32;
+};
+
+template <>
+struct FieldTypeOf<int32_t> {
+  static constexpr FieldType value = FieldType::INT32;
+};
+
+template <>
+struct FieldTypeOf<float> {
+  static constexpr FieldType value = FieldType::FLOAT;
+};
+
+template <>
+struct FieldTypeOf<double> {
+  static constexpr FieldType value = FieldType::DOUBLE;
+};
+
+template <>
+struct FieldTypeOf<Timestamp> {
+  static constexpr FieldType value = FieldType::TIMESTAMP;
+};
+
+template <typename T>
+struct FieldTypeOf<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+  static constexpr FieldType value =
+      FieldTypeOf<typename std::underlying_type<T>::type>::value;
+};
+
+/**
+ * @brief Get the @ref FieldType for a structure member type (scalar or array).
+ */
+template <typename MemberType>
+struct MemberFieldType {
+  static constexpr FieldType value =
+      FieldTypeOf<typename std::remove_all_extents<MemberType>::type>::value;
+};
+
+constexpr bool StringEqual(const char* a, const char* b) {
+  return *a == *b && (*a == '\0' || StringEqual(a + 1, b + 1));
+}
+} // namespace detail
+
+/**
+ * @brief Field metadata for a message structure.
+ *
+ * Specializations provide:
+ * - `MESSAGE_TYPE` - The @ref MessageType for the structure, or @ref
+ *   MessageType::INVALID for sub-structures (e.g., @ref SatelliteInfo)
+ * - `NAME` - The structure name
+ * - `fields` - An array of @ref FieldDescriptor entries in memory order
+ * - `NUM_FIELDS` - The number of entries in `fields`
+ *
+ * @tparam T The message structure type.
+ * @tparam Dummy Unused. Allows the metadata to be defined in this header.
+ */
+template <typename T, typename Dummy = void>
+struct MessageReflection;
+
+/**
+ * @brief Check if @ref MessageReflection metadata fully and exactly describes
+ *        the layout of a structure: each field must start where the previous
+ *        one ended, and the last field must end at the end of the structure.
+ */
+template <typename T>
+constexpr bool IsReflectionLayoutValid(size_t index = 0) {
+  typedef MessageReflection<T> Reflection;
+  return index == Reflection::NUM_FIELDS
+             ? true
+             : (Reflection::fields[index].offset +
+                    Reflection::fields[index].GetSize() ==
+                (index + 1 == Reflection::NUM_FIELDS
+                     ? sizeof(T)
+                     : Reflection::fields[index + 1].offset)) &&
+                   (index > 0 || Reflection::fields[0].offset == 0) &&
+                   IsReflectionLayoutValid<T>(index + 1);
+}
+
+/**
+ * @brief Find a field by name at compile time.
+ *
+ * @tparam T The message structure type.
+ * @param name The field name.
+ *
+ * @return The index of the field within `MessageReflection<T>::fields`, or -1
+ *         if not found.
+ */
+template <typename T>
+constexpr int FindField(const char* name, size_t index = 0) {
+  return index == MessageReflection<T>::NUM_FIELDS
+             ? -1
+             : detail::StringEqual(MessageReflection<T>::fields[index].name,
+                                   name)
+                   ? static_cast<int>(index)
+                   : FindField<T>(name, index + 1);
+}
+
+/**
+ * @brief Read a field value from a structure as a `double`.
+ *
+ * @ref Timestamp values are converted to seconds, or `NAN` if invalid. The
+ * structure does not need to be aligned.
+ *
+ * @param data A pointer to the start of the structure.
+ * @param field The field to be read.
+ * @param index The array element to be read. Must be 0 for non-array fields.
+ *
+ * @return The field value.
+ */
+inline double GetFieldValue(const void* data, const FieldDescriptor& field,
+                            size_t index = 0) {
+  const uint8_t* ptr = static_cast<const uint8_t*>(data) + field.offset +
+                       index * GetFieldTypeSize(field.type);
+  switch (field.type) {
+    case FieldType::UINT8:
+      return *ptr;
+    case FieldType::INT8:
+      return static_cast<int8_t>(*ptr);
+    case FieldType::UINT16: {
+      uint16_t value;
+      std::memcpy(&value, ptr, sizeof(value));
+      return value;
+    }
+    case FieldType::INT16: {
+      int16_t value;
+      std::memcpy(&value, ptr, sizeof(value));
+      return value;
+    }
+    case FieldType::UINT32: {
+      uint32_t value;
+      std::memcpy(&value, ptr, sizeof(value));
+      return value;
+    }
+    case FieldType::INT32: {
+      int32_t value;
+      std::memcpy(&value, ptr, sizeof(value));
+      return value;
+    }
+    case FieldType::FLOAT: {
+      float value;
+      std::memcpy(&value, ptr, sizeof(value));
+      return value;
+    }
+    case FieldType::DOUBLE: {
+      double value;
+      std::memcpy(&value, ptr, sizeof(value));
+      return value;
+    }
+    case FieldType::TIMESTAMP:
+    default: {
+      Timestamp value;
+      std::memcpy(&value, ptr, sizeof(value));
+      if (value.seconds == Timestamp::INVALID ||
+          value.fraction_ns == Timestamp::INVALID) {
+        return NAN;
+      } else {
+        return value.seconds + (value.fraction_ns * 1e-9);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Runtime description of a message structure, for use when the message
+ *        type is not known at compile time.
+ */
+struct MessageDescriptor {
+  MessageType message_type;
+  const char* name;
+  size_t size_bytes;
+  const FieldDescriptor* fields;
+  size_t num_fields;
+};
+
+/** @} */
+
+// Helper macros used to define the reflection metadata below.
+#define P1_BEGIN_REFLECTION(struct_type, message_type)                    \
+  template <typename Dummy>                                               \
+  struct MessageReflection<struct_type, Dummy> {                          \
+    typedef struct_type Type;                                             \
+    static constexpr MessageType MESSAGE_TYPE = MessageType::message_type; \
+    static constexpr const char* NAME = #struct_type;                     \
+    static constexpr FieldDescriptor fields[] = {
+
+#define P1_FIELD(field, unit)                                              \
+  {#field, offsetof(Type, field),                                         \
+   detail::MemberFieldType<decltype(Type::field)>::value,                 \
+   std::extent<decltype(Type::field)>::value, unit},
+
+#define P1_END_REFLECTION(struct_type)                                     \
+  }                                                                        \
+  ;                                                                        \
+  static constexpr size_t NUM_FIELDS = sizeof(fields) / sizeof(fields[0]); \
+  }                                                                        \
+  ;                                                                        \
+  template <typename Dummy>                                                \
+  constexpr MessageType MessageReflection<struct_type, Dummy>::MESSAGE_TYPE; \
+  template <typename Dummy>                                                \
+  constexpr const char* MessageReflection<struct_type, Dummy>::NAME;      \
+  template <typename Dummy>                                                \
+  constexpr FieldDescriptor MessageReflection<struct_type, Dummy>::fields[]; \
+  template <typename Dummy>                                                \
+  constexpr size_t MessageReflection<struct_type, Dummy>::NUM_FIELDS;     \
+  static_assert(IsReflectionLayoutValid<struct_type>(),                    \
+                "Reflection metadata for " #struct_type                    \
+                " does not match the structure layout.");
+
+// clang-format off
+
+P1_BEGIN_REFLECTION(Timestamp, INVALID)
+  P1_FIELD(seconds, "s")
+  P1_FIELD(fraction_ns, "ns")
+P1_END_REFLECTION(Timestamp)
+
+P1_BEGIN_REFLECTION(MessageHeader, INVALID)
+  P1_FIELD(sync, "")
+  P1_FIELD(flags, "")
+  P1_FIELD(reserved, "")
+  P1_FIELD(crc, "")
+  P1_FIELD(protocol_version, "")
+  P1_FIELD(reserved_1, "")
+  P1_FIELD(message_type, "")
+  P1_FIELD(sequence_number, "")
+  P1_FIELD(payload_size_bytes, "B")
+  P1_FIELD(source_identifier, "")
+P1_END_REFLECTION(MessageHeader)
+
+P1_BEGIN_REFLECTION(PoseMessage, POSE)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(gps_time, "s")
+  P1_FIELD(solution_type, "")
+  P1_FIELD(reserved, "")
+  P1_FIELD(lla_deg, "deg,deg,m")
+  P1_FIELD(position_std_enu_m, "m")
+  P1_FIELD(ypr_deg, "deg")
+  P1_FIELD(ypr_std_deg, "deg")
+  P1_FIELD(velocity_body_mps, "m/s")
+  P1_FIELD(velocity_std_body_mps, "m/s")
+  P1_FIELD(aggregate_protection_level_m, "m")
+  P1_FIELD(horizontal_protection_level_m, "m")
+  P1_FIELD(vertical_protection_level_m, "m")
+P1_END_REFLECTION(PoseMessage)
+
+P1_BEGIN_REFLECTION(PoseAuxMessage, POSE_AUX)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(position_std_body_m, "m")
+  P1_FIELD(position_cov_enu_m2, "m^2")
+  P1_FIELD(attitude_quaternion, "")
+  P1_FIELD(velocity_enu_mps, "m/s")
+  P1_FIELD(velocity_std_enu_mps, "m/s")
+P1_END_REFLECTION(PoseAuxMessage)
+
+P1_BEGIN_REFLECTION(CompactPoseMessage, COMPACT_POSE)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(gps_time, "s")
+  P1_FIELD(solution_type, "")
+  P1_FIELD(presence_mask, "")
+  P1_FIELD(reserved, "")
+  P1_FIELD(latlon, "1e-7 deg")
+  P1_FIELD(altitude, "1e-3 m")
+  P1_FIELD(lla_hp, "1e-9 deg,1e-9 deg,1e-5 m")
+  P1_FIELD(reserved_1, "")
+  P1_FIELD(ypr, "180/32768 deg")
+  P1_FIELD(velocity_body, "1e-2 m/s")
+  P1_FIELD(position_std_enu, "1e-3 m")
+  P1_FIELD(ypr_std, "1e-3 deg")
+  P1_FIELD(velocity_std_body, "1e-3 m/s")
+  P1_FIELD(protection_levels, "1e-2 m")
+P1_END_REFLECTION(CompactPoseMessage)
+
+P1_BEGIN_REFLECTION(GNSSInfoMessage, GNSS_INFO)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(gps_time, "s")
+  P1_FIELD(last_differential_time, "s")
+  P1_FIELD(reference_station_id, "")
+  P1_FIELD(gdop, "")
+  P1_FIELD(pdop, "")
+  P1_FIELD(hdop, "")
+  P1_FIELD(vdop, "")
+  P1_FIELD(gps_time_std_sec, "s")
+P1_END_REFLECTION(GNSSInfoMessage)
+
+P1_BEGIN_REFLECTION(GNSSSatelliteMessage, GNSS_SATELLITE)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(gps_time, "s")
+  P1_FIELD(num_satellites, "")
+  P1_FIELD(reserved, "")
+P1_END_REFLECTION(GNSSSatelliteMessage)
+
+P1_BEGIN_REFLECTION(SatelliteInfo, INVALID)
+  P1_FIELD(system, "")
+  P1_FIELD(prn, "")
+  P1_FIELD(usage, "")
+  P1_FIELD(reserved, "")
+  P1_FIELD(azimuth_deg, "deg")
+  P1_FIELD(elevation_deg, "deg")
+P1_END_REFLECTION(SatelliteInfo)
+
+P1_BEGIN_REFLECTION(IMUMeasurement, IMU_MEASUREMENT)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(accel_mps2, "m/s^2")
+  P1_FIELD(accel_std_mps2, "m/s^2")
+  P1_FIELD(gyro_rps, "rad/s")
+  P1_FIELD(gyro_std_rps, "rad/s")
+P1_END_REFLECTION(IMUMeasurement)
+
+P1_BEGIN_REFLECTION(IMUMeasurementBatch, IMU_MEASUREMENT_BATCH)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(num_samples, "")
+  P1_FIELD(reserved, "")
+P1_END_REFLECTION(IMUMeasurementBatch)
+
+P1_BEGIN_REFLECTION(IMUBatchSample, INVALID)
+  P1_FIELD(time_offset_ns, "ns")
+  P1_FIELD(accel_mps2, "m/s^2")
+  P1_FIELD(accel_std_mps2, "m/s^2")
+  P1_FIELD(gyro_rps, "rad/s")
+  P1_FIELD(gyro_std_rps, "rad/s")
+P1_END_REFLECTION(IMUBatchSample)
+
+P1_BEGIN_REFLECTION(ros::PoseMessage, ROS_POSE)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(position_rel_m, "m")
+  P1_FIELD(orientation, "")
+P1_END_REFLECTION(ros::PoseMessage)
+
+P1_BEGIN_REFLECTION(ros::GPSFixMessage, ROS_GPS_FIX)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(latitude_deg, "deg")
+  P1_FIELD(longitude_deg, "deg")
+  P1_FIELD(altitude_m, "m")
+  P1_FIELD(track_deg, "deg")
+  P1_FIELD(speed_mps, "m/s")
+  P1_FIELD(climb_mps, "m/s")
+  P1_FIELD(pitch_deg, "deg")
+  P1_FIELD(roll_deg, "deg")
+  P1_FIELD(dip_deg, "deg")
+  P1_FIELD(gps_time, "s")
+  P1_FIELD(gdop, "")
+  P1_FIELD(pdop, "")
+  P1_FIELD(hdop, "")
+  P1_FIELD(vdop, "")
+  P1_FIELD(tdop, "")
+  P1_FIELD(err_3d_m, "m")
+  P1_FIELD(err_horiz_m, "m")
+  P1_FIELD(err_vert_m, "m")
+  P1_FIELD(err_track_deg, "deg")
+  P1_FIELD(err_speed_mps, "m/s")
+  P1_FIELD(err_climb_mps, "m/s")
+  P1_FIELD(err_time_sec, "s")
+  P1_FIELD(err_pitch_deg, "deg")
+  P1_FIELD(err_roll_deg, "deg")
+  P1_FIELD(err_dip_deg, "deg")
+  P1_FIELD(position_covariance_m2, "m^2")
+  P1_FIELD(position_covariance_type, "")
+  P1_FIELD(reserved, "")
+P1_END_REFLECTION(ros::GPSFixMessage)
+
+P1_BEGIN_REFLECTION(ros::IMUMessage, ROS_IMU)
+  P1_FIELD(p1_time, "s")
+  P1_FIELD(orientation, "")
+  P1_FIELD(orientation_covariance, "")
+  P1_FIELD(angular_velocity_rps, "rad/s")
+  P1_FIELD(angular_velocity_covariance, "(rad/s)^2")
+  P1_FIELD(acceleration_mps2, "m/s^2")
+  P1_FIELD(acceleration_covariance, "(m/s^2)^2")
+P1_END_REFLECTION(ros::IMUMessage)
+
+// clang-format on
+
+#undef P1_BEGIN_REFLECTION
+#undef P1_FIELD
+#undef P1_END_REFLECTION
+
+/**
+ * @brief Get a runtime description of a message structure.
+ * @ingroup reflection
+ *
+ * @tparam T The message structure type.
+ *
+ * @return The message description.
+ */
+template <typename T>
+constexpr MessageDescriptor GetMessageDescriptor() {
+  return MessageDescriptor{MessageReflection<T>::MESSAGE_TYPE,
+                           MessageReflection<T>::NAME, sizeof(T),
+                           MessageReflection<T>::fields,
+                           MessageReflection<T>::NUM_FIELDS};
+}
+
+/**
+ * @brief Get a runtime description of the payload structure for a message
+ *        type.
+ * @ingroup reflection
+ *
+ * @note
+ * For variable-length messages (e.g., @ref GNSSSatelliteMessage), this
+ * describes the fixed portion of the payload only.
+ *
+ * @param type The message type.
+ *
+ * @return The message description, or `nullptr` if the message type is not
+ *         recognized.
+ */
+inline const MessageDescriptor* GetMessageDescriptor(MessageType type) {
+  static const MessageDescriptor descriptors[] = {
+      GetMessageDescriptor<PoseMessage>(),
+      GetMessageDescriptor<PoseAuxMessage>(),
+      GetMessageDescriptor<CompactPoseMessage>(),
+      GetMessageDescriptor<GNSSInfoMessage>(),
+      GetMessageDescriptor<GNSSSatelliteMessage>(),
+      GetMessageDescriptor<IMUMeasurement>(),
+      GetMessageDescriptor<IMUMeasurementBatch>(),
+      GetMessageDescriptor<ros::PoseMessage>(),
+      GetMessageDescriptor<ros::GPSFixMessage>(),
+      GetMessageDescriptor<ros::IMUMessage>(),
+  };
+
+  for (const auto& descriptor : descriptors) {
+    if (descriptor.message_type == type) {
+      return &descriptor;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace messages
+} // namespace fusion_engine
+} // namespace point_one
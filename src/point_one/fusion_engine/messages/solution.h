@@ -159,6 +159,135 @@ struct PoseAuxMessage {
   float velocity_std_enu_mps[3] = {NAN, NAN, NAN};
 };
 
+/**
+ * @brief Quantized platform pose solution for low-bandwidth links (@ref
+ *        MessageType::COMPACT_POSE).
+ * @ingroup messages
+ *
+ * This message contains the same content as @ref PoseMessage, stored using
+ * fixed-point integers instead of floating point values. Rather than using
+ * `NAN` for unavailable values, the @ref presence_mask bitmask indicates which
+ * groups of fields are populated. Fields whose presence bit is cleared are set
+ * to 0 and must be ignored.
+ *
+ * Values are rounded to the nearest representable value. Velocity (+/-327.67
+ * m/s), standard deviations, and protection levels saturate at their maximum
+ * representable values. Angles are wrapped to [-180, 180) degrees.
+ *
+ * See @ref compact_pose_support for conversion to/from @ref PoseMessage.
+ */
+struct CompactPoseMessage {
+  /**
+   * @defgroup compact_pose_presence Bit definitions for the compact pose
+   *           presence bitmask (@ref CompactPoseMessage::presence_mask).
+   * @{
+   */
+  static constexpr uint8_t GPS_TIME_PRESENT = 0x01;
+  static constexpr uint8_t POSITION_PRESENT = 0x02;
+  static constexpr uint8_t POSITION_STD_PRESENT = 0x04;
+  static constexpr uint8_t ATTITUDE_PRESENT = 0x08;
+  static constexpr uint8_t ATTITUDE_STD_PRESENT = 0x10;
+  static constexpr uint8_t VELOCITY_PRESENT = 0x20;
+  static constexpr uint8_t VELOCITY_STD_PRESENT = 0x40;
+  static constexpr uint8_t PROTECTION_LEVELS_PRESENT = 0x80;
+  /** @} */
+
+  /**
+   * @name Field Scale Factors
+   * @{
+   */
+  /** Latitude/longitude resolution (in degrees). */
+  static constexpr double LATLON_SCALE_DEG = 1e-7;
+  /** Latitude/longitude high-resolution component scale (in degrees). */
+  static constexpr double LATLON_HP_SCALE_DEG = 1e-9;
+  /** Altitude resolution (in meters). */
+  static constexpr double ALTITUDE_SCALE_M = 1e-3;
+  /** Altitude high-resolution component scale (in meters). */
+  static constexpr double ALTITUDE_HP_SCALE_M = 1e-5;
+  /** Attitude angle resolution (in degrees): 180 / 2^15. */
+  static constexpr double ANGLE_SCALE_DEG = 180.0 / 32768.0;
+  /** Velocity resolution (in meters/second). */
+  static constexpr double VELOCITY_SCALE_MPS = 1e-2;
+  /** Position standard deviation resolution (in meters). */
+  static constexpr double POSITION_STD_SCALE_M = 1e-3;
+  /** Attitude standard deviation resolution (in degrees). */
+  static constexpr double ANGLE_STD_SCALE_DEG = 1e-3;
+  /** Velocity standard deviation resolution (in meters/second). */
+  static constexpr double VELOCITY_STD_SCALE_MPS = 1e-3;
+  /** Protection level resolution (in meters). */
+  static constexpr double PROTECTION_LEVEL_SCALE_M = 1e-2;
+  /** @} */
+
+  /** The time of the message, in P1 time (beginning at power-on). */
+  Timestamp p1_time;
+
+  /** The GPS time of the message, if available, referenced to 1980/1/6. */
+  Timestamp gps_time;
+
+  /** The type of this position solution. */
+  SolutionType solution_type = SolutionType::Invalid;
+
+  /**
+   * A bitmask indicating which fields are populated. See @ref
+   * compact_pose_presence.
+   */
+  uint8_t presence_mask = 0;
+
+  uint8_t reserved[2] = {0};
+
+  /**
+   * The geodetic latitude and longitude (in @ref LATLON_SCALE_DEG units). See
+   * @ref PoseMessage::lla_deg for datum considerations.
+   */
+  int32_t latlon[2] = {0, 0};
+
+  /** The altitude above the WGS-84 ellipsoid (in @ref ALTITUDE_SCALE_M units). */
+  int32_t altitude = 0;
+
+  /**
+   * High-resolution components of the latitude, longitude (in @ref
+   * LATLON_HP_SCALE_DEG units), and altitude (in @ref ALTITUDE_HP_SCALE_M
+   * units), in the range [-50, 50]. These are added to @ref latlon and @ref
+   * altitude to obtain the full precision position.
+   */
+  int8_t lla_hp[3] = {0, 0, 0};
+
+  uint8_t reserved_1 = 0;
+
+  /**
+   * The platform attitude (yaw, pitch, roll) (in @ref ANGLE_SCALE_DEG units).
+   * See @ref PoseMessage::ypr_deg.
+   */
+  int16_t ypr[3] = {0, 0, 0};
+
+  /**
+   * The platform velocity, resolved in the body frame (in @ref
+   * VELOCITY_SCALE_MPS units). Saturates at +/-327.67 m/s.
+   */
+  int16_t velocity_body[3] = {0, 0, 0};
+
+  /**
+   * The position standard deviation, resolved in the local ENU frame (in @ref
+   * POSITION_STD_SCALE_M units).
+   */
+  uint16_t position_std_enu[3] = {0, 0, 0};
+
+  /** The attitude standard deviation (in @ref ANGLE_STD_SCALE_DEG units). */
+  uint16_t ypr_std[3] = {0, 0, 0};
+
+  /**
+   * The velocity standard deviation, resolved in the body frame (in @ref
+   * VELOCITY_STD_SCALE_MPS units).
+   */
+  uint16_t velocity_std_body[3] = {0, 0, 0};
+
+  /**
+   * The aggregate 3D, horizontal, and vertical protection levels (in @ref
+   * PROTECTION_LEVEL_SCALE_M units).
+   */
+  uint16_t protection_levels[3] = {0, 0, 0};
+};
+
 /**
  * @brief Information about the GNSS data used in the @ref PoseMessage with the
  *        corresponding timestamp (@ref MessageType::GNSS_INFO).
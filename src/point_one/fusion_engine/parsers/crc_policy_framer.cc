@@ -0,0 +1,225 @@
+/**************************************************************************/ /**
+ * @brief FusionEngine framer with a configurable CRC verification policy.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/parsers/crc_policy_framer.h"
+
+#include <algorithm> // For min()
+#include <chrono>
+#include <cstring> // For memcpy()
+
+#include "point_one/fusion_engine/messages/crc.h"
+
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::parsers;
+
+namespace {
+
+/******************************************************************************/
+size_t GetMessageSize(const uint8_t* message) {
+  const MessageHeader& header =
+      *reinterpret_cast<const MessageHeader*>(message);
+  return sizeof(MessageHeader) + static_cast<size_t>(header.payload_size_bytes);
+}
+
+/******************************************************************************/
+// Deferred messages are stored back to back. Round each one up to a multiple
+// of 4 bytes so the following message header stays aligned.
+size_t GetPaddedSize(size_t size_bytes) {
+  return (size_bytes + 3) & ~size_t(3);
+}
+
+// The background thread waits briefly for this much data to be queued before
+// verifying it, so it is not woken up for every message.
+constexpr size_t DEFERRED_BATCH_SIZE_BYTES = 64 * 1024;
+constexpr std::chrono::milliseconds DEFERRED_BATCH_TIMEOUT(1);
+
+/******************************************************************************/
+// Counters written only by the framing thread do not need an atomic
+// read-modify-write.
+void Increment(std::atomic<uint64_t>& counter) {
+  counter.store(counter.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+}
+
+} // namespace
+
+/******************************************************************************/
+CRCPolicyFramer::CRCPolicyFramer(size_t capacity_bytes, const Config& config)
+    : FusionEngineFramer(capacity_bytes),
+      config_(config),
+      batch_size_bytes_(std::min(DEFERRED_BATCH_SIZE_BYTES,
+                                 config.max_deferred_bytes / 2)),
+      messages_verified_(0),
+      messages_skipped_(0),
+      messages_deferred_(0),
+      deferred_overflows_(0) {
+  if (config_.policy == CRCPolicy::DEFERRED) {
+    thread_ = std::thread(&CRCPolicyFramer::Run, this);
+  }
+}
+
+/******************************************************************************/
+CRCPolicyFramer::~CRCPolicyFramer() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    queue_cv_.notify_one();
+    thread_.join();
+  }
+}
+
+/******************************************************************************/
+void CRCPolicyFramer::SetLateFailureCallback(LateFailureCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  late_failure_callback_ = std::move(callback);
+}
+
+/******************************************************************************/
+void CRCPolicyFramer::Reset() {
+  FusionEngineFramer::Reset();
+
+  // The base statistics were cleared, so resynchronization can no longer be
+  // detected by comparing the discarded byte count. The new stream starts
+  // unverified, just like a newly constructed framer.
+  last_bytes_discarded_ = 0;
+  verify_next_ = true;
+  messages_since_verify_ = 0;
+}
+
+/******************************************************************************/
+void CRCPolicyFramer::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] {
+    return deferred_verified_ == messages_deferred_.load();
+  });
+}
+
+/******************************************************************************/
+CRCPolicyFramer::VerificationStatistics
+CRCPolicyFramer::GetVerificationStatistics() const {
+  VerificationStatistics stats;
+  stats.messages_verified = messages_verified_.load();
+  stats.messages_skipped = messages_skipped_.load();
+  stats.messages_deferred = messages_deferred_.load();
+  stats.deferred_overflows = deferred_overflows_.load();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.deferred_verified = deferred_verified_;
+  stats.deferred_failures = deferred_failures_;
+  return stats;
+}
+
+/******************************************************************************/
+bool CRCPolicyFramer::ValidateMessage(const uint8_t* message) {
+  // If any data was discarded since the last message (including a message that
+  // failed verification), we just resynchronized and cannot trust the framing.
+  // Always verify the next message.
+  uint64_t bytes_discarded = GetStatistics().bytes_discarded;
+  if (bytes_discarded != last_bytes_discarded_) {
+    last_bytes_discarded_ = bytes_discarded;
+    verify_next_ = true;
+  }
+
+  if (verify_next_ || config_.policy == CRCPolicy::ALWAYS) {
+    return Verify(message);
+  } else if (config_.policy == CRCPolicy::SAMPLED) {
+    if (++messages_since_verify_ >= config_.sample_interval) {
+      return Verify(message);
+    } else {
+      Increment(messages_skipped_);
+      return true;
+    }
+  } else {
+    return Defer(message);
+  }
+}
+
+/******************************************************************************/
+bool CRCPolicyFramer::Verify(const uint8_t* message) {
+  Increment(messages_verified_);
+  messages_since_verify_ = 0;
+  verify_next_ = !IsValid(message);
+  return !verify_next_;
+}
+
+/******************************************************************************/
+bool CRCPolicyFramer::Defer(const uint8_t* message) {
+  size_t size_bytes = GetMessageSize(message);
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t offset = pending_.size();
+    size_t padded_size_bytes = GetPaddedSize(size_bytes);
+    if (offset + padded_size_bytes <= config_.max_deferred_bytes) {
+      pending_.resize(offset + padded_size_bytes);
+      std::memcpy(pending_.data() + offset, message, size_bytes);
+      Increment(messages_deferred_);
+      message = nullptr;
+
+      // Only wake the background thread when the queue is no longer empty, or
+      // when a full batch is ready.
+      notify = worker_waiting_ &&
+               (offset == 0 || (offset < batch_size_bytes_ &&
+                                pending_.size() >= batch_size_bytes_));
+    }
+  }
+
+  if (message == nullptr) {
+    if (notify) {
+      queue_cv_.notify_one();
+    }
+    return true;
+  } else {
+    Increment(deferred_overflows_);
+    return Verify(message);
+  }
+}
+
+/******************************************************************************/
+void CRCPolicyFramer::Run() {
+  // Swap the pending queue with an empty buffer, then verify its contents
+  // without holding the lock so the framing thread is not blocked.
+  std::vector<uint8_t> batch;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    worker_waiting_ = true;
+    queue_cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      break;
+    }
+
+    // Give the framing thread a chance to queue a full batch.
+    queue_cv_.wait_for(lock, DEFERRED_BATCH_TIMEOUT, [this] {
+      return stopping_ || pending_.size() >= batch_size_bytes_;
+    });
+    worker_waiting_ = false;
+
+    batch.swap(pending_);
+    LateFailureCallback callback = late_failure_callback_;
+    lock.unlock();
+
+    uint64_t num_verified = 0;
+    uint64_t num_failures = 0;
+    for (size_t offset = 0; offset < batch.size();) {
+      const uint8_t* message = batch.data() + offset;
+      if (!IsValid(message)) {
+        ++num_failures;
+        if (callback) {
+          callback(*reinterpret_cast<const MessageHeader*>(message));
+        }
+      }
+      ++num_verified;
+      offset += GetPaddedSize(GetMessageSize(message));
+    }
+    batch.clear();
+
+    lock.lock();
+    deferred_verified_ += num_verified;
+    deferred_failures_ += num_failures;
+    done_cv_.notify_all();
+  }
+}
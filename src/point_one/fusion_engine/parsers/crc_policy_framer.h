@@ -0,0 +1,243 @@
+/**************************************************************************/ /**
+ * @brief FusionEngine framer with a configurable CRC verification policy.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef> // For size_t
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/parsers/fusion_engine_framer.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace parsers {
+
+/**
+ * @addtogroup parsers
+ * @{
+ */
+
+/**
+ * @brief CRC verification policy for a @ref CRCPolicyFramer.
+ */
+enum class CRCPolicy : uint8_t {
+  /** Verify the CRC of every message before dispatching it. */
+  ALWAYS = 0,
+  /**
+   * Verify the CRC of 1 out of every @ref CRCPolicyFramer::Config
+   * "sample_interval" messages. Other messages are dispatched without being
+   * checked.
+   */
+  SAMPLED = 1,
+  /**
+   * Dispatch messages immediately, and verify their CRCs on a background
+   * thread. Failures are reported after the message has been dispatched,
+   * typically within a few milliseconds.
+   */
+  DEFERRED = 2,
+};
+
+/**
+ * @brief Get a human-friendly string name for the specified @ref CRCPolicy.
+ *
+ * @param policy The desired policy.
+ *
+ * @return The corresponding string name.
+ */
+inline std::string to_string(CRCPolicy policy) {
+  switch (policy) {
+    case CRCPolicy::ALWAYS:
+      return "Always";
+    case CRCPolicy::SAMPLED:
+      return "Sampled";
+    case CRCPolicy::DEFERRED:
+      return "Deferred";
+    default:
+      return "Unrecognized Policy (" + std::to_string((int)policy) + ")";
+  }
+}
+
+/**
+ * @brief Frame FusionEngine messages, with reduced CRC verification for trusted
+ *        transports.
+ *
+ * On transports that cannot corrupt data (e.g., shared memory or loopback
+ * sockets within one machine), verifying the CRC of every message is wasted
+ * work. This class frames messages exactly like @ref FusionEngineFramer, but
+ * applies a @ref CRCPolicy to decide which messages are verified, and when.
+ * Each input source should use its own framer instance, so the policy may be
+ * chosen per source: e.g., @ref CRCPolicy::ALWAYS for a serial port and @ref
+ * CRCPolicy::SAMPLED for a local IPC channel.
+ *
+ * To make sure framing errors are not hidden, the first message, and the first
+ * message after any discarded data (i.e., after resynchronizing), are always
+ * verified before being dispatched, regardless of the policy.
+ *
+ * ```{.cpp}
+ * CRCPolicyFramer::Config config;
+ * config.policy = CRCPolicy::DEFERRED;
+ * CRCPolicyFramer framer(1024, config);
+ * framer.SetMessageCallback(...);
+ * framer.SetLateFailureCallback([](const MessageHeader& header) {
+ *   ...
+ * });
+ * framer.OnData(buffer, num_bytes);
+ * ```
+ */
+class P1_EXPORT CRCPolicyFramer : public FusionEngineFramer {
+ public:
+  struct Config {
+    /** The CRC verification policy. */
+    CRCPolicy policy = CRCPolicy::ALWAYS;
+
+    /**
+     * For @ref CRCPolicy::SAMPLED, the number of messages per verified
+     * message. Values of 0 or 1 verify every message.
+     */
+    uint32_t sample_interval = 16;
+
+    /**
+     * For @ref CRCPolicy::DEFERRED, the maximum number of bytes waiting to be
+     * verified. If the background thread falls behind, messages are verified
+     * immediately instead.
+     */
+    size_t max_deferred_bytes = 1 << 20;
+  };
+
+  /**
+   * @brief Verification counters.
+   */
+  struct VerificationStatistics {
+    /**
+     * The number of messages verified before being dispatched. Messages that
+     * failed are also counted in @ref Statistics::crc_failures.
+     */
+    uint64_t messages_verified = 0;
+    /** The number of messages dispatched without verification (sampled). */
+    uint64_t messages_skipped = 0;
+    /** The number of messages queued for background verification. */
+    uint64_t messages_deferred = 0;
+    /** The number of deferred messages that have been verified. */
+    uint64_t deferred_verified = 0;
+    /** The number of deferred messages that failed verification. */
+    uint64_t deferred_failures = 0;
+    /**
+     * The number of messages verified immediately because the deferred queue
+     * was full.
+     */
+    uint64_t deferred_overflows = 0;
+  };
+
+  /**
+   * @brief Callback invoked for each deferred message that failed
+   *        verification, after it was already dispatched.
+   *
+   * @note
+   * This function is called from the background verification thread.
+   *
+   * @param header The message header.
+   */
+  typedef std::function<void(const messages::MessageHeader& header)>
+      LateFailureCallback;
+
+  /**
+   * @brief Construct a framer that verifies every message.
+   *
+   * @param capacity_bytes The maximum message size (header + payload) that can
+   *        be framed, in bytes.
+   */
+  explicit CRCPolicyFramer(size_t capacity_bytes)
+      : CRCPolicyFramer(capacity_bytes, Config()) {}
+
+  /**
+   * @brief Construct a framer with the specified verification policy.
+   *
+   * @param capacity_bytes The maximum message size (header + payload) that can
+   *        be framed, in bytes.
+   * @param config The verification configuration.
+   */
+  CRCPolicyFramer(size_t capacity_bytes, const Config& config);
+
+  /**
+   * @brief Destructor. Any deferred messages are verified before returning.
+   */
+  ~CRCPolicyFramer() override;
+
+  /**
+   * @brief Get the verification configuration.
+   */
+  const Config& GetConfig() const { return config_; }
+
+  /**
+   * @brief Set the function to be called for each deferred message that fails
+   *        verification.
+   *
+   * @param callback The callback function.
+   */
+  void SetLateFailureCallback(LateFailureCallback callback);
+
+  /**
+   * @brief Discard any buffered data and reset the stream offset and
+   *        statistics. The next message is always verified.
+   */
+  void Reset() override;
+
+  /**
+   * @brief Wait until all deferred messages have been verified.
+   */
+  void Flush();
+
+  /**
+   * @brief Get the current verification counters.
+   */
+  VerificationStatistics GetVerificationStatistics() const;
+
+ protected:
+  bool ValidateMessage(const uint8_t* message) override;
+
+ private:
+  bool Verify(const uint8_t* message);
+  bool Defer(const uint8_t* message);
+  void Run();
+
+  Config config_;
+  size_t batch_size_bytes_;
+
+  uint64_t last_bytes_discarded_ = 0;
+  bool verify_next_ = true;
+  uint32_t messages_since_verify_ = 0;
+
+  // Counters updated by the framing thread. These may be read from any thread.
+  std::atomic<uint64_t> messages_verified_;
+  std::atomic<uint64_t> messages_skipped_;
+  std::atomic<uint64_t> messages_deferred_;
+  std::atomic<uint64_t> deferred_overflows_;
+
+  // Guards the deferred queue and the state below.
+  mutable std::mutex mutex_;
+  std::condition_variable queue_cv_;
+  std::condition_variable done_cv_;
+  std::vector<uint8_t> pending_;
+  uint64_t deferred_verified_ = 0;
+  uint64_t deferred_failures_ = 0;
+  bool worker_waiting_ = false;
+  LateFailureCallback late_failure_callback_;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+/** @} */
+
+} // namespace parsers
+} // namespace fusion_engine
+} // namespace point_one
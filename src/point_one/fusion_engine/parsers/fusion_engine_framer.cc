@@ -0,0 +1,153 @@
+/**************************************************************************/ /**
+ * @brief Utility class for framing FusionEngine messages from a byte stream.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/parsers/fusion_engine_framer.h"
+
+#include <cstring> // For memcpy(), memmove()
+
+#include "point_one/fusion_engine/messages/crc.h"
+
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::parsers;
+
+/******************************************************************************/
+FusionEngineFramer::FusionEngineFramer(size_t capacity_bytes) {
+  // The buffer must be able to hold at least a complete header. Otherwise,
+  // OnData() would never be able to make progress.
+  if (capacity_bytes < sizeof(MessageHeader)) {
+    capacity_bytes = sizeof(MessageHeader);
+  }
+
+  // Note: Allocating 64-bit words to guarantee the alignment of the start of the
+  // buffer.
+  size_t num_words = (capacity_bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  buffer_ = reinterpret_cast<uint8_t*>(new uint64_t[num_words]);
+  capacity_bytes_ = num_words * sizeof(uint64_t);
+}
+
+/******************************************************************************/
+FusionEngineFramer::~FusionEngineFramer() {
+  delete[] reinterpret_cast<uint64_t*>(buffer_);
+}
+
+/******************************************************************************/
+void FusionEngineFramer::Reset() {
+  buffered_bytes_ = 0;
+  buffer_offset_bytes_ = 0;
+  stats_ = Statistics();
+}
+
+/******************************************************************************/
+size_t FusionEngineFramer::OnData(const void* buffer, size_t length_bytes) {
+  const uint8_t* data = static_cast<const uint8_t*>(buffer);
+  size_t dispatch_count = 0;
+  while (length_bytes > 0) {
+    size_t copy_size = capacity_bytes_ - buffered_bytes_;
+    if (copy_size > length_bytes) {
+      copy_size = length_bytes;
+    }
+
+    std::memcpy(buffer_ + buffered_bytes_, data, copy_size);
+    buffered_bytes_ += copy_size;
+    data += copy_size;
+    length_bytes -= copy_size;
+
+    dispatch_count += ProcessBuffer();
+  }
+
+  return dispatch_count;
+}
+
+/******************************************************************************/
+bool FusionEngineFramer::ValidateMessage(const uint8_t* message) {
+  return IsValid(message);
+}
+
+/******************************************************************************/
+size_t FusionEngineFramer::ProcessBuffer() {
+  size_t dispatch_count = 0;
+  size_t offset = 0;
+  while (offset < buffered_bytes_) {
+    // Search for the sync bytes. If the last byte in the buffer is SYNC0, keep
+    // it since the next byte may be SYNC1.
+    const uint8_t* sync = static_cast<const uint8_t*>(
+        std::memchr(buffer_ + offset, MessageHeader::SYNC0,
+                    buffered_bytes_ - offset));
+    if (sync == nullptr) {
+      stats_.bytes_discarded += buffered_bytes_ - offset;
+      offset = buffered_bytes_;
+      break;
+    }
+
+    size_t sync_offset = static_cast<size_t>(sync - buffer_);
+    stats_.bytes_discarded += sync_offset - offset;
+    offset = sync_offset;
+    if (offset + 1 >= buffered_bytes_) {
+      break;
+    } else if (buffer_[offset + 1] != MessageHeader::SYNC1) {
+      ++stats_.bytes_discarded;
+      ++offset;
+      continue;
+    }
+
+    // Messages are normally a multiple of 4 bytes long, so they will stay
+    // aligned within the buffer. If we resynchronized on an unaligned byte,
+    // shift the remaining data to the start of the buffer.
+    if ((offset & 0x3) != 0) {
+      std::memmove(buffer_, buffer_ + offset, buffered_bytes_ - offset);
+      buffered_bytes_ -= offset;
+      buffer_offset_bytes_ += offset;
+      offset = 0;
+    }
+
+    // Wait for the complete header.
+    size_t available_bytes = buffered_bytes_ - offset;
+    if (available_bytes < sizeof(MessageHeader)) {
+      break;
+    }
+
+    const MessageHeader& header =
+        *reinterpret_cast<const MessageHeader*>(buffer_ + offset);
+    size_t message_size_bytes =
+        sizeof(MessageHeader) + static_cast<size_t>(header.payload_size_bytes);
+    if (message_size_bytes > capacity_bytes_ ||
+        message_size_bytes > MessageHeader::MAX_MESSAGE_SIZE_BYTES) {
+      ++stats_.oversized_messages;
+      ++stats_.bytes_discarded;
+      ++offset;
+      continue;
+    }
+
+    // Wait for the complete payload.
+    if (available_bytes < message_size_bytes) {
+      break;
+    }
+
+    if (ValidateMessage(buffer_ + offset)) {
+      ++stats_.messages_decoded;
+      ++dispatch_count;
+      if (callback_) {
+        callback_(header, buffer_ + offset + sizeof(MessageHeader),
+                  buffer_offset_bytes_ + offset);
+      }
+      offset += message_size_bytes;
+    } else {
+      ++stats_.crc_failures;
+      ++stats_.bytes_discarded;
+      ++offset;
+    }
+  }
+
+  // Move any remaining data to the front of the buffer.
+  if (offset > 0) {
+    if (offset < buffered_bytes_) {
+      std::memmove(buffer_, buffer_ + offset, buffered_bytes_ - offset);
+    }
+    buffered_bytes_ -= offset;
+    buffer_offset_bytes_ += offset;
+  }
+
+  return dispatch_count;
+}
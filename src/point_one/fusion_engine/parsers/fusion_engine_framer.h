@@ -0,0 +1,170 @@
+/**************************************************************************/ /**
+ * @brief Utility class for framing FusionEngine messages from a byte stream.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef> // For size_t
+#include <cstdint>
+#include <functional>
+#include <utility> // For std::move()
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/defs.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace parsers {
+
+/**
+ * @defgroup parsers Message Parsing Support
+ * @brief Utilities for extracting messages from incoming byte streams.
+ * @{
+ */
+
+/**
+ * @brief Frame and validate incoming FusionEngine messages.
+ *
+ * This class locates FusionEngine messages within a stream of bytes (e.g., a
+ * serial port, socket, or file), validates their CRCs, and calls a user
+ * callback for each complete message. Data that is not part of a valid message
+ * is discarded, and the framer automatically resynchronizes after corrupted or
+ * truncated messages.
+ *
+ * ```{.cpp}
+ * FusionEngineFramer framer(1024);
+ * framer.SetMessageCallback(
+ *     [](const MessageHeader& header, const void* payload, uint64_t offset) {
+ *       ...
+ *     });
+ * framer.OnData(buffer, num_bytes);
+ * ```
+ *
+ * The message header and payload passed to the callback are guaranteed to be
+ * 4-byte aligned, and are valid only for the duration of the callback.
+ */
+class P1_EXPORT FusionEngineFramer {
+ public:
+  /**
+   * @brief Callback invoked for each valid message.
+   *
+   * @param header The message header.
+   * @param payload A pointer to the message payload.
+   * @param offset_bytes The offset of the start of the message within the
+   *        stream (in bytes), counting all bytes passed to @ref OnData() since
+   *        construction or the last call to @ref Reset().
+   */
+  typedef std::function<void(const messages::MessageHeader& header,
+                             const void* payload, uint64_t offset_bytes)>
+      MessageCallback;
+
+  /**
+   * @brief Framer statistics.
+   */
+  struct Statistics {
+    /** The number of valid messages dispatched. */
+    uint64_t messages_decoded = 0;
+    /** The number of candidate messages that failed CRC validation. */
+    uint64_t crc_failures = 0;
+    /** The number of candidate messages whose size exceeded the buffer. */
+    uint64_t oversized_messages = 0;
+    /** The number of bytes discarded while searching for valid messages. */
+    uint64_t bytes_discarded = 0;
+  };
+
+  /**
+   * @brief Construct a framer with an internally allocated buffer.
+   *
+   * @param capacity_bytes The maximum message size (header + payload) that can
+   *        be framed, in bytes. Note that a corrupted header may claim a
+   *        payload up to this size, delaying resynchronization until that much
+   *        data has been received. Values smaller than a @ref
+   *        messages::MessageHeader are increased to the header size.
+   */
+  explicit FusionEngineFramer(size_t capacity_bytes);
+
+  virtual ~FusionEngineFramer();
+
+  FusionEngineFramer(const FusionEngineFramer&) = delete;
+  FusionEngineFramer& operator=(const FusionEngineFramer&) = delete;
+
+  /**
+   * @brief Set the function to be called for each valid message.
+   *
+   * @param callback The callback function.
+   */
+  void SetMessageCallback(MessageCallback callback) {
+    callback_ = std::move(callback);
+  }
+
+  /**
+   * @brief Process incoming data.
+   *
+   * @param buffer A buffer containing the incoming data.
+   * @param length_bytes The number of bytes in `buffer`.
+   *
+   * @return The number of complete messages dispatched.
+   */
+  size_t OnData(const void* buffer, size_t length_bytes);
+
+  /**
+   * @brief Discard any buffered data and reset the stream offset and
+   *        statistics.
+   *
+   * Derived classes that track per-stream state should override this function
+   * and call the base implementation.
+   */
+  virtual void Reset();
+
+  /**
+   * @brief Get the number of bytes currently buffered (i.e., a partial message
+   *        waiting for more data).
+   */
+  size_t GetBufferedBytes() const { return buffered_bytes_; }
+
+  /**
+   * @brief Get the total number of bytes passed to @ref OnData().
+   */
+  uint64_t GetStreamOffset() const {
+    return buffer_offset_bytes_ + buffered_bytes_;
+  }
+
+  /**
+   * @brief Get the current framer statistics.
+   */
+  const Statistics& GetStatistics() const { return stats_; }
+
+ protected:
+  /**
+   * @brief Check if a complete candidate message is valid.
+   *
+   * The default implementation verifies the CRC. Derived classes may override
+   * this to change the verification policy.
+   *
+   * @param message A 4-byte aligned buffer containing the header and payload.
+   *
+   * @return `true` if the message should be dispatched.
+   */
+  virtual bool ValidateMessage(const uint8_t* message);
+
+ private:
+  size_t ProcessBuffer();
+
+  MessageCallback callback_;
+
+  uint8_t* buffer_ = nullptr;
+  size_t capacity_bytes_ = 0;
+  size_t buffered_bytes_ = 0;
+
+  /** The stream offset of `buffer_[0]`. */
+  uint64_t buffer_offset_bytes_ = 0;
+
+  Statistics stats_;
+};
+
+/** @} */
+
+} // namespace parsers
+} // namespace fusion_engine
+} // namespace point_one
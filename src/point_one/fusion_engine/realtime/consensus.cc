@@ -0,0 +1,374 @@
+/**************************************************************************/ /**
+ * @brief Consensus position from multiple time-aligned receivers.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/realtime/consensus.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+using namespace point_one::fusion_engine::geodesy;
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::realtime;
+
+namespace {
+/******************************************************************************/
+Timestamp ToTimestamp(double p1_time_sec) {
+  Timestamp result;
+  double seconds = std::floor(p1_time_sec);
+  int64_t fraction_ns =
+      static_cast<int64_t>(std::round((p1_time_sec - seconds) * 1e9));
+  if (fraction_ns >= 1000000000) {
+    seconds += 1.0;
+    fraction_ns -= 1000000000;
+  }
+  result.seconds = static_cast<uint32_t>(seconds);
+  result.fraction_ns = static_cast<uint32_t>(fraction_ns);
+  return result;
+}
+} // namespace
+
+/******************************************************************************/
+PoseConsensus::PoseConsensus(const Config& config) : config_(config) {
+  config_.history_size = std::max<size_t>(config_.history_size, 2);
+  if (!(config_.epoch_interval_sec > 0.0)) {
+    config_.epoch_interval_sec = 0.1;
+  }
+  receivers_.reserve(config_.max_receivers);
+  samples_.reserve(config_.max_receivers);
+  observations_.reserve(config_.max_receivers);
+  result_.receivers.reserve(config_.max_receivers);
+}
+
+/******************************************************************************/
+void PoseConsensus::OnMessage(const MessageHeader& header,
+                              const void* payload) {
+  if (header.message_type == MessageType::POSE &&
+      header.payload_size_bytes >= sizeof(PoseMessage)) {
+    PoseMessage pose;
+    std::memcpy(&pose, payload, sizeof(pose));
+    OnPose(header.source_identifier, pose);
+  }
+}
+
+/******************************************************************************/
+void PoseConsensus::OnPose(uint32_t source_identifier,
+                           const PoseMessage& pose) {
+  if (pose.solution_type == SolutionType::Invalid ||
+      pose.p1_time.seconds == Timestamp::INVALID ||
+      pose.p1_time.fraction_ns == Timestamp::INVALID) {
+    return;
+  }
+
+  double p1_time_sec = pose.p1_time.seconds + (pose.p1_time.fraction_ns * 1e-9);
+  AddPosition(source_identifier, p1_time_sec, pose.lla_deg,
+              pose.position_std_enu_m);
+}
+
+/******************************************************************************/
+void PoseConsensus::AddPosition(uint32_t source_identifier,
+                                double p1_time_sec, const double lla_deg[3],
+                                const float position_std_enu_m[3]) {
+  if (std::isnan(p1_time_sec) || std::isnan(lla_deg[0]) ||
+      std::isnan(lla_deg[1]) || std::isnan(lla_deg[2])) {
+    return;
+  }
+
+  Receiver* receiver = GetReceiver(source_identifier);
+  if (receiver == nullptr ||
+      (receiver->count > 0 &&
+       p1_time_sec <= receiver->GetNewest().p1_time_sec)) {
+    return;
+  }
+
+  if (receiver->count > 0) {
+    receiver->newest = (receiver->newest + 1) % receiver->samples.size();
+  }
+  receiver->count = std::min(receiver->count + 1, receiver->samples.size());
+
+  Sample& sample = receiver->samples[receiver->newest];
+  sample.p1_time_sec = p1_time_sec;
+  std::memcpy(sample.lla_deg, lla_deg, sizeof(sample.lla_deg));
+  for (int i = 0; i < 3; ++i) {
+    double std_m = std::isnan(position_std_enu_m[i]) ? config_.default_std_m
+                                                     : position_std_enu_m[i];
+    sample.std_enu_m[i] = std::max(std_m, config_.min_std_m);
+  }
+
+  if (!started_) {
+    next_epoch_index_ = static_cast<int64_t>(
+        std::ceil(p1_time_sec / config_.epoch_interval_sec));
+    started_ = true;
+  }
+
+  ProcessEpochs(false);
+}
+
+/******************************************************************************/
+void PoseConsensus::Flush() { ProcessEpochs(true); }
+
+/******************************************************************************/
+void PoseConsensus::Reset() {
+  receivers_.clear();
+  started_ = false;
+  next_epoch_index_ = 0;
+  have_result_ = false;
+}
+
+/******************************************************************************/
+PoseConsensus::Receiver* PoseConsensus::GetReceiver(
+    uint32_t source_identifier) {
+  // The number of receivers is small, so a linear search is fastest.
+  for (Receiver& receiver : receivers_) {
+    if (receiver.source_identifier == source_identifier) {
+      return &receiver;
+    }
+  }
+
+  if (receivers_.size() >= config_.max_receivers) {
+    return nullptr;
+  }
+
+  receivers_.emplace_back();
+  Receiver& receiver = receivers_.back();
+  receiver.source_identifier = source_identifier;
+  receiver.samples.resize(config_.history_size);
+  return &receiver;
+}
+
+/******************************************************************************/
+void PoseConsensus::ProcessEpochs(bool flush) {
+  while (true) {
+    double epoch_sec = next_epoch_index_ * config_.epoch_interval_sec;
+
+    // Wait until every active receiver has reported a pose at or after the
+    // epoch, or until the latency limit is reached.
+    double newest_sec = -INFINITY;
+    double active_sec = epoch_sec - config_.max_interpolation_gap_sec;
+    bool waiting = false;
+    for (const Receiver& receiver : receivers_) {
+      if (receiver.count == 0) {
+        continue;
+      }
+
+      double receiver_newest_sec = receiver.GetNewest().p1_time_sec;
+      newest_sec = std::max(newest_sec, receiver_newest_sec);
+      if (receiver_newest_sec < epoch_sec &&
+          receiver_newest_sec >= active_sec) {
+        waiting = true;
+      }
+    }
+
+    if (newest_sec < epoch_sec ||
+        (waiting && !flush &&
+         newest_sec < epoch_sec + config_.max_latency_sec)) {
+      break;
+    }
+
+    ++next_epoch_index_;
+    if (ComputeEpoch(epoch_sec) == 0) {
+      // No receiver covers this epoch (i.e., there is a gap in the data). Skip
+      // ahead to the next available pose rather than stepping through every
+      // epoch in the gap.
+      double next_sec = INFINITY;
+      for (const Receiver& receiver : receivers_) {
+        for (size_t age = 0; age < receiver.count; ++age) {
+          double sample_sec = receiver.GetFromNewest(age).p1_time_sec;
+          if (sample_sec <= epoch_sec) {
+            break;
+          }
+          next_sec = std::min(next_sec, sample_sec);
+        }
+      }
+
+      if (std::isfinite(next_sec)) {
+        next_epoch_index_ = std::max(
+            next_epoch_index_,
+            static_cast<int64_t>(
+                std::ceil(next_sec / config_.epoch_interval_sec)));
+      }
+    }
+  }
+}
+
+/******************************************************************************/
+bool PoseConsensus::Interpolate(const Receiver& receiver, double p1_time_sec,
+                                Sample* result) const {
+  // Search backward from the newest pose; epochs are normally close to the
+  // end of the history.
+  for (size_t age = 0; age < receiver.count; ++age) {
+    const Sample& before = receiver.GetFromNewest(age);
+    if (before.p1_time_sec == p1_time_sec) {
+      *result = before;
+      return true;
+    } else if (before.p1_time_sec < p1_time_sec) {
+      if (age == 0) {
+        return false;
+      }
+
+      const Sample& after = receiver.GetFromNewest(age - 1);
+      double dt_sec = after.p1_time_sec - before.p1_time_sec;
+      if (dt_sec > config_.max_interpolation_gap_sec) {
+        return false;
+      }
+
+      double alpha = (p1_time_sec - before.p1_time_sec) / dt_sec;
+      result->p1_time_sec = p1_time_sec;
+      for (int i = 0; i < 3; ++i) {
+        double delta = after.lla_deg[i] - before.lla_deg[i];
+        if (i == 1) {
+          // Interpolate across the antimeridian, not around the globe.
+          delta = WrapLongitudeDeg(delta);
+        }
+        result->lla_deg[i] = before.lla_deg[i] + alpha * delta;
+        result->std_enu_m[i] =
+            before.std_enu_m[i] +
+            alpha * (after.std_enu_m[i] - before.std_enu_m[i]);
+      }
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/******************************************************************************/
+size_t PoseConsensus::ComputeEpoch(double p1_time_sec) {
+  samples_.clear();
+  observations_.clear();
+  for (size_t i = 0; i < receivers_.size(); ++i) {
+    Sample sample;
+    if (Interpolate(receivers_[i], p1_time_sec, &sample)) {
+      samples_.push_back(sample);
+      Observation observation;
+      observation.receiver_index = i;
+      observation.used = true;
+      observations_.push_back(observation);
+    }
+  }
+
+  size_t num_observations = observations_.size();
+  if (num_observations == 0 ||
+      num_observations < config_.min_receivers) {
+    return num_observations;
+  }
+
+  // Express the positions in a local ENU frame centered on the first receiver.
+  // Receivers on the same platform are close together, so the radii of
+  // curvature at the reference position are sufficient. Longitude differences
+  // are wrapped so receivers on either side of the antimeridian are adjacent.
+  const double* reference_lla_deg = samples_[0].lla_deg;
+  double meridian_radius_m, prime_vertical_radius_m;
+  geodesy::GetRadiiOfCurvature(reference_lla_deg[0], &meridian_radius_m,
+                               &prime_vertical_radius_m);
+  double scale_east = prime_vertical_radius_m *
+                      std::cos(reference_lla_deg[0] * DEG_TO_RAD) *
+                      DEG_TO_RAD;
+  double scale_north = meridian_radius_m * DEG_TO_RAD;
+  for (size_t i = 0; i < num_observations; ++i) {
+    const Sample& sample = samples_[i];
+    Observation& observation = observations_[i];
+    observation.enu_m[0] =
+        WrapLongitudeDeg(sample.lla_deg[1] - reference_lla_deg[1]) * scale_east;
+    observation.enu_m[1] =
+        (sample.lla_deg[0] - reference_lla_deg[0]) * scale_north;
+    observation.enu_m[2] = sample.lla_deg[2] - reference_lla_deg[2];
+    for (int j = 0; j < 3; ++j) {
+      observation.variance_m2[j] = sample.std_enu_m[j] * sample.std_enu_m[j];
+    }
+  }
+
+  // Compare each receiver against the weighted mean of the other included
+  // receivers, excluding the most inconsistent receiver until the rest agree.
+  result_.receivers.resize(num_observations);
+  result_.consistent = true;
+  double weight_sum[3], weighted_sum[3];
+  size_t num_used;
+  while (true) {
+    std::fill(weight_sum, weight_sum + 3, 0.0);
+    std::fill(weighted_sum, weighted_sum + 3, 0.0);
+    num_used = 0;
+    for (const Observation& observation : observations_) {
+      if (observation.used) {
+        for (int j = 0; j < 3; ++j) {
+          weight_sum[j] += 1.0 / observation.variance_m2[j];
+          weighted_sum[j] += observation.enu_m[j] / observation.variance_m2[j];
+        }
+        ++num_used;
+      }
+    }
+
+    size_t worst_index = num_observations;
+    double worst_statistic = config_.outlier_threshold;
+    for (size_t i = 0; i < num_observations; ++i) {
+      const Observation& observation = observations_[i];
+      ConsensusReceiver& entry = result_.receivers[i];
+      size_t num_others = num_used - (observation.used ? 1 : 0);
+      if (num_others == 0) {
+        entry.test_statistic = NAN;
+        continue;
+      }
+
+      double statistic = 0.0;
+      for (int j = 0; j < 3; ++j) {
+        double weight = 1.0 / observation.variance_m2[j];
+        double others_weight =
+            weight_sum[j] - (observation.used ? weight : 0.0);
+        double others_sum =
+            weighted_sum[j] -
+            (observation.used ? observation.enu_m[j] * weight : 0.0);
+        double delta = observation.enu_m[j] - others_sum / others_weight;
+        statistic += delta * delta /
+                     (observation.variance_m2[j] + 1.0 / others_weight);
+      }
+      entry.test_statistic = statistic;
+
+      if (observation.used && statistic > worst_statistic) {
+        worst_index = i;
+        worst_statistic = statistic;
+      }
+    }
+
+    if (worst_index == num_observations) {
+      break;
+    } else if (num_used <= 2) {
+      result_.consistent = false;
+      break;
+    } else {
+      observations_[worst_index].used = false;
+    }
+  }
+
+  double mean_enu_m[3];
+  for (int j = 0; j < 3; ++j) {
+    mean_enu_m[j] = weighted_sum[j] / weight_sum[j];
+    result_.position_std_enu_m[j] = std::sqrt(1.0 / weight_sum[j]);
+  }
+
+  result_.p1_time = ToTimestamp(p1_time_sec);
+  result_.lla_deg[0] = reference_lla_deg[0] + mean_enu_m[1] / scale_north;
+  result_.lla_deg[1] =
+      WrapLongitudeDeg(reference_lla_deg[1] + mean_enu_m[0] / scale_east);
+  result_.lla_deg[2] = reference_lla_deg[2] + mean_enu_m[2];
+  result_.num_used = num_used;
+  for (size_t i = 0; i < num_observations; ++i) {
+    const Observation& observation = observations_[i];
+    ConsensusReceiver& entry = result_.receivers[i];
+    entry.source_identifier =
+        receivers_[observation.receiver_index].source_identifier;
+    for (int j = 0; j < 3; ++j) {
+      entry.residual_enu_m[j] = observation.enu_m[j] - mean_enu_m[j];
+    }
+    entry.outlier = !observation.used;
+  }
+
+  have_result_ = true;
+  if (callback_) {
+    callback_(result_);
+  }
+
+  return num_observations;
+}
@@ -0,0 +1,260 @@
+/**************************************************************************/ /**
+ * @brief Consensus position from multiple time-aligned receivers.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cmath> // For NAN
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace realtime {
+
+/**
+ * @defgroup consensus Multi-Receiver Consensus
+ * @brief Combine the poses from several receivers on the same platform.
+ *
+ * @ref PoseConsensus interpolates the @ref messages::PoseMessage stream from
+ * each receiver (identified by @ref messages::MessageHeader::source_identifier)
+ * to a common grid of epochs, and computes an inverse-variance weighted mean
+ * position at each epoch. Each receiver is compared with the mean of the
+ * _other_ receivers, normalized by their combined covariance, so that a
+ * faulty receiver does not mask itself by pulling the mean toward its own
+ * position. With three or more receivers, the receiver with the largest
+ * inconsistency is excluded and the test repeated until the remaining
+ * receivers agree. With two receivers, a disagreement cannot be attributed to
+ * either one and is reported as @ref ConsensusPose::consistent = `false`.
+ *
+ * All receivers must report the position of the same point on the platform
+ * (e.g., by configuring a common output lever arm).
+ *
+ * Each receiver keeps a fixed-size history of recent poses, so memory use is
+ * bounded, and each epoch is computed once, as soon as every active receiver
+ * has reported a pose at or after it (or once @ref
+ * PoseConsensus::Config::max_latency_sec has elapsed).
+ * @{
+ */
+
+/**
+ * @brief The contribution of a single receiver to a consensus epoch.
+ */
+struct ConsensusReceiver {
+  uint32_t source_identifier = 0;
+
+  /** The receiver position minus the consensus position, in ENU. */
+  double residual_enu_m[3] = {NAN, NAN, NAN};
+
+  /**
+   * The squared Mahalanobis distance between the receiver position and the
+   * weighted mean of the other receivers (`NAN` if there are no other
+   * receivers).
+   */
+  double test_statistic = NAN;
+
+  /** `true` if the receiver was excluded from the consensus. */
+  bool outlier = false;
+};
+
+/**
+ * @brief The consensus position at a single epoch.
+ */
+struct ConsensusPose {
+  messages::Timestamp p1_time;
+
+  /** The consensus position (see @ref messages::PoseMessage::lla_deg). */
+  double lla_deg[3] = {NAN, NAN, NAN};
+
+  /** The standard deviation of the consensus position, in ENU. */
+  double position_std_enu_m[3] = {NAN, NAN, NAN};
+
+  /** The number of receivers included in the consensus. */
+  size_t num_used = 0;
+
+  /**
+   * `false` if the receivers disagree and the outlier could not be identified
+   * (e.g., only two receivers are available).
+   */
+  bool consistent = true;
+
+  /** All receivers with a position at this epoch. */
+  std::vector<ConsensusReceiver> receivers;
+};
+
+/**
+ * @brief Compute a consensus position from the poses of several receivers.
+ *
+ * Typical usage:
+ *
+ * ```{.cpp}
+ * PoseConsensus consensus;
+ * consensus.SetResultCallback([](const ConsensusPose& result) { ... });
+ * framer.SetMessageCallback(
+ *     [&](const MessageHeader& header, const void* payload) {
+ *       consensus.OnMessage(header, payload);
+ *     });
+ * ```
+ */
+class P1_EXPORT PoseConsensus {
+ public:
+  using ResultCallback = std::function<void(const ConsensusPose&)>;
+
+  struct Config {
+    /** The spacing of the consensus epochs (in P1 time). */
+    double epoch_interval_sec = 0.1;
+
+    /**
+     * Compute an epoch without waiting for slower receivers once any receiver
+     * is this far ahead of it.
+     */
+    double max_latency_sec = 0.5;
+
+    /** Do not interpolate between poses further apart than this. */
+    double max_interpolation_gap_sec = 1.0;
+
+    /** The number of poses stored for each receiver. */
+    size_t history_size = 16;
+
+    /** The maximum number of receivers. Additional sources are ignored. */
+    size_t max_receivers = 8;
+
+    /** The minimum number of receivers required to compute an epoch. */
+    size_t min_receivers = 2;
+
+    /**
+     * The threshold for @ref ConsensusReceiver::test_statistic (chi-squared
+     * with 3 degrees of freedom; the default corresponds to a 0.1% false alarm
+     * rate).
+     */
+    double outlier_threshold = 16.27;
+
+    /** The standard deviation assumed for poses that do not report one. */
+    double default_std_m = 1.0;
+
+    /** The minimum standard deviation, to limit the weight of any receiver. */
+    double min_std_m = 0.005;
+  };
+
+  PoseConsensus() : PoseConsensus(Config()) {}
+  explicit PoseConsensus(const Config& config);
+
+  /**
+   * @brief Set a function to be called for each consensus epoch.
+   */
+  void SetResultCallback(ResultCallback callback) {
+    callback_ = std::move(callback);
+  }
+
+  /**
+   * @brief Process an incoming message, adding @ref messages::PoseMessage for
+   *        the receiver identified by the message source.
+   *
+   * @param header The message header.
+   * @param payload The message payload.
+   */
+  void OnMessage(const messages::MessageHeader& header, const void* payload);
+
+  /**
+   * @brief Add a pose from the specified receiver.
+   *
+   * Poses with an invalid solution or position are ignored.
+   *
+   * @param source_identifier The receiver.
+   * @param pose The pose message.
+   */
+  void OnPose(uint32_t source_identifier, const messages::PoseMessage& pose);
+
+  /**
+   * @brief Add a position from the specified receiver. Positions must be in
+   *        increasing time order for each receiver.
+   *
+   * @param source_identifier The receiver.
+   * @param p1_time_sec The P1 time of the position (in seconds).
+   * @param lla_deg The position (see @ref messages::PoseMessage::lla_deg).
+   * @param position_std_enu_m The position standard deviation in ENU. `NAN`
+   *        values are replaced by @ref Config::default_std_m.
+   */
+  void AddPosition(uint32_t source_identifier, double p1_time_sec,
+                   const double lla_deg[3], const float position_std_enu_m[3]);
+
+  /**
+   * @brief Compute all remaining epochs covered by the received poses without
+   *        waiting for slower receivers, e.g., at the end of a log.
+   */
+  void Flush();
+
+  /**
+   * @brief Clear all receivers and stored poses.
+   */
+  void Reset();
+
+  /**
+   * @brief Get the most recent consensus result.
+   *
+   * @return The result, or `nullptr` if no epochs have been computed.
+   */
+  const ConsensusPose* GetLatestResult() const {
+    return have_result_ ? &result_ : nullptr;
+  }
+
+ private:
+  struct Sample {
+    double p1_time_sec;
+    double lla_deg[3];
+    double std_enu_m[3];
+  };
+
+  // A fixed-capacity history of poses from one receiver.
+  struct Receiver {
+    uint32_t source_identifier = 0;
+    std::vector<Sample> samples;
+    size_t newest = 0;
+    size_t count = 0;
+
+    const Sample& GetNewest() const { return samples[newest]; }
+    const Sample& GetFromNewest(size_t age) const {
+      return samples[(newest + samples.size() - age) % samples.size()];
+    }
+  };
+
+  // A receiver's position at an epoch, relative to the reference position.
+  // Excluded receivers have `used == false`.
+  struct Observation {
+    size_t receiver_index;
+    double enu_m[3];
+    double variance_m2[3];
+    bool used;
+  };
+
+  Receiver* GetReceiver(uint32_t source_identifier);
+  void ProcessEpochs(bool flush);
+  bool Interpolate(const Receiver& receiver, double p1_time_sec,
+                   Sample* result) const;
+  size_t ComputeEpoch(double p1_time_sec);
+
+  Config config_;
+  ResultCallback callback_;
+
+  std::vector<Receiver> receivers_;
+  int64_t next_epoch_index_ = 0;
+  bool started_ = false;
+
+  std::vector<Sample> samples_;
+  std::vector<Observation> observations_;
+  ConsensusPose result_;
+  bool have_result_ = false;
+};
+
+/** @} */
+
+} // namespace realtime
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,547 @@
+/**************************************************************************/ /**
+ * @brief Geofence (polygonal zone) evaluation for streaming poses.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/realtime/geofence.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+
+using namespace point_one::fusion_engine::geodesy;
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::realtime;
+
+namespace {
+// Cells are expanded by this amount (in degrees) when assigning edges so that
+// edges passing exactly along a cell boundary are included in both cells.
+constexpr double CELL_MARGIN_DEG = 1e-9;
+
+// Factor by which the cell size is increased until the grid fits within
+// Config::max_cells.
+constexpr double CELL_GROWTH_FACTOR = 1.25;
+
+/******************************************************************************/
+// Test if a line segment intersects an axis-aligned box (Liang-Barsky
+// clipping).
+template <typename Edge>
+bool SegmentIntersectsBox(const Edge& edge, double min_x, double min_y,
+                          double max_x, double max_y) {
+  double dx = edge.x2 - edge.x1;
+  double dy = edge.y2 - edge.y1;
+  double p[4] = {-dx, dx, -dy, dy};
+  double q[4] = {edge.x1 - min_x, max_x - edge.x1, edge.y1 - min_y,
+                 max_y - edge.y1};
+  double t0 = 0.0, t1 = 1.0;
+  for (int i = 0; i < 4; ++i) {
+    if (p[i] == 0.0) {
+      if (q[i] < 0.0) {
+        return false;
+      }
+    } else {
+      double t = q[i] / p[i];
+      if (p[i] < 0.0) {
+        t0 = std::max(t0, t);
+      } else {
+        t1 = std::min(t1, t);
+      }
+      if (t0 > t1) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/******************************************************************************/
+// Get the longitude at which an edge crosses the specified latitude. The edge
+// must straddle the latitude.
+template <typename Edge>
+inline double GetCrossingX(const Edge& edge, double y) {
+  return edge.x1 + (y - edge.y1) * (edge.x2 - edge.x1) / (edge.y2 - edge.y1);
+}
+
+/******************************************************************************/
+// Get the latitude at which an edge crosses the specified longitude. The edge
+// must straddle the longitude.
+template <typename Edge>
+inline double GetCrossingY(const Edge& edge, double x) {
+  return edge.y1 + (x - edge.x1) * (edge.y2 - edge.y1) / (edge.x2 - edge.x1);
+}
+
+/******************************************************************************/
+// Get the distance from the origin to a line segment.
+inline double GetSegmentDistance(double x1, double y1, double x2, double y2) {
+  double dx = x2 - x1;
+  double dy = y2 - y1;
+  double length2 = dx * dx + dy * dy;
+  double t = length2 > 0.0 ? -(x1 * dx + y1 * dy) / length2 : 0.0;
+  t = std::min(1.0, std::max(0.0, t));
+  return std::hypot(x1 + t * dx, y1 + t * dy);
+}
+} // namespace
+
+/******************************************************************************/
+bool GeofenceEngine::AddZone(uint32_t zone_id, const double* lat_lon_deg,
+                             size_t num_vertices) {
+  if (num_vertices < 3 || zone_index_by_id_.count(zone_id) != 0) {
+    return false;
+  }
+
+  Zone zone;
+  zone.id = zone_id;
+  zone.first_vertex = static_cast<uint32_t>(edges_.size());
+  zone.num_vertices = static_cast<uint32_t>(num_vertices);
+  zone.min_lat_deg = zone.min_lon_deg = INFINITY;
+  zone.max_lat_deg = zone.max_lon_deg = -INFINITY;
+  for (size_t i = 0; i < num_vertices; ++i) {
+    double lat = lat_lon_deg[i * 2];
+    double lon = lat_lon_deg[i * 2 + 1];
+    if (!(lat >= -90.0 && lat <= 90.0 && lon >= -180.0 && lon <= 180.0)) {
+      return false;
+    }
+    zone.min_lat_deg = std::min(zone.min_lat_deg, lat);
+    zone.max_lat_deg = std::max(zone.max_lat_deg, lat);
+    zone.min_lon_deg = std::min(zone.min_lon_deg, lon);
+    zone.max_lon_deg = std::max(zone.max_lon_deg, lon);
+  }
+
+  // A zone spanning more than half the globe in longitude almost certainly
+  // crosses the antimeridian, which is not supported.
+  if (zone.max_lon_deg - zone.min_lon_deg > 180.0) {
+    return false;
+  }
+
+  for (size_t i = 0; i < num_vertices; ++i) {
+    size_t next = (i + 1) % num_vertices;
+    Edge edge;
+    edge.x1 = lat_lon_deg[i * 2 + 1];
+    edge.y1 = lat_lon_deg[i * 2];
+    edge.x2 = lat_lon_deg[next * 2 + 1];
+    edge.y2 = lat_lon_deg[next * 2];
+    edges_.push_back(edge);
+  }
+
+  zone_index_by_id_[zone_id] = static_cast<uint32_t>(zones_.size());
+  zones_.push_back(zone);
+  index_valid_ = false;
+  return true;
+}
+
+/******************************************************************************/
+void GeofenceEngine::ClearZones() {
+  zones_.clear();
+  edges_.clear();
+  zone_index_by_id_.clear();
+  num_rows_ = 0;
+  num_cols_ = 0;
+  cell_offsets_.clear();
+  cell_entries_.clear();
+  cell_edges_.clear();
+  index_valid_ = true;
+  Reset();
+}
+
+/******************************************************************************/
+void GeofenceEngine::Build() {
+  index_valid_ = true;
+  num_rows_ = 0;
+  num_cols_ = 0;
+  cell_offsets_.clear();
+  cell_entries_.clear();
+  cell_edges_.clear();
+  if (zones_.empty()) {
+    return;
+  }
+
+  // Size the grid to cover all zones.
+  double min_lat = 90.0, max_lat = -90.0, min_lon = 180.0, max_lon = -180.0;
+  for (const Zone& zone : zones_) {
+    min_lat = std::min(min_lat, zone.min_lat_deg);
+    max_lat = std::max(max_lat, zone.max_lat_deg);
+    min_lon = std::min(min_lon, zone.min_lon_deg);
+    max_lon = std::max(max_lon, zone.max_lon_deg);
+  }
+
+  origin_lat_deg_ = min_lat;
+  origin_lon_deg_ = min_lon;
+  cell_size_deg_ = config_.cell_size_deg > 0.0 ? config_.cell_size_deg : 0.01;
+  // Each zone may store an entry in every cell of its bounding box, so limit
+  // the total number of bounding box cells as well as the size of the grid.
+  // Limiting both to 32 bits keeps cell indices and entry offsets in range.
+  size_t max_cells = std::min<size_t>(std::max<size_t>(config_.max_cells, 1),
+                                      std::numeric_limits<uint32_t>::max());
+  auto get_cell_index = [this](double value_deg, double origin_deg) {
+    return static_cast<size_t>((value_deg - origin_deg) / cell_size_deg_);
+  };
+  while (true) {
+    num_rows_ = static_cast<size_t>((max_lat - min_lat) / cell_size_deg_) + 1;
+    num_cols_ = static_cast<size_t>((max_lon - min_lon) / cell_size_deg_) + 1;
+    if (num_rows_ * num_cols_ <= max_cells) {
+      size_t num_zone_cells = 0;
+      for (const Zone& zone : zones_) {
+        size_t num_zone_rows = get_cell_index(zone.max_lat_deg, min_lat) -
+                               get_cell_index(zone.min_lat_deg, min_lat) + 1;
+        size_t num_zone_cols = get_cell_index(zone.max_lon_deg, min_lon) -
+                               get_cell_index(zone.min_lon_deg, min_lon) + 1;
+        num_zone_cells += num_zone_rows * num_zone_cols;
+        if (num_zone_cells > max_cells) {
+          break;
+        }
+      }
+
+      // With a single cell, each zone stores at most one entry and the cell
+      // count cannot be reduced further.
+      if (num_zone_cells <= max_cells || num_rows_ * num_cols_ == 1) {
+        break;
+      }
+    }
+    cell_size_deg_ *= CELL_GROWTH_FACTOR;
+  }
+
+  // Classify the cells overlapping each zone. Entries are generated in zone
+  // order, so the entries for each cell end up sorted by zone index.
+  struct PendingEntry {
+    uint32_t cell;
+    CellEntry entry;
+  };
+  std::vector<PendingEntry> pending;
+  std::vector<uint32_t> pending_edges;
+  std::vector<std::pair<uint32_t, uint32_t>> hits;
+  std::vector<double> crossings;
+  for (uint32_t z = 0; z < zones_.size(); ++z) {
+    const Zone& zone = zones_[z];
+    const Edge* edges = edges_.data() + zone.first_vertex;
+    size_t row0 = static_cast<size_t>((zone.min_lat_deg - origin_lat_deg_) /
+                                      cell_size_deg_);
+    size_t row1 = static_cast<size_t>((zone.max_lat_deg - origin_lat_deg_) /
+                                      cell_size_deg_);
+    size_t col0 = static_cast<size_t>((zone.min_lon_deg - origin_lon_deg_) /
+                                      cell_size_deg_);
+    size_t col1 = static_cast<size_t>((zone.max_lon_deg - origin_lon_deg_) /
+                                      cell_size_deg_);
+    row1 = std::min(row1, num_rows_ - 1);
+    col1 = std::min(col1, num_cols_ - 1);
+
+    // Find the cells crossed by each edge.
+    hits.clear();
+    for (uint32_t e = 0; e < zone.num_vertices; ++e) {
+      const Edge& edge = edges[e];
+      double edge_min_x = std::min(edge.x1, edge.x2) - CELL_MARGIN_DEG;
+      double edge_max_x = std::max(edge.x1, edge.x2) + CELL_MARGIN_DEG;
+      double edge_min_y = std::min(edge.y1, edge.y2) - CELL_MARGIN_DEG;
+      double edge_max_y = std::max(edge.y1, edge.y2) + CELL_MARGIN_DEG;
+      size_t r_begin = static_cast<size_t>(std::max(
+          0.0, (edge_min_y - origin_lat_deg_) / cell_size_deg_));
+      size_t r_end = std::min(
+          row1, static_cast<size_t>(std::max(
+                    0.0, (edge_max_y - origin_lat_deg_) / cell_size_deg_)));
+      size_t c_begin = static_cast<size_t>(std::max(
+          0.0, (edge_min_x - origin_lon_deg_) / cell_size_deg_));
+      size_t c_end = std::min(
+          col1, static_cast<size_t>(std::max(
+                    0.0, (edge_max_x - origin_lon_deg_) / cell_size_deg_)));
+      for (size_t r = std::max(r_begin, row0); r <= r_end; ++r) {
+        double y0 = origin_lat_deg_ + r * cell_size_deg_ - CELL_MARGIN_DEG;
+        double y1 = y0 + cell_size_deg_ + 2.0 * CELL_MARGIN_DEG;
+        for (size_t c = std::max(c_begin, col0); c <= c_end; ++c) {
+          double x0 = origin_lon_deg_ + c * cell_size_deg_ - CELL_MARGIN_DEG;
+          double x1 = x0 + cell_size_deg_ + 2.0 * CELL_MARGIN_DEG;
+          if (SegmentIntersectsBox(edge, x0, y0, x1, y1)) {
+            hits.emplace_back(static_cast<uint32_t>(r * num_cols_ + c), e);
+          }
+        }
+      }
+    }
+    std::sort(hits.begin(), hits.end());
+
+    // Determine whether each cell center is inside the zone by casting a ray
+    // along each row of cell centers, then store cells that are crossed by an
+    // edge or lie inside the zone.
+    size_t hit_index = 0;
+    for (size_t r = row0; r <= row1; ++r) {
+      double cy = origin_lat_deg_ + (r + 0.5) * cell_size_deg_;
+      crossings.clear();
+      for (uint32_t e = 0; e < zone.num_vertices; ++e) {
+        const Edge& edge = edges[e];
+        if ((edge.y1 > cy) != (edge.y2 > cy)) {
+          crossings.push_back(GetCrossingX(edge, cy));
+        }
+      }
+      std::sort(crossings.begin(), crossings.end());
+
+      size_t num_left = 0;
+      for (size_t c = col0; c <= col1; ++c) {
+        uint32_t cell = static_cast<uint32_t>(r * num_cols_ + c);
+        double cx = origin_lon_deg_ + (c + 0.5) * cell_size_deg_;
+        while (num_left < crossings.size() && crossings[num_left] <= cx) {
+          ++num_left;
+        }
+
+        PendingEntry pending_entry;
+        pending_entry.cell = cell;
+        pending_entry.entry.zone_index = z;
+        pending_entry.entry.first_edge =
+            static_cast<uint32_t>(pending_edges.size());
+        pending_entry.entry.center_inside =
+            ((crossings.size() - num_left) & 1) != 0;
+        while (hit_index < hits.size() && hits[hit_index].first == cell) {
+          pending_edges.push_back(zone.first_vertex + hits[hit_index].second);
+          ++hit_index;
+        }
+        pending_entry.entry.num_edges = static_cast<uint32_t>(
+            pending_edges.size() - pending_entry.entry.first_edge);
+        if (pending_entry.entry.num_edges > 0 ||
+            pending_entry.entry.center_inside) {
+          pending.push_back(pending_entry);
+        }
+      }
+    }
+  }
+
+  // Group the entries by cell, and copy the edges for each cell so that they
+  // are contiguous in memory.
+  cell_offsets_.assign(num_rows_ * num_cols_ + 1, 0);
+  for (const PendingEntry& pending_entry : pending) {
+    ++cell_offsets_[pending_entry.cell + 1];
+  }
+  for (size_t i = 1; i < cell_offsets_.size(); ++i) {
+    cell_offsets_[i] += cell_offsets_[i - 1];
+  }
+
+  std::vector<uint32_t> next_entry(cell_offsets_.begin(),
+                                   cell_offsets_.end() - 1);
+  cell_entries_.resize(pending.size());
+  for (const PendingEntry& pending_entry : pending) {
+    cell_entries_[next_entry[pending_entry.cell]++] = pending_entry.entry;
+  }
+
+  cell_edges_.reserve(pending_edges.size());
+  for (CellEntry& entry : cell_entries_) {
+    uint32_t first_edge = static_cast<uint32_t>(cell_edges_.size());
+    for (uint32_t i = 0; i < entry.num_edges; ++i) {
+      cell_edges_.push_back(edges_[pending_edges[entry.first_edge + i]]);
+    }
+    entry.first_edge = first_edge;
+  }
+}
+
+/******************************************************************************/
+void GeofenceEngine::OnMessage(const MessageHeader& header,
+                               const void* payload) {
+  if (header.message_type == MessageType::POSE &&
+      header.payload_size_bytes >= sizeof(PoseMessage)) {
+    PoseMessage pose;
+    std::memcpy(&pose, payload, sizeof(pose));
+    OnPose(header.source_identifier, pose);
+  }
+}
+
+/******************************************************************************/
+void GeofenceEngine::OnPose(uint32_t source_identifier,
+                            const PoseMessage& pose) {
+  if (pose.solution_type == SolutionType::Invalid) {
+    return;
+  }
+
+  double protection_level_m = pose.horizontal_protection_level_m;
+  if (std::isnan(protection_level_m) && config_.std_dev_scale > 0.0) {
+    protection_level_m =
+        config_.std_dev_scale *
+        std::max(pose.position_std_enu_m[0], pose.position_std_enu_m[1]);
+  }
+
+  EvaluatePosition(source_identifier, pose.p1_time, pose.lla_deg[0],
+                   pose.lla_deg[1], protection_level_m);
+}
+
+/******************************************************************************/
+void GeofenceEngine::EvaluatePosition(uint32_t source_identifier,
+                                      const Timestamp& p1_time,
+                                      double latitude_deg,
+                                      double longitude_deg,
+                                      double protection_level_m) {
+  if (std::isnan(latitude_deg) || std::isnan(longitude_deg)) {
+    return;
+  }
+
+  if (!index_valid_) {
+    Build();
+  }
+
+  FindContainingZones(latitude_deg, longitude_deg, &current_zones_);
+
+  // Compare the sorted current and previous zone sets.
+  VehicleState& state = vehicles_[source_identifier];
+  const std::vector<uint32_t>& previous = state.zones;
+  if (previous != current_zones_) {
+    size_t i = 0, j = 0;
+    while (i < previous.size() || j < current_zones_.size()) {
+      if (j == current_zones_.size() ||
+          (i < previous.size() && previous[i] < current_zones_[j])) {
+        EmitEvent(source_identifier, previous[i++], GeofenceEventType::EXIT,
+                  p1_time, latitude_deg, longitude_deg, protection_level_m);
+      } else if (i == previous.size() || current_zones_[j] < previous[i]) {
+        EmitEvent(source_identifier, current_zones_[j++],
+                  GeofenceEventType::ENTER, p1_time, latitude_deg,
+                  longitude_deg, protection_level_m);
+      } else {
+        ++i;
+        ++j;
+      }
+    }
+    state.zones.swap(current_zones_);
+  }
+}
+
+/******************************************************************************/
+void GeofenceEngine::GetContainingZones(double latitude_deg,
+                                        double longitude_deg,
+                                        std::vector<uint32_t>* zone_ids) const {
+  FindContainingZones(latitude_deg, longitude_deg, zone_ids);
+  for (uint32_t& zone : *zone_ids) {
+    zone = zones_[zone].id;
+  }
+}
+
+/******************************************************************************/
+double GeofenceEngine::GetBoundaryDistance(uint32_t zone_id,
+                                           double latitude_deg,
+                                           double longitude_deg) const {
+  auto it = zone_index_by_id_.find(zone_id);
+  if (it == zone_index_by_id_.end()) {
+    return NAN;
+  } else {
+    return GetBoundaryDistanceForIndex(it->second, latitude_deg,
+                                       longitude_deg);
+  }
+}
+
+/******************************************************************************/
+bool GeofenceEngine::GetCurrentZones(uint32_t source_identifier,
+                                     std::vector<uint32_t>* zone_ids) const {
+  auto it = vehicles_.find(source_identifier);
+  if (it == vehicles_.end()) {
+    return false;
+  }
+
+  zone_ids->clear();
+  for (uint32_t zone : it->second.zones) {
+    zone_ids->push_back(zones_[zone].id);
+  }
+  return true;
+}
+
+/******************************************************************************/
+void GeofenceEngine::Reset() { vehicles_.clear(); }
+
+/******************************************************************************/
+void GeofenceEngine::FindContainingZones(
+    double latitude_deg, double longitude_deg,
+    std::vector<uint32_t>* zone_indices) const {
+  zone_indices->clear();
+  if (num_cols_ == 0) {
+    return;
+  }
+
+  // Note: NaN positions fail these checks.
+  double row_f = (latitude_deg - origin_lat_deg_) / cell_size_deg_;
+  double col_f = (longitude_deg - origin_lon_deg_) / cell_size_deg_;
+  if (!(row_f >= 0.0 && row_f < num_rows_ && col_f >= 0.0 &&
+        col_f < num_cols_)) {
+    return;
+  }
+
+  size_t row = static_cast<size_t>(row_f);
+  size_t col = static_cast<size_t>(col_f);
+  size_t cell = row * num_cols_ + col;
+  double cx = origin_lon_deg_ + (col + 0.5) * cell_size_deg_;
+  double cy = origin_lat_deg_ + (row + 0.5) * cell_size_deg_;
+  double x = longitude_deg, y = latitude_deg;
+  double min_x = std::min(cx, x), max_x = std::max(cx, x);
+  double min_y = std::min(cy, y), max_y = std::max(cy, y);
+
+  for (uint32_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+    const CellEntry& entry = cell_entries_[i];
+    bool inside = entry.center_inside;
+
+    // Walk from the cell center to the position, first horizontally to
+    // (x, cy), then vertically to (x, y), toggling the inside state at each
+    // edge crossed. Only edges crossing this cell can intersect the path. The
+    // half-open intervals match the ray casting rule used to classify the
+    // cell center in Build().
+    const Edge* edge = cell_edges_.data() + entry.first_edge;
+    const Edge* end = edge + entry.num_edges;
+    for (; edge != end; ++edge) {
+      if ((edge->y1 > cy) != (edge->y2 > cy)) {
+        double crossing_x = GetCrossingX(*edge, cy);
+        if (crossing_x > min_x && crossing_x <= max_x) {
+          inside = !inside;
+        }
+      }
+      if ((edge->x1 > x) != (edge->x2 > x)) {
+        double crossing_y = GetCrossingY(*edge, x);
+        if (crossing_y > min_y && crossing_y <= max_y) {
+          inside = !inside;
+        }
+      }
+    }
+
+    if (inside) {
+      zone_indices->push_back(entry.zone_index);
+    }
+  }
+}
+
+/******************************************************************************/
+double GeofenceEngine::GetBoundaryDistanceForIndex(uint32_t zone_index,
+                                                   double latitude_deg,
+                                                   double longitude_deg) const {
+  // Compute distances in a local tangent plane at the position.
+  double meridian_radius_m, prime_vertical_radius_m;
+  geodesy::GetRadiiOfCurvature(latitude_deg, &meridian_radius_m,
+                               &prime_vertical_radius_m);
+  double scale_x = prime_vertical_radius_m *
+                   std::cos(latitude_deg * DEG_TO_RAD) * DEG_TO_RAD;
+  double scale_y = meridian_radius_m * DEG_TO_RAD;
+
+  const Zone& zone = zones_[zone_index];
+  const Edge* edges = edges_.data() + zone.first_vertex;
+  double distance_m = INFINITY;
+  for (uint32_t e = 0; e < zone.num_vertices; ++e) {
+    const Edge& edge = edges[e];
+    distance_m = std::min(
+        distance_m,
+        GetSegmentDistance((edge.x1 - longitude_deg) * scale_x,
+                           (edge.y1 - latitude_deg) * scale_y,
+                           (edge.x2 - longitude_deg) * scale_x,
+                           (edge.y2 - latitude_deg) * scale_y));
+  }
+  return distance_m;
+}
+
+/******************************************************************************/
+void GeofenceEngine::EmitEvent(uint32_t source_identifier, uint32_t zone_index,
+                               GeofenceEventType type,
+                               const Timestamp& p1_time, double latitude_deg,
+                               double longitude_deg,
+                               double protection_level_m) {
+  if (!callback_) {
+    return;
+  }
+
+  GeofenceEvent event;
+  event.source_identifier = source_identifier;
+  event.zone_id = zones_[zone_index].id;
+  event.type = type;
+  event.p1_time = p1_time;
+  event.boundary_distance_m =
+      GetBoundaryDistanceForIndex(zone_index, latitude_deg, longitude_deg);
+  event.protection_level_m = protection_level_m;
+  event.uncertain = event.boundary_distance_m < protection_level_m;
+  callback_(event);
+}
@@ -0,0 +1,310 @@
+/**************************************************************************/ /**
+ * @brief Geofence (polygonal zone) evaluation for streaming poses.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cmath> // For NAN
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace realtime {
+
+/**
+ * @defgroup geofence Geofencing
+ * @brief Detect when vehicles enter or leave polygonal zones.
+ *
+ * @ref GeofenceEngine indexes a set of zones in a uniform latitude/longitude
+ * grid. Each grid cell stores the zones that touch it: zones covering the
+ * entire cell are stored without edges, and zones whose boundary crosses the
+ * cell are stored with only the edges crossing that cell, along with whether
+ * the cell center is inside the zone. Evaluating a position visits a single
+ * cell and tests only the edges in that cell, so the cost depends on the local
+ * boundary density rather than the total number of zones or vertices.
+ *
+ * Each vehicle (identified by @ref messages::MessageHeader::source_identifier)
+ * keeps the set of zones it currently occupies. Enter and exit events are
+ * generated when that set changes. A crossing is flagged as uncertain if the
+ * zone boundary lies within the pose's horizontal protection level, i.e., the
+ * vehicle may not actually have crossed it.
+ *
+ * Zone edges are straight lines in latitude/longitude, and zones may not cross
+ * the antimeridian.
+ * @{
+ */
+
+enum class GeofenceEventType : uint8_t {
+  ENTER = 0,
+  EXIT = 1,
+};
+
+/**
+ * @brief A vehicle entering or leaving a zone.
+ */
+struct GeofenceEvent {
+  /** The vehicle (message source) that crossed the zone boundary. */
+  uint32_t source_identifier = 0;
+
+  /** The ID of the zone (see @ref GeofenceEngine::AddZone()). */
+  uint32_t zone_id = 0;
+
+  GeofenceEventType type = GeofenceEventType::ENTER;
+
+  /** The time of the first pose after the crossing. */
+  messages::Timestamp p1_time;
+
+  /** The distance from the pose to the nearest edge of the zone. */
+  double boundary_distance_m = NAN;
+
+  /** The horizontal protection level of the pose (`NAN` if not available). */
+  double protection_level_m = NAN;
+
+  /**
+   * `true` if the zone boundary is within the protection level of the pose, in
+   * which case the crossing may be caused by position error.
+   */
+  bool uncertain = false;
+};
+
+/**
+ * @brief Evaluate streaming vehicle positions against a set of polygonal
+ *        zones.
+ *
+ * Typical usage:
+ *
+ * ```{.cpp}
+ * GeofenceEngine engine;
+ * engine.AddZone(1, depot_lat_lon_deg, num_depot_vertices);
+ * ...
+ * engine.Build();
+ * engine.SetEventCallback([](const GeofenceEvent& event) { ... });
+ * framer.SetMessageCallback(
+ *     [&](const MessageHeader& header, const void* payload) {
+ *       engine.OnMessage(header, payload);
+ *     });
+ * ```
+ */
+class P1_EXPORT GeofenceEngine {
+ public:
+  using EventCallback = std::function<void(const GeofenceEvent&)>;
+
+  struct Config {
+    /**
+     * The size of each grid cell (in degrees). Smaller cells contain fewer
+     * edges, at the cost of memory. The size is increased automatically if the
+     * zones span more than @ref max_cells cells, or if the zone bounding boxes
+     * cover more than @ref max_cells cells in total.
+     */
+    double cell_size_deg = 0.01;
+
+    /**
+     * The maximum number of grid cells, and the maximum total number of cells
+     * covered by the bounding boxes of all zones (which bounds the size of the
+     * index). Values larger than 2^32 - 1 are clamped.
+     */
+    size_t max_cells = 1 << 22;
+
+    /**
+     * For poses with no horizontal protection level, use this multiple of the
+     * largest horizontal position standard deviation instead (0 to disable).
+     */
+    double std_dev_scale = 3.0;
+  };
+
+  GeofenceEngine() : GeofenceEngine(Config()) {}
+  explicit GeofenceEngine(const Config& config) : config_(config) {}
+
+  /**
+   * @brief Add a zone. The zone takes effect when the index is rebuilt (see
+   *        @ref Build()).
+   *
+   * @param zone_id A unique ID for the zone.
+   * @param lat_lon_deg The latitude and longitude of each vertex (2 values per
+   *        vertex). The polygon is closed implicitly, and may be specified in
+   *        either winding order.
+   * @param num_vertices The number of vertices.
+   *
+   * @return `true` on success, or `false` if the ID is already in use, there
+   *         are fewer than 3 vertices, a vertex is invalid, or the zone crosses
+   *         the antimeridian.
+   */
+  bool AddZone(uint32_t zone_id, const double* lat_lon_deg,
+               size_t num_vertices);
+
+  /**
+   * @brief Remove all zones and vehicle state.
+   */
+  void ClearZones();
+
+  /**
+   * @brief Build the spatial index for the current set of zones.
+   *
+   * Called automatically by @ref OnPose() and @ref EvaluatePosition() if zones
+   * have been added since the last call.
+   */
+  void Build();
+
+  size_t GetNumZones() const { return zones_.size(); }
+
+  /**
+   * @brief Set a function to be called for each enter or exit event.
+   */
+  void SetEventCallback(EventCallback callback) {
+    callback_ = std::move(callback);
+  }
+
+  /**
+   * @brief Process an incoming message, evaluating @ref messages::PoseMessage
+   *        for the vehicle identified by the message source.
+   *
+   * @param header The message header.
+   * @param payload The message payload.
+   */
+  void OnMessage(const messages::MessageHeader& header, const void* payload);
+
+  /**
+   * @brief Evaluate a pose for the specified vehicle.
+   *
+   * Poses with an invalid solution or position are ignored.
+   *
+   * @param source_identifier The vehicle.
+   * @param pose The pose message.
+   */
+  void OnPose(uint32_t source_identifier, const messages::PoseMessage& pose);
+
+  /**
+   * @brief Evaluate a position for the specified vehicle, generating events
+   *        for any zones entered or left since its previous position.
+   *
+   * The first position for a vehicle generates an enter event for each zone
+   * containing it.
+   *
+   * @param source_identifier The vehicle.
+   * @param p1_time The time of the position.
+   * @param latitude_deg The latitude.
+   * @param longitude_deg The longitude.
+   * @param protection_level_m The horizontal protection level (`NAN` if not
+   *        available).
+   */
+  void EvaluatePosition(uint32_t source_identifier,
+                        const messages::Timestamp& p1_time,
+                        double latitude_deg, double longitude_deg,
+                        double protection_level_m = NAN);
+
+  /**
+   * @brief Get the zones containing a position. @ref Build() must be called
+   *        after adding zones.
+   *
+   * @param latitude_deg The latitude.
+   * @param longitude_deg The longitude.
+   * @param[out] zone_ids The IDs of the zones containing the position, in the
+   *        order the zones were added.
+   */
+  void GetContainingZones(double latitude_deg, double longitude_deg,
+                          std::vector<uint32_t>* zone_ids) const;
+
+  /**
+   * @brief Get the distance from a position to the nearest edge of a zone.
+   *
+   * @param zone_id The zone.
+   * @param latitude_deg The latitude.
+   * @param longitude_deg The longitude.
+   *
+   * @return The distance (in meters), or `NAN` if the zone does not exist.
+   */
+  double GetBoundaryDistance(uint32_t zone_id, double latitude_deg,
+                             double longitude_deg) const;
+
+  /**
+   * @brief Get the zones currently occupied by a vehicle.
+   *
+   * @param source_identifier The vehicle.
+   * @param[out] zone_ids The IDs of the occupied zones.
+   *
+   * @return `true` on success, or `false` if no positions have been received
+   *         for the vehicle.
+   */
+  bool GetCurrentZones(uint32_t source_identifier,
+                       std::vector<uint32_t>* zone_ids) const;
+
+  /**
+   * @brief Clear all vehicle state. Zones are not affected.
+   */
+  void Reset();
+
+ private:
+  struct Zone {
+    uint32_t id;
+    uint32_t first_vertex;
+    uint32_t num_vertices;
+    double min_lat_deg;
+    double max_lat_deg;
+    double min_lon_deg;
+    double max_lon_deg;
+  };
+
+  // An edge, stored as (longitude, latitude) pairs.
+  struct Edge {
+    double x1, y1, x2, y2;
+  };
+
+  struct CellEntry {
+    uint32_t zone_index;
+    uint32_t first_edge;
+    uint32_t num_edges;
+    bool center_inside;
+  };
+
+  struct VehicleState {
+    // Sorted zone indices.
+    std::vector<uint32_t> zones;
+  };
+
+  void FindContainingZones(double latitude_deg, double longitude_deg,
+                           std::vector<uint32_t>* zone_indices) const;
+  double GetBoundaryDistanceForIndex(uint32_t zone_index, double latitude_deg,
+                                     double longitude_deg) const;
+  void EmitEvent(uint32_t source_identifier, uint32_t zone_index,
+                 GeofenceEventType type, const messages::Timestamp& p1_time,
+                 double latitude_deg, double longitude_deg,
+                 double protection_level_m);
+
+  Config config_;
+  EventCallback callback_;
+
+  std::vector<Zone> zones_;
+  std::vector<Edge> edges_;
+  std::unordered_map<uint32_t, uint32_t> zone_index_by_id_;
+  bool index_valid_ = true;
+
+  // Grid index. The entries for cell (row, col) are
+  // cell_entries_[cell_offsets_[row * num_cols_ + col]] through
+  // cell_entries_[cell_offsets_[row * num_cols_ + col + 1] - 1].
+  double origin_lat_deg_ = 0.0;
+  double origin_lon_deg_ = 0.0;
+  double cell_size_deg_ = 0.0;
+  size_t num_rows_ = 0;
+  size_t num_cols_ = 0;
+  std::vector<uint32_t> cell_offsets_;
+  std::vector<CellEntry> cell_entries_;
+  std::vector<Edge> cell_edges_;
+
+  std::unordered_map<uint32_t, VehicleState> vehicles_;
+  std::vector<uint32_t> current_zones_;
+};
+
+/** @} */
+
+} // namespace realtime
+} // namespace fusion_engine
+} // namespace point_one
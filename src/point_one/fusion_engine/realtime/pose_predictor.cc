@@ -0,0 +1,361 @@
+/**************************************************************************/ /**
+ * @brief Low-latency pose prediction.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/realtime/pose_predictor.h"
+
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#include "point_one/fusion_engine/geodesy/frames.h"
+#include "point_one/fusion_engine/messages/imu_batch.h"
+#include "point_one/fusion_engine/realtime/time_sync.h"
+
+using namespace point_one::fusion_engine::geodesy;
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::realtime;
+
+namespace {
+// Number of failed seqlock reads before a reader yields its time slice to the
+// writer.
+constexpr int MAX_SPINS = 64;
+
+/******************************************************************************/
+bool IsValidTime(const Timestamp& time) {
+  return time.seconds != Timestamp::INVALID &&
+         time.fraction_ns != Timestamp::INVALID;
+}
+
+/******************************************************************************/
+double GetDifferenceSec(const Timestamp& a, const Timestamp& b) {
+  return (static_cast<int64_t>(a.seconds) - static_cast<int64_t>(b.seconds)) +
+         (static_cast<int64_t>(a.fraction_ns) -
+          static_cast<int64_t>(b.fraction_ns)) *
+             1e-9;
+}
+
+/******************************************************************************/
+Timestamp AddSec(const Timestamp& time, double offset_sec) {
+  int64_t ns = time.seconds * 1000000000LL + time.fraction_ns +
+               std::llround(offset_sec * 1e9);
+  Timestamp result;
+  if (ns >= 0) {
+    result.seconds = static_cast<uint32_t>(ns / 1000000000LL);
+    result.fraction_ns = static_cast<uint32_t>(ns % 1000000000LL);
+  }
+  return result;
+}
+
+/******************************************************************************/
+double Square(double value) { return value * value; }
+
+} // namespace
+
+constexpr int64_t PosePredictor::INVALID_HOST_TIME;
+
+/******************************************************************************/
+PosePredictor::PosePredictor(const Config& config) : config_(config) {
+  static_assert(std::is_trivially_copyable<State>::value,
+                "State must be trivially copyable.");
+  sequence_.store(0, std::memory_order_relaxed);
+  Reset();
+}
+
+/******************************************************************************/
+void PosePredictor::OnPose(const PoseMessage& pose, int64_t host_time_ns) {
+  if (pose.solution_type == SolutionType::Invalid ||
+      !IsValidTime(pose.p1_time) || std::isnan(pose.lla_deg[0]) ||
+      std::isnan(pose.lla_deg[1]) || std::isnan(pose.lla_deg[2])) {
+    return;
+  }
+
+  state_.valid = true;
+  state_.solution_type = pose.solution_type;
+  state_.p1_time = pose.p1_time;
+  state_.host_time_ns = host_time_ns;
+  std::memcpy(state_.lla_deg, pose.lla_deg, sizeof(state_.lla_deg));
+  std::memcpy(state_.ypr_deg, pose.ypr_deg, sizeof(state_.ypr_deg));
+  std::memcpy(state_.velocity_body_mps, pose.velocity_body_mps,
+              sizeof(state_.velocity_body_mps));
+  std::memcpy(state_.position_std_enu_m, pose.position_std_enu_m,
+              sizeof(state_.position_std_enu_m));
+  std::memcpy(state_.ypr_std_deg, pose.ypr_std_deg,
+              sizeof(state_.ypr_std_deg));
+  std::memcpy(state_.velocity_std_body_mps, pose.velocity_std_body_mps,
+              sizeof(state_.velocity_std_body_mps));
+  Publish();
+}
+
+/******************************************************************************/
+void PosePredictor::OnIMU(const IMUMeasurement& imu) {
+  if (UpdateRates(imu)) {
+    Publish();
+  }
+}
+
+/******************************************************************************/
+void PosePredictor::OnMessage(const MessageHeader& header, const void* payload,
+                              const TimeSync* time_sync) {
+  if (header.message_type == MessageType::POSE &&
+      header.payload_size_bytes >= sizeof(PoseMessage)) {
+    PoseMessage pose;
+    std::memcpy(&pose, payload, sizeof(pose));
+
+    int64_t host_time_ns = INVALID_HOST_TIME;
+    if (time_sync != nullptr &&
+        !time_sync->P1ToHost(header.source_identifier, pose.p1_time,
+                             &host_time_ns)) {
+      host_time_ns = INVALID_HOST_TIME;
+    }
+
+    OnPose(pose, host_time_ns);
+  } else if (header.message_type == MessageType::IMU_MEASUREMENT &&
+             header.payload_size_bytes >= sizeof(IMUMeasurement)) {
+    IMUMeasurement imu;
+    std::memcpy(&imu, payload, sizeof(imu));
+    OnIMU(imu);
+  } else if (header.message_type == MessageType::IMU_MEASUREMENT_BATCH) {
+    // Only the latest rates are used for prediction, so publish once for the
+    // whole batch rather than once per sample.
+    IMUBatchView batch(payload, header.payload_size_bytes);
+    bool updated = false;
+    for (const IMUMeasurement& imu : batch) {
+      updated |= UpdateRates(imu);
+    }
+
+    if (updated) {
+      Publish();
+    }
+  }
+}
+
+/******************************************************************************/
+void PosePredictor::Reset() {
+  state_ = State();
+  Publish();
+}
+
+/******************************************************************************/
+bool PosePredictor::Predict(const Timestamp& p1_time,
+                            PosePrediction* result) const {
+  if (!IsValidTime(p1_time)) {
+    return false;
+  }
+
+  State state;
+  Load(&state);
+  if (!state.valid) {
+    return false;
+  }
+
+  return Extrapolate(state, GetDifferenceSec(p1_time, state.p1_time), result);
+}
+
+/******************************************************************************/
+bool PosePredictor::PredictAtHostTime(int64_t host_time_ns,
+                                      PosePrediction* result) const {
+  State state;
+  Load(&state);
+  if (!state.valid || state.host_time_ns == INVALID_HOST_TIME) {
+    return false;
+  }
+
+  return Extrapolate(state, (host_time_ns - state.host_time_ns) * 1e-9,
+                     result);
+}
+
+/******************************************************************************/
+bool PosePredictor::UpdateRates(const IMUMeasurement& imu) {
+  if (!IsValidTime(imu.p1_time) || std::isnan(imu.gyro_rps[0]) ||
+      std::isnan(imu.gyro_rps[1]) || std::isnan(imu.gyro_rps[2])) {
+    return false;
+  }
+
+  state_.have_rates = true;
+  state_.imu_p1_time = imu.p1_time;
+  std::memcpy(state_.gyro_rps, imu.gyro_rps, sizeof(state_.gyro_rps));
+  std::memcpy(state_.gyro_std_rps, imu.gyro_std_rps,
+              sizeof(state_.gyro_std_rps));
+  return true;
+}
+
+/******************************************************************************/
+void PosePredictor::Publish() {
+  uint64_t words[NUM_WORDS] = {0};
+  std::memcpy(words, &state_, sizeof(state_));
+
+  // Sequence lock (single writer): the sequence number is odd while an update
+  // is in progress. The release fence orders the odd sequence number before
+  // the data, and the final release store orders the data before the even
+  // sequence number.
+  uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < NUM_WORDS; ++i) {
+    words_[i].store(words[i], std::memory_order_relaxed);
+  }
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+/******************************************************************************/
+void PosePredictor::Load(State* state) const {
+  uint64_t words[NUM_WORDS];
+  for (int attempt = 1;; ++attempt) {
+    // Updates are short, so spin briefly. If the writer was preempted in the
+    // middle of an update, yield so it can finish instead of burning the CPU.
+    if (attempt > MAX_SPINS) {
+      std::this_thread::yield();
+    }
+
+    uint32_t start = sequence_.load(std::memory_order_acquire);
+    if (start & 1) {
+      continue;
+    }
+
+    for (size_t i = 0; i < NUM_WORDS; ++i) {
+      words[i] = words_[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) == start) {
+      break;
+    }
+  }
+
+  std::memcpy(state, words, sizeof(*state));
+}
+
+/******************************************************************************/
+bool PosePredictor::Extrapolate(const State& state, double dt_sec,
+                                PosePrediction* result) const {
+  if (std::fabs(dt_sec) > config_.max_extrapolation_sec) {
+    return false;
+  }
+
+  *result = PosePrediction();
+  result->p1_time = AddSec(state.p1_time, dt_sec);
+  result->source_p1_time = state.p1_time;
+  result->extrapolation_sec = dt_sec;
+  result->solution_type = state.solution_type;
+
+  // Propagate attitude using the Euler angle rates computed from the body
+  // rotation rates (Z-Y-X convention).
+  double yaw = state.ypr_deg[0] * DEG_TO_RAD;
+  double pitch = state.ypr_deg[1] * DEG_TO_RAD;
+  double roll = state.ypr_deg[2] * DEG_TO_RAD;
+  double ypr_rate[3] = {0.0, 0.0, 0.0};
+  double ypr_rate_std[3] = {0.0, 0.0, 0.0};
+  // Attitude may not be available yet (e.g., before heading has converged). In
+  // that case, the attitude is reported as-is (NaN) and position is held.
+  bool have_attitude = !std::isnan(yaw) && !std::isnan(pitch) &&
+                       !std::isnan(roll);
+  bool use_rates = have_attitude && state.have_rates &&
+                   std::fabs(GetDifferenceSec(state.imu_p1_time,
+                                              state.p1_time)) <=
+                       config_.max_imu_age_sec &&
+                   std::fabs(std::cos(pitch)) > 1e-3;
+  if (use_rates) {
+    double p = state.gyro_rps[0], q = state.gyro_rps[1], r = state.gyro_rps[2];
+    double sr = std::sin(roll), cr = std::cos(roll);
+    ypr_rate[0] = (q * sr + r * cr) / std::cos(pitch);
+    ypr_rate[1] = q * cr - r * sr;
+    ypr_rate[2] = p + (q * sr + r * cr) * std::tan(pitch);
+
+    // Approximate the Euler rate uncertainty by the corresponding body axis
+    // rate uncertainty.
+    for (int i = 0; i < 3; ++i) {
+      double std_rps = state.gyro_std_rps[2 - i];
+      ypr_rate_std[i] = std::isnan(std_rps) ? 0.0 : std_rps;
+    }
+  }
+
+  double ypr[3] = {yaw, pitch, roll};
+  for (int i = 0; i < 3; ++i) {
+    result->ypr_deg[i] = (ypr[i] + ypr_rate[i] * dt_sec) * RAD_TO_DEG;
+    result->ypr_std_deg[i] = static_cast<float>(
+        std::sqrt(Square(state.ypr_std_deg[i]) +
+                  Square(ypr_rate_std[i] * dt_sec * RAD_TO_DEG)));
+  }
+
+  // Wrap yaw to [-180, 180].
+  if (result->ypr_deg[0] > 180.0) {
+    result->ypr_deg[0] -= 360.0;
+  } else if (result->ypr_deg[0] < -180.0) {
+    result->ypr_deg[0] += 360.0;
+  }
+
+  // Hold the body frame velocity constant and rotate it into ENU using the
+  // attitude at the middle of the interval. If velocity or attitude is not
+  // available, hold position.
+  std::memcpy(result->velocity_body_mps, state.velocity_body_mps,
+              sizeof(result->velocity_body_mps));
+  std::memcpy(result->lla_deg, state.lla_deg, sizeof(result->lla_deg));
+  std::memcpy(result->position_std_enu_m, state.position_std_enu_m,
+              sizeof(result->position_std_enu_m));
+  if (!have_attitude || std::isnan(state.velocity_body_mps[0]) ||
+      std::isnan(state.velocity_body_mps[1]) ||
+      std::isnan(state.velocity_body_mps[2])) {
+    return true;
+  }
+
+  double half_dt_sec = 0.5 * dt_sec;
+  double mid_ypr_deg[3];
+  for (int i = 0; i < 3; ++i) {
+    mid_ypr_deg[i] = (ypr[i] + ypr_rate[i] * half_dt_sec) * RAD_TO_DEG;
+  }
+
+  double C[9];
+  GetBodyToENURotation(mid_ypr_deg, C);
+
+  double velocity_enu_mps[3];
+  double velocity_var_enu[3];
+  for (int i = 0; i < 3; ++i) {
+    velocity_enu_mps[i] = 0.0;
+    velocity_var_enu[i] = 0.0;
+    for (int j = 0; j < 3; ++j) {
+      velocity_enu_mps[i] += C[i * 3 + j] * state.velocity_body_mps[j];
+      if (!std::isnan(state.velocity_std_body_mps[j])) {
+        velocity_var_enu[i] +=
+            Square(C[i * 3 + j]) * Square(state.velocity_std_body_mps[j]);
+      }
+    }
+  }
+
+  double lat_rad = state.lla_deg[0] * DEG_TO_RAD;
+  double meridian_radius_m, prime_vertical_radius_m;
+  GetRadiiOfCurvature(state.lla_deg[0], &meridian_radius_m,
+                      &prime_vertical_radius_m);
+  double altitude_m = state.lla_deg[2];
+
+  result->lla_deg[0] += velocity_enu_mps[1] * dt_sec /
+                        (meridian_radius_m + altitude_m) * RAD_TO_DEG;
+  result->lla_deg[1] +=
+      velocity_enu_mps[0] * dt_sec /
+      ((prime_vertical_radius_m + altitude_m) * std::cos(lat_rad)) *
+      RAD_TO_DEG;
+  result->lla_deg[2] += velocity_enu_mps[2] * dt_sec;
+
+  // Position uncertainty grows with the velocity uncertainty, and with the
+  // cross-track error caused by yaw uncertainty.
+  double speed_h_mps = std::hypot(velocity_enu_mps[0], velocity_enu_mps[1]);
+  double cross_track_std_m =
+      speed_h_mps * std::fabs(dt_sec) * result->ypr_std_deg[0] * DEG_TO_RAD;
+  double cross_track_dir[3] = {0.0, 0.0, 0.0};
+  if (speed_h_mps > 0.0) {
+    cross_track_dir[0] = -velocity_enu_mps[1] / speed_h_mps;
+    cross_track_dir[1] = velocity_enu_mps[0] / speed_h_mps;
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    double variance = Square(state.position_std_enu_m[i]) +
+                      velocity_var_enu[i] * dt_sec * dt_sec;
+    if (!std::isnan(cross_track_std_m)) {
+      variance += Square(cross_track_dir[i] * cross_track_std_m);
+    }
+    result->position_std_enu_m[i] = static_cast<float>(std::sqrt(variance));
+  }
+
+  return true;
+}
@@ -0,0 +1,223 @@
+/**************************************************************************/ /**
+ * @brief Low-latency pose prediction.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cmath> // For NAN
+#include <cstdint>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace realtime {
+
+class TimeSync;
+
+/**
+ * @defgroup pose_prediction Pose Prediction
+ * @brief Extrapolate the most recent pose to the current time.
+ * @{
+ */
+
+/**
+ * @brief A predicted pose.
+ */
+struct PosePrediction {
+  /** The time to which the pose was predicted, in P1 time. */
+  messages::Timestamp p1_time;
+
+  /** The P1 time of the pose message used for the prediction. */
+  messages::Timestamp source_p1_time;
+
+  /**
+   * The prediction interval (in seconds): @ref p1_time - @ref source_p1_time.
+   */
+  double extrapolation_sec = NAN;
+
+  /** The type of the source position solution. */
+  messages::SolutionType solution_type = messages::SolutionType::Invalid;
+
+  /** See @ref messages::PoseMessage::lla_deg. */
+  double lla_deg[3] = {NAN, NAN, NAN};
+
+  /** See @ref messages::PoseMessage::ypr_deg. */
+  double ypr_deg[3] = {NAN, NAN, NAN};
+
+  /** See @ref messages::PoseMessage::velocity_body_mps. */
+  double velocity_body_mps[3] = {NAN, NAN, NAN};
+
+  /**
+   * The position standard deviation (in meters), including the uncertainty
+   * accumulated during extrapolation.
+   */
+  float position_std_enu_m[3] = {NAN, NAN, NAN};
+
+  /**
+   * The attitude standard deviation (in degrees), including the uncertainty
+   * accumulated during extrapolation.
+   */
+  float ypr_std_deg[3] = {NAN, NAN, NAN};
+};
+
+/**
+ * @brief Predict the platform pose at the current time from the most recent
+ *        @ref messages::PoseMessage.
+ *
+ * Pose messages arrive some time after the solution time. This class
+ * extrapolates the latest pose forward to a requested time:
+ * - Attitude is propagated using the body rotation rates from the most recent
+ *   @ref messages::IMUMeasurement, if available.
+ * - The body frame velocity is assumed constant, and is rotated into the local
+ *   ENU frame using the attitude at the middle of the prediction interval, so
+ *   turns are followed.
+ * - Position, velocity, and attitude standard deviations grow with the
+ *   prediction interval, including the cross-track error caused by yaw
+ *   uncertainty.
+ * - Poses without a valid attitude (e.g., before heading has converged) are
+ *   accepted. Until attitude is available, the position is held and the
+ *   predicted attitude is NaN.
+ *
+ * A single thread (e.g., the thread decoding the incoming data) must call
+ * @ref OnPose(), @ref OnIMU(), @ref OnMessage(), and @ref Reset(). Any number
+ * of other threads may call @ref Predict() and @ref PredictAtHostTime()
+ * concurrently. The predictor state is published using a sequence lock, so
+ * readers never block the writer and never take a lock themselves: a read
+ * that overlaps an update is simply retried.
+ *
+ * ```{.cpp}
+ * // Decoding thread:
+ * predictor.OnMessage(header, payload, &time_sync);
+ *
+ * // Control thread:
+ * PosePrediction pose;
+ * if (predictor.PredictAtHostTime(now_ns, &pose)) {
+ *   ...
+ * }
+ * ```
+ */
+class P1_EXPORT PosePredictor {
+ public:
+  static constexpr int64_t INVALID_HOST_TIME = INT64_MIN;
+
+  struct Config {
+    /** Predictions further than this from the latest pose will fail. */
+    double max_extrapolation_sec = 1.0;
+
+    /**
+     * IMU measurements older or newer than this relative to the latest pose
+     * are not used to propagate attitude.
+     */
+    double max_imu_age_sec = 0.2;
+  };
+
+  PosePredictor() : PosePredictor(Config()) {}
+  explicit PosePredictor(const Config& config);
+
+  /**
+   * @brief Update the predictor with a new pose.
+   *
+   * @param pose The pose message.
+   * @param host_time_ns The host time corresponding to `pose.p1_time` (see
+   *        @ref TimeSync), or @ref INVALID_HOST_TIME if not known. Required by
+   *        @ref PredictAtHostTime().
+   */
+  void OnPose(const messages::PoseMessage& pose,
+              int64_t host_time_ns = INVALID_HOST_TIME);
+
+  /**
+   * @brief Update the rotation rates used to propagate attitude.
+   *
+   * @param imu The IMU measurement.
+   */
+  void OnIMU(const messages::IMUMeasurement& imu);
+
+  /**
+   * @brief Process an incoming message, calling @ref OnPose() or @ref OnIMU()
+   *        as appropriate.
+   *
+   * For @ref messages::IMUMeasurementBatch messages, the rotation rates are
+   * updated from each sample in the batch and the result is published once.
+   *
+   * @param header The message header.
+   * @param payload The message payload.
+   * @param time_sync If not `nullptr`, used to compute the host time for pose
+   *        messages.
+   */
+  void OnMessage(const messages::MessageHeader& header, const void* payload,
+                 const TimeSync* time_sync = nullptr);
+
+  /**
+   * @brief Clear the current state.
+   */
+  void Reset();
+
+  /**
+   * @brief Predict the pose at the specified P1 time.
+   *
+   * @param p1_time The desired time.
+   * @param[out] result The predicted pose.
+   *
+   * @return `true` on success, or `false` if no pose is available or the
+   *         requested time is too far from the latest pose.
+   */
+  bool Predict(const messages::Timestamp& p1_time,
+               PosePrediction* result) const;
+
+  /**
+   * @brief Predict the pose at the specified host time.
+   *
+   * @param host_time_ns The desired time.
+   * @param[out] result The predicted pose.
+   *
+   * @return `true` on success, or `false` if no pose is available, the host
+   *         time of the latest pose is not known, or the requested time is too
+   *         far from the latest pose.
+   */
+  bool PredictAtHostTime(int64_t host_time_ns, PosePrediction* result) const;
+
+ private:
+  // Note: This must be trivially copyable since it is published word-by-word.
+  struct State {
+    bool valid = false;
+    bool have_rates = false;
+    messages::SolutionType solution_type = messages::SolutionType::Invalid;
+    messages::Timestamp p1_time;
+    messages::Timestamp imu_p1_time;
+    int64_t host_time_ns = INVALID_HOST_TIME;
+    double lla_deg[3];
+    double ypr_deg[3];
+    double velocity_body_mps[3];
+    float position_std_enu_m[3];
+    float ypr_std_deg[3];
+    float velocity_std_body_mps[3];
+    double gyro_rps[3];
+    double gyro_std_rps[3];
+  };
+
+  static constexpr size_t NUM_WORDS = (sizeof(State) + 7) / 8;
+
+  bool UpdateRates(const messages::IMUMeasurement& imu);
+  void Publish();
+  void Load(State* state) const;
+  bool Extrapolate(const State& state, double dt_sec,
+                   PosePrediction* result) const;
+
+  Config config_;
+
+  // Writer-side copy of the state.
+  State state_;
+
+  std::atomic<uint32_t> sequence_;
+  std::atomic<uint64_t> words_[NUM_WORDS];
+};
+
+/** @} */
+
+} // namespace realtime
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,329 @@
+/**************************************************************************/ /**
+ * @brief Host clock to P1 time synchronization.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/realtime/time_sync.h"
+
+#include <cmath>
+#include <cstddef> // For offsetof()
+#include <cstring>
+
+#include "point_one/fusion_engine/messages/compact_pose.h"
+#include "point_one/fusion_engine/messages/imu_batch.h"
+#include "point_one/fusion_engine/messages/ros.h"
+
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::realtime;
+
+namespace {
+// Number of consecutive rejected windows after which the minimum latency is
+// assumed to have changed.
+constexpr int MAX_CONSECUTIVE_REJECTIONS = 3;
+
+// All messages with a P1 time store it at the start of the payload.
+static_assert(offsetof(PoseMessage, p1_time) == 0, "Unexpected layout.");
+static_assert(offsetof(PoseAuxMessage, p1_time) == 0, "Unexpected layout.");
+static_assert(offsetof(CompactPoseMessage, p1_time) == 0, "Unexpected layout.");
+static_assert(offsetof(GNSSInfoMessage, p1_time) == 0, "Unexpected layout.");
+static_assert(offsetof(GNSSSatelliteMessage, p1_time) == 0,
+              "Unexpected layout.");
+static_assert(offsetof(IMUMeasurement, p1_time) == 0, "Unexpected layout.");
+static_assert(offsetof(IMUMeasurementBatch, p1_time) == 0,
+              "Unexpected layout.");
+static_assert(offsetof(ros::PoseMessage, p1_time) == 0, "Unexpected layout.");
+static_assert(offsetof(ros::GPSFixMessage, p1_time) == 0,
+              "Unexpected layout.");
+static_assert(offsetof(ros::IMUMessage, p1_time) == 0, "Unexpected layout.");
+
+/******************************************************************************/
+bool IsValidTime(const Timestamp& time) {
+  return time.seconds != Timestamp::INVALID &&
+         time.fraction_ns != Timestamp::INVALID;
+}
+} // namespace
+
+/******************************************************************************/
+TimeSyncEstimator::TimeSyncEstimator(const Config& config) : config_(config) {
+  if (config_.num_windows < 2) {
+    config_.num_windows = 2;
+  }
+  points_.reserve(config_.num_windows);
+}
+
+/******************************************************************************/
+void TimeSyncEstimator::AddSample(const Timestamp& p1_time,
+                                  int64_t host_time_ns) {
+  if (!IsValidTime(p1_time)) {
+    return;
+  }
+
+  ++stats_.num_samples;
+  if (!valid_) {
+    Start(p1_time, host_time_ns);
+    return;
+  }
+
+  double p1_sec = GetRelativeP1Sec(p1_time);
+  double delay_sec = (host_time_ns - host_reference_ns_) * 1e-9 - p1_sec;
+
+  // Restart if P1 time went backward (e.g., the device restarted), or if the
+  // delay is impossibly small (e.g., the host clock jumped).
+  if (p1_sec < last_p1_sec_ - config_.reset_threshold_sec ||
+      delay_sec <
+          offset_ + drift_ * p1_sec - config_.reset_threshold_sec) {
+    ++stats_.num_resets;
+    Start(p1_time, host_time_ns);
+    return;
+  }
+
+  if (p1_sec > last_p1_sec_) {
+    last_p1_sec_ = p1_sec;
+  }
+
+  // Track the minimum delay within the current window. When a new window
+  // starts, add the previous window's minimum to the fit.
+  int64_t window_index =
+      static_cast<int64_t>(std::floor(p1_sec / config_.window_sec));
+  if (window_index > window_index_) {
+    CloseWindow();
+    window_index_ = window_index;
+    window_min_ = {p1_sec, delay_sec};
+  } else if (delay_sec < window_min_.delay_sec) {
+    window_min_ = {p1_sec, delay_sec};
+  }
+
+  // Until the first window is complete, use the minimum delay so far.
+  if (points_.empty() && delay_sec < offset_) {
+    offset_ = delay_sec;
+  }
+}
+
+/******************************************************************************/
+void TimeSyncEstimator::Reset() {
+  valid_ = false;
+  points_.clear();
+  next_point_ = 0;
+  consecutive_rejections_ = 0;
+}
+
+/******************************************************************************/
+bool TimeSyncEstimator::P1ToHost(const Timestamp& p1_time,
+                                 int64_t* host_time_ns) const {
+  if (!valid_ || !IsValidTime(p1_time)) {
+    return false;
+  }
+
+  double p1_sec = GetRelativeP1Sec(p1_time);
+  double host_sec = p1_sec + offset_ + drift_ * p1_sec;
+  *host_time_ns = host_reference_ns_ + std::llround(host_sec * 1e9);
+  return true;
+}
+
+/******************************************************************************/
+bool TimeSyncEstimator::HostToP1(int64_t host_time_ns,
+                                 Timestamp* p1_time) const {
+  if (!valid_) {
+    return false;
+  }
+
+  double host_sec = (host_time_ns - host_reference_ns_) * 1e-9;
+  double p1_sec = (host_sec - offset_) / (1.0 + drift_);
+  int64_t p1_ns = p1_reference_.seconds * 1000000000LL +
+                  p1_reference_.fraction_ns + std::llround(p1_sec * 1e9);
+  if (p1_ns < 0) {
+    return false;
+  }
+
+  p1_time->seconds = static_cast<uint32_t>(p1_ns / 1000000000LL);
+  p1_time->fraction_ns = static_cast<uint32_t>(p1_ns % 1000000000LL);
+  return true;
+}
+
+/******************************************************************************/
+double TimeSyncEstimator::GetOffsetSec() const {
+  if (!valid_) {
+    return NAN;
+  }
+
+  return (host_reference_ns_ * 1e-9 - p1_reference_.seconds -
+          p1_reference_.fraction_ns * 1e-9) +
+         offset_ + drift_ * last_p1_sec_;
+}
+
+/******************************************************************************/
+void TimeSyncEstimator::Start(const Timestamp& p1_time, int64_t host_time_ns) {
+  Reset();
+  valid_ = true;
+  p1_reference_ = p1_time;
+  host_reference_ns_ = host_time_ns;
+  offset_ = 0.0;
+  drift_ = 0.0;
+  last_p1_sec_ = 0.0;
+  window_index_ = 0;
+  window_min_ = {0.0, 0.0};
+}
+
+/******************************************************************************/
+double TimeSyncEstimator::GetRelativeP1Sec(const Timestamp& p1_time) const {
+  return (static_cast<int64_t>(p1_time.seconds) -
+          static_cast<int64_t>(p1_reference_.seconds)) +
+         (static_cast<int64_t>(p1_time.fraction_ns) -
+          static_cast<int64_t>(p1_reference_.fraction_ns)) *
+             1e-9;
+}
+
+/******************************************************************************/
+void TimeSyncEstimator::CloseWindow() {
+  ++stats_.num_windows;
+
+  // Reject windows where every message was delayed. If that happens several
+  // times in a row, the minimum latency itself has most likely changed:
+  // restart the fit from the latest window, keeping the current drift.
+  if (points_.size() >= 2) {
+    double residual_sec =
+        window_min_.delay_sec - (offset_ + drift_ * window_min_.p1_sec);
+    if (residual_sec > config_.outlier_threshold_sec) {
+      ++stats_.num_windows_rejected;
+      if (++consecutive_rejections_ < MAX_CONSECUTIVE_REJECTIONS) {
+        return;
+      }
+
+      points_.clear();
+      next_point_ = 0;
+    }
+  }
+
+  consecutive_rejections_ = 0;
+
+  if (points_.size() < config_.num_windows) {
+    points_.push_back(window_min_);
+  } else {
+    points_[next_point_] = window_min_;
+    next_point_ = (next_point_ + 1) % config_.num_windows;
+  }
+
+  Fit();
+}
+
+/******************************************************************************/
+void TimeSyncEstimator::Fit() {
+  if (points_.size() == 1) {
+    offset_ = points_[0].delay_sec - drift_ * points_[0].p1_sec;
+    return;
+  }
+
+  // Least squares fit to the window minima, followed by a second pass
+  // excluding any minima that are now far above the first fit.
+  for (int pass = 0; pass < 2; ++pass) {
+    double n = 0.0, sum_x = 0.0, sum_y = 0.0;
+    for (const auto& point : points_) {
+      if (pass == 0 || point.delay_sec - (offset_ + drift_ * point.p1_sec) <=
+                           config_.outlier_threshold_sec) {
+        n += 1.0;
+        sum_x += point.p1_sec;
+        sum_y += point.delay_sec;
+      }
+    }
+
+    if (n < 2.0) {
+      break;
+    }
+
+    double mean_x = sum_x / n;
+    double mean_y = sum_y / n;
+    double s_xx = 0.0, s_xy = 0.0;
+    for (const auto& point : points_) {
+      if (pass == 0 || point.delay_sec - (offset_ + drift_ * point.p1_sec) <=
+                           config_.outlier_threshold_sec) {
+        double dx = point.p1_sec - mean_x;
+        s_xx += dx * dx;
+        s_xy += dx * (point.delay_sec - mean_y);
+      }
+    }
+
+    double drift = s_xx > 0.0 ? s_xy / s_xx : drift_;
+    double offset = mean_y - drift * mean_x;
+    drift_ = drift;
+    offset_ = offset;
+  }
+}
+
+namespace point_one {
+namespace fusion_engine {
+namespace realtime {
+
+/******************************************************************************/
+bool GetMessageP1Time(const MessageHeader& header, const void* payload,
+                      Timestamp* p1_time) {
+  switch (header.message_type) {
+    case MessageType::POSE:
+    case MessageType::GNSS_INFO:
+    case MessageType::GNSS_SATELLITE:
+    case MessageType::POSE_AUX:
+    case MessageType::COMPACT_POSE:
+    case MessageType::IMU_MEASUREMENT:
+    case MessageType::IMU_MEASUREMENT_BATCH:
+    case MessageType::ROS_POSE:
+    case MessageType::ROS_GPS_FIX:
+    case MessageType::ROS_IMU:
+      if (header.payload_size_bytes < sizeof(Timestamp)) {
+        return false;
+      }
+
+      std::memcpy(p1_time, payload, sizeof(Timestamp));
+      return IsValidTime(*p1_time);
+
+    default:
+      return false;
+  }
+}
+
+} // namespace realtime
+} // namespace fusion_engine
+} // namespace point_one
+
+/******************************************************************************/
+void TimeSync::OnMessage(const MessageHeader& header, const void* payload,
+                         int64_t host_time_ns) {
+  Timestamp p1_time;
+  if (!GetMessageP1Time(header, payload, &p1_time)) {
+    return;
+  }
+
+  if (last_estimator_ == nullptr ||
+      header.source_identifier != last_source_) {
+    last_source_ = header.source_identifier;
+    last_estimator_ =
+        &estimators_.emplace(header.source_identifier, config_).first->second;
+  }
+
+  last_estimator_->AddSample(p1_time, host_time_ns);
+}
+
+/******************************************************************************/
+bool TimeSync::P1ToHost(uint32_t source_identifier, const Timestamp& p1_time,
+                        int64_t* host_time_ns) const {
+  const TimeSyncEstimator* estimator = GetEstimator(source_identifier);
+  return estimator != nullptr && estimator->P1ToHost(p1_time, host_time_ns);
+}
+
+/******************************************************************************/
+bool TimeSync::HostToP1(uint32_t source_identifier, int64_t host_time_ns,
+                        Timestamp* p1_time) const {
+  const TimeSyncEstimator* estimator = GetEstimator(source_identifier);
+  return estimator != nullptr && estimator->HostToP1(host_time_ns, p1_time);
+}
+
+/******************************************************************************/
+const TimeSyncEstimator* TimeSync::GetEstimator(
+    uint32_t source_identifier) const {
+  auto it = estimators_.find(source_identifier);
+  return it == estimators_.end() ? nullptr : &it->second;
+}
+
+/******************************************************************************/
+void TimeSync::Reset() {
+  estimators_.clear();
+  last_estimator_ = nullptr;
+}
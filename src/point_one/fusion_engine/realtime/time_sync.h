@@ -0,0 +1,299 @@
+/**************************************************************************/ /**
+ * @brief Host clock to P1 time synchronization.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility> // For std::move()
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace realtime {
+
+/**
+ * @defgroup time_sync Host Time Synchronization
+ * @brief Map P1 time to a host clock using message arrival times.
+ *
+ * When fusing FusionEngine output with other sensors, each message's P1 time
+ * must be expressed in the host's time base (e.g., `CLOCK_MONOTONIC`). The host
+ * only observes the time at which each message arrived, which is the true time
+ * of the solution plus a transport latency that varies with queuing delays:
+ *
+ * ```
+ * host_arrival = P1 time + offset + drift * P1 time + queuing delay (>= 0)
+ * ```
+ *
+ * @ref TimeSyncEstimator tracks the _lower envelope_ of the arrival delays: it
+ * keeps the minimum delay observed within each window of P1 time and fits a
+ * line (offset and drift) to the most recent window minima. Messages delayed
+ * by queuing never define a window minimum unless every message in the window
+ * was delayed, in which case the window is rejected as an outlier when
+ * compared with the fit. The resulting offset includes the minimum transport
+ * latency.
+ *
+ * Each sample costs a few arithmetic operations, with a refit of at most
+ * @ref TimeSyncEstimator::Config::num_windows points once per window, and
+ * conversions are O(1).
+ * @{
+ */
+
+/**
+ * @brief Estimate the relationship between P1 time and a host clock for a
+ *        single device.
+ */
+class P1_EXPORT TimeSyncEstimator {
+ public:
+  struct Config {
+    /** The length of each lower envelope window (in P1 time). */
+    double window_sec = 1.0;
+
+    /** The number of window minima used to fit offset and drift. */
+    size_t num_windows = 30;
+
+    /**
+     * Window minima further above the fit than this are rejected as queuing
+     * delay outliers. If 3 consecutive windows are rejected, the minimum
+     * latency is assumed to have changed and the fit is restarted from the
+     * latest window.
+     */
+    double outlier_threshold_sec = 0.002;
+
+    /**
+     * Reset the estimate if P1 time jumps backward or a delay is this far
+     * below the fit (e.g., the device restarted or the host clock jumped).
+     */
+    double reset_threshold_sec = 0.5;
+  };
+
+  struct Statistics {
+    uint64_t num_samples = 0;
+    uint64_t num_windows = 0;
+    uint64_t num_windows_rejected = 0;
+    uint64_t num_resets = 0;
+  };
+
+  TimeSyncEstimator() : TimeSyncEstimator(Config()) {}
+  explicit TimeSyncEstimator(const Config& config);
+
+  /**
+   * @brief Add a measurement.
+   *
+   * @param p1_time The P1 time of the received message.
+   * @param host_time_ns The host time at which the message arrived.
+   */
+  void AddSample(const messages::Timestamp& p1_time, int64_t host_time_ns);
+
+  /**
+   * @brief Clear the current estimate.
+   */
+  void Reset();
+
+  /**
+   * @brief Check if an estimate is available (i.e., at least one sample has
+   *        been received since the last reset).
+   */
+  bool IsValid() const { return valid_; }
+
+  /**
+   * @brief Convert a P1 time to host time.
+   *
+   * @param p1_time The P1 time to convert.
+   * @param[out] host_time_ns The corresponding host time.
+   *
+   * @return `true` on success, or `false` if no estimate is available or the
+   *         P1 time is invalid.
+   */
+  bool P1ToHost(const messages::Timestamp& p1_time,
+                int64_t* host_time_ns) const;
+
+  /**
+   * @brief Convert a host time to P1 time.
+   *
+   * @param host_time_ns The host time to convert.
+   * @param[out] p1_time The corresponding P1 time.
+   *
+   * @return `true` on success, or `false` if no estimate is available.
+   */
+  bool HostToP1(int64_t host_time_ns, messages::Timestamp* p1_time) const;
+
+  /**
+   * @brief Get the estimated host time minus P1 time at the most recent
+   *        sample (in seconds), including the minimum transport latency.
+   */
+  double GetOffsetSec() const;
+
+  /**
+   * @brief Get the estimated host clock drift relative to P1 time (in parts
+   *        per million).
+   */
+  double GetDriftPPM() const { return drift_ * 1e6; }
+
+  const Statistics& GetStatistics() const { return stats_; }
+
+ private:
+  struct Point {
+    double p1_sec;
+    double delay_sec;
+  };
+
+  void Start(const messages::Timestamp& p1_time, int64_t host_time_ns);
+  double GetRelativeP1Sec(const messages::Timestamp& p1_time) const;
+  void CloseWindow();
+  void Fit();
+
+  Config config_;
+  Statistics stats_;
+
+  bool valid_ = false;
+  messages::Timestamp p1_reference_;
+  int64_t host_reference_ns_ = 0;
+
+  // Delays are expressed as `host - host_reference - (p1 - p1_reference)`.
+  double offset_ = 0.0;
+  double drift_ = 0.0;
+  double last_p1_sec_ = 0.0;
+
+  int64_t window_index_ = 0;
+  Point window_min_ = {0.0, 0.0};
+
+  std::vector<Point> points_;
+  size_t next_point_ = 0;
+  int consecutive_rejections_ = 0;
+};
+
+/**
+ * @brief Get the P1 time of a message.
+ *
+ * @param header The message header.
+ * @param payload The message payload.
+ * @param[out] p1_time The P1 time of the message.
+ *
+ * @return `true` on success, or `false` if the message does not include a
+ *         valid P1 time.
+ */
+P1_EXPORT bool GetMessageP1Time(const messages::MessageHeader& header,
+                                const void* payload,
+                                messages::Timestamp* p1_time);
+
+/**
+ * @brief Maintain a separate @ref TimeSyncEstimator for each @ref
+ *        messages::MessageHeader::source_identifier.
+ *
+ * ```{.cpp}
+ * TimeSync sync;
+ * framer.SetMessageCallback(
+ *     [&](const MessageHeader& header, const void* payload, uint64_t) {
+ *       timespec now;
+ *       clock_gettime(CLOCK_MONOTONIC, &now);
+ *       int64_t now_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+ *       sync.OnMessage(header, payload, now_ns);
+ *       ...
+ *       int64_t host_time_ns;
+ *       if (sync.P1ToHost(header.source_identifier, pose.p1_time,
+ *                         &host_time_ns)) {
+ *         ...
+ *       }
+ *     });
+ * ```
+ */
+class P1_EXPORT TimeSync {
+ public:
+  explicit TimeSync(
+      const TimeSyncEstimator::Config& config = TimeSyncEstimator::Config())
+      : config_(config) {}
+
+  // Note: The cached estimator pointer refers to this object's map, so it is
+  // not copied or moved.
+  TimeSync(const TimeSync& other)
+      : config_(other.config_), estimators_(other.estimators_) {}
+  TimeSync(TimeSync&& other) noexcept
+      : config_(other.config_), estimators_(std::move(other.estimators_)) {
+    other.last_estimator_ = nullptr;
+  }
+  TimeSync& operator=(const TimeSync& other) {
+    config_ = other.config_;
+    estimators_ = other.estimators_;
+    last_estimator_ = nullptr;
+    return *this;
+  }
+  TimeSync& operator=(TimeSync&& other) noexcept {
+    config_ = other.config_;
+    estimators_ = std::move(other.estimators_);
+    last_estimator_ = nullptr;
+    other.last_estimator_ = nullptr;
+    return *this;
+  }
+
+  /**
+   * @brief Process an incoming message. Messages that do not contain a P1
+   *        time are ignored.
+   *
+   * @param header The message header.
+   * @param payload The message payload.
+   * @param host_time_ns The host time at which the message arrived.
+   */
+  void OnMessage(const messages::MessageHeader& header, const void* payload,
+                 int64_t host_time_ns);
+
+  /**
+   * @brief Convert a P1 time from the specified source to host time.
+   *
+   * @param source_identifier The source of the P1 time.
+   * @param p1_time The P1 time to convert.
+   * @param[out] host_time_ns The corresponding host time.
+   *
+   * @return `true` on success, or `false` if no estimate is available for the
+   *         source or the P1 time is invalid.
+   */
+  bool P1ToHost(uint32_t source_identifier, const messages::Timestamp& p1_time,
+                int64_t* host_time_ns) const;
+
+  /**
+   * @brief Convert a host time to P1 time for the specified source.
+   *
+   * @param source_identifier The desired P1 time source.
+   * @param host_time_ns The host time to convert.
+   * @param[out] p1_time The corresponding P1 time.
+   *
+   * @return `true` on success, or `false` if no estimate is available for the
+   *         source.
+   */
+  bool HostToP1(uint32_t source_identifier, int64_t host_time_ns,
+                messages::Timestamp* p1_time) const;
+
+  /**
+   * @brief Get the estimator for the specified source.
+   *
+   * @return The estimator, or `nullptr` if no messages have been received
+   *         from the source.
+   */
+  const TimeSyncEstimator* GetEstimator(uint32_t source_identifier) const;
+
+  /**
+   * @brief Clear all estimates.
+   */
+  void Reset();
+
+ private:
+  TimeSyncEstimator::Config config_;
+  std::unordered_map<uint32_t, TimeSyncEstimator> estimators_;
+
+  // The most recently used estimator, to avoid a lookup in the common case of
+  // a single source.
+  uint32_t last_source_ = 0;
+  TimeSyncEstimator* last_estimator_ = nullptr;
+};
+
+/** @} */
+
+} // namespace realtime
+} // namespace fusion_engine
+} // namespace point_one
@@ -0,0 +1,170 @@
+/**************************************************************************/ /**
+ * @brief JSON encoding of FusionEngine messages.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/server/json_encoder.h"
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "point_one/fusion_engine/messages/imu_batch.h"
+#include "point_one/fusion_engine/messages/reflection.h"
+
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::server;
+
+namespace {
+/******************************************************************************/
+void AppendValue(double value, FieldType type, std::string* json) {
+  if (std::isnan(value) || std::isinf(value)) {
+    json->append("null");
+    return;
+  }
+
+  char buffer[32];
+  switch (type) {
+    case FieldType::FLOAT:
+      std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+      break;
+    case FieldType::DOUBLE:
+      std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+      break;
+    case FieldType::TIMESTAMP:
+      std::snprintf(buffer, sizeof(buffer), "%.9f", value);
+      break;
+    default:
+      std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+      break;
+  }
+  json->append(buffer);
+}
+
+/******************************************************************************/
+// Append the fields of a structure as `"name":value` pairs, without the
+// enclosing braces.
+void AppendFields(const void* data, const FieldDescriptor* fields,
+                  size_t num_fields, std::string* json) {
+  bool first = true;
+  for (size_t i = 0; i < num_fields; ++i) {
+    const FieldDescriptor& field = fields[i];
+    if (std::strncmp(field.name, "reserved", 8) == 0) {
+      continue;
+    }
+
+    if (!first) {
+      json->push_back(',');
+    }
+    first = false;
+
+    json->push_back('"');
+    json->append(field.name);
+    json->append("\":");
+    if (field.array_length == 0) {
+      AppendValue(GetFieldValue(data, field), field.type, json);
+    } else {
+      json->push_back('[');
+      for (size_t j = 0; j < field.array_length; ++j) {
+        if (j > 0) {
+          json->push_back(',');
+        }
+        AppendValue(GetFieldValue(data, field, j), field.type, json);
+      }
+      json->push_back(']');
+    }
+  }
+}
+
+/******************************************************************************/
+template <typename T>
+void AppendObject(const T& object, std::string* json) {
+  typedef MessageReflection<T> Reflection;
+  json->push_back('{');
+  AppendFields(&object, Reflection::fields, Reflection::NUM_FIELDS, json);
+  json->push_back('}');
+}
+} // namespace
+
+namespace point_one {
+namespace fusion_engine {
+namespace server {
+
+/******************************************************************************/
+bool EncodeMessageJSON(const MessageHeader& header, const void* payload,
+                       std::string* json) {
+  const MessageDescriptor* descriptor =
+      GetMessageDescriptor(header.message_type);
+  if (descriptor != nullptr &&
+      header.payload_size_bytes < descriptor->size_bytes) {
+    return false;
+  }
+
+  // Validate variable-length payloads before writing anything.
+  const uint8_t* payload_bytes = static_cast<const uint8_t*>(payload);
+  GNSSSatelliteMessage satellite_message;
+  if (header.message_type == MessageType::GNSS_SATELLITE) {
+    std::memcpy(&satellite_message, payload, sizeof(satellite_message));
+    if (header.payload_size_bytes <
+        sizeof(GNSSSatelliteMessage) +
+            satellite_message.num_satellites * sizeof(SatelliteInfo)) {
+      return false;
+    }
+  }
+
+  IMUBatchView imu_batch(payload, header.payload_size_bytes);
+  if (header.message_type == MessageType::IMU_MEASUREMENT_BATCH &&
+      !imu_batch.IsValid()) {
+    return false;
+  }
+
+  char buffer[96];
+  std::snprintf(buffer, sizeof(buffer),
+                "{\"type\":\"%s\",\"message_type\":%u,\"source\":%" PRIu32
+                ",\"sequence\":%" PRIu32 ",\"data\":",
+                descriptor != nullptr ? descriptor->name : "Unknown",
+                static_cast<unsigned>(header.message_type),
+                header.source_identifier, header.sequence_number);
+  json->append(buffer);
+
+  if (descriptor == nullptr) {
+    json->append("null}");
+    return true;
+  }
+
+  json->push_back('{');
+  AppendFields(payload, descriptor->fields, descriptor->num_fields, json);
+
+  if (header.message_type == MessageType::GNSS_SATELLITE) {
+    json->append(",\"satellites\":[");
+    for (size_t i = 0; i < satellite_message.num_satellites; ++i) {
+      SatelliteInfo satellite;
+      std::memcpy(&satellite,
+                  payload_bytes + sizeof(GNSSSatelliteMessage) +
+                      i * sizeof(SatelliteInfo),
+                  sizeof(satellite));
+      if (i > 0) {
+        json->push_back(',');
+      }
+      AppendObject(satellite, json);
+    }
+    json->push_back(']');
+  } else if (header.message_type == MessageType::IMU_MEASUREMENT_BATCH) {
+    json->append(",\"samples\":[");
+    for (size_t i = 0; i < imu_batch.size(); ++i) {
+      if (i > 0) {
+        json->push_back(',');
+      }
+      AppendObject(imu_batch[i], json);
+    }
+    json->push_back(']');
+  }
+
+  json->append("}}");
+  return true;
+}
+
+} // namespace server
+} // namespace fusion_engine
+} // namespace point_one
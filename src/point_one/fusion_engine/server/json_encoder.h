@@ -0,0 +1,58 @@
+/**************************************************************************/ /**
+ * @brief JSON encoding of FusionEngine messages.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <string>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace server {
+
+/**
+ * @defgroup server Streaming Server
+ * @brief Stream decoded messages to remote clients (e.g., browser
+ *        dashboards).
+ * @{
+ */
+
+/**
+ * @brief Encode a message as a JSON object.
+ *
+ * The message fields are described by @ref messages::MessageReflection, and
+ * are written as a `data` object keyed by field name (reserved fields are
+ * omitted). For example:
+ *
+ * ```
+ * {"type":"PoseMessage","message_type":10000,"source":0,"sequence":12,
+ *  "data":{"p1_time":1234.5,"gps_time":1300000000.1,"solution_type":4,
+ *          "lla_deg":[37.7,-122.4,10.2],...}}
+ * ```
+ *
+ * Timestamps are written in seconds and `NAN` values as `null`. The satellites
+ * in a @ref messages::GNSSSatelliteMessage and the samples in a @ref
+ * messages::IMUMeasurementBatch are written as a `satellites` or `samples`
+ * array within `data`. Messages without reflection metadata are written with
+ * `"data":null`.
+ *
+ * @param header The message header.
+ * @param payload The message payload.
+ * @param[out] json The encoded message. The JSON text is appended to any
+ *        existing contents.
+ *
+ * @return `true` on success, or `false` if the payload is too small for the
+ *         message type.
+ */
+P1_EXPORT bool EncodeMessageJSON(const messages::MessageHeader& header,
+                                 const void* payload, std::string* json);
+
+/** @} */
+
+} // namespace server
+} // namespace fusion_engine
+} // namespace point_one
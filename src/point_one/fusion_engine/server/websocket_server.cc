@@ -0,0 +1,785 @@
+/**************************************************************************/ /**
+ * @brief WebSocket server for streaming messages to remote clients.
+ * @file
+ ******************************************************************************/
+
+#include "point_one/fusion_engine/server/websocket_server.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "point_one/fusion_engine/server/json_encoder.h"
+
+using namespace point_one::fusion_engine::messages;
+using namespace point_one::fusion_engine::server;
+
+namespace {
+constexpr const char* WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+constexpr uint8_t OPCODE_CONTINUATION = 0x0;
+constexpr uint8_t OPCODE_TEXT = 0x1;
+constexpr uint8_t OPCODE_BINARY = 0x2;
+constexpr uint8_t OPCODE_CLOSE = 0x8;
+constexpr uint8_t OPCODE_PING = 0x9;
+constexpr uint8_t OPCODE_PONG = 0xA;
+
+// Limits on client input, to bound memory use for misbehaving clients.
+constexpr size_t MAX_HANDSHAKE_BYTES = 8192;
+constexpr size_t MAX_CLIENT_FRAME_BYTES = 4096;
+
+// Rate limits allow messages up to this fraction of the interval early, so
+// that timing jitter does not drop messages arriving at exactly the limit.
+constexpr double RATE_LIMIT_TOLERANCE = 0.1;
+
+constexpr int POLL_TIMEOUT_MS = 1000;
+
+#if defined(MSG_NOSIGNAL)
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+/******************************************************************************/
+int64_t GetSteadyTimeNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/******************************************************************************/
+bool SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/******************************************************************************/
+inline uint32_t RotateLeft(uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+/******************************************************************************/
+// Compute the SHA-1 digest of a string (used only for the WebSocket handshake,
+// as required by RFC 6455).
+void ComputeSHA1(const std::string& input, uint8_t digest[20]) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                   0xC3D2E1F0};
+
+  std::string message = input;
+  uint64_t length_bits = static_cast<uint64_t>(input.size()) * 8;
+  message.push_back(static_cast<char>(0x80));
+  while (message.size() % 64 != 56) {
+    message.push_back('\0');
+  }
+  for (int i = 7; i >= 0; --i) {
+    message.push_back(static_cast<char>((length_bits >> (i * 8)) & 0xFF));
+  }
+
+  for (size_t chunk = 0; chunk < message.size(); chunk += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+      const uint8_t* p =
+          reinterpret_cast<const uint8_t*>(message.data()) + chunk + i * 4;
+      w[i] = (static_cast<uint32_t>(p[0]) << 24) |
+             (static_cast<uint32_t>(p[1]) << 16) |
+             (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+    for (int i = 16; i < 80; ++i) {
+      w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = RotateLeft(b, 30);
+      b = a;
+      a = temp;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+
+  for (int i = 0; i < 5; ++i) {
+    digest[i * 4] = static_cast<uint8_t>(h[i] >> 24);
+    digest[i * 4 + 1] = static_cast<uint8_t>(h[i] >> 16);
+    digest[i * 4 + 2] = static_cast<uint8_t>(h[i] >> 8);
+    digest[i * 4 + 3] = static_cast<uint8_t>(h[i]);
+  }
+}
+
+/******************************************************************************/
+std::string EncodeBase64(const uint8_t* data, size_t size) {
+  static const char ALPHABET[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string result;
+  for (size_t i = 0; i < size; i += 3) {
+    uint32_t value = static_cast<uint32_t>(data[i]) << 16;
+    if (i + 1 < size) {
+      value |= static_cast<uint32_t>(data[i + 1]) << 8;
+    }
+    if (i + 2 < size) {
+      value |= data[i + 2];
+    }
+    result.push_back(ALPHABET[(value >> 18) & 0x3F]);
+    result.push_back(ALPHABET[(value >> 12) & 0x3F]);
+    result.push_back(i + 1 < size ? ALPHABET[(value >> 6) & 0x3F] : '=');
+    result.push_back(i + 2 < size ? ALPHABET[value & 0x3F] : '=');
+  }
+  return result;
+}
+
+/******************************************************************************/
+// Append a server-to-client (unmasked) frame header.
+void AppendFrameHeader(uint8_t opcode, size_t size, std::string* frame) {
+  frame->push_back(static_cast<char>(0x80 | opcode));
+  if (size < 126) {
+    frame->push_back(static_cast<char>(size));
+  } else if (size <= 0xFFFF) {
+    frame->push_back(static_cast<char>(126));
+    frame->push_back(static_cast<char>(size >> 8));
+    frame->push_back(static_cast<char>(size & 0xFF));
+  } else {
+    frame->push_back(static_cast<char>(127));
+    for (int i = 7; i >= 0; --i) {
+      frame->push_back(
+          static_cast<char>((static_cast<uint64_t>(size) >> (i * 8)) & 0xFF));
+    }
+  }
+}
+
+/******************************************************************************/
+std::string DecodePercent(const std::string& input) {
+  std::string result;
+  for (size_t i = 0; i < input.size(); ++i) {
+    if (input[i] == '%' && i + 2 < input.size() &&
+        std::isxdigit(static_cast<unsigned char>(input[i + 1])) &&
+        std::isxdigit(static_cast<unsigned char>(input[i + 2]))) {
+      result.push_back(static_cast<char>(
+          std::strtol(input.substr(i + 1, 2).c_str(), nullptr, 16)));
+      i += 2;
+    } else {
+      result.push_back(input[i]);
+    }
+  }
+  return result;
+}
+
+/******************************************************************************/
+// Find the value of an HTTP header (case-insensitive name match).
+bool FindHeader(const std::string& request, const char* name,
+                std::string* value) {
+  size_t name_length = std::strlen(name);
+  size_t line_start = request.find("\r\n");
+  while (line_start != std::string::npos) {
+    line_start += 2;
+    size_t line_end = request.find("\r\n", line_start);
+    if (line_end == std::string::npos || line_end == line_start) {
+      break;
+    }
+
+    if (line_end - line_start > name_length &&
+        request[line_start + name_length] == ':') {
+      bool match = true;
+      for (size_t i = 0; i < name_length && match; ++i) {
+        match = std::tolower(static_cast<unsigned char>(
+                    request[line_start + i])) == name[i];
+      }
+      if (match) {
+        size_t begin = line_start + name_length + 1;
+        while (begin < line_end && request[begin] == ' ') {
+          ++begin;
+        }
+        size_t end = line_end;
+        while (end > begin && request[end - 1] == ' ') {
+          --end;
+        }
+        *value = request.substr(begin, end - begin);
+        return true;
+      }
+    }
+    line_start = line_end;
+  }
+  return false;
+}
+} // namespace
+
+/******************************************************************************/
+struct WebSocketServer::Client {
+  // The following are only modified by the I/O thread. Fields read by
+  // Publish() are modified while holding the server mutex.
+  int fd = -1;
+  bool upgraded = false;
+  bool closing = false;
+  std::string input;
+
+  // Subscription.
+  std::vector<uint16_t> types; // Sorted. Empty to accept all types.
+  int64_t min_interval_ns = 0;
+  Format format = Format::JSON;
+
+  // Rate limit state, used by Publish() (guarded by the server mutex).
+  std::vector<std::pair<uint16_t, int64_t>> last_sent_ns;
+
+  // Frames queued for the client (guarded by the server mutex). Frames may be
+  // shared with other clients.
+  std::deque<Frame> pending;
+
+  // Frames being sent (I/O thread only).
+  std::deque<Frame> sending;
+  size_t send_offset = 0;
+
+  // The total size of the pending and sending queues.
+  std::atomic<size_t> queue_bytes{0};
+};
+
+/******************************************************************************/
+WebSocketServer::WebSocketServer(const Config& config)
+    : config_(config), running_(false), wake_pending_(false) {}
+
+/******************************************************************************/
+WebSocketServer::~WebSocketServer() { Stop(); }
+
+/******************************************************************************/
+bool WebSocketServer::Start() {
+  if (running_) {
+    return false;
+  }
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(config_.port);
+  if (inet_pton(AF_INET, config_.bind_address.c_str(), &address.sin_addr) !=
+      1) {
+    return false;
+  }
+
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    return false;
+  }
+
+  int enable = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  socklen_t address_size = sizeof(address);
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listen_fd_, SOMAXCONN) != 0 || !SetNonBlocking(listen_fd_) ||
+      getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+                  &address_size) != 0 ||
+      pipe(wake_fds_) != 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+
+  SetNonBlocking(wake_fds_[0]);
+  SetNonBlocking(wake_fds_[1]);
+  port_ = ntohs(address.sin_port);
+  running_ = true;
+  thread_ = std::thread(&WebSocketServer::Run, this);
+  return true;
+}
+
+/******************************************************************************/
+void WebSocketServer::Stop() {
+  if (!running_) {
+    return;
+  }
+
+  running_ = false;
+  Wake();
+  thread_.join();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& client : clients_) {
+    close(client->fd);
+  }
+  clients_.clear();
+  statistics_.num_clients = 0;
+
+  close(listen_fd_);
+  close(wake_fds_[0]);
+  close(wake_fds_[1]);
+  listen_fd_ = wake_fds_[0] = wake_fds_[1] = -1;
+  wake_pending_ = false;
+}
+
+/******************************************************************************/
+void WebSocketServer::Publish(const MessageHeader& header,
+                              const void* payload) {
+  int64_t now_ns = GetSteadyTimeNs();
+  uint16_t type = static_cast<uint16_t>(header.message_type);
+
+  // Frames are encoded on first use, once per format.
+  Frame frames[2];
+  bool encoded[2] = {false, false};
+  bool queued = false;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++statistics_.num_published;
+    for (auto& client_ptr : clients_) {
+      Client& client = *client_ptr;
+      if (!client.upgraded || client.closing ||
+          (!client.types.empty() &&
+           !std::binary_search(client.types.begin(), client.types.end(),
+                               type))) {
+        continue;
+      }
+
+      // Check the rate limit for this message type.
+      std::pair<uint16_t, int64_t>* last_sent = nullptr;
+      if (client.min_interval_ns > 0) {
+        for (auto& entry : client.last_sent_ns) {
+          if (entry.first == type) {
+            last_sent = &entry;
+            break;
+          }
+        }
+        if (last_sent == nullptr) {
+          client.last_sent_ns.emplace_back(type, INT64_MIN);
+          last_sent = &client.last_sent_ns.back();
+        } else if (now_ns - last_sent->second <
+                   client.min_interval_ns * (1.0 - RATE_LIMIT_TOLERANCE)) {
+          continue;
+        }
+      }
+
+      if (client.queue_bytes.load(std::memory_order_relaxed) >=
+          config_.max_queue_bytes) {
+        ++statistics_.num_dropped;
+        continue;
+      }
+
+      size_t format_index = static_cast<size_t>(client.format);
+      if (!encoded[format_index]) {
+        encoded[format_index] = true;
+        std::string* frame = new std::string();
+        if (client.format == Format::JSON) {
+          std::string json;
+          if (EncodeMessageJSON(header, payload, &json)) {
+            AppendFrameHeader(OPCODE_TEXT, json.size(), frame);
+            frame->append(json);
+          }
+        } else {
+          size_t size = sizeof(MessageHeader) + header.payload_size_bytes;
+          AppendFrameHeader(OPCODE_BINARY, size, frame);
+          frame->append(reinterpret_cast<const char*>(&header),
+                        sizeof(MessageHeader));
+          frame->append(static_cast<const char*>(payload),
+                        header.payload_size_bytes);
+        }
+
+        if (frame->empty()) {
+          delete frame;
+        } else {
+          frames[format_index].reset(frame);
+          ++statistics_.num_encoded;
+        }
+      }
+
+      if (frames[format_index]) {
+        Enqueue(&client, frames[format_index]);
+        ++statistics_.num_queued;
+        queued = true;
+        if (last_sent != nullptr) {
+          last_sent->second = now_ns;
+        }
+      }
+    }
+  }
+
+  if (queued) {
+    Wake();
+  }
+}
+
+/******************************************************************************/
+WebSocketServer::Statistics WebSocketServer::GetStatistics() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return statistics_;
+}
+
+/******************************************************************************/
+void WebSocketServer::Run() {
+  std::vector<pollfd> fds;
+  std::vector<Client*> polled_clients;
+  std::vector<Client*> closed;
+  while (running_) {
+    // Collect newly queued frames. Sockets are read and written without
+    // holding the mutex so that Publish() is never blocked by network I/O.
+    fds.clear();
+    polled_clients.clear();
+    fds.push_back(pollfd{listen_fd_, POLLIN, 0});
+    fds.push_back(pollfd{wake_fds_[0], POLLIN, 0});
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto& client : clients_) {
+        TakePendingFrames(client.get());
+        short events = POLLIN;
+        if (!client->sending.empty()) {
+          events |= POLLOUT;
+        }
+        fds.push_back(pollfd{client->fd, events, 0});
+        polled_clients.push_back(client.get());
+      }
+    }
+
+    if (poll(fds.data(), fds.size(), POLL_TIMEOUT_MS) < 0) {
+      continue;
+    }
+
+    if (fds[1].revents & POLLIN) {
+      // Drain the pipe before clearing the flag so a byte written by a
+      // concurrent Wake() is never consumed while the flag stays set. Frames
+      // published before the flag is cleared are collected at the top of the
+      // next iteration; later ones write a new byte.
+      char buffer[64];
+      while (read(wake_fds_[0], buffer, sizeof(buffer)) > 0) {
+      }
+      wake_pending_.store(false);
+    }
+
+    if (fds[0].revents & POLLIN) {
+      AcceptClients();
+    }
+
+    // Clients are only removed by this thread, so they may be accessed without
+    // holding the mutex.
+    closed.clear();
+    for (size_t i = 0; i < polled_clients.size(); ++i) {
+      Client* client = polled_clients[i];
+      short revents = fds[i + 2].revents;
+      bool ok = (revents & (POLLERR | POLLNVAL)) == 0;
+      if (ok && (revents & (POLLIN | POLLHUP))) {
+        ok = ReadClient(client);
+      }
+      if (ok && !client->sending.empty()) {
+        ok = WriteClient(client);
+      }
+      if (!ok) {
+        closed.push_back(client);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!closed.empty()) {
+      auto end = std::remove_if(
+          clients_.begin(), clients_.end(),
+          [&closed](const std::unique_ptr<Client>& client) {
+            if (std::find(closed.begin(), closed.end(), client.get()) ==
+                closed.end()) {
+              return false;
+            }
+            close(client->fd);
+            return true;
+          });
+      clients_.erase(end, clients_.end());
+    }
+
+    statistics_.num_clients = static_cast<size_t>(
+        std::count_if(clients_.begin(), clients_.end(),
+                      [](const std::unique_ptr<Client>& client) {
+                        return client->upgraded;
+                      }));
+  }
+}
+
+/******************************************************************************/
+void WebSocketServer::Wake() {
+  if (!wake_pending_.exchange(true)) {
+    char value = 0;
+    if (write(wake_fds_[1], &value, 1) < 0) {
+      // The pipe is full, so the thread will wake anyway.
+    }
+  }
+}
+
+/******************************************************************************/
+void WebSocketServer::AcceptClients() {
+  while (true) {
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      break;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (clients_.size() >= config_.max_clients || !SetNonBlocking(fd)) {
+      close(fd);
+      continue;
+    }
+
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+#if defined(SO_NOSIGPIPE)
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+
+    std::unique_ptr<Client> client(new Client());
+    client->fd = fd;
+    clients_.push_back(std::move(client));
+  }
+}
+
+/******************************************************************************/
+bool WebSocketServer::ReadClient(Client* client) {
+  char buffer[4096];
+  while (true) {
+    ssize_t received = recv(client->fd, buffer, sizeof(buffer), 0);
+    if (received > 0) {
+      client->input.append(buffer, static_cast<size_t>(received));
+    } else if (received == 0) {
+      return false;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    } else if (errno != EINTR) {
+      return false;
+    }
+  }
+
+  if (client->input.empty()) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool ok =
+      client->upgraded ? HandleFrames(client) : HandleHandshake(client);
+  TakePendingFrames(client);
+  return ok;
+}
+
+/******************************************************************************/
+bool WebSocketServer::HandleHandshake(Client* client) {
+  size_t end = client->input.find("\r\n\r\n");
+  if (end == std::string::npos) {
+    return client->input.size() <= MAX_HANDSHAKE_BYTES;
+  }
+
+  std::string request = client->input.substr(0, end + 2);
+  client->input.erase(0, end + 4);
+
+  std::string key;
+  if (request.compare(0, 4, "GET ") != 0 ||
+      !FindHeader(request, "sec-websocket-key", &key)) {
+    static const char RESPONSE[] =
+        "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n"
+        "Content-Length: 0\r\n\r\n";
+    Enqueue(client, Frame(new std::string(RESPONSE)));
+    client->closing = true;
+    return true;
+  }
+
+  uint8_t digest[20];
+  ComputeSHA1(key + WEBSOCKET_GUID, digest);
+  std::string response =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Accept: " +
+      EncodeBase64(digest, sizeof(digest)) + "\r\n\r\n";
+  Enqueue(client, Frame(new std::string(std::move(response))));
+
+  // Parse the subscription from the request target (`GET /path?query ...`).
+  size_t target_end = request.find(' ', 4);
+  size_t query_start = request.find('?', 4);
+  if (query_start != std::string::npos && query_start < target_end) {
+    ParseSubscription(
+        request.substr(query_start + 1, target_end - query_start - 1),
+        client);
+  }
+
+  client->upgraded = true;
+  return HandleFrames(client);
+}
+
+/******************************************************************************/
+bool WebSocketServer::HandleFrames(Client* client) {
+  std::string& input = client->input;
+  while (input.size() >= 2) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(input.data());
+    bool final_fragment = (data[0] & 0x80) != 0;
+    uint8_t opcode = data[0] & 0x0F;
+    bool masked = (data[1] & 0x80) != 0;
+    uint64_t size = data[1] & 0x7F;
+    size_t offset = 2;
+    if (size == 126) {
+      if (input.size() < 4) {
+        break;
+      }
+      size = (static_cast<uint64_t>(data[2]) << 8) | data[3];
+      offset = 4;
+    } else if (size == 127) {
+      if (input.size() < 10) {
+        break;
+      }
+      size = 0;
+      for (int i = 0; i < 8; ++i) {
+        size = (size << 8) | data[2 + i];
+      }
+      offset = 10;
+    }
+
+    // Client frames must be masked (RFC 6455 section 5.1). Clients have no
+    // reason to send large messages.
+    if (!masked || size > MAX_CLIENT_FRAME_BYTES) {
+      return false;
+    }
+
+    if (input.size() < offset + 4 + size) {
+      break;
+    }
+
+    const uint8_t* mask = data + offset;
+    std::string payload(static_cast<size_t>(size), '\0');
+    for (size_t i = 0; i < size; ++i) {
+      payload[i] = static_cast<char>(data[offset + 4 + i] ^ mask[i % 4]);
+    }
+    input.erase(0, offset + 4 + static_cast<size_t>(size));
+
+    if (opcode == OPCODE_TEXT && final_fragment) {
+      ParseSubscription(payload, client);
+    } else if (opcode == OPCODE_CLOSE) {
+      std::string* frame = new std::string();
+      AppendFrameHeader(OPCODE_CLOSE, std::min<size_t>(payload.size(), 2),
+                        frame);
+      frame->append(payload, 0, 2);
+      Enqueue(client, Frame(frame));
+      client->closing = true;
+      break;
+    } else if (opcode == OPCODE_PING) {
+      std::string* frame = new std::string();
+      AppendFrameHeader(OPCODE_PONG, payload.size(), frame);
+      frame->append(payload);
+      Enqueue(client, Frame(frame));
+    } else if (opcode == OPCODE_CONTINUATION) {
+      // Fragmented subscription requests are not supported.
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************/
+bool WebSocketServer::WriteClient(Client* client) {
+  while (!client->sending.empty()) {
+    const std::string& frame = *client->sending.front();
+    ssize_t sent = send(client->fd, frame.data() + client->send_offset,
+                        frame.size() - client->send_offset, SEND_FLAGS);
+    if (sent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        return true;
+      }
+      return false;
+    }
+
+    client->send_offset += static_cast<size_t>(sent);
+    if (client->send_offset == frame.size()) {
+      client->queue_bytes.fetch_sub(frame.size(), std::memory_order_relaxed);
+      client->sending.pop_front();
+      client->send_offset = 0;
+    }
+  }
+
+  // Close the connection once any final response has been sent.
+  return !client->closing;
+}
+
+/******************************************************************************/
+void WebSocketServer::Enqueue(Client* client, Frame frame) {
+  client->queue_bytes.fetch_add(frame->size(), std::memory_order_relaxed);
+  client->pending.push_back(std::move(frame));
+}
+
+/******************************************************************************/
+void WebSocketServer::TakePendingFrames(Client* client) {
+  if (client->sending.empty()) {
+    client->sending.swap(client->pending);
+  } else {
+    for (Frame& frame : client->pending) {
+      client->sending.push_back(std::move(frame));
+    }
+    client->pending.clear();
+  }
+}
+
+/******************************************************************************/
+void WebSocketServer::ParseSubscription(const std::string& query,
+                                        Client* client) {
+  size_t start = 0;
+  while (start <= query.size()) {
+    size_t end = query.find('&', start);
+    if (end == std::string::npos) {
+      end = query.size();
+    }
+
+    std::string parameter = DecodePercent(query.substr(start, end - start));
+    size_t equals = parameter.find('=');
+    if (equals != std::string::npos) {
+      std::string name = parameter.substr(0, equals);
+      std::string value = parameter.substr(equals + 1);
+      if (name == "types") {
+        client->types.clear();
+        const char* ptr = value.c_str();
+        while (*ptr != '\0') {
+          char* next;
+          unsigned long type = std::strtoul(ptr, &next, 10);
+          if (next == ptr) {
+            ++ptr;
+          } else {
+            if (type <= 0xFFFF) {
+              client->types.push_back(static_cast<uint16_t>(type));
+            }
+            ptr = next;
+          }
+        }
+        std::sort(client->types.begin(), client->types.end());
+      } else if (name == "rate_hz") {
+        double rate_hz = std::strtod(value.c_str(), nullptr);
+        client->min_interval_ns =
+            rate_hz > 0.0 ? static_cast<int64_t>(1e9 / rate_hz) : 0;
+      } else if (name == "format") {
+        if (value == "json") {
+          client->format = Format::JSON;
+        } else if (value == "binary") {
+          client->format = Format::BINARY;
+        }
+      }
+    }
+
+    start = end + 1;
+  }
+}
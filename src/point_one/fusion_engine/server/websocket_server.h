@@ -0,0 +1,171 @@
+/**************************************************************************/ /**
+ * @brief WebSocket server for streaming messages to remote clients.
+ * @file
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "point_one/fusion_engine/common/portability.h"
+#include "point_one/fusion_engine/messages/core.h"
+
+namespace point_one {
+namespace fusion_engine {
+namespace server {
+
+/**
+ * @addtogroup server
+ * @{
+ */
+
+/**
+ * @brief Stream messages to WebSocket clients (e.g., browser dashboards).
+ *
+ * The application calls @ref Publish() for each decoded message. Each message
+ * is encoded at most once per format, as a complete WebSocket frame, and the
+ * same buffer is queued for every client that wants it, so the cost per client
+ * is a type filter, a rate check, and a reference count increment. Network I/O
+ * is performed by a background thread using non-blocking sockets.
+ *
+ * Clients select the data they receive using query parameters in the
+ * connection URL, e.g., `ws://host:port/?types=10000,10002&rate_hz=5`:
+ * - `types` - A comma-separated list of @ref messages::MessageType values
+ *   (default: all messages)
+ * - `rate_hz` - The maximum rate for each message type (default: unlimited)
+ * - `format` - `json` (text frames, see @ref EncodeMessageJSON()) or `binary`
+ *   (binary frames containing the original FusionEngine message, header
+ *   included; default: `json`)
+ *
+ * The subscription may be changed after connecting by sending a text message
+ * containing new parameters in the same form (e.g., `types=10000&rate_hz=1`).
+ *
+ * Clients that do not keep up are not allowed to delay other clients: once a
+ * client's queue exceeds @ref Config::max_queue_bytes, new messages for that
+ * client are dropped until the queue drains.
+ *
+ * @note
+ * This class is only available on POSIX platforms.
+ */
+class P1_EXPORT WebSocketServer {
+ public:
+  struct Config {
+    /** The address to listen on. Use `0.0.0.0` to accept remote clients. */
+    std::string bind_address = "127.0.0.1";
+
+    /** The port to listen on, or 0 to select an available port. */
+    uint16_t port = 0;
+
+    /** The maximum number of connected clients. */
+    size_t max_clients = 1024;
+
+    /** The maximum number of bytes queued for a single client. */
+    size_t max_queue_bytes = 1 << 20;
+  };
+
+  struct Statistics {
+    /** The number of connected (upgraded) clients. */
+    size_t num_clients = 0;
+
+    /** The number of messages passed to @ref Publish(). */
+    uint64_t num_published = 0;
+
+    /** The number of messages encoded (at most one per format per message). */
+    uint64_t num_encoded = 0;
+
+    /** The total number of messages queued for all clients. */
+    uint64_t num_queued = 0;
+
+    /** The number of messages dropped because a client queue was full. */
+    uint64_t num_dropped = 0;
+  };
+
+  WebSocketServer() : WebSocketServer(Config()) {}
+  explicit WebSocketServer(const Config& config);
+  ~WebSocketServer();
+
+  WebSocketServer(const WebSocketServer&) = delete;
+  WebSocketServer& operator=(const WebSocketServer&) = delete;
+
+  /**
+   * @brief Start listening for connections.
+   *
+   * @return `true` on success, or `false` if the server is already running or
+   *         the socket could not be opened.
+   */
+  bool Start();
+
+  /**
+   * @brief Disconnect all clients and stop the server.
+   */
+  void Stop();
+
+  /**
+   * @brief Get the port the server is listening on (e.g., if @ref
+   *        Config::port is 0).
+   */
+  uint16_t GetPort() const { return port_; }
+
+  /**
+   * @brief Send a message to all interested clients.
+   *
+   * This function may be called from any thread, e.g., directly from a @ref
+   * parsers::FusionEngineFramer callback.
+   *
+   * @param header The message header.
+   * @param payload The message payload.
+   */
+  void Publish(const messages::MessageHeader& header, const void* payload);
+
+  /**
+   * @brief Get server statistics.
+   */
+  Statistics GetStatistics() const;
+
+ private:
+  enum class Format : uint8_t {
+    JSON = 0,
+    BINARY = 1,
+  };
+
+  typedef std::shared_ptr<const std::string> Frame;
+
+  struct Client;
+
+  void Run();
+  void Wake();
+  void AcceptClients();
+  bool ReadClient(Client* client);
+  bool HandleHandshake(Client* client);
+  bool HandleFrames(Client* client);
+  bool WriteClient(Client* client);
+  void Enqueue(Client* client, Frame frame);
+  void TakePendingFrames(Client* client);
+  static void ParseSubscription(const std::string& query, Client* client);
+
+  Config config_;
+  uint16_t port_ = 0;
+  int listen_fd_ = -1;
+  int wake_fds_[2] = {-1, -1};
+  std::atomic<bool> running_;
+  std::atomic<bool> wake_pending_;
+  std::thread thread_;
+
+  // Guards the client list and the client state used by Publish().
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Client>> clients_;
+  Statistics statistics_;
+};
+
+/** @} */
+
+} // namespace server
+} // namespace fusion_engine
+} // namespace point_one